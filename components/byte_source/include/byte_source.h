@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_err.h"
+#include "memfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BYTE_SOURCE_MEMORY,
+    BYTE_SOURCE_EXTENTS,
+    BYTE_SOURCE_FILE,
+} byte_source_kind_t;
+
+/**
+ * @brief Sequential reader over compressed image data
+ *
+ * Decoders pull their input through this instead of taking a whole-file
+ * buffer, so a source on SD or in a RAM file is processed without first
+ * being copied into PSRAM. Backends:
+ *   - memory: a caller-owned buffer
+ *   - extents: a MemFS file, read in place (pinned until close)
+ *   - file: a FILE*, either opened here or borrowed at its current position
+ *
+ * Fields are private to byte_source.c except where noted.
+ */
+typedef struct {
+    byte_source_kind_t kind;
+    size_t size;    // total bytes from the start position
+    size_t offset;  // bytes consumed so far
+    const uint8_t *data;
+    memfs_extents_t ext;
+    FILE *fp;
+    long fp_start;  // fp position the source starts at
+    bool owns_fp;
+    uint8_t *copy;  // PSRAM copy made by byte_source_map, or NULL (public)
+} byte_source_t;
+
+/**
+ * @brief Read from a caller-owned buffer, which must outlive the source
+ */
+void byte_source_init_memory(byte_source_t *src, const void *data, size_t size);
+
+/**
+ * @brief Read a whole file: a MemFS file in place, anything else via stdio
+ *
+ * @return ESP_OK, or ESP_FAIL when the file cannot be opened
+ */
+esp_err_t byte_source_open_file(byte_source_t *src, const char *path);
+
+/**
+ * @brief Read from fp's current position to its end; fp stays open on close
+ *
+ * For payloads embedded in a larger file, such as an album pack.
+ */
+void byte_source_init_stream(byte_source_t *src, FILE *fp);
+
+/**
+ * @brief Release the source (unpin, close an owned file, free a copy)
+ */
+void byte_source_close(byte_source_t *src);
+
+/**
+ * @brief Total size in bytes, from the start position
+ */
+static inline size_t byte_source_size(const byte_source_t *src)
+{
+    return src->size;
+}
+
+/**
+ * @brief Bytes left to read
+ */
+static inline size_t byte_source_remaining(const byte_source_t *src)
+{
+    return src->size - src->offset;
+}
+
+/**
+ * @brief Whether byte_source_next hands out in-place pointers
+ *
+ * False for stdio-backed sources, whose callers need a read buffer.
+ */
+static inline bool byte_source_in_place(const byte_source_t *src)
+{
+    return src->kind != BYTE_SOURCE_FILE;
+}
+
+/**
+ * @brief Read up to len bytes into buf
+ *
+ * @return bytes read; short only at the end of the source or on an I/O error
+ */
+size_t byte_source_read(byte_source_t *src, void *buf, size_t len);
+
+/**
+ * @brief Skip len bytes
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_SIZE when fewer than len bytes remain
+ */
+esp_err_t byte_source_skip(byte_source_t *src, size_t len);
+
+/**
+ * @brief Start reading from the beginning again
+ */
+esp_err_t byte_source_rewind(byte_source_t *src);
+
+/**
+ * @brief Consume the next run of bytes held in place, without copying
+ *
+ * Returns up to max bytes (to the end of the current extent for MemFS) and
+ * advances past them, or NULL when the backend has no direct pointer
+ * (stdio) or nothing is left; fall back to byte_source_read then.
+ */
+const uint8_t *byte_source_next(byte_source_t *src, size_t max, size_t *len);
+
+/**
+ * @brief The remaining bytes as one contiguous buffer
+ *
+ * In place when the backend already holds them that way; otherwise read
+ * into a PSRAM copy (src->copy) that lives until close, and the underlying
+ * file is released right away. For decoders that cannot stream their input.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM, or ESP_FAIL on a short read
+ */
+esp_err_t byte_source_map(byte_source_t *src, const uint8_t **data, size_t *size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+#include "byte_source.h"
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "byte_source";
+
+void byte_source_init_memory(byte_source_t *src, const void *data, size_t size)
+{
+    memset(src, 0, sizeof(*src));
+    src->kind = BYTE_SOURCE_MEMORY;
+    src->data = (const uint8_t *) data;
+    src->size = size;
+}
+
+// Size from fp's current position to its end; the position is kept
+static size_t stream_size(FILE *fp, long start)
+{
+    if (start < 0 || fseek(fp, 0, SEEK_END) != 0) {
+        return 0;
+    }
+    long end = ftell(fp);
+    fseek(fp, start, SEEK_SET);
+    return end > start ? (size_t) (end - start) : 0;
+}
+
+void byte_source_init_stream(byte_source_t *src, FILE *fp)
+{
+    memset(src, 0, sizeof(*src));
+    src->kind = BYTE_SOURCE_FILE;
+    src->fp = fp;
+    src->fp_start = ftell(fp);
+    src->size = stream_size(fp, src->fp_start);
+}
+
+esp_err_t byte_source_open_file(byte_source_t *src, const char *path)
+{
+    memset(src, 0, sizeof(*src));
+    if (memfs_get_extents(path, &src->ext) == ESP_OK) {
+        src->kind = BYTE_SOURCE_EXTENTS;
+        src->size = src->ext.size;
+        return ESP_OK;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+    byte_source_init_stream(src, fp);
+    src->owns_fp = true;
+    return ESP_OK;
+}
+
+// Drop the backing file or pin, keeping any copy
+static void release_backend(byte_source_t *src)
+{
+    if (src->kind == BYTE_SOURCE_EXTENTS) {
+        memfs_put_extents(&src->ext);
+    } else if (src->kind == BYTE_SOURCE_FILE && src->owns_fp) {
+        fclose(src->fp);
+    }
+    src->fp = NULL;
+    src->owns_fp = false;
+}
+
+void byte_source_close(byte_source_t *src)
+{
+    release_backend(src);
+    heap_caps_free(src->copy);
+    memset(src, 0, sizeof(*src));
+}
+
+const uint8_t *byte_source_next(byte_source_t *src, size_t max, size_t *len)
+{
+    size_t left = byte_source_remaining(src);
+    const uint8_t *p = NULL;
+    size_t n = 0;
+    if (left == 0 || max == 0) {
+        // Nothing to hand out
+    } else if (src->kind == BYTE_SOURCE_MEMORY) {
+        p = src->data + src->offset;
+        n = left;
+    } else if (src->kind == BYTE_SOURCE_EXTENTS) {
+        size_t pos = src->offset % MEMFS_EXTENT_SIZE;
+        p = src->ext.extents[src->offset / MEMFS_EXTENT_SIZE] + pos;
+        n = MEMFS_EXTENT_SIZE - pos < left ? MEMFS_EXTENT_SIZE - pos : left;
+    }
+    if (!p) {
+        *len = 0;
+        return NULL;
+    }
+    n = n < max ? n : max;
+    src->offset += n;
+    *len = n;
+    return p;
+}
+
+size_t byte_source_read(byte_source_t *src, void *buf, size_t len)
+{
+    uint8_t *out = (uint8_t *) buf;
+    if (src->kind == BYTE_SOURCE_FILE) {
+        size_t left = byte_source_remaining(src);
+        size_t n = fread(out, 1, len < left ? len : left, src->fp);
+        src->offset += n;
+        return n;
+    }
+
+    size_t done = 0;
+    while (done < len) {
+        size_t n;
+        const uint8_t *p = byte_source_next(src, len - done, &n);
+        if (!p) {
+            break;
+        }
+        memcpy(out + done, p, n);
+        done += n;
+    }
+    return done;
+}
+
+esp_err_t byte_source_skip(byte_source_t *src, size_t len)
+{
+    if (len > byte_source_remaining(src)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (src->kind == BYTE_SOURCE_FILE && fseek(src->fp, (long) len, SEEK_CUR) != 0) {
+        return ESP_FAIL;
+    }
+    src->offset += len;
+    return ESP_OK;
+}
+
+esp_err_t byte_source_rewind(byte_source_t *src)
+{
+    if (src->kind == BYTE_SOURCE_FILE && fseek(src->fp, src->fp_start, SEEK_SET) != 0) {
+        return ESP_FAIL;
+    }
+    src->offset = 0;
+    return ESP_OK;
+}
+
+esp_err_t byte_source_map(byte_source_t *src, const uint8_t **data, size_t *size)
+{
+    size_t left = byte_source_remaining(src);
+    if (src->kind == BYTE_SOURCE_MEMORY) {
+        *data = src->data + src->offset;
+        *size = left;
+        return ESP_OK;
+    }
+    if (left == 0) {
+        *data = NULL;
+        *size = 0;
+        return ESP_OK;
+    }
+    if (src->kind == BYTE_SOURCE_EXTENTS &&
+        src->offset / MEMFS_EXTENT_SIZE == (src->size - 1) / MEMFS_EXTENT_SIZE) {
+        *data = src->ext.extents[src->offset / MEMFS_EXTENT_SIZE] +
+                src->offset % MEMFS_EXTENT_SIZE;
+        *size = left;
+        return ESP_OK;
+    }
+
+    // Spread over extents, or behind stdio: gather a copy
+    uint8_t *copy = (uint8_t *) heap_caps_malloc(left, MALLOC_CAP_SPIRAM);
+    if (!copy) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes to map the source", (unsigned) left);
+        return ESP_ERR_NO_MEM;
+    }
+    if (byte_source_read(src, copy, left) != left) {
+        heap_caps_free(copy);
+        return ESP_FAIL;
+    }
+
+    // From here on the source reads the copy
+    release_backend(src);
+    src->kind = BYTE_SOURCE_MEMORY;
+    src->copy = copy;
+    src->data = copy;
+    src->size = left;
+    src->offset = 0;
+    *data = copy;
+    *size = left;
+    return ESP_OK;
+}
@@ -1,6 +1,7 @@
 #ifndef EPAPER_H
 #define EPAPER_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 // Resolution APIs
@@ -44,6 +45,35 @@ void epaper_init(const epaper_config_t *cfg);
  */
 void epaper_display(uint8_t *image);
 
+/**
+ * @brief Begin a streamed display update
+ *
+ * Prepares the controller to receive the frame row by row with
+ * epaper_stream_rows() while it is still being produced, then refreshed by
+ * epaper_stream_commit(). Rows must be sent top to bottom, each band
+ * starting where the previous one ended.
+ *
+ * @return true if the update was started; false if the driver cannot
+ *         stream, in which case the caller uses epaper_display()
+ */
+bool epaper_stream_begin(void);
+
+/**
+ * @brief Send a band of rows of a streamed update
+ * @param rows Packed 4bpp panel rows (native orientation, as in the frame
+ *             buffer passed to epaper_display)
+ * @param y First panel row of the band
+ * @param count Number of rows
+ */
+void epaper_stream_rows(const uint8_t *rows, uint16_t y, uint16_t count);
+
+/**
+ * @brief Finish a streamed update
+ * @param refresh true to refresh the panel with the streamed frame; false
+ *                to abandon it and leave the panel showing the old image
+ */
+void epaper_stream_commit(bool refresh);
+
 /**
  * @brief Clear display with specific color
  * @param image Buffer to use for clearing (size must match display)
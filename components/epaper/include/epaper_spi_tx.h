@@ -0,0 +1,64 @@
+#ifndef EPAPER_SPI_TX_H
+#define EPAPER_SPI_TX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/spi_master.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bounce buffers in flight at once; the device's queue_size must be at least this
+#define EPAPER_SPI_TX_BUFS 2
+
+/**
+ * @brief Bulk pixel transfer engine shared by the panel drivers
+ *
+ * Frame data lives in PSRAM, which SPI DMA cannot read, so it is copied into
+ * internal DMA-capable bounce buffers that are as large as the bus and heap
+ * allow. Full buffers go out as queued transactions, so the next buffer is
+ * filled while the previous one is on the wire.
+ *
+ * If init cannot allocate the buffers, writes fall back to small blocking
+ * transactions through a stack copy: slow, but the frame still arrives.
+ *
+ * The caller owns CS, DC and the bus lock. It must call epaper_spi_tx_flush()
+ * before raising CS or issuing a polling transaction on the same device.
+ */
+typedef struct {
+    spi_device_handle_t spi;
+    uint8_t *buf[EPAPER_SPI_TX_BUFS];
+    size_t buf_size;
+    spi_transaction_t trans[EPAPER_SPI_TX_BUFS];
+    int slot;       // buffer being filled
+    size_t fill;    // bytes staged in buf[slot]
+    int in_flight;  // queued transactions not yet reaped
+} epaper_spi_tx_t;
+
+/**
+ * @brief Allocate the bounce buffers for a device on the given bus
+ * @return ESP_OK, or ESP_ERR_NO_MEM if not even the minimum size fits (the
+ *         engine is still usable, on the polled fallback)
+ */
+esp_err_t epaper_spi_tx_init(epaper_spi_tx_t *tx, spi_device_handle_t spi, int spi_host);
+
+/**
+ * @brief Queue len bytes for transmission
+ * @param map Optional 256-entry table applied to every byte on the copy
+ */
+void epaper_spi_tx_write(epaper_spi_tx_t *tx, const uint8_t *data, size_t len,
+                         const uint8_t *map);
+
+/**
+ * @brief Send any staged bytes and wait for every queued transaction
+ */
+void epaper_spi_tx_flush(epaper_spi_tx_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
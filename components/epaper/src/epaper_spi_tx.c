@@ -0,0 +1,151 @@
+#include "epaper_spi_tx.h"
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "epaper_spi_tx";
+
+// Upper bound per bounce buffer: past this the transaction overhead is
+// already negligible and internal RAM is better spent elsewhere
+#define EPAPER_SPI_TX_MAX_BUF (16 * 1024)
+// Below this the engine is no better than the per-chunk path it replaces
+#define EPAPER_SPI_TX_MIN_BUF 512
+// Stack copy per polling transaction when there are no bounce buffers
+#define EPAPER_SPI_TX_POLL_CHUNK 128
+
+esp_err_t epaper_spi_tx_init(epaper_spi_tx_t *tx, spi_device_handle_t spi, int spi_host)
+{
+    memset(tx, 0, sizeof(*tx));
+    tx->spi = spi;
+
+    size_t size = EPAPER_SPI_TX_MAX_BUF;
+    size_t bus_max = 0;
+    if (spi_bus_get_max_transaction_len((spi_host_device_t) spi_host, &bus_max) == ESP_OK &&
+        bus_max < size) {
+        size = bus_max;
+    }
+    // DMA descriptors want word-aligned lengths
+    size &= ~(size_t) 3;
+
+    // Take the largest pair that fits in internal DMA-capable RAM
+    for (; size >= EPAPER_SPI_TX_MIN_BUF; size /= 2) {
+        int i = 0;
+        for (; i < EPAPER_SPI_TX_BUFS; i++) {
+            tx->buf[i] = heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (!tx->buf[i]) {
+                break;
+            }
+        }
+        if (i == EPAPER_SPI_TX_BUFS) {
+            tx->buf_size = size;
+            ESP_LOGI(TAG, "%d x %d-byte DMA bounce buffers", EPAPER_SPI_TX_BUFS, (int) size);
+            return ESP_OK;
+        }
+        while (i-- > 0) {
+            heap_caps_free(tx->buf[i]);
+            tx->buf[i] = NULL;
+        }
+    }
+
+    ESP_LOGE(TAG, "No room for %d-byte DMA bounce buffers", EPAPER_SPI_TX_MIN_BUF);
+    return ESP_ERR_NO_MEM;
+}
+
+static void epaper_spi_tx_reap(epaper_spi_tx_t *tx)
+{
+    spi_transaction_t *done;
+    esp_err_t ret = spi_device_get_trans_result(tx->spi, &done, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SPI transaction failed: %s", esp_err_to_name(ret));
+    }
+    tx->in_flight--;
+}
+
+// Queue the staged buffer and move on to the next one
+static void epaper_spi_tx_submit(epaper_spi_tx_t *tx)
+{
+    spi_transaction_t *t = &tx->trans[tx->slot];
+    *t = (spi_transaction_t) {.length = tx->fill * 8, .tx_buffer = tx->buf[tx->slot]};
+    esp_err_t ret = spi_device_queue_trans(tx->spi, t, portMAX_DELAY);
+    if (ret == ESP_OK) {
+        tx->in_flight++;
+    } else {
+        ESP_LOGE(TAG, "SPI queue %d bytes failed: %s", (int) tx->fill, esp_err_to_name(ret));
+    }
+    tx->slot = (tx->slot + 1) % EPAPER_SPI_TX_BUFS;
+    tx->fill = 0;
+}
+
+// Copy len bytes to dst, translated through map when given
+static void epaper_spi_tx_copy(uint8_t *dst, const uint8_t *data, size_t len, const uint8_t *map)
+{
+    if (map) {
+        for (size_t i = 0; i < len; i++) {
+            dst[i] = map[data[i]];
+        }
+    } else {
+        memcpy(dst, data, len);
+    }
+}
+
+// Fallback when init could not allocate the bounce buffers: small chunks
+// through a stack buffer (internal RAM), one blocking transaction each
+static void epaper_spi_tx_write_polled(epaper_spi_tx_t *tx, const uint8_t *data, size_t len,
+                                       const uint8_t *map)
+{
+    uint8_t buf[EPAPER_SPI_TX_POLL_CHUNK];
+    while (len > 0) {
+        size_t n = len < sizeof(buf) ? len : sizeof(buf);
+        epaper_spi_tx_copy(buf, data, n, map);
+        spi_transaction_t t = {.length = n * 8, .tx_buffer = buf};
+        esp_err_t ret = spi_device_polling_transmit(tx->spi, &t);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "SPI transmit %d bytes failed: %s", (int) n, esp_err_to_name(ret));
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+void epaper_spi_tx_write(epaper_spi_tx_t *tx, const uint8_t *data, size_t len,
+                         const uint8_t *map)
+{
+    if (!tx->buf_size) {
+        epaper_spi_tx_write_polled(tx, data, len, map);
+        return;
+    }
+    while (len > 0) {
+        // Transactions complete in order, so with every buffer queued the
+        // oldest one is the slot about to be refilled
+        if (tx->fill == 0 && tx->in_flight == EPAPER_SPI_TX_BUFS) {
+            epaper_spi_tx_reap(tx);
+        }
+
+        uint8_t *dst = tx->buf[tx->slot] + tx->fill;
+        size_t n = tx->buf_size - tx->fill;
+        if (n > len) {
+            n = len;
+        }
+        epaper_spi_tx_copy(dst, data, n, map);
+        tx->fill += n;
+        data += n;
+        len -= n;
+
+        if (tx->fill == tx->buf_size) {
+            epaper_spi_tx_submit(tx);
+        }
+    }
+}
+
+void epaper_spi_tx_flush(epaper_spi_tx_t *tx)
+{
+    if (tx->fill > 0) {
+        epaper_spi_tx_submit(tx);
+    }
+    while (tx->in_flight > 0) {
+        epaper_spi_tx_reap(tx);
+    }
+}
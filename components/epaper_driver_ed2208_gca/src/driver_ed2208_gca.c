@@ -4,7 +4,9 @@
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "epaper.h"
+#include "epaper_spi_tx.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 
 #ifdef CONFIG_PM_ENABLE
@@ -15,6 +17,7 @@ static const char *TAG = "epaper_ed2208_gca";
 
 static epaper_config_t g_cfg;
 static spi_device_handle_t spi;
+static epaper_spi_tx_t s_tx;
 
 #ifdef CONFIG_PM_ENABLE
 static esp_pm_lock_handle_t pm_lock = NULL;
@@ -27,8 +30,6 @@ static esp_pm_lock_handle_t pm_lock = NULL;
 
 // SPI max transfer size per transaction
 #define SPI_MAX_CHUNK 4092
-// Data transfer chunk size (per CS window)
-#define DATA_CHUNK_SIZE 128
 
 // --- Low-level SPI helpers ---
 
@@ -105,34 +106,18 @@ static void send_command(uint8_t cmd)
     cmd_data(cmd, NULL, 0);
 }
 
-// Send image buffer in DATA_CHUNK_SIZE-byte chunks, each in its own CS window,
-// copied to a stack-local buffer to avoid PSRAM DMA issues.
-static void send_buffer(uint8_t *data, int len)
+// Send pixel data in one CS window. DTM accepts the data as one continuous
+// byte stream, so CS stays low throughout while the transfer engine copies it
+// through internal DMA bounce buffers (the frame buffer is in PSRAM).
+static void send_buffer(const uint8_t *data, int len)
 {
-    uint8_t buf[DATA_CHUNK_SIZE];
-    uint8_t *ptr = data;
-    int remaining = len;
-
-    ESP_LOGI(TAG, "Sending %d bytes in %d-byte chunks", len, DATA_CHUNK_SIZE);
-
-    while (remaining > 0) {
-        int chunk = (remaining > DATA_CHUNK_SIZE) ? DATA_CHUNK_SIZE : remaining;
-
-        // Copy to stack buffer (internal RAM) for reliable DMA
-        memcpy(buf, ptr, chunk);
-
-        gpio_set_level(g_cfg.pin_dc, 1);  // DC high = data
-        spi_begin();
-        gpio_set_level(g_cfg.pin_cs, 0);  // CS low
-        spi_write(buf, chunk);
-        gpio_set_level(g_cfg.pin_cs, 1);  // CS high
-        spi_end();
-
-        ptr += chunk;
-        remaining -= chunk;
-    }
-
-    ESP_LOGI(TAG, "Buffer send complete");
+    gpio_set_level(g_cfg.pin_dc, 1);  // DC high = data
+    spi_begin();
+    gpio_set_level(g_cfg.pin_cs, 0);  // CS low
+    epaper_spi_tx_write(&s_tx, data, len, NULL);
+    epaper_spi_tx_flush(&s_tx);
+    gpio_set_level(g_cfg.pin_cs, 1);  // CS high
+    spi_end();
 }
 
 static bool is_busy(void)
@@ -205,10 +190,13 @@ static void spi_add_device(void)
         .clock_speed_hz = 20 * 1000 * 1000,
         .mode = 0,
         .spics_io_num = -1,  // CS is manually controlled
-        .queue_size = 1,
+        .queue_size = EPAPER_SPI_TX_BUFS,
         .flags = SPI_DEVICE_HALFDUPLEX | SPI_DEVICE_NO_DUMMY,
     };
     ESP_ERROR_CHECK(spi_bus_add_device(g_cfg.spi_host, &devcfg, &spi));
+    if (epaper_spi_tx_init(&s_tx, spi, g_cfg.spi_host) != ESP_OK) {
+        ESP_LOGW(TAG, "Pixel data falls back to polled SPI transfers");
+    }
 }
 
 static void hw_reset(void)
@@ -240,9 +228,8 @@ static void send_init_sequence(void)
     cmd_data(0xE3, (uint8_t[]){0x2F}, 1);                                // PWS
 }
 
-// Full display update cycle:
-// RESET -> INIT -> wait -> DTM -> DATA -> PON -> wait -> DRF -> wait -> POF -> wait -> DSLP
-static void display_update_cycle(uint8_t *image)
+// First half of an update: RESET -> INIT -> wait -> DTM. Pixel data follows.
+static void update_begin(void)
 {
 #ifdef CONFIG_PM_ENABLE
     if (pm_lock) {
@@ -257,7 +244,11 @@ static void display_update_cycle(uint8_t *image)
     wait_busy("init");
 
     send_command(0x10);  // DATA_START_TRANSMISSION
-    send_buffer(image, EPD_BUF_SIZE);
+}
+
+// Second half: wait -> PON -> wait -> DRF -> wait -> POF -> wait -> DSLP
+static void update_finish(void)
+{
     wait_busy("data");
 
     send_command(0x04);  // POWER_ON
@@ -278,6 +269,17 @@ static void display_update_cycle(uint8_t *image)
 #endif
 }
 
+// Full display update cycle:
+// RESET -> INIT -> wait -> DTM -> DATA -> PON -> wait -> DRF -> wait -> POF -> wait -> DSLP
+static void display_update_cycle(uint8_t *image)
+{
+    update_begin();
+    int64_t t0 = esp_timer_get_time();
+    send_buffer(image, EPD_BUF_SIZE);
+    ESP_LOGI(TAG, "Frame push took %lld ms", (long long) (esp_timer_get_time() - t0) / 1000);
+    update_finish();
+}
+
 // --- Public API ---
 
 uint16_t epaper_get_width(void)
@@ -324,6 +326,40 @@ void epaper_display(uint8_t *image)
     ESP_LOGI(TAG, "Display update complete");
 }
 
+// DTM takes the frame as one sequential byte stream and send_buffer gives
+// every band its own CS window, so rows can be fed as they are produced with
+// the bus free in between.
+bool epaper_stream_begin(void)
+{
+    ESP_LOGI(TAG, "Starting streamed display update");
+    update_begin();
+    return true;
+}
+
+void epaper_stream_rows(const uint8_t *rows, uint16_t y, uint16_t count)
+{
+    (void) y;  // rows arrive in order; DTM has no addressing
+    send_buffer(rows, (int) count * (EPD_WIDTH / 2));
+}
+
+void epaper_stream_commit(bool refresh)
+{
+    if (refresh) {
+        update_finish();
+        ESP_LOGI(TAG, "Streamed display update complete");
+        return;
+    }
+
+    // Abandoned: leave the partial frame unrefreshed and put the controller
+    // back to sleep (the next update starts with a hardware reset)
+    cmd_data(0x07, (uint8_t[]){0xA5}, 1);  // DEEP_SLEEP
+#ifdef CONFIG_PM_ENABLE
+    if (pm_lock) {
+        esp_pm_lock_release(pm_lock);
+    }
+#endif
+}
+
 void epaper_enter_deepsleep(void)
 {
     ESP_LOGI(TAG, "Entering deep sleep");
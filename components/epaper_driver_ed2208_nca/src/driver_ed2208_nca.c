@@ -4,7 +4,9 @@
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "epaper.h"
+#include "epaper_spi_tx.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 
 #ifdef CONFIG_PM_ENABLE
@@ -15,6 +17,9 @@ static const char *TAG = "epaper_ed2208_nca";
 
 static epaper_config_t g_cfg;
 static spi_device_handle_t spi;
+static epaper_spi_tx_t s_tx;
+// Packed frame byte -> packed hardware color byte (two color_get lookups)
+static uint8_t s_color_map[256];
 
 #ifdef CONFIG_PM_ENABLE
 static esp_pm_lock_handle_t pm_lock = NULL;
@@ -153,6 +158,9 @@ static void spi_add_device(void)
         .flags = SPI_DEVICE_HALFDUPLEX,
     };
     ESP_ERROR_CHECK(spi_bus_add_device(g_cfg.spi_host, &devcfg, &spi));
+    if (epaper_spi_tx_init(&s_tx, spi, g_cfg.spi_host) != ESP_OK) {
+        ESP_LOGW(TAG, "Pixel data falls back to polled SPI transfers");
+    }
 }
 
 static void hw_reset(void)
@@ -241,6 +249,10 @@ void epaper_init(const epaper_config_t *cfg)
 
     ESP_LOGI(TAG, "Initializing ED2208-NCA (Spectra 6, 13.3\") E-Paper Driver");
 
+    for (int b = 0; b < 256; b++) {
+        s_color_map[b] = (color_get(b >> 4) << 4) | color_get(b & 0x0F);
+    }
+
     spi_add_device();
     gpio_init();
 
@@ -285,14 +297,8 @@ void epaper_display(uint8_t *image)
     uint16_t block_w_bytes = EPD_WIDTH / 2 / 2;  // 300 bytes (packed)
     uint16_t row_stride_bytes = EPD_WIDTH / 2;   // 600 bytes
 
-    uint8_t *line_buf = heap_caps_malloc(block_w_bytes, MALLOC_CAP_DMA);
-    if (!line_buf) {
-        ESP_LOGE(TAG, "Malloc failed");
-        goto out;
-    }
-
     // Hold the SPI bus exclusively for the whole pixel transfer. CS/CS1 stay LOW
-    // across every per-row transmit below, so any other transaction on this
+    // across every queued transfer below, so any other transaction on this
     // shared bus (the SD card is on the same SPI2_HOST — e.g. a thumbnail being
     // written, or the debug-log writer task) would be clocked into the panel too,
     // desyncing the pixel stream: broken rows at the injection point and every
@@ -300,52 +306,33 @@ void epaper_display(uint8_t *image)
     // turn instead of corrupting the frame. Released right after the transfer so
     // the (multi-second) refresh wait below doesn't block the SD.
     spi_device_acquire_bus(spi, portMAX_DELAY);
+    int64_t t0 = esp_timer_get_time();
 
-    // --- Phase 1: CS (Left half) ---
-    gpio_set_level(g_cfg.pin_cs, 0);
-
-    gpio_set_level(g_cfg.pin_dc, 0);  // CMD
     uint8_t dtm_cmd = 0x10;
     spi_transaction_t t_dtm = {.length = 8, .tx_buffer = &dtm_cmd};
-    spi_device_transmit(spi, &t_dtm);
+    const int cs_pins[2] = {g_cfg.pin_cs, g_cfg.pin_cs1};
 
-    gpio_set_level(g_cfg.pin_dc, 1);  // DATA
-
-    for (uint16_t row = 0; row < EPD_HEIGHT; row++) {
-        for (uint16_t col = 0; col < block_w_bytes; col++) {
-            uint8_t b = image[row * row_stride_bytes + col];
-            uint8_t p1 = (b >> 4) & 0x0F;
-            uint8_t p2 = b & 0x0F;
-            line_buf[col] = (color_get(p1) << 4) | color_get(p2);
-        }
-        spi_transaction_t t_line = {.length = block_w_bytes * 8, .tx_buffer = line_buf};
-        spi_device_transmit(spi, &t_line);
-    }
-    gpio_set_level(g_cfg.pin_cs, 1);
-
-    // --- Phase 2: CS1 (Right half) ---
-    gpio_set_level(g_cfg.pin_cs1, 0);
+    // Phase 1 sends the left half of every row via CS, phase 2 the right half
+    // via CS1. Row halves are translated to hardware colors on the copy into
+    // the transfer engine, which packs many of them into each DMA transaction.
+    for (int half = 0; half < 2; half++) {
+        gpio_set_level(cs_pins[half], 0);
 
-    gpio_set_level(g_cfg.pin_dc, 0);  // CMD
-    spi_device_transmit(spi, &t_dtm);
+        gpio_set_level(g_cfg.pin_dc, 0);  // CMD
+        spi_device_transmit(spi, &t_dtm);
 
-    gpio_set_level(g_cfg.pin_dc, 1);  // DATA
+        gpio_set_level(g_cfg.pin_dc, 1);  // DATA
 
-    for (uint16_t row = 0; row < EPD_HEIGHT; row++) {
-        for (uint16_t col = 0; col < block_w_bytes; col++) {
-            uint8_t b = image[row * row_stride_bytes + col + block_w_bytes];
-            uint8_t p1 = (b >> 4) & 0x0F;
-            uint8_t p2 = b & 0x0F;
-            line_buf[col] = (color_get(p1) << 4) | color_get(p2);
+        const uint8_t *src = image + half * block_w_bytes;
+        for (uint16_t row = 0; row < EPD_HEIGHT; row++, src += row_stride_bytes) {
+            epaper_spi_tx_write(&s_tx, src, block_w_bytes, s_color_map);
         }
-        spi_transaction_t t_line = {.length = block_w_bytes * 8, .tx_buffer = line_buf};
-        spi_device_transmit(spi, &t_line);
+        epaper_spi_tx_flush(&s_tx);
+        gpio_set_level(cs_pins[half], 1);
     }
-    gpio_set_level(g_cfg.pin_cs1, 1);
 
     spi_device_release_bus(spi);
-
-    free(line_buf);
+    ESP_LOGI(TAG, "Frame push took %lld ms", (long long) (esp_timer_get_time() - t0) / 1000);
 
     // PON — both controllers
     cmd_data_both(0x04, NULL, 0);
@@ -361,13 +348,32 @@ void epaper_display(uint8_t *image)
 
     ESP_LOGI(TAG, "Display update complete");
 
-out:
 #ifdef CONFIG_PM_ENABLE
     if (pm_lock) {
         esp_pm_lock_release(pm_lock);
     }
 #endif
-    return;
+}
+
+// Each controller takes its half of every row in one DTM stream per chip
+// select, left half first, so the right halves cannot be sent until the
+// whole frame exists. Streamed updates are not supported; callers fall
+// back to epaper_display().
+bool epaper_stream_begin(void)
+{
+    return false;
+}
+
+void epaper_stream_rows(const uint8_t *rows, uint16_t y, uint16_t count)
+{
+    (void) rows;
+    (void) y;
+    (void) count;
+}
+
+void epaper_stream_commit(bool refresh)
+{
+    (void) refresh;
 }
 
 void epaper_enter_deepsleep(void)
@@ -22,11 +22,14 @@
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "epaper.h"
+#include "esp_attr.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "it8951_dirty.h"
+#include "it8951_mode.h"
 
 #ifdef CONFIG_PM_ENABLE
 #include "esp_pm.h"
@@ -64,7 +67,9 @@ static const char *TAG = "it8951";
 
 // ---- Display update modes (ED103TC2 / 10.3") ----
 #define IT8951_MODE_INIT 0
+#define IT8951_MODE_DU 1
 #define IT8951_MODE_GC16 2
+#define IT8951_MODE_GL16 3
 #define IT8951_MODE_A2 6
 
 // Fallback VCOM magnitude (-2.0 V) applied only if the panel's stored VCOM is
@@ -95,9 +100,11 @@ typedef struct {
 } it8951_dev_info_t;
 
 static spi_device_handle_t s_spi = NULL;
-// Internal-RAM, DMA-capable bounce buffer: the framebuffer lives in PSRAM, which
-// SPI DMA can't transmit from directly, so image chunks are copied through this.
-static uint8_t *s_dma_buf = NULL;
+// Internal-RAM, DMA-capable bounce buffers: the framebuffer lives in PSRAM, which
+// SPI DMA can't transmit from directly, so image rows are copied through these.
+// Two of them ping-pong so one row is prepared while the other is on the wire.
+#define IT8951_DMA_BUFS 2
+static uint8_t *s_dma_buf[IT8951_DMA_BUFS] = {NULL};
 static int s_pin_cs = -1;
 static int s_pin_rst = -1;
 static int s_pin_busy = -1;    // HRDY: high = ready, low = busy
@@ -107,6 +114,24 @@ static int8_t s_temp_c = IT8951_DEFAULT_TEMP_C;  // panel temperature for wavefo
 // Default to the ED103TC2 geometry until GetSystemInfo reports the real values.
 static it8951_dev_info_t s_dev = {.panel_w = 1872, .panel_h = 1404};
 
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+// Waveform selection: every loaded row is scanned (levels used, pixels changed
+// against the PSRAM copy of the last refreshed frame) before the refresh picks
+// its mode. The panel state lives in RTC memory so a wake from deep sleep,
+// which loses the PSRAM copy but not the picture, still skips the INIT flash.
+static uint8_t *s_shadow = NULL;
+static bool s_shadow_valid = false;
+static it8951_scan_t s_scan;
+static RTC_DATA_ATTR it8951_mode_state_t s_mode;
+#endif
+
+#if CONFIG_IT8951_PARTIAL_REFRESH
+// Changed areas of the frame being loaded; a streamed frame is diffed row by
+// row as it loads (s_track_dirty), a whole frame before anything is sent
+static it8951_dirty_t s_dirty;
+static bool s_track_dirty = false;
+#endif
+
 #ifdef CONFIG_PM_ENABLE
 // Block automatic light sleep during a display update: light sleep isolates the
 // GPIOs mid-transaction and would corrupt the SPI image stream. Matches the
@@ -365,7 +390,7 @@ void epaper_init(const epaper_config_t *cfg)
         .clock_speed_hz = IT8951_SPI_CLOCK_HZ,
         .mode = 0,
         .spics_io_num = -1,
-        .queue_size = 1,
+        .queue_size = IT8951_DMA_BUFS,
     };
     esp_err_t ret = spi_bus_add_device(cfg->spi_host, &dev_cfg, &s_spi);
     if (ret != ESP_OK) {
@@ -380,10 +405,12 @@ void epaper_init(const epaper_config_t *cfg)
     }
 #endif
 
-    // DMA-capable internal-RAM bounce buffer for streaming the PSRAM framebuffer.
-    s_dma_buf = heap_caps_malloc(IT8951_SPI_CHUNK, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
-    if (!s_dma_buf) {
-        ESP_LOGE(TAG, "failed to alloc %d-byte SPI DMA buffer", IT8951_SPI_CHUNK);
+    // DMA-capable internal-RAM bounce buffers for streaming the PSRAM framebuffer.
+    for (int i = 0; i < IT8951_DMA_BUFS; i++) {
+        s_dma_buf[i] = heap_caps_malloc(IT8951_SPI_CHUNK, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (!s_dma_buf[i]) {
+            ESP_LOGE(TAG, "failed to alloc %d-byte SPI DMA buffer", IT8951_SPI_CHUNK);
+        }
     }
 
     it8951_reset();
@@ -407,6 +434,15 @@ void epaper_init(const epaper_config_t *cfg)
     // Enable host packed-write so streamed image data isn't byte-padded.
     it8951_write_reg(IT8951_REG_I80CPCR, 0x0001);
 
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+    // Without the copy frames are still classified, just never as small deltas
+    s_shadow = heap_caps_malloc((size_t) s_dev.panel_w * s_dev.panel_h / 2, MALLOC_CAP_SPIRAM);
+    s_shadow_valid = false;
+    if (!s_shadow) {
+        ESP_LOGW(TAG, "no PSRAM for the previous-frame copy; GL16 disabled");
+    }
+#endif
+
     // Force the panel temperature so the IT8951 selects a usable waveform;
     // without it GC16 can refresh blank. s_temp_c starts at a room-temperature
     // default and is refined by epaper_set_temperature() (live SHT40 reading).
@@ -421,40 +457,71 @@ void epaper_set_temperature(int8_t celsius)
     }
 }
 
-void epaper_display(uint8_t *image)
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+static void it8951_scan_start(void)
 {
-    if (!s_spi || !image || !s_dma_buf) {
-        return;
+    it8951_scan_begin(&s_scan, s_shadow && s_shadow_valid);
+}
+
+// Scan bytes [off, off + bytes) of frame row y about to be loaded and make
+// them the previous-frame data
+static void it8951_scan_load_row(const uint8_t *row, uint16_t y, size_t off, size_t bytes)
+{
+    const size_t row_bytes = (size_t) s_dev.panel_w / 2;
+    uint8_t *prev = s_shadow ? s_shadow + (size_t) y * row_bytes : NULL;
+#if CONFIG_IT8951_PARTIAL_REFRESH
+    if (s_track_dirty && prev) {
+        it8951_dirty_row(&s_dirty, y, row, prev, row_bytes);
     }
-#ifdef CONFIG_PM_ENABLE
-    if (pm_lock) {
-        esp_pm_lock_acquire(pm_lock);
+#endif
+    it8951_scan_row(&s_scan, row + off, prev ? prev + off : NULL, bytes);
+    if (prev) {
+        memcpy(prev + off, row + off, bytes);
     }
+}
 #endif
-    const uint16_t w = s_dev.panel_w;
-    const uint16_t h = s_dev.panel_h;
-    const size_t row_bytes = (size_t) w / 2;  // 4bpp = 2 px/byte
 
-    it8951_set_target_memory(s_img_addr);
+// Panel memory x of frame buffer columns [x, x + w). Without the panel word
+// order option each row's words are reversed on the way out, so the columns
+// land mirrored.
+static uint16_t it8951_memory_x(uint16_t x, uint16_t w)
+{
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+    (void) w;
+    return x;
+#else
+    return s_dev.panel_w - x - w;
+#endif
+}
 
-    // Load full-frame image area (4bpp).
+// Load frame buffer area (x, y, w, h) into the IT8951 image buffer. rows is
+// frame row y; x and w are multiples of 4 pixels (whole 16-bit words). The
+// target memory must already be set.
+static void it8951_load_area(const uint8_t *rows, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    const size_t stride = (size_t) s_dev.panel_w / 2;  // 4bpp = 2 px/byte
+    const size_t off = (size_t) x / 2;
+    const size_t area_bytes = (size_t) w / 2;
+
+    // Load the image area (4bpp).
     it8951_write_cmd(IT8951_TCON_LD_IMG_AREA);
     it8951_write_data((IT8951_LD_ENDIAN << 8) | (IT8951_BPP_4 << 4) | IT8951_LD_ROTATE);
-    it8951_write_data(0);  // x
-    it8951_write_data(0);  // y
+    it8951_write_data(it8951_memory_x(x, w));
+    it8951_write_data(y);
     it8951_write_data(w);
     it8951_write_data(h);
 
-    // Stream the image in ONE CS-low session (single 0x0000 write preamble, all
+    // Stream the area in ONE CS-low session (single 0x0000 write preamble, all
     // data back-to-back; toggling CS mid-load resets the IT8951 write pointer).
     // The ED103TC2 scans each row right-to-left, so mirror it -- but at 16-bit
     // *word* granularity (the unit the IT8951 reconstructs from the SPI byte
     // stream): emit the row's words in reverse order while keeping each word's
     // two bytes intact, exactly as Seeed's driver does. Reversing at byte
     // granularity would swap the two bytes inside each word and scramble pixels
-    // locally. The bounce buffer also keeps SPI DMA off the PSRAM frame buffer
-    // (which it can't transmit from directly).
-    const size_t row_words = row_bytes / 2;
+    // locally. With CONFIG_IT8951_FB_PANEL_WORD_ORDER the frame buffer already
+    // holds rows in that order and they are copied as-is. The bounce buffers
+    // also keep SPI DMA off the PSRAM frame buffer (which it can't transmit
+    // from directly).
     wait_ready();
     // Hold the SPI bus exclusively for the whole CS-low image stream. CS stays
     // low across every row transmit below (toggling it mid-load resets the
@@ -466,38 +533,242 @@ void epaper_display(uint8_t *image)
     spi_device_acquire_bus(s_spi, portMAX_DELAY);
     cs_low();
     spi_write16(IT8951_PRE_WR_DATA);
-    for (uint16_t y = 0; y < h; y++) {
-        const uint8_t *src = image + (size_t) y * row_bytes;
-        for (size_t wi = 0; wi < row_words; wi++) {
-            const uint8_t *sw = src + (row_words - 1 - wi) * 2;
-            s_dma_buf[wi * 2] = sw[0];
-            s_dma_buf[wi * 2 + 1] = sw[1];
+
+    // Rows go out as queued DMA transactions, alternating between the two
+    // bounce buffers: while one row is clocked out the next is copied into the
+    // other buffer. Waiting for a result blocks rather than busy-spins, so the
+    // multi-second push no longer starves the IDLE task.
+    static spi_transaction_t trans[IT8951_DMA_BUFS];
+    int in_flight = 0;
+    for (uint16_t r = 0; r < h; r++) {
+        const int slot = r % IT8951_DMA_BUFS;
+        if (in_flight == IT8951_DMA_BUFS) {
+            spi_transaction_t *done;
+            spi_device_get_trans_result(s_spi, &done, portMAX_DELAY);
+            in_flight--;
         }
-        spi_tx(s_dma_buf, row_bytes);
-        // The polling transmits busy-spin the CPU for the whole multi-second
-        // frame push, starving the IDLE task and tripping its watchdog on
-        // large panels. Yielding is safe mid-load: the bus is held, CS stays
-        // low, and the IT8951 has no inter-row deadline.
-        if ((y & 63) == 63) {
-            vTaskDelay(1);
+        uint8_t *dst = s_dma_buf[slot];
+        const uint8_t *row = rows + (size_t) r * stride;
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+        it8951_scan_load_row(row, y + r, off, area_bytes);
+#endif
+        const uint8_t *src = row + off;
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+        memcpy(dst, src, area_bytes);
+#else
+        const size_t area_words = area_bytes / 2;
+        for (size_t wi = 0; wi < area_words; wi++) {
+            const uint8_t *sw = src + (area_words - 1 - wi) * 2;
+            dst[wi * 2] = sw[0];
+            dst[wi * 2 + 1] = sw[1];
         }
+#endif
+        trans[slot] = (spi_transaction_t) {.length = area_bytes * 8, .tx_buffer = dst};
+        esp_err_t ret = spi_device_queue_trans(s_spi, &trans[slot], portMAX_DELAY);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "SPI queue row %d failed: %s", y + r, esp_err_to_name(ret));
+            break;
+        }
+        in_flight++;
+    }
+    // Drain before raising CS: the last rows may still be on the wire
+    while (in_flight > 0) {
+        spi_transaction_t *done;
+        spi_device_get_trans_result(s_spi, &done, portMAX_DELAY);
+        in_flight--;
     }
     cs_high();
     spi_device_release_bus(s_spi);
 
     it8951_write_cmd(IT8951_TCON_LD_IMG_END);
+}
 
-    // Anti-ghosting: a full INIT (white) clear resets every pixel before the
-    // image, so high-contrast content (e.g. a QR code) doesn't shadow through.
-    // GC16 alone leaves visible ghosting on this panel, so we accept the extra
-    // clear flash. The image is already loaded, so the prior frame stays up
-    // during the load and only the brief clear precedes the new image.
-    it8951_display_area(0, 0, w, h, IT8951_MODE_INIT);
-    it8951_wait_display_ready();
+static uint16_t it8951_wave_mode(it8951_wave_t wave)
+{
+    switch (wave) {
+    case IT8951_WAVE_GL16:
+        return IT8951_MODE_GL16;
+    case IT8951_WAVE_DU:
+        return IT8951_MODE_DU;
+    case IT8951_WAVE_A2:
+        return IT8951_MODE_A2;
+    default:
+        return IT8951_MODE_GC16;
+    }
+}
+
+// Show the loaded image buffer: only the dirty rectangles when given,
+// otherwise the whole panel
+static void it8951_refresh(const it8951_dirty_t *dirty)
+{
+    const uint16_t w = s_dev.panel_w;
+    const uint16_t h = s_dev.panel_h;
+    it8951_wave_t wave = IT8951_WAVE_FULL;
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+    wave = it8951_mode_select(&s_mode, &s_scan, CONFIG_IT8951_GHOST_BUDGET);
+    s_shadow_valid = s_shadow != NULL;
+#endif
 
-    it8951_display_area(0, 0, w, h, IT8951_MODE_GC16);
+    int64_t t0 = esp_timer_get_time();
+    uint32_t area = (uint32_t) w * h;
+    if (wave == IT8951_WAVE_FULL) {
+        // Anti-ghosting: a full INIT (white) clear resets every pixel before
+        // the image, so high-contrast content (e.g. a QR code) doesn't shadow
+        // through. The image is already loaded, so the prior frame stays up
+        // during the load and only the brief clear precedes the new image.
+        // The panel's memory holds the whole frame even after a partial load.
+        it8951_display_area(0, 0, w, h, IT8951_MODE_INIT);
+        it8951_wait_display_ready();
+        it8951_display_area(0, 0, w, h, IT8951_MODE_GC16);
+    } else if (dirty) {
+        for (int i = 0; i < dirty->count; i++) {
+            const it8951_rect_t *r = &dirty->rects[i];
+            it8951_display_area(it8951_memory_x(r->x, r->w), r->y, r->w, r->h,
+                                it8951_wave_mode(wave));
+        }
+        area = it8951_dirty_area(dirty);
+    } else {
+        it8951_display_area(0, 0, w, h, it8951_wave_mode(wave));
+    }
     it8951_wait_display_ready();
 
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+    ESP_LOGI(TAG, "%s refresh of %lu px took %lld ms (levels 0x%04x, %lu px changed, ghost %u)",
+             it8951_wave_name(wave), (unsigned long) area,
+             (long long) (esp_timer_get_time() - t0) / 1000, s_scan.levels,
+             (unsigned long) s_scan.changed, s_mode.ghost);
+#else
+    ESP_LOGI(TAG, "%s refresh of %lu px took %lld ms", it8951_wave_name(wave),
+             (unsigned long) area, (long long) (esp_timer_get_time() - t0) / 1000);
+#endif
+}
+
+#if CONFIG_IT8951_PARTIAL_REFRESH
+// Whether a tracked set of changes is small enough to refresh on its own
+static bool it8951_dirty_is_partial(const it8951_dirty_t *dirty)
+{
+    uint32_t total = (uint32_t) s_dev.panel_w * s_dev.panel_h;
+    return (uint64_t) it8951_dirty_area(dirty) * 100 <=
+           (uint64_t) total * CONFIG_IT8951_PARTIAL_MAX_PCT;
+}
+
+// Diff a frame against the last refreshed one. Returns the dirty rectangles
+// when they are worth loading on their own, NULL when the whole frame is due.
+static const it8951_dirty_t *it8951_diff_frame(const uint8_t *image)
+{
+    if (!s_shadow || !s_shadow_valid) {
+        return NULL;
+    }
+    const size_t stride = (size_t) s_dev.panel_w / 2;
+    it8951_dirty_begin(&s_dirty, s_dev.panel_w);
+    for (uint16_t y = 0; y < s_dev.panel_h; y++) {
+        it8951_dirty_row(&s_dirty, y, image + y * stride, s_shadow + y * stride, stride);
+    }
+    it8951_dirty_end(&s_dirty);
+    return it8951_dirty_is_partial(&s_dirty) ? &s_dirty : NULL;
+}
+#endif
+
+void epaper_display(uint8_t *image)
+{
+    if (!s_spi || !image || !s_dma_buf[0] || !s_dma_buf[1]) {
+        return;
+    }
+#ifdef CONFIG_PM_ENABLE
+    if (pm_lock) {
+        esp_pm_lock_acquire(pm_lock);
+    }
+#endif
+    const it8951_dirty_t *dirty = NULL;
+#if CONFIG_IT8951_PARTIAL_REFRESH
+    dirty = it8951_diff_frame(image);
+#endif
+    if (dirty && dirty->count == 0) {
+        ESP_LOGI(TAG, "Frame unchanged; refresh skipped");
+    } else {
+        it8951_set_target_memory(s_img_addr);
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+        it8951_scan_start();
+#endif
+        int64_t t0 = esp_timer_get_time();
+        if (dirty) {
+            const size_t stride = (size_t) s_dev.panel_w / 2;
+            for (int i = 0; i < dirty->count; i++) {
+                const it8951_rect_t *r = &dirty->rects[i];
+                it8951_load_area(image + (size_t) r->y * stride, r->x, r->y, r->w, r->h);
+            }
+        } else {
+            it8951_load_area(image, 0, 0, s_dev.panel_w, s_dev.panel_h);
+        }
+        ESP_LOGI(TAG, "Frame push (%d area%s) took %lld ms", dirty ? dirty->count : 1,
+                 dirty && dirty->count != 1 ? "s" : "",
+                 (long long) (esp_timer_get_time() - t0) / 1000);
+        it8951_refresh(dirty);
+    }
+
+#ifdef CONFIG_PM_ENABLE
+    if (pm_lock) {
+        esp_pm_lock_release(pm_lock);
+    }
+#endif
+}
+
+// Streamed updates load each band of rows as its own image area, so nothing
+// is held across the gaps between bands (the SD card stays usable) and rows
+// may arrive at whatever pace the producer manages. With partial refresh the
+// rows are diffed as they load and only the changed areas are refreshed.
+bool epaper_stream_begin(void)
+{
+    if (!s_spi || !s_dma_buf[0] || !s_dma_buf[1]) {
+        return false;
+    }
+#ifdef CONFIG_PM_ENABLE
+    if (pm_lock) {
+        esp_pm_lock_acquire(pm_lock);
+    }
+#endif
+    it8951_set_target_memory(s_img_addr);
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+    it8951_scan_start();
+#endif
+#if CONFIG_IT8951_PARTIAL_REFRESH
+    s_track_dirty = s_shadow && s_shadow_valid;
+    it8951_dirty_begin(&s_dirty, s_dev.panel_w);
+#endif
+    return true;
+}
+
+void epaper_stream_rows(const uint8_t *rows, uint16_t y, uint16_t count)
+{
+    if (y >= s_dev.panel_h) {
+        return;
+    }
+    if (count > s_dev.panel_h - y) {
+        count = s_dev.panel_h - y;
+    }
+    it8951_load_area(rows, 0, y, s_dev.panel_w, count);
+}
+
+void epaper_stream_commit(bool refresh)
+{
+    const it8951_dirty_t *dirty = NULL;
+#if CONFIG_IT8951_PARTIAL_REFRESH
+    if (s_track_dirty) {
+        it8951_dirty_end(&s_dirty);
+        dirty = it8951_dirty_is_partial(&s_dirty) ? &s_dirty : NULL;
+        s_track_dirty = false;
+    }
+#endif
+    if (!refresh) {
+#if CONFIG_IT8951_ADAPTIVE_WAVEFORM
+        // The copy now holds rows the panel never showed
+        s_shadow_valid = false;
+#endif
+    } else if (dirty && dirty->count == 0) {
+        ESP_LOGI(TAG, "Streamed frame unchanged; refresh skipped");
+    } else {
+        it8951_refresh(dirty);
+    }
 #ifdef CONFIG_PM_ENABLE
     if (pm_lock) {
         esp_pm_lock_release(pm_lock);
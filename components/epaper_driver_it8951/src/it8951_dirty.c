@@ -0,0 +1,64 @@
+#include "it8951_dirty.h"
+
+#include <string.h>
+
+void it8951_dirty_begin(it8951_dirty_t *dirty, uint16_t width)
+{
+    memset(dirty, 0, sizeof(*dirty));
+    dirty->width = width;
+}
+
+void it8951_dirty_row(it8951_dirty_t *dirty, uint16_t y, const uint8_t *row, const uint8_t *prev,
+                      size_t bytes)
+{
+    size_t first = 0;
+    while (first < bytes && row[first] == prev[first]) {
+        first++;
+    }
+    if (first == bytes) {
+        return;
+    }
+    size_t last = bytes - 1;
+    while (row[last] == prev[last]) {
+        last--;
+    }
+    uint16_t x0 = (uint16_t) (first * 2);
+    uint16_t x1 = (uint16_t) (last * 2 + 2);
+
+    it8951_rect_t *r = dirty->count > 0 ? &dirty->rects[dirty->count - 1] : NULL;
+    if (r && (y - (r->y + r->h) < IT8951_DIRTY_GAP_ROWS ||
+              dirty->count == IT8951_DIRTY_MAX_RECTS)) {
+        uint16_t rx1 = r->x + r->w;
+        if (x0 < r->x) {
+            r->x = x0;
+        }
+        r->w = (x1 > rx1 ? x1 : rx1) - r->x;
+        r->h = y - r->y + 1;
+        return;
+    }
+    dirty->rects[dirty->count++] = (it8951_rect_t) {.x = x0, .y = y, .w = x1 - x0, .h = 1};
+}
+
+void it8951_dirty_end(it8951_dirty_t *dirty)
+{
+    for (int i = 0; i < dirty->count; i++) {
+        it8951_rect_t *r = &dirty->rects[i];
+        uint32_t x0 = r->x - r->x % IT8951_DIRTY_ALIGN_PX;
+        uint32_t x1 = (uint32_t) r->x + r->w + IT8951_DIRTY_ALIGN_PX - 1;
+        x1 -= x1 % IT8951_DIRTY_ALIGN_PX;
+        if (x1 > dirty->width) {
+            x1 = dirty->width;
+        }
+        r->x = (uint16_t) x0;
+        r->w = (uint16_t) (x1 - x0);
+    }
+}
+
+uint32_t it8951_dirty_area(const it8951_dirty_t *dirty)
+{
+    uint32_t area = 0;
+    for (int i = 0; i < dirty->count; i++) {
+        area += (uint32_t) dirty->rects[i].w * dirty->rects[i].h;
+    }
+    return area;
+}
@@ -0,0 +1,67 @@
+// Dirty-rectangle tracking for IT8951 partial refreshes.
+//
+// Pure logic with no ESP-IDF dependencies (unit-tested on the host): rows of
+// the new frame are compared with the previous frame top to bottom, and runs
+// of changed rows become a few bounding rectangles that the driver loads and
+// refreshes instead of the whole panel.
+
+#ifndef IT8951_DIRTY_H
+#define IT8951_DIRTY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// At most this many rectangles; further changes widen the last one
+#define IT8951_DIRTY_MAX_RECTS 4
+// Changed rows separated by fewer unchanged rows than this share a rectangle
+#define IT8951_DIRTY_GAP_ROWS 32
+// Rectangle x and width are multiples of this many pixels (whole 16-bit
+// words of 4bpp data, as the image load and the word-mirrored rows need)
+#define IT8951_DIRTY_ALIGN_PX 16
+
+// In frame buffer pixels
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} it8951_rect_t;
+
+typedef struct {
+    it8951_rect_t rects[IT8951_DIRTY_MAX_RECTS];
+    int count;
+    uint16_t width;
+} it8951_dirty_t;
+
+/**
+ * @brief Start tracking a frame of the given width in pixels
+ */
+void it8951_dirty_begin(it8951_dirty_t *dirty, uint16_t width);
+
+/**
+ * @brief Compare full packed 4bpp row y of the new frame with the previous one
+ *
+ * Rows must be fed in increasing order.
+ */
+void it8951_dirty_row(it8951_dirty_t *dirty, uint16_t y, const uint8_t *row, const uint8_t *prev,
+                      size_t bytes);
+
+/**
+ * @brief Align the rectangles to IT8951_DIRTY_ALIGN_PX
+ */
+void it8951_dirty_end(it8951_dirty_t *dirty);
+
+/**
+ * @brief Total pixels covered by the rectangles
+ */
+uint32_t it8951_dirty_area(const it8951_dirty_t *dirty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
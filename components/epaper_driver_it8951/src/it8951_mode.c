@@ -0,0 +1,85 @@
+#include "it8951_mode.h"
+
+#include <string.h>
+
+#define IT8951_BILEVEL_LEVELS ((1u << 0) | (1u << 15))
+
+void it8951_scan_begin(it8951_scan_t *scan, bool has_prev)
+{
+    memset(scan, 0, sizeof(*scan));
+    scan->has_prev = has_prev;
+}
+
+void it8951_scan_row(it8951_scan_t *scan, const uint8_t *row, const uint8_t *prev, size_t bytes)
+{
+    uint16_t levels = scan->levels;
+    uint32_t changed = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        uint8_t b = row[i];
+        levels |= (uint16_t) ((1u << (b >> 4)) | (1u << (b & 0x0F)));
+    }
+    if (scan->has_prev && prev) {
+        uint16_t prev_levels = scan->prev_levels;
+        for (size_t i = 0; i < bytes; i++) {
+            uint8_t p = prev[i];
+            uint8_t d = row[i] ^ p;
+            prev_levels |= (uint16_t) ((1u << (p >> 4)) | (1u << (p & 0x0F)));
+            changed += ((d & 0xF0) != 0) + ((d & 0x0F) != 0);
+        }
+        scan->prev_levels = prev_levels;
+    }
+    scan->levels = levels;
+    scan->pixels += (uint32_t) bytes * 2;
+    scan->changed += changed;
+}
+
+it8951_wave_t it8951_mode_select(it8951_mode_state_t *state, const it8951_scan_t *scan,
+                                 uint16_t budget)
+{
+    bool bilevel = (scan->levels & ~IT8951_BILEVEL_LEVELS) == 0;
+    it8951_wave_t wave;
+    uint16_t cost;
+
+    if (!state->known || state->ghost >= budget) {
+        wave = IT8951_WAVE_FULL;
+        cost = 0;
+        state->ghost = 0;
+    } else if (bilevel) {
+        // A2 only drives pixels that start out black or white
+        bool from_bilevel = scan->has_prev
+                                ? (scan->prev_levels & ~IT8951_BILEVEL_LEVELS) == 0
+                                : state->prev_bilevel;
+        wave = from_bilevel ? IT8951_WAVE_A2 : IT8951_WAVE_DU;
+        cost = from_bilevel ? IT8951_GHOST_COST_A2 : IT8951_GHOST_COST_DU;
+    } else if (scan->has_prev &&
+               (uint64_t) scan->changed * 100 <=
+                   (uint64_t) scan->pixels * IT8951_GL16_MAX_CHANGED_PCT) {
+        wave = IT8951_WAVE_GL16;
+        cost = IT8951_GHOST_COST_GL16;
+    } else {
+        wave = IT8951_WAVE_GC16;
+        cost = IT8951_GHOST_COST_GC16;
+    }
+
+    state->ghost += cost;
+    state->known = true;
+    state->prev_bilevel = bilevel;
+    return wave;
+}
+
+const char *it8951_wave_name(it8951_wave_t wave)
+{
+    switch (wave) {
+    case IT8951_WAVE_FULL:
+        return "INIT+GC16";
+    case IT8951_WAVE_GC16:
+        return "GC16";
+    case IT8951_WAVE_GL16:
+        return "GL16";
+    case IT8951_WAVE_DU:
+        return "DU";
+    case IT8951_WAVE_A2:
+        return "A2";
+    }
+    return "?";
+}
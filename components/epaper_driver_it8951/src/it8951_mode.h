@@ -0,0 +1,83 @@
+// Content-aware waveform selection for the IT8951 driver.
+//
+// Pure logic with no ESP-IDF dependencies (unit-tested on the host): the
+// driver feeds every row it loads through it8951_scan_row(), then asks
+// it8951_mode_select() which waveform to refresh with.
+
+#ifndef IT8951_MODE_H
+#define IT8951_MODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    IT8951_WAVE_FULL,  // INIT clear, then GC16: two flashes, clears all ghosting
+    IT8951_WAVE_GC16,  // one flashing 16-level update
+    IT8951_WAVE_GL16,  // non-flashing 16-level update for small changes
+    IT8951_WAVE_DU,    // fast black/white update from any gray level
+    IT8951_WAVE_A2,    // fastest black/white update; both frames bilevel
+} it8951_wave_t;
+
+// Ghosting each waveform leaves behind, charged against the budget
+#define IT8951_GHOST_COST_GC16 3
+#define IT8951_GHOST_COST_GL16 1
+#define IT8951_GHOST_COST_DU 2
+#define IT8951_GHOST_COST_A2 4
+
+// A frame may use GL16 when at most this share of its pixels changed
+#define IT8951_GL16_MAX_CHANGED_PCT 20
+
+// What the rows loaded for one update contain
+typedef struct {
+    uint16_t levels;       // bit n set when gray level n occurs
+    bool has_prev;         // prev_levels and changed are meaningful
+    uint16_t prev_levels;  // the same for the previous frame's scanned rows
+    uint32_t pixels;       // pixels scanned
+    uint32_t changed;      // pixels that differ from the previous frame
+} it8951_scan_t;
+
+// What is known about the panel across updates
+typedef struct {
+    bool known;         // the panel shows a frame this state describes
+    bool prev_bilevel;  // that frame held only black and white
+    uint16_t ghost;     // ghosting cost accumulated since the last full refresh
+} it8951_mode_state_t;
+
+/**
+ * @brief Start scanning a new frame
+ * @param has_prev Whether rows will be compared with the previous frame
+ */
+void it8951_scan_begin(it8951_scan_t *scan, bool has_prev);
+
+/**
+ * @brief Add one packed 4bpp row to the scan
+ * @param prev The same row of the previous frame; ignored unless has_prev
+ */
+void it8951_scan_row(it8951_scan_t *scan, const uint8_t *row, const uint8_t *prev, size_t bytes);
+
+/**
+ * @brief Pick the waveform for a scanned frame and account for it
+ *
+ * A panel in an unknown state or with its ghosting budget spent gets a full
+ * refresh. Otherwise black/white frames use A2 (or DU when the panel still
+ * shows gray levels in the scanned area), frames with few changed pixels use
+ * GL16 and the rest GC16.
+ *
+ * @param budget Ghosting cost allowed between full refreshes; 0 always
+ *               refreshes fully
+ */
+it8951_wave_t it8951_mode_select(it8951_mode_state_t *state, const it8951_scan_t *scan,
+                                 uint16_t budget);
+
+const char *it8951_wave_name(it8951_wave_t wave);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
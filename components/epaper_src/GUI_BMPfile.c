@@ -496,9 +496,19 @@ static UBYTE read_bmp24_mapped(const char *path, UWORD Xstart, UWORD Ystart, GUI
     int height = bmpInfoHeader.biHeight;
     int row_padded = (width * 3 + 3) & (~3);
 
+    // Only the part of each row that fits the display is mapped and painted
+    int paint_width = Xstart < Paint.Width ? Paint.Width - Xstart : 0;
+    if (paint_width > width) {
+        paint_width = width;
+    }
+
     UBYTE *row_data = (UBYTE *) heap_caps_malloc(row_padded, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (!row_data) {
+    UBYTE *index_row = (UBYTE *) heap_caps_malloc(paint_width > 0 ? paint_width : 1,
+                                                  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!row_data || !index_row) {
         ESP_LOGE(TAG, "Failed to allocate row buffer");
+        heap_caps_free(row_data);
+        heap_caps_free(index_row);
         fclose(fp);
         return 1;
     }
@@ -518,21 +528,14 @@ static UBYTE read_bmp24_mapped(const char *path, UWORD Xstart, UWORD Ystart, GUI
             continue;
         }
 
-        for (int x = 0; x < width; x++) {
-            if (Xstart + x >= Paint.Width) {
-                break;
-            }
-
-            int offset = x * 3;
-            uint8_t r = row_data[offset + 2];  // BMP is BGR
-            uint8_t g = row_data[offset + 1];
-            uint8_t b = row_data[offset + 0];
-
-            // Paint pixel directly
-            Paint_SetPixel(Xstart + x, Ystart + display_y, map_rgb(r, g, b));
+        for (int x = 0; x < paint_width; x++) {
+            const UBYTE *p = &row_data[x * 3];
+            index_row[x] = map_rgb(p[2], p[1], p[0]);  // BMP is BGR
         }
+        Paint_BlitSpanIndices(Xstart, Ystart + display_y, index_row, paint_width);
     }
 
+    heap_caps_free(index_row);
     heap_caps_free(row_data);
     fclose(fp);
     ESP_LOGI(TAG, "BMP displayed successfully (stream processing)");
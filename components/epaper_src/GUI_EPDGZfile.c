@@ -1,96 +1,224 @@
 // filename: GUI_EPDGZfile.c
 #include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <zlib.h>
 
+#include "GUI_EPDGZfile.h"
 #include "GUI_Paint.h"
+#include "byte_source.h"
 
 static const char *TAG = "GUI_EPDGZfile";
 
+// Compressed input is read in chunks of this size; the whole file is never
+// held in RAM
+#define EPDGZ_IN_CHUNK 4096
+// Sources held in RAM are handed to zlib in place, up to this much at once
+#define EPDGZ_DIRECT_MAX (64 * 1024)
+
+// zlib allocators backed by PSRAM: the 32 KB inflate window should not come
+// out of internal RAM
+static voidpf epdgz_zalloc(voidpf opaque, uInt items, uInt size)
+{
+    (void) opaque;
+    return heap_caps_malloc((size_t) items * size, MALLOC_CAP_SPIRAM);
+}
+
+static void epdgz_zfree(voidpf opaque, voidpf address)
+{
+    (void) opaque;
+    heap_caps_free(address);
+}
+
+typedef struct {
+    byte_source_t *src;
+    z_stream strm;
+    uint8_t *in;  // input chunk, for sources without a direct pointer
+    bool eof;         // compressed input exhausted
+    bool stream_end;  // gzip member ended
+} epdgz_reader_t;
+
+// Inflate exactly len bytes into out. Returns the number of bytes produced,
+// which is short only when the payload ended early; -1 on corrupt data.
+static long epdgz_inflate(epdgz_reader_t *rd, uint8_t *out, size_t len)
+{
+    rd->strm.next_out = out;
+    rd->strm.avail_out = len;
+    while (rd->strm.avail_out > 0 && !rd->stream_end) {
+        if (rd->strm.avail_in == 0 && !rd->eof) {
+            size_t n;
+            const uint8_t *p = byte_source_next(rd->src, EPDGZ_DIRECT_MAX, &n);
+            if (!p) {
+                n = byte_source_read(rd->src, rd->in, EPDGZ_IN_CHUNK);
+                p = rd->in;
+            }
+            if (n == 0) {
+                rd->eof = true;
+            }
+            rd->strm.next_in = (Bytef *) p;
+            rd->strm.avail_in = n;
+        }
+        int ret = inflate(&rd->strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            rd->stream_end = true;
+        } else if (ret == Z_BUF_ERROR && rd->eof) {
+            ESP_LOGE(TAG, "EPDGZ payload truncated");
+            return -1;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            ESP_LOGE(TAG, "Decompression failed: %d", ret);
+            return -1;
+        }
+    }
+    return (long) (len - rd->strm.avail_out);
+}
+
+// Rotation 0/180 keep logical rows as memory rows; when the horizontal
+// direction also survives, payload rows are frame rows (possibly in flipped
+// order, reported through flip_y) and can be written straight into place
+static bool epdgz_rows_in_place(bool *flip_y)
+{
+    bool flip_x = (Paint.Rotate == ROTATE_180) != ((Paint.Mirror & MIRROR_HORIZONTAL) != 0);
+    *flip_y = (Paint.Rotate == ROTATE_180) != ((Paint.Mirror & MIRROR_VERTICAL) != 0);
+    return (Paint.Rotate == ROTATE_0 || Paint.Rotate == ROTATE_180) && !flip_x &&
+           !Paint.WordMirror && Paint.Width == Paint.WidthMemory &&
+           ((size_t) Paint.Width + 1) / 2 == Paint.WidthByte;
+}
+
+// Inflate a whole frame from src into the Paint target
+static int epdgz_read(byte_source_t *src)
+{
+    epdgz_reader_t reader = {.src = src};
+    epdgz_reader_t *rd = &reader;
+    const int width = Paint.Width;
+    const int height = Paint.Height;
+    const size_t row_bytes = ((size_t) width + 1) / 2;
+
+    bool flip_y;
+    bool in_place = epdgz_rows_in_place(&flip_y);
+
+    bool direct = byte_source_in_place(src);
+    rd->in = !direct ? heap_caps_malloc(EPDGZ_IN_CHUNK, MALLOC_CAP_SPIRAM) : NULL;
+    uint8_t *row = !in_place ? heap_caps_malloc(row_bytes, MALLOC_CAP_SPIRAM) : NULL;
+    if ((!direct && !rd->in) || (!in_place && !row)) {
+        ESP_LOGE(TAG, "Failed to allocate EPDGZ buffers");
+        heap_caps_free(rd->in);
+        heap_caps_free(row);
+        return 1;
+    }
+
+    rd->strm.zalloc = epdgz_zalloc;
+    rd->strm.zfree = epdgz_zfree;
+    // 16 + MAX_WBITS enables gzip decoding
+    if (inflateInit2(&rd->strm, 16 + MAX_WBITS) != Z_OK) {
+        ESP_LOGE(TAG, "inflateInit2 failed");
+        heap_caps_free(rd->in);
+        heap_caps_free(row);
+        return 1;
+    }
+
+    int result = 0;
+    int y = 0;
+    for (; y < height; y++) {
+        long got;
+        if (in_place) {
+            uint8_t *dst = Paint.Image + (size_t) (flip_y ? height - 1 - y : y) * Paint.WidthByte;
+            got = epdgz_inflate(rd, dst, row_bytes);
+        } else {
+            got = epdgz_inflate(rd, row, row_bytes);
+            if (got == (long) row_bytes) {
+                Paint_BlitRow4bpp(0, y, row, width);
+            }
+        }
+
+        if (got < 0) {
+            result = 1;
+            break;
+        }
+        if (got < (long) row_bytes) {
+            // A short payload leaves the remaining rows cleared, as before
+            ESP_LOGW(TAG, "EPDGZ payload ended at row %d of %d", y, height);
+            break;
+        }
+    }
+
+    inflateEnd(&rd->strm);
+    heap_caps_free(rd->in);
+    heap_caps_free(row);
+
+    if (result == 0) {
+        ESP_LOGI(TAG, "EPDGZ: %dx%d streamed (%s)", width, height,
+                 in_place ? "in place" : "row blit");
+    }
+    return result;
+}
+
 /**
  * @brief Read EPDGZ file and display it on the e-paper display
  *
- * Reads a gzip-compressed 4-bit-per-pixel raw e-paper image file,
- * decompresses it, and paints directly to the display buffer using
- * Paint_SetPixel.
+ * Streams a gzip-compressed 4-bit-per-pixel raw e-paper image file through
+ * a small input chunk, inflating logical rows straight into the frame
+ * buffer. When a logical row is a memory row stored left to right (rotation
+ * 0/180 with a matching mirror), it is inflated in place; other layouts go
+ * through a scratch row and Paint_BlitRow4bpp. A file on a RAM filesystem
+ * is inflated straight out of its extents, without reads or an input chunk.
  *
  * @param path Path to the EPDGZ file
  * @return 0 on success, non-zero on error
  */
 int GUI_ReadEPDGZ(const char *path)
 {
-    FILE *fp = fopen(path, "rb");
-    if (!fp) {
+    byte_source_t src;
+    if (byte_source_open_file(&src, path) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to open EPDGZ file: %s", path);
         return 1;
     }
+    int result = epdgz_read(&src);
+    byte_source_close(&src);
+    return result;
+}
 
-    fseek(fp, 0, SEEK_END);
-    long compressed_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    uint8_t *compressed_data = heap_caps_malloc(compressed_size, MALLOC_CAP_SPIRAM);
-    if (!compressed_data) {
-        ESP_LOGE(TAG, "Failed to allocate memory for compressed data");
-        fclose(fp);
-        return 1;
-    }
-    fread(compressed_data, 1, compressed_size, fp);
-    fclose(fp);
-
-    int width = Paint.Width;
-    int height = Paint.Height;
-    int uncompressed_size = (width * height + 1) / 2;
-
-    uint8_t *uncompressed_data = heap_caps_malloc(uncompressed_size, MALLOC_CAP_SPIRAM);
-    if (!uncompressed_data) {
-        ESP_LOGE(TAG, "Failed to allocate memory for decompressed data");
-        heap_caps_free(compressed_data);
-        return 1;
-    }
-
-    z_stream strm = {0};
-    strm.avail_in = compressed_size;
-    strm.next_in = compressed_data;
-    strm.avail_out = uncompressed_size;
-    strm.next_out = uncompressed_data;
+int GUI_ReadEPDGZStream(FILE *fp)
+{
+    byte_source_t src;
+    byte_source_init_stream(&src, fp);
+    int result = epdgz_read(&src);
+    byte_source_close(&src);
+    return result;
+}
 
-    // 16 + MAX_WBITS enables gzip decoding
-    if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) {
-        ESP_LOGE(TAG, "inflateInit2 failed");
-        heap_caps_free(compressed_data);
-        heap_caps_free(uncompressed_data);
-        return 1;
-    }
+int GUI_ReadEPDGZSource(byte_source_t *src)
+{
+    return epdgz_read(src);
+}
 
-    int ret = inflate(&strm, Z_FINISH);
-    inflateEnd(&strm);
-    heap_caps_free(compressed_data);
+int GUI_ReadEPDRows(const uint8_t *rows, size_t length)
+{
+    const int width = Paint.Width;
+    const int height = Paint.Height;
+    const size_t row_bytes = ((size_t) width + 1) / 2;
 
-    if (ret != Z_STREAM_END && ret != Z_OK) {
-        ESP_LOGE(TAG, "Decompression failed: %d", ret);
-        heap_caps_free(uncompressed_data);
+    if (length != row_bytes * height) {
+        ESP_LOGE(TAG, "Packed frame is %u bytes, expected %u", (unsigned) length,
+                 (unsigned) (row_bytes * height));
         return 1;
     }
 
-    ESP_LOGI(TAG, "EPDGZ: %dx%d, compressed %ld -> %d bytes", width, height, compressed_size,
-             uncompressed_size);
-
-    int byteIdx = 0;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x += 2) {
-            uint8_t byte = uncompressed_data[byteIdx++];
-            uint8_t p1 = (byte >> 4) & 0x0F;
-            uint8_t p2 = byte & 0x0F;
-            Paint_SetPixel(x, y, p1);
-            if (x + 1 < width) {
-                Paint_SetPixel(x + 1, y, p2);
+    bool flip_y;
+    if (epdgz_rows_in_place(&flip_y)) {
+        if (!flip_y) {
+            memcpy(Paint.Image, rows, length);
+        } else {
+            for (int y = 0; y < height; y++) {
+                memcpy(Paint.Image + (size_t) (height - 1 - y) * row_bytes, rows + y * row_bytes,
+                       row_bytes);
             }
         }
+    } else {
+        for (int y = 0; y < height; y++) {
+            Paint_BlitRow4bpp(0, y, rows + y * row_bytes, width);
+        }
     }
-
-    ESP_LOGI(TAG, "EPDGZ displayed successfully");
-    heap_caps_free(uncompressed_data);
     return 0;
 }
@@ -2,7 +2,12 @@
 #ifndef __GUI_EPDGZFILE_H
 #define __GUI_EPDGZFILE_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 #include "GUI_Paint.h"
+#include "byte_source.h"
 
 /**
  * @brief Read EPDGZ file and display it on the e-paper display
@@ -16,4 +21,34 @@
  */
 int GUI_ReadEPDGZ(const char *path);
 
+/**
+ * @brief Read an EPDGZ payload starting at fp's current position
+ *
+ * For payloads embedded in a larger file: reading stops at the end of the
+ * gzip member, so trailing bytes are harmless. fp stays open.
+ *
+ * @return 0 on success, non-zero on error
+ */
+int GUI_ReadEPDGZStream(FILE *fp);
+
+/**
+ * @brief Read an EPDGZ payload from a byte source
+ *
+ * Sources held in RAM (memory, MemFS extents) are inflated in place; others
+ * through a small input chunk. Reading stops at the end of the gzip member.
+ *
+ * @return 0 on success, non-zero on error
+ */
+int GUI_ReadEPDGZSource(byte_source_t *src);
+
+/**
+ * @brief Copy an uncompressed EPDGZ payload into the frame
+ *
+ * rows are the logical 4bpp rows an .epdgz inflates to, e.g. mapped
+ * straight from flash; length must cover exactly one frame.
+ *
+ * @return 0 on success, non-zero on error
+ */
+int GUI_ReadEPDRows(const uint8_t *rows, size_t length);
+
 #endif
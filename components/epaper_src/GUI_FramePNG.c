@@ -0,0 +1,195 @@
+// filename: GUI_FramePNG.c
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <png.h>
+#include <string.h>
+
+#include "GUI_FramePNG.h"
+
+static const char *TAG = "GUI_FramePNG";
+
+// Encoded output is collected into pieces of this size before it reaches
+// the writer, so a socket sees a few large sends instead of one per zlib
+// flush
+#define FRAME_PNG_OUT_CHUNK 4096
+
+typedef struct {
+    GUI_PngWriteFn write;
+    void *ctx;
+    UBYTE *buf;
+    size_t fill;
+    bool failed;
+} frame_png_out_t;
+
+static void frame_png_drain(frame_png_out_t *out)
+{
+    if (out->fill > 0 && !out->failed && out->write(out->ctx, out->buf, out->fill) != 0) {
+        out->failed = true;
+    }
+    out->fill = 0;
+}
+
+static void frame_png_write(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    frame_png_out_t *out = (frame_png_out_t *) png_get_io_ptr(png_ptr);
+    while (length > 0) {
+        size_t n = FRAME_PNG_OUT_CHUNK - out->fill;
+        if (n > length) {
+            n = length;
+        }
+        memcpy(out->buf + out->fill, data, n);
+        out->fill += n;
+        data += n;
+        length -= n;
+        if (out->fill == FRAME_PNG_OUT_CHUNK) {
+            frame_png_drain(out);
+        }
+    }
+    if (out->failed) {
+        png_error(png_ptr, "PNG output rejected");
+    }
+}
+
+static void frame_png_flush(png_structp png_ptr)
+{
+    (void) png_ptr;
+}
+
+// Theoretical ink colors by Spectra index (index 4 is reserved)
+static const png_color spectra_colors[7] = {
+    {0, 0, 0},        // Black
+    {255, 255, 255},  // White
+    {255, 255, 0},    // Yellow
+    {255, 0, 0},      // Red
+    {255, 255, 255},  // Reserved
+    {0, 0, 255},      // Blue
+    {0, 255, 0}       // Green
+};
+
+UBYTE *GUI_ReadFrame4bpp(UWORD Shrink, UWORD *Width, UWORD *Height)
+{
+    if (Shrink == 0) {
+        return NULL;
+    }
+
+    const int width = Paint.Width;
+    const int out_w = (width + Shrink - 1) / Shrink;
+    const int out_h = (Paint.Height + Shrink - 1) / Shrink;
+    const size_t out_row_bytes = ((size_t) out_w + 1) / 2;
+
+    UBYTE *rows = heap_caps_malloc(out_row_bytes * out_h, MALLOC_CAP_SPIRAM);
+    UBYTE *row = Shrink > 1 ? heap_caps_malloc(((size_t) width + 1) / 2, MALLOC_CAP_SPIRAM) : NULL;
+    if (!rows || (Shrink > 1 && !row)) {
+        ESP_LOGE(TAG, "Failed to allocate frame copy");
+        heap_caps_free(rows);
+        heap_caps_free(row);
+        return NULL;
+    }
+
+    for (int oy = 0; oy < out_h; oy++) {
+        UBYTE *dst = rows + (size_t) oy * out_row_bytes;
+        if (Shrink == 1) {
+            Paint_ReadRow4bpp(0, oy, dst, width);
+            continue;
+        }
+        Paint_ReadRow4bpp(0, oy * Shrink, row, width);
+        memset(dst, 0, out_row_bytes);
+        for (int ox = 0; ox < out_w; ox++) {
+            int x = ox * Shrink;
+            UBYTE v = (x & 1) ? (row[x / 2] & 0x0F) : (row[x / 2] >> 4);
+            dst[ox / 2] |= (ox & 1) ? v : (UBYTE) (v << 4);
+        }
+    }
+    heap_caps_free(row);
+
+    *Width = (UWORD) out_w;
+    *Height = (UWORD) out_h;
+    return rows;
+}
+
+UBYTE GUI_WritePng4bpp(const UBYTE *Rows, UWORD Width, UWORD Height, bool Grayscale,
+                       GUI_PngWriteFn write, void *ctx)
+{
+    if (!Rows || !write) {
+        return 1;
+    }
+
+    const size_t row_bytes = ((size_t) Width + 1) / 2;
+
+    frame_png_out_t out = {.write = write, .ctx = ctx, .fill = 0, .failed = false};
+    out.buf = heap_caps_malloc(FRAME_PNG_OUT_CHUNK, MALLOC_CAP_SPIRAM);
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info_ptr = png_ptr ? png_create_info_struct(png_ptr) : NULL;
+
+    volatile UBYTE result = 1;
+    if (!out.buf || !info_ptr) {
+        ESP_LOGE(TAG, "Failed to allocate PNG encoder");
+        goto cleanup;
+    }
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        ESP_LOGE(TAG, "PNG encoding failed");
+        goto cleanup;
+    }
+
+    png_set_write_fn(png_ptr, &out, frame_png_write, frame_png_flush);
+    png_set_IHDR(png_ptr, info_ptr, Width, Height, 4, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+    // All 16 entries are defined so any nibble in the frame decodes
+    png_color palette[16];
+    for (int i = 0; i < 16; i++) {
+        if (Grayscale) {
+            palette[i].red = palette[i].green = palette[i].blue = (png_byte) (i * 17);
+        } else {
+            palette[i] = i < 7 ? spectra_colors[i] : spectra_colors[1];
+        }
+    }
+    png_set_PLTE(png_ptr, info_ptr, palette, 16);
+
+    // Dithered rows gain little from filtering, and the fastest zlib level
+    // keeps encoding ahead of the network
+    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+    png_set_compression_level(png_ptr, 1);
+    png_write_info(png_ptr, info_ptr);
+
+    for (int y = 0; y < Height; y++) {
+        png_write_row(png_ptr, (png_const_bytep) (Rows + (size_t) y * row_bytes));
+    }
+    png_write_end(png_ptr, NULL);
+
+    frame_png_drain(&out);
+    result = out.failed ? 1 : 0;
+
+cleanup:
+    if (png_ptr) {
+        png_destroy_write_struct(&png_ptr, info_ptr ? &info_ptr : NULL);
+    }
+    heap_caps_free(out.buf);
+    return result;
+}
+
+static UBYTE frame_png_encode(GUI_PngWriteFn write, void *ctx, UWORD Shrink, bool grayscale)
+{
+    if (!write) {
+        return 1;
+    }
+    UWORD width, height;
+    UBYTE *rows = GUI_ReadFrame4bpp(Shrink, &width, &height);
+    if (!rows) {
+        return 1;
+    }
+    UBYTE result = GUI_WritePng4bpp(rows, width, height, grayscale, write, ctx);
+    heap_caps_free(rows);
+    return result;
+}
+
+UBYTE GUI_WritePng_6Color(GUI_PngWriteFn write, void *ctx, UWORD Shrink)
+{
+    return frame_png_encode(write, ctx, Shrink, false);
+}
+
+UBYTE GUI_WritePng_Gray16(GUI_PngWriteFn write, void *ctx, UWORD Shrink)
+{
+    return frame_png_encode(write, ctx, Shrink, true);
+}
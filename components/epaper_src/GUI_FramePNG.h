@@ -0,0 +1,58 @@
+// filename: GUI_FramePNG.h
+#ifndef __GUI_FRAMEPNG_H
+#define __GUI_FRAMEPNG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "GUI_Paint.h"
+
+/**
+ * Receives encoded PNG bytes in order; a non-zero return aborts encoding.
+ */
+typedef int (*GUI_PngWriteFn)(void *ctx, const UBYTE *data, size_t len);
+
+/**
+ * @brief Encode the Paint frame as a 4-bit indexed PNG (Spectra 6-color)
+ *
+ * Logical rows are read packed with Paint_ReadRow4bpp, which is already the
+ * PNG 4-bit row layout, so the frame is never expanded to RGB. The palette
+ * holds the theoretical ink colors; the reserved index shows as white.
+ *
+ * @param write Output callback, called with pieces of at most 4 KB
+ * @param ctx Passed to write
+ * @param Shrink Keep every Shrink-th pixel in each direction (1 = full size)
+ * @return 0 on success, 1 on error
+ */
+UBYTE GUI_WritePng_6Color(GUI_PngWriteFn write, void *ctx, UWORD Shrink);
+
+/**
+ * @brief Encode the Paint frame as a 4-bit indexed PNG (GC16 grayscale)
+ *
+ * As GUI_WritePng_6Color, with nibble i shown as the gray ramp level i * 17.
+ */
+UBYTE GUI_WritePng_Gray16(GUI_PngWriteFn write, void *ctx, UWORD Shrink);
+
+/**
+ * @brief Copy the Paint frame out as packed 4-bit logical rows
+ *
+ * The two halves of GUI_WritePng_*, for callers that must not hold the
+ * frame for the whole encode: copy while the frame is stable, encode later.
+ * Rows are ((Width + 1) / 2) bytes each, in PSRAM; free with heap_caps_free.
+ *
+ * @param Shrink Keep every Shrink-th pixel in each direction (1 = full size)
+ * @param Width, Height Receive the copy's size
+ * @return the rows, or NULL when out of memory
+ */
+UBYTE *GUI_ReadFrame4bpp(UWORD Shrink, UWORD *Width, UWORD *Height);
+
+/**
+ * @brief Encode rows from GUI_ReadFrame4bpp as a 4-bit indexed PNG
+ *
+ * @param Grayscale Use the GC16 gray ramp instead of the Spectra palette
+ * @return 0 on success, 1 on error
+ */
+UBYTE GUI_WritePng4bpp(const UBYTE *Rows, UWORD Width, UWORD Height, bool Grayscale,
+                       GUI_PngWriteFn write, void *ctx);
+
+#endif
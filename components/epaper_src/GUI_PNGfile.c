@@ -10,33 +10,24 @@
 static const char *TAG = "GUI_PNGfile";
 
 /**
- * @brief Read a PNG file and paint it to the display buffer
+ * @brief Read a PNG stream and paint it to the display buffer
  *
- * Decodes the PNG to RGB888 row by row and paints each pixel through the
- * given RGB -> 4-bit pixel mapper using Paint_SetPixel.
+ * Decodes the PNG starting at fp's position to RGB888 row by row, maps each
+ * pixel through the given RGB -> 4-bit pixel mapper and paints the row with
+ * Paint_BlitSpanIndices. The caller owns fp.
  */
-static UBYTE read_png_mapped(const char *path, UWORD Xstart, UWORD Ystart, GUI_RGBMapFn map_rgb)
+static UBYTE read_png_stream(FILE *fp, UWORD Xstart, UWORD Ystart, GUI_RGBMapFn map_rgb)
 {
-    FILE *fp = NULL;
     png_structp png_ptr = NULL;
     png_infop info_ptr = NULL;
     png_bytep *volatile row_pointers = NULL;
     uint8_t *volatile rgb_buffer = NULL;
-
-    ESP_LOGI(TAG, "Reading PNG: %s", path);
-
-    // Open PNG file
-    fp = fopen(path, "rb");
-    if (!fp) {
-        ESP_LOGE(TAG, "Cannot open PNG file: %s", path);
-        return 1;
-    }
+    UBYTE *volatile index_row = NULL;
 
     // Verify PNG signature
     uint8_t sig[8];
     if (fread(sig, 1, 8, fp) != 8 || png_sig_cmp(sig, 0, 8) != 0) {
         ESP_LOGE(TAG, "Not a valid PNG file");
-        fclose(fp);
         return 1;
     }
 
@@ -44,7 +35,6 @@ static UBYTE read_png_mapped(const char *path, UWORD Xstart, UWORD Ystart, GUI_R
     png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!png_ptr) {
         ESP_LOGE(TAG, "Failed to create PNG read struct");
-        fclose(fp);
         return 1;
     }
 
@@ -53,7 +43,6 @@ static UBYTE read_png_mapped(const char *path, UWORD Xstart, UWORD Ystart, GUI_R
     if (!info_ptr) {
         ESP_LOGE(TAG, "Failed to create PNG info struct");
         png_destroy_read_struct(&png_ptr, NULL, NULL);
-        fclose(fp);
         return 1;
     }
 
@@ -112,48 +101,66 @@ static UBYTE read_png_mapped(const char *path, UWORD Xstart, UWORD Ystart, GUI_R
         goto cleanup;
     }
 
+    // Only the part of each row that fits the display is mapped and painted
+    int paint_width = width < Paint.Width ? width : Paint.Width;
+    index_row =
+        heap_caps_malloc(paint_width > 0 ? paint_width : 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!index_row) {
+        ESP_LOGE(TAG, "Failed to allocate index row (%d bytes)", paint_width);
+        goto cleanup;
+    }
+
     // Process image row by row
     ESP_LOGI(TAG, "PNG decoded successfully");
 
     for (int y = 0; y < height; y++) {
         png_read_row(png_ptr, (png_bytep) rgb_buffer, NULL);
+        if (y >= Paint.Height) {
+            continue;
+        }
 
-        for (int x = 0; x < width; x++) {
-            if (x >= Paint.Width || y >= Paint.Height) {
-                continue;
-            }
-
-            int offset = x * 3;  // 3 bytes per pixel (RGB)
-            uint8_t r = rgb_buffer[offset + 0];
-            uint8_t g = rgb_buffer[offset + 1];
-            uint8_t b = rgb_buffer[offset + 2];
-
-            UBYTE color = map_rgb(r, g, b);
-
-            // Paint pixel directly (Paint rotation system handles coordinate transformations)
-            Paint_SetPixel(Xstart + x, Ystart + y, color);
+        for (int x = 0; x < paint_width; x++) {
+            const uint8_t *p = &rgb_buffer[x * 3];  // 3 bytes per pixel (RGB)
+            index_row[x] = map_rgb(p[0], p[1], p[2]);
         }
+
+        // Paint rotation system handles coordinate transformations
+        Paint_BlitSpanIndices(Xstart, Ystart + y, index_row, paint_width);
     }
 
+    heap_caps_free(index_row);
     heap_caps_free(rgb_buffer);
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    fclose(fp);
 
     ESP_LOGI(TAG, "PNG displayed successfully");
     return 0;
 
 cleanup:
+    if (index_row)
+        heap_caps_free(index_row);
     if (rgb_buffer)
         heap_caps_free(rgb_buffer);
     if (row_pointers)
         free(row_pointers);
     if (png_ptr)
         png_destroy_read_struct(&png_ptr, info_ptr ? &info_ptr : NULL, NULL);
-    if (fp)
-        fclose(fp);
     return 1;
 }
 
+static UBYTE read_png_mapped(const char *path, UWORD Xstart, UWORD Ystart, GUI_RGBMapFn map_rgb)
+{
+    ESP_LOGI(TAG, "Reading PNG: %s", path);
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        ESP_LOGE(TAG, "Cannot open PNG file: %s", path);
+        return 1;
+    }
+    UBYTE result = read_png_stream(fp, Xstart, Ystart, map_rgb);
+    fclose(fp);
+    return result;
+}
+
 UBYTE GUI_ReadPng_RGB_6Color(const char *path, UWORD Xstart, UWORD Ystart)
 {
     return read_png_mapped(path, Xstart, Ystart, GUI_RGBToSpectra6);
@@ -163,3 +170,13 @@ UBYTE GUI_ReadPng_Gray16(const char *path, UWORD Xstart, UWORD Ystart)
 {
     return read_png_mapped(path, Xstart, Ystart, GUI_RGBToGray16);
 }
+
+UBYTE GUI_ReadPngStream_RGB_6Color(FILE *fp, UWORD Xstart, UWORD Ystart)
+{
+    return read_png_stream(fp, Xstart, Ystart, GUI_RGBToSpectra6);
+}
+
+UBYTE GUI_ReadPngStream_Gray16(FILE *fp, UWORD Xstart, UWORD Ystart)
+{
+    return read_png_stream(fp, Xstart, Ystart, GUI_RGBToGray16);
+}
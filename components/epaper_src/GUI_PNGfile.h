@@ -2,6 +2,8 @@
 #ifndef __GUI_PNGFILE_H
 #define __GUI_PNGFILE_H
 
+#include <stdio.h>
+
 #include "GUI_Paint.h"
 
 /**
@@ -28,4 +30,13 @@ UBYTE GUI_ReadPng_RGB_6Color(const char *path, UWORD Xstart, UWORD Ystart);
  */
 UBYTE GUI_ReadPng_Gray16(const char *path, UWORD Xstart, UWORD Ystart);
 
+/**
+ * @brief Stream variants: decode a PNG starting at fp's current position
+ *
+ * For PNGs embedded in a larger file. Decoding stops at the image end, so
+ * bytes after it are never read; fp stays open.
+ */
+UBYTE GUI_ReadPngStream_RGB_6Color(FILE *fp, UWORD Xstart, UWORD Ystart);
+UBYTE GUI_ReadPngStream_Gray16(FILE *fp, UWORD Xstart, UWORD Ystart);
+
 #endif
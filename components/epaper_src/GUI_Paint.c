@@ -114,6 +114,7 @@ void Paint_NewImage(UBYTE* image, UWORD Width, UWORD Height, UWORD Rotate, UWORD
 
     Paint.Rotate = Rotate;
     Paint.Mirror = MIRROR_NONE;
+    Paint.WordMirror = 0;
 
     if (Rotate == ROTATE_0 || Rotate == ROTATE_180) {
         Paint.Width = Width;
@@ -190,6 +191,31 @@ void Paint_SetScale(UBYTE scale)
         ESP_LOGI(TAG, "Scale Only support: 2 4 7 16");
     }
 }
+/******************************************************************************
+function: Store memory rows in reversed 16-bit word order
+parameter:
+    enable : Non-zero to enable
+    Every memory row keeps its groups of four pixels (one 16-bit word) in
+    reverse order while the pixels inside each word stay in place: the
+    layout a controller that scans rows right to left in word units (the
+    IT8951 with an ED103TC2) takes directly. Applied after rotation and
+    mirror. 4-bit scales only; the memory width must be a multiple of 4.
+******************************************************************************/
+void Paint_SetWordMirror(UBYTE enable)
+{
+    if (enable && (Paint.WidthMemory % 4 != 0 || Paint.WidthByte % 2 != 0)) {
+        ESP_LOGI(TAG, "Word mirror needs a memory width that is a multiple of 4");
+        return;
+    }
+    Paint.WordMirror = enable ? 1 : 0;
+}
+
+// Memory X of pixel X under the word mirror
+static inline int Paint_WordMirrorX(int X)
+{
+    return (Paint.WidthByte / 2 - 1 - X / 4) * 4 + X % 4;
+}
+
 /******************************************************************************
 function: Draw Pixels
 parameter:
@@ -246,6 +272,9 @@ void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
         ESP_LOGI(TAG, "Exceeding Memory display boundaries");
         return;
     }
+    if (Paint.WordMirror) {
+        X = Paint_WordMirrorX(X);
+    }
     UDOUBLE Addr = X / 2 + Y * Paint.WidthByte;
     UBYTE Rdata = Paint.Image[Addr];
     Rdata = Rdata & (~(0xF0 >> ((X % 2) * 4)));
@@ -306,10 +335,272 @@ UBYTE Paint_GetPixel(UWORD Xpoint, UWORD Ypoint)
     if (X > Paint.WidthMemory || Y > Paint.HeightMemory) {
         return 0;
     }
+    if (Paint.WordMirror) {
+        X = Paint_WordMirrorX(X);
+    }
     UBYTE Rdata = Paint.Image[X / 2 + Y * Paint.WidthByte];
     return (X % 2 == 0) ? (UBYTE) (Rdata >> 4) : (UBYTE) (Rdata & 0x0F);
 }
 
+/******************************************************************************
+function: Resolve where a horizontal logical span lands in memory
+parameter:
+    Xstart : Logical X of the first pixel
+    Ypoint : Logical Y of the span
+    X, Y   : Memory coordinates of the first pixel
+    dX, dY : Memory step per logical pixel (exactly one is +-1)
+    Returns false for an unsupported rotation or mirror
+******************************************************************************/
+static bool Paint_ResolveSpan(UWORD Xstart, UWORD Ypoint, int* X, int* Y, int* dX, int* dY)
+{
+    switch (Paint.Rotate) {
+    case 0:
+        *X = Xstart;
+        *Y = Ypoint;
+        *dX = 1;
+        *dY = 0;
+        break;
+    case 90:
+        *X = Paint.WidthMemory - Ypoint - 1;
+        *Y = Xstart;
+        *dX = 0;
+        *dY = 1;
+        break;
+    case 180:
+        *X = Paint.WidthMemory - Xstart - 1;
+        *Y = Paint.HeightMemory - Ypoint - 1;
+        *dX = -1;
+        *dY = 0;
+        break;
+    case 270:
+        *X = Ypoint;
+        *Y = Paint.HeightMemory - Xstart - 1;
+        *dX = 0;
+        *dY = -1;
+        break;
+    default:
+        return false;
+    }
+
+    if (Paint.Mirror & ~MIRROR_ORIGIN) {
+        return false;
+    }
+    if (Paint.Mirror & MIRROR_HORIZONTAL) {
+        *X = Paint.WidthMemory - *X - 1;
+        *dX = -*dX;
+    }
+    if (Paint.Mirror & MIRROR_VERTICAL) {
+        *Y = Paint.HeightMemory - *Y - 1;
+        *dY = -*dY;
+    }
+    return true;
+}
+
+// Clip a logical span to the image; returns the number of pixels to write
+static UWORD Paint_ClipSpan(UWORD Xstart, UWORD Ypoint, UWORD Count)
+{
+    if (Ypoint >= Paint.Height || Xstart >= Paint.Width) {
+        return 0;
+    }
+    if (Count > Paint.Width - Xstart) {
+        Count = Paint.Width - Xstart;
+    }
+    return Count;
+}
+
+// Write Count one-per-byte indices starting at memory (X, Y), stepping by
+// (dX, dY). The span has already been resolved and clipped.
+static void Paint_WriteIndices(int X, int Y, int dX, int dY, const UBYTE* Indices, UWORD Count)
+{
+    UBYTE* row = Paint.Image + (UDOUBLE) Y * Paint.WidthByte;
+    UWORD i = 0;
+
+    if (Paint.WordMirror) {
+        if (dY != 0) {
+            X = Paint_WordMirrorX(X);
+        } else {
+            // Runs along a row jump between words: place pixel by pixel
+            for (; i < Count; i++, X += dX) {
+                int MX = Paint_WordMirrorX(X);
+                UBYTE shift = (MX % 2 == 0) ? 4 : 0;
+                UBYTE* p = row + MX / 2;
+                *p = (UBYTE) ((*p & ~(0x0F << shift)) | ((Indices[i] & 0x0F) << shift));
+            }
+            return;
+        }
+    }
+
+    if (dY != 0) {
+        // Column in memory: the nibble position never changes, only the row
+        UBYTE* p = row + X / 2;
+        long stride = (long) dY * Paint.WidthByte;
+        UBYTE shift = (X % 2 == 0) ? 4 : 0;
+        UBYTE keep = (UBYTE) ~(0x0F << shift);
+        for (; i < Count; i++, p += stride) {
+            *p = (UBYTE) ((*p & keep) | ((Indices[i] & 0x0F) << shift));
+        }
+        return;
+    }
+
+    if (dX > 0) {
+        if (X % 2 != 0) {
+            row[X / 2] = (UBYTE) ((row[X / 2] & 0xF0) | (Indices[i++] & 0x0F));
+            X++;
+        }
+        UBYTE* p = row + X / 2;
+        for (; i + 1 < Count; i += 2) {
+            *p++ = (UBYTE) ((Indices[i] << 4) | (Indices[i + 1] & 0x0F));
+        }
+        if (i < Count) {
+            *p = (UBYTE) ((*p & 0x0F) | (Indices[i] << 4));
+        }
+    } else {
+        if (X % 2 == 0) {
+            row[X / 2] = (UBYTE) ((row[X / 2] & 0x0F) | (Indices[i++] << 4));
+            X--;
+        }
+        // X is now odd: each byte takes the next pixel in its low nibble and
+        // the one after it in its high nibble
+        UBYTE* p = row + X / 2;
+        for (; i + 1 < Count; i += 2) {
+            *p-- = (UBYTE) ((Indices[i + 1] << 4) | (Indices[i] & 0x0F));
+        }
+        if (i < Count) {
+            *p = (UBYTE) ((*p & 0xF0) | (Indices[i] & 0x0F));
+        }
+    }
+}
+
+/******************************************************************************
+function: Write a horizontal logical span of color indices
+parameter:
+    Xstart  : Logical X of the first pixel
+    Ypoint  : Logical Y of the span
+    Indices : One 4-bit color per byte
+    Count   : Number of pixels; the span is clipped to the image
+    Equivalent to Paint_SetPixel for each pixel (4-bit scales only), with
+    rotation and mirror resolved once per span and whole bytes written
+    where the span runs along a memory row
+******************************************************************************/
+void Paint_BlitSpanIndices(UWORD Xstart, UWORD Ypoint, const UBYTE* Indices, UWORD Count)
+{
+    int X, Y, dX, dY;
+    Count = Paint_ClipSpan(Xstart, Ypoint, Count);
+    if (Count == 0 || !Paint_ResolveSpan(Xstart, Ypoint, &X, &Y, &dX, &dY)) {
+        return;
+    }
+    Paint_WriteIndices(X, Y, dX, dY, Indices, Count);
+}
+
+/******************************************************************************
+function: Write a horizontal logical span of packed 4bpp pixels
+parameter:
+    Xstart : Logical X of the first pixel
+    Ypoint : Logical Y of the span
+    Packed : Two pixels per byte, high nibble first
+    Count  : Number of pixels; the span is clipped to the image
+    Spans that land byte-aligned on a memory row are copied (or reversed)
+    a byte at a time; anything else is unpacked into Paint_BlitSpanIndices
+******************************************************************************/
+void Paint_BlitRow4bpp(UWORD Xstart, UWORD Ypoint, const UBYTE* Packed, UWORD Count)
+{
+    int X, Y, dX, dY;
+    Count = Paint_ClipSpan(Xstart, Ypoint, Count);
+    if (Count == 0 || !Paint_ResolveSpan(Xstart, Ypoint, &X, &Y, &dX, &dY)) {
+        return;
+    }
+
+    UBYTE* row = Paint.Image + (UDOUBLE) Y * Paint.WidthByte;
+    UWORD pairs = Count / 2;
+    bool linear = dY == 0 && !Paint.WordMirror;
+    if (linear && dX > 0 && X % 2 == 0) {
+        memcpy(row + X / 2, Packed, pairs);
+        if (Count % 2 != 0) {
+            UBYTE* p = row + X / 2 + pairs;
+            *p = (UBYTE) ((*p & 0x0F) | (Packed[pairs] & 0xF0));
+        }
+        return;
+    }
+    if (linear && dX < 0 && X % 2 != 0) {
+        // Reversed row: byte order and the nibbles within each byte flip
+        UBYTE* p = row + X / 2;
+        for (UWORD i = 0; i < pairs; i++, p--) {
+            UBYTE b = Packed[i];
+            *p = (UBYTE) ((b << 4) | (b >> 4));
+        }
+        if (Count % 2 != 0) {
+            *p = (UBYTE) ((*p & 0xF0) | (Packed[pairs] >> 4));
+        }
+        return;
+    }
+
+    // Unaligned or column spans: unpack in chunks and write through the
+    // resolved stepping
+    UBYTE chunk[64];
+    for (UWORD done = 0; done < Count;) {
+        UWORD left = Count - done;
+        UWORD n = (left < sizeof(chunk)) ? left : (UWORD) sizeof(chunk);
+        for (UWORD i = 0; i < n; i++) {
+            UWORD px = done + i;
+            UBYTE b = Packed[px / 2];
+            chunk[i] = (px % 2 == 0) ? (UBYTE) (b >> 4) : (UBYTE) (b & 0x0F);
+        }
+        Paint_WriteIndices(X + dX * done, Y + dY * done, dX, dY, chunk, n);
+        done += n;
+    }
+}
+
+/******************************************************************************
+function: Read a horizontal logical span back as packed 4bpp pixels
+parameter:
+    Xstart : Logical X of the first pixel
+    Ypoint : Logical Y of the span
+    Packed : Receives two pixels per byte, high nibble first; a trailing
+             odd pixel leaves the low nibble zero
+    Count  : Number of pixels; pixels outside the image read as 0
+    The inverse of Paint_BlitRow4bpp, equivalent to Paint_GetPixel per
+    pixel. Does not modify the image, so it may run alongside a panel
+    transfer of the same buffer.
+******************************************************************************/
+void Paint_ReadRow4bpp(UWORD Xstart, UWORD Ypoint, UBYTE* Packed, UWORD Count)
+{
+    int X, Y, dX, dY;
+    UWORD n = Paint_ClipSpan(Xstart, Ypoint, Count);
+    memset(Packed, 0, (Count + 1) / 2);
+    if (n == 0 || !Paint_ResolveSpan(Xstart, Ypoint, &X, &Y, &dX, &dY)) {
+        return;
+    }
+
+    const UBYTE* row = Paint.Image + (UDOUBLE) Y * Paint.WidthByte;
+    UWORD pairs = n / 2;
+    bool linear = dY == 0 && !Paint.WordMirror;
+    if (linear && dX > 0 && X % 2 == 0) {
+        memcpy(Packed, row + X / 2, pairs);
+        if (n % 2 != 0) {
+            Packed[pairs] = row[X / 2 + pairs] & 0xF0;
+        }
+        return;
+    }
+    if (linear && dX < 0 && X % 2 != 0) {
+        const UBYTE* p = row + X / 2;
+        for (UWORD i = 0; i < pairs; i++, p--) {
+            Packed[i] = (UBYTE) ((*p << 4) | (*p >> 4));
+        }
+        if (n % 2 != 0) {
+            Packed[pairs] = (UBYTE) (*p << 4);
+        }
+        return;
+    }
+
+    long step = (long) dY * Paint.WidthByte;
+    for (UWORD i = 0; i < n; i++, X += dX, row += step) {
+        int MX = Paint.WordMirror ? Paint_WordMirrorX(X) : X;
+        UBYTE b = row[MX / 2];
+        UBYTE px = (MX % 2 == 0) ? (UBYTE) (b >> 4) : (UBYTE) (b & 0x0F);
+        Packed[i / 2] |= (i % 2 == 0) ? (UBYTE) (px << 4) : px;
+    }
+}
+
 /******************************************************************************
 function: Clear the color of the picture
 parameter:
@@ -89,6 +89,7 @@ typedef struct {
     UWORD WidthByte;
     UWORD HeightByte;
     UWORD Scale;
+    UBYTE WordMirror;  // memory rows stored in reversed 16-bit word order
 } PAINT;
 extern PAINT Paint;
 
@@ -192,7 +193,11 @@ void Paint_SetRotate(UWORD Rotate);
 void Paint_SetMirroring(UBYTE mirror);
 void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color);
 UBYTE Paint_GetPixel(UWORD Xpoint, UWORD Ypoint);
+void Paint_BlitSpanIndices(UWORD Xstart, UWORD Ypoint, const UBYTE* Indices, UWORD Count);
+void Paint_BlitRow4bpp(UWORD Xstart, UWORD Ypoint, const UBYTE* Packed, UWORD Count);
+void Paint_ReadRow4bpp(UWORD Xstart, UWORD Ypoint, UBYTE* Packed, UWORD Count);
 void Paint_SetScale(UBYTE scale);
+void Paint_SetWordMirror(UBYTE enable);
 
 void Paint_Clear(UWORD Color);
 void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
@@ -17,19 +17,22 @@ static UBYTE display_rgb_buffer_mapped(const uint8_t *rgb_buffer, int width, int
 
     ESP_LOGI(TAG, "Displaying RGB buffer: %dx%d at (%d,%d)", width, height, Xstart, Ystart);
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if ((Xstart + x) >= Paint.Width || (Ystart + y) >= Paint.Height) {
-                continue;
+    // Rows are mapped in stack-sized chunks and painted as spans
+    UBYTE chunk[128];
+    int paint_width = Xstart < Paint.Width ? Paint.Width - Xstart : 0;
+    if (paint_width > width) {
+        paint_width = width;
+    }
+    for (int y = 0; y < height && Ystart + y < Paint.Height; y++) {
+        const uint8_t *row = &rgb_buffer[(size_t) y * width * 3];
+        for (int x0 = 0; x0 < paint_width; x0 += sizeof(chunk)) {
+            int n = paint_width - x0 < (int) sizeof(chunk) ? paint_width - x0 : (int) sizeof(chunk);
+            for (int i = 0; i < n; i++) {
+                const uint8_t *p = &row[(x0 + i) * 3];
+                // The buffer should already be dithered to palette colors
+                chunk[i] = map_rgb(p[0], p[1], p[2]);
             }
-
-            int offset = (y * width + x) * 3;
-            uint8_t r = rgb_buffer[offset + 0];
-            uint8_t g = rgb_buffer[offset + 1];
-            uint8_t b = rgb_buffer[offset + 2];
-
-            // The buffer should already be dithered to palette colors
-            Paint_SetPixel(Xstart + x, Ystart + y, map_rgb(r, g, b));
+            Paint_BlitSpanIndices(Xstart + x0, Ystart + y, chunk, n);
         }
     }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "esp_err.h"
 
@@ -8,12 +9,32 @@
 extern "C" {
 #endif
 
+// Files are stored as fixed-size extents allocated from PSRAM: growing a
+// file never moves or copies what is already written
+#define MEMFS_EXTENT_SIZE (16 * 1024)
+
+/**
+ * @brief In-place view of a RAM file's data
+ *
+ * extents[i] holds MEMFS_EXTENT_SIZE bytes of the file, except the last,
+ * which holds the remainder (see memfs_extent_len).
+ */
+typedef struct {
+    const uint8_t *const *extents;
+    size_t count;
+    size_t size;  // file size in bytes
+    void *file;   // pinned file, for memfs_put_extents
+} memfs_extents_t;
+
 /**
  * @brief Initialize and mount a RAM-based virtual filesystem
  *
+ * Each mount point is a separate filesystem; several can be mounted at once.
+ *
  * @param base_path The mount point (e.g., "/storage")
  * @param max_files Maximum number of files to support
- * @return esp_err_t ESP_OK on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if base_path
+ *         is already mounted
  */
 esp_err_t memfs_mount(const char *base_path, size_t max_files);
 
@@ -26,12 +47,40 @@ esp_err_t memfs_mount(const char *base_path, size_t max_files);
 esp_err_t memfs_unmount(const char *base_path);
 
 /**
- * @brief Get total bytes used by files in the RAM filesystem
+ * @brief Get total bytes used by files in all mounted RAM filesystems
  *
  * @return size_t Total bytes
  */
 size_t memfs_get_total_used(void);
 
+/**
+ * @brief Map a RAM file's data in place, without copying it out
+ *
+ * Pins the file until memfs_put_extents: unlinking, renaming, truncating or
+ * opening it for writing fails with EBUSY meanwhile.
+ *
+ * @param path Full path, including the mount point
+ * @param out Filled in on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if path is not a
+ *         file on a RAM filesystem (read it with stdio instead),
+ *         ESP_ERR_INVALID_STATE if the file is open for writing
+ */
+esp_err_t memfs_get_extents(const char *path, memfs_extents_t *out);
+
+/**
+ * @brief Unpin a file mapped with memfs_get_extents
+ */
+void memfs_put_extents(memfs_extents_t *ext);
+
+/**
+ * @brief Length of extent i of a mapped file
+ */
+static inline size_t memfs_extent_len(const memfs_extents_t *ext, size_t i)
+{
+    size_t start = i * MEMFS_EXTENT_SIZE;
+    return ext->size - start < MEMFS_EXTENT_SIZE ? ext->size - start : MEMFS_EXTENT_SIZE;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,7 @@
 #include "memfs.h"
 
+#include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/errno.h>
 #include <sys/fcntl.h>
@@ -12,11 +14,14 @@
 
 static const char *TAG = "memfs";
 
-typedef struct {
+typedef struct mem_file_s {
     char *name;
-    uint8_t *data;
+    uint8_t **extents;    // MEMFS_EXTENT_SIZE bytes each, in file order
+    size_t extent_count;  // extents allocated
+    size_t extent_slots;  // capacity of the extents table
     size_t size;
-    size_t capacity;
+    int pins;                 // outstanding memfs_get_extents views
+    struct mem_file_s *next;  // hash bucket chain
 } mem_file_t;
 
 typedef struct {
@@ -25,20 +30,156 @@ typedef struct {
     int flags;
 } mem_fd_t;
 
-static mem_file_t **files = NULL;
-static size_t max_files_count = 0;
-static mem_fd_t *fds = NULL;
-static size_t max_fds_count = 0;
+// One mounted instance; the VFS hands it back as the context pointer, so
+// several mounts (e.g. a MemFS fallback for /storage next to a staging
+// mount) stay independent
+typedef struct memfs_s {
+    char *base_path;
+    mem_file_t **buckets;  // name hash -> chain of files
+    size_t bucket_mask;    // bucket count - 1 (a power of two)
+    size_t file_count;
+    size_t max_files_count;
+    mem_fd_t *fds;
+    size_t max_fds_count;
+    struct memfs_s *next;
+} memfs_t;
+
+static memfs_t *mounts = NULL;
+
+// FNV-1a
+static size_t name_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (uint8_t) *name++) * 16777619u;
+    }
+    return hash;
+}
+
+// Link pointing at the file called name, or at the end of its bucket chain
+static mem_file_t **find_link(memfs_t *fs, const char *name)
+{
+    mem_file_t **link = &fs->buckets[name_hash(name) & fs->bucket_mask];
+    while (*link && strcmp((*link)->name, name) != 0) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+static mem_file_t *find_file(memfs_t *fs, const char *name)
+{
+    return *find_link(fs, name);
+}
+
+static bool file_is_open(memfs_t *fs, const mem_file_t *file)
+{
+    for (int i = 0; i < fs->max_fds_count; i++) {
+        if (fs->fds[i].file == file) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool file_is_busy(memfs_t *fs, const mem_file_t *file)
+{
+    return file->pins > 0 || file_is_open(fs, file);
+}
+
+static void free_extents(mem_file_t *file)
+{
+    for (size_t i = 0; i < file->extent_count; i++) {
+        heap_caps_free(file->extents[i]);
+    }
+    free(file->extents);
+    file->extents = NULL;
+    file->extent_count = 0;
+    file->extent_slots = 0;
+    file->size = 0;
+}
+
+static void free_file(mem_file_t *file)
+{
+    free_extents(file);
+    free(file->name);
+    free(file);
+}
+
+// Unlink file from its bucket chain and free it
+static void remove_file(memfs_t *fs, mem_file_t *file)
+{
+    mem_file_t **link = find_link(fs, file->name);
+    *link = file->next;
+    fs->file_count--;
+    free_file(file);
+}
+
+// Allocate extents until the file can hold end bytes
+static bool reserve_extents(mem_file_t *file, size_t end)
+{
+    size_t needed = (end + MEMFS_EXTENT_SIZE - 1) / MEMFS_EXTENT_SIZE;
+    if (needed > file->extent_slots) {
+        size_t slots = file->extent_slots ? file->extent_slots * 2 : 4;
+        while (slots < needed) {
+            slots *= 2;
+        }
+        uint8_t **table = realloc(file->extents, slots * sizeof(uint8_t *));
+        if (!table) {
+            return false;
+        }
+        file->extents = table;
+        file->extent_slots = slots;
+    }
+    while (file->extent_count < needed) {
+        uint8_t *extent = heap_caps_malloc(MEMFS_EXTENT_SIZE, MALLOC_CAP_SPIRAM);
+        if (!extent) {
+            return false;
+        }
+        file->extents[file->extent_count++] = extent;
+    }
+    return true;
+}
+
+// Copy len bytes into the file at offset; src NULL writes zeros
+static void copy_in(mem_file_t *file, size_t offset, const uint8_t *src, size_t len)
+{
+    while (len > 0) {
+        size_t pos = offset % MEMFS_EXTENT_SIZE;
+        size_t n = MEMFS_EXTENT_SIZE - pos < len ? MEMFS_EXTENT_SIZE - pos : len;
+        uint8_t *dst = file->extents[offset / MEMFS_EXTENT_SIZE] + pos;
+        if (src) {
+            memcpy(dst, src, n);
+            src += n;
+        } else {
+            memset(dst, 0, n);
+        }
+        offset += n;
+        len -= n;
+    }
+}
+
+static void copy_out(const mem_file_t *file, size_t offset, uint8_t *dst, size_t len)
+{
+    while (len > 0) {
+        size_t pos = offset % MEMFS_EXTENT_SIZE;
+        size_t n = MEMFS_EXTENT_SIZE - pos < len ? MEMFS_EXTENT_SIZE - pos : len;
+        memcpy(dst, file->extents[offset / MEMFS_EXTENT_SIZE] + pos, n);
+        dst += n;
+        offset += n;
+        len -= n;
+    }
+}
 
 static int memfs_open_vfs(void *ctx, const char *path, int flags, int mode)
 {
+    memfs_t *fs = (memfs_t *) ctx;
     // Skip leading slash
     if (path[0] == '/')
         path++;
 
     int fd = -1;
-    for (int i = 0; i < max_fds_count; i++) {
-        if (fds[i].file == NULL) {
+    for (int i = 0; i < fs->max_fds_count; i++) {
+        if (fs->fds[i].file == NULL) {
             fd = i;
             break;
         }
@@ -49,21 +190,21 @@ static int memfs_open_vfs(void *ctx, const char *path, int flags, int mode)
         return -1;
     }
 
-    mem_file_t *file = NULL;
-    for (int i = 0; i < max_files_count; i++) {
-        if (files[i] && strcmp(files[i]->name, path) == 0) {
-            file = files[i];
-            break;
-        }
-    }
+    mem_file_t **link = find_link(fs, path);
+    mem_file_t *file = *link;
 
     if (file) {
         if ((flags & O_CREAT) && (flags & O_EXCL)) {
             errno = EEXIST;
             return -1;
         }
+        // Mapped data must not change under the reader
+        if (file->pins > 0 && (flags & O_ACCMODE) != O_RDONLY) {
+            errno = EBUSY;
+            return -1;
+        }
         if (flags & O_TRUNC) {
-            file->size = 0;
+            free_extents(file);
         }
     } else {
         if (!(flags & O_CREAT)) {
@@ -71,15 +212,7 @@ static int memfs_open_vfs(void *ctx, const char *path, int flags, int mode)
             return -1;
         }
 
-        int file_idx = -1;
-        for (int i = 0; i < max_files_count; i++) {
-            if (files[i] == NULL) {
-                file_idx = i;
-                break;
-            }
-        }
-
-        if (file_idx == -1) {
+        if (fs->file_count >= fs->max_files_count) {
             errno = ENOSPC;
             return -1;
         }
@@ -90,41 +223,46 @@ static int memfs_open_vfs(void *ctx, const char *path, int flags, int mode)
             return -1;
         }
         file->name = strdup(path);
-        files[file_idx] = file;
+        if (!file->name) {
+            free(file);
+            errno = ENOMEM;
+            return -1;
+        }
+        *link = file;
+        fs->file_count++;
     }
 
-    fds[fd].file = file;
-    fds[fd].offset = (flags & O_APPEND) ? file->size : 0;
-    fds[fd].flags = flags;
+    fs->fds[fd].file = file;
+    fs->fds[fd].offset = (flags & O_APPEND) ? file->size : 0;
+    fs->fds[fd].flags = flags;
 
     return fd;
 }
 
 static ssize_t memfs_write_vfs(void *ctx, int fd, const void *data, size_t size)
 {
-    if (fd < 0 || fd >= max_fds_count || fds[fd].file == NULL) {
+    memfs_t *fs = (memfs_t *) ctx;
+    if (fd < 0 || fd >= fs->max_fds_count || fs->fds[fd].file == NULL) {
         errno = EBADF;
         return -1;
     }
 
-    mem_file_t *file = fds[fd].file;
-    size_t offset = fds[fd].offset;
+    mem_file_t *file = fs->fds[fd].file;
+    size_t offset = fs->fds[fd].offset;
 
-    if (offset + size > file->capacity) {
-        size_t new_capacity = (offset + size + 4095) & ~4095;
-        uint8_t *new_data = heap_caps_realloc(file->data, new_capacity, MALLOC_CAP_SPIRAM);
-        if (!new_data) {
-            errno = ENOMEM;
-            return -1;
-        }
-        file->data = new_data;
-        file->capacity = new_capacity;
+    if (!reserve_extents(file, offset + size)) {
+        errno = ENOMEM;
+        return -1;
     }
 
-    memcpy(file->data + offset, data, size);
-    fds[fd].offset += size;
-    if (fds[fd].offset > file->size) {
-        file->size = fds[fd].offset;
+    // A write past the end (after a seek) leaves a hole that reads as zeros
+    if (offset > file->size) {
+        copy_in(file, file->size, NULL, offset - file->size);
+    }
+    copy_in(file, offset, (const uint8_t *) data, size);
+    fs->fds[fd].offset += size;
+    if (fs->fds[fd].offset > file->size) {
+        file->size = fs->fds[fd].offset;
     }
 
     return size;
@@ -132,13 +270,14 @@ static ssize_t memfs_write_vfs(void *ctx, int fd, const void *data, size_t size)
 
 static ssize_t memfs_read_vfs(void *ctx, int fd, void *dst, size_t size)
 {
-    if (fd < 0 || fd >= max_fds_count || fds[fd].file == NULL) {
+    memfs_t *fs = (memfs_t *) ctx;
+    if (fd < 0 || fd >= fs->max_fds_count || fs->fds[fd].file == NULL) {
         errno = EBADF;
         return -1;
     }
 
-    mem_file_t *file = fds[fd].file;
-    size_t offset = fds[fd].offset;
+    mem_file_t *file = fs->fds[fd].file;
+    size_t offset = fs->fds[fd].offset;
 
     if (offset >= file->size) {
         return 0;
@@ -147,20 +286,21 @@ static ssize_t memfs_read_vfs(void *ctx, int fd, void *dst, size_t size)
     size_t available = file->size - offset;
     size_t to_read = (size < available) ? size : available;
 
-    memcpy(dst, file->data + offset, to_read);
-    fds[fd].offset += to_read;
+    copy_out(file, offset, (uint8_t *) dst, to_read);
+    fs->fds[fd].offset += to_read;
 
     return to_read;
 }
 
 static off_t memfs_lseek_vfs(void *ctx, int fd, off_t offset, int mode)
 {
-    if (fd < 0 || fd >= max_fds_count || fds[fd].file == NULL) {
+    memfs_t *fs = (memfs_t *) ctx;
+    if (fd < 0 || fd >= fs->max_fds_count || fs->fds[fd].file == NULL) {
         errno = EBADF;
         return -1;
     }
 
-    mem_file_t *file = fds[fd].file;
+    mem_file_t *file = fs->fds[fd].file;
     size_t new_offset = 0;
 
     switch (mode) {
@@ -168,7 +308,7 @@ static off_t memfs_lseek_vfs(void *ctx, int fd, off_t offset, int mode)
         new_offset = offset;
         break;
     case SEEK_CUR:
-        new_offset = fds[fd].offset + offset;
+        new_offset = fs->fds[fd].offset + offset;
         break;
     case SEEK_END:
         new_offset = file->size + offset;
@@ -178,29 +318,31 @@ static off_t memfs_lseek_vfs(void *ctx, int fd, off_t offset, int mode)
         return -1;
     }
 
-    fds[fd].offset = new_offset;
+    fs->fds[fd].offset = new_offset;
     return new_offset;
 }
 
 static int memfs_close_vfs(void *ctx, int fd)
 {
-    if (fd < 0 || fd >= max_fds_count || fds[fd].file == NULL) {
+    memfs_t *fs = (memfs_t *) ctx;
+    if (fd < 0 || fd >= fs->max_fds_count || fs->fds[fd].file == NULL) {
         errno = EBADF;
         return -1;
     }
 
-    fds[fd].file = NULL;
+    fs->fds[fd].file = NULL;
     return 0;
 }
 
 static int memfs_fstat_vfs(void *ctx, int fd, struct stat *st)
 {
-    if (fd < 0 || fd >= max_fds_count || fds[fd].file == NULL) {
+    memfs_t *fs = (memfs_t *) ctx;
+    if (fd < 0 || fd >= fs->max_fds_count || fs->fds[fd].file == NULL) {
         errno = EBADF;
         return -1;
     }
 
-    mem_file_t *file = fds[fd].file;
+    mem_file_t *file = fs->fds[fd].file;
     memset(st, 0, sizeof(*st));
     st->st_size = file->size;
     st->st_mode = S_IFREG | 0666;
@@ -209,93 +351,72 @@ static int memfs_fstat_vfs(void *ctx, int fd, struct stat *st)
 
 static int memfs_stat_vfs(void *ctx, const char *path, struct stat *st)
 {
+    memfs_t *fs = (memfs_t *) ctx;
     if (path[0] == '/')
         path++;
 
-    for (int i = 0; i < max_files_count; i++) {
-        if (files[i] && strcmp(files[i]->name, path) == 0) {
-            memset(st, 0, sizeof(*st));
-            st->st_size = files[i]->size;
-            st->st_mode = S_IFREG | 0666;
-            return 0;
-        }
+    mem_file_t *file = find_file(fs, path);
+    if (!file) {
+        errno = ENOENT;
+        return -1;
     }
 
-    errno = ENOENT;
-    return -1;
+    memset(st, 0, sizeof(*st));
+    st->st_size = file->size;
+    st->st_mode = S_IFREG | 0666;
+    return 0;
 }
+
 static int memfs_unlink_vfs(void *ctx, const char *path)
 {
+    memfs_t *fs = (memfs_t *) ctx;
     if (path[0] == '/')
         path++;
 
-    for (int i = 0; i < max_files_count; i++) {
-        if (files[i] && strcmp(files[i]->name, path) == 0) {
-            // Check if any FD is open for this file
-            for (int j = 0; j < max_fds_count; j++) {
-                if (fds[j].file == files[i]) {
-                    errno = EBUSY;
-                    return -1;
-                }
-            }
+    mem_file_t *file = find_file(fs, path);
+    if (!file) {
+        errno = ENOENT;
+        return -1;
+    }
 
-            free(files[i]->name);
-            if (files[i]->data)
-                heap_caps_free(files[i]->data);
-            free(files[i]);
-            files[i] = NULL;
-            return 0;
-        }
+    // Open or mapped files stay
+    if (file_is_busy(fs, file)) {
+        errno = EBUSY;
+        return -1;
     }
 
-    errno = ENOENT;
-    return -1;
+    remove_file(fs, file);
+    return 0;
 }
 
 static int memfs_rename_vfs(void *ctx, const char *src, const char *dst)
 {
+    memfs_t *fs = (memfs_t *) ctx;
     if (src[0] == '/')
         src++;
     if (dst[0] == '/')
         dst++;
 
-    mem_file_t *src_file = NULL;
-    for (int i = 0; i < max_files_count; i++) {
-        if (files[i] && strcmp(files[i]->name, src) == 0) {
-            src_file = files[i];
-            break;
-        }
-    }
-
+    mem_file_t *src_file = find_file(fs, src);
     if (!src_file) {
         errno = ENOENT;
         return -1;
     }
 
-    // Check if src is open
-    for (int j = 0; j < max_fds_count; j++) {
-        if (fds[j].file == src_file) {
-            errno = EBUSY;
-            return -1;
-        }
+    if (file_is_busy(fs, src_file)) {
+        errno = EBUSY;
+        return -1;
     }
 
     // If destination exists, unlink it
-    for (int i = 0; i < max_files_count; i++) {
-        if (files[i] && strcmp(files[i]->name, dst) == 0) {
-            // Check if dst is open
-            for (int j = 0; j < max_fds_count; j++) {
-                if (fds[j].file == files[i]) {
-                    errno = EBUSY;
-                    return -1;
-                }
-            }
-            free(files[i]->name);
-            if (files[i]->data)
-                heap_caps_free(files[i]->data);
-            free(files[i]);
-            files[i] = NULL;
-            break;
+    mem_file_t *dst_file = find_file(fs, dst);
+    if (dst_file == src_file) {
+        return 0;
+    }
+    if (dst_file) {
+        if (file_is_busy(fs, dst_file)) {
+            errno = EBUSY;
+            return -1;
         }
     }
 
@@ -305,22 +426,66 @@ static int memfs_rename_vfs(void *ctx, const char *src, const char *dst)
         return -1;
     }
 
+    if (dst_file) {
+        remove_file(fs, dst_file);
+    }
+
+    // Rehash under the new name
+    mem_file_t **link = find_link(fs, src_file->name);
+    *link = src_file->next;
     free(src_file->name);
     src_file->name = new_name;
+    link = find_link(fs, new_name);
+    src_file->next = NULL;
+    *link = src_file;
 
     return 0;
 }
 
-esp_err_t memfs_mount(const char *base_path, size_t max_files)
+static void free_mount(memfs_t *fs)
 {
-    if (files)
-        return ESP_ERR_INVALID_STATE;
+    if (fs->buckets) {
+        for (size_t i = 0; i <= fs->bucket_mask; i++) {
+            while (fs->buckets[i]) {
+                mem_file_t *file = fs->buckets[i];
+                fs->buckets[i] = file->next;
+                free_file(file);
+            }
+        }
+    }
+    free(fs->buckets);
+    free(fs->fds);
+    free(fs->base_path);
+    free(fs);
+}
 
-    max_files_count = max_files;
-    files = (mem_file_t **) calloc(max_files_count, sizeof(mem_file_t *));
+esp_err_t memfs_mount(const char *base_path, size_t max_files)
+{
+    for (memfs_t *m = mounts; m; m = m->next) {
+        if (strcmp(m->base_path, base_path) == 0) {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
 
-    max_fds_count = max_files * 2;
-    fds = (mem_fd_t *) calloc(max_fds_count, sizeof(mem_fd_t));
+    memfs_t *fs = (memfs_t *) calloc(1, sizeof(memfs_t));
+    if (!fs) {
+        return ESP_ERR_NO_MEM;
+    }
+    // About one file per bucket when full
+    size_t buckets = 8;
+    while (buckets < max_files) {
+        buckets *= 2;
+    }
+    fs->base_path = strdup(base_path);
+    fs->max_files_count = max_files;
+    fs->buckets = (mem_file_t **) calloc(buckets, sizeof(mem_file_t *));
+    fs->bucket_mask = buckets - 1;
+    fs->max_fds_count = max_files * 2;
+    fs->fds = (mem_fd_t *) calloc(fs->max_fds_count, sizeof(mem_fd_t));
+    if (!fs->base_path || !fs->buckets || !fs->fds) {
+        free_mount(fs);
+        return ESP_ERR_NO_MEM;
+    }
 
     esp_vfs_t vfs = {
         .flags = ESP_VFS_FLAG_CONTEXT_PTR,
@@ -335,28 +500,33 @@ esp_err_t memfs_mount(const char *base_path, size_t max_files)
         .rename_p = &memfs_rename_vfs,
     };
 
-    ESP_ERROR_CHECK(esp_vfs_register(base_path, &vfs, NULL));
+    esp_err_t err = esp_vfs_register(base_path, &vfs, fs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register RAM filesystem at %s", base_path);
+        free_mount(fs);
+        return err;
+    }
+    fs->next = mounts;
+    mounts = fs;
     ESP_LOGI(TAG, "Mounted RAM filesystem at %s", base_path);
     return ESP_OK;
 }
 
 esp_err_t memfs_unmount(const char *base_path)
 {
+    memfs_t **link = &mounts;
+    while (*link && strcmp((*link)->base_path, base_path) != 0) {
+        link = &(*link)->next;
+    }
+    memfs_t *fs = *link;
+    if (!fs) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *link = fs->next;
+
     // Simplified: unregister and free all
     esp_vfs_unregister(base_path);
-
-    for (int i = 0; i < max_files_count; i++) {
-        if (files[i]) {
-            free(files[i]->name);
-            if (files[i]->data)
-                heap_caps_free(files[i]->data);
-            free(files[i]);
-        }
-    }
-    free(files);
-    files = NULL;
-    free(fds);
-    fds = NULL;
+    free_mount(fs);
 
     return ESP_OK;
 }
@@ -364,11 +534,48 @@ esp_err_t memfs_unmount(const char *base_path)
 size_t memfs_get_total_used(void)
 {
     size_t total = 0;
-    if (files) {
-        for (int i = 0; i < max_files_count; i++) {
-            if (files[i])
-                total += files[i]->capacity;
+    for (memfs_t *fs = mounts; fs; fs = fs->next) {
+        for (size_t i = 0; i <= fs->bucket_mask; i++) {
+            for (mem_file_t *file = fs->buckets[i]; file; file = file->next) {
+                total += file->extent_count * MEMFS_EXTENT_SIZE;
+            }
         }
     }
     return total;
 }
+
+esp_err_t memfs_get_extents(const char *path, memfs_extents_t *out)
+{
+    for (memfs_t *fs = mounts; fs; fs = fs->next) {
+        size_t len = strlen(fs->base_path);
+        if (strncmp(path, fs->base_path, len) != 0 || path[len] != '/') {
+            continue;
+        }
+
+        mem_file_t *file = find_file(fs, path + len + 1);
+        if (!file) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        for (int i = 0; i < fs->max_fds_count; i++) {
+            if (fs->fds[i].file == file && (fs->fds[i].flags & O_ACCMODE) != O_RDONLY) {
+                return ESP_ERR_INVALID_STATE;
+            }
+        }
+
+        file->pins++;
+        out->extents = (const uint8_t *const *) file->extents;
+        out->count = (file->size + MEMFS_EXTENT_SIZE - 1) / MEMFS_EXTENT_SIZE;
+        out->size = file->size;
+        out->file = file;
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+void memfs_put_extents(memfs_extents_t *ext)
+{
+    if (ext->file) {
+        ((mem_file_t *) ext->file)->pins--;
+        ext->file = NULL;
+    }
+}
@@ -17,6 +17,9 @@ extern const char *test_board_display_type;  // "spectra6" or "gc16"
 #define BOARD_HAL_DISPLAY_HEIGHT test_board_display_height
 #define BOARD_HAL_DISPLAY_TYPE test_board_display_type
 
+// Defined by the tests that need it
+bool board_hal_is_usb_connected(void);
+
 #ifdef __cplusplus
 }
 #endif
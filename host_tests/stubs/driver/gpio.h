@@ -1,5 +1,45 @@
-// Host-test stub for driver/gpio.h — config.h includes it but the tested
-// code touches no GPIO symbols.
+// Host-test stub for driver/gpio.h. config.h only needs gpio_num_t; the
+// panel-driver tests link fake_spi_panel.c, which implements the functions
+// below against a simulated pin bank.
 #pragma once
 
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef int gpio_num_t;
+
+typedef enum {
+    GPIO_MODE_DISABLE = 0,
+    GPIO_MODE_INPUT,
+    GPIO_MODE_OUTPUT,
+} gpio_mode_t;
+
+#define GPIO_PULLUP_DISABLE 0
+#define GPIO_PULLUP_ENABLE 1
+#define GPIO_PULLDOWN_DISABLE 0
+#define GPIO_PULLDOWN_ENABLE 1
+#define GPIO_INTR_DISABLE 0
+
+typedef struct {
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    int pull_up_en;
+    int pull_down_en;
+    int intr_type;
+} gpio_config_t;
+
+esp_err_t gpio_config(const gpio_config_t *cfg);
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level);
+int gpio_get_level(gpio_num_t pin);
+esp_err_t gpio_hold_en(gpio_num_t pin);
+esp_err_t gpio_hold_dis(gpio_num_t pin);
+void gpio_deep_sleep_hold_en(void);
+
+#ifdef __cplusplus
+}
+#endif
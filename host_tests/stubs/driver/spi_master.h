@@ -0,0 +1,70 @@
+// Host-test stub for driver/spi_master.h: the subset the panel drivers use,
+// implemented by the transaction-level simulator in fake_spi_panel.c.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+// The IDF header reaches the task API (vTaskDelay) transitively
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int spi_host_device_t;
+typedef struct fake_spi_device *spi_device_handle_t;
+
+#define SPI_DEVICE_HALFDUPLEX (1u << 4)
+#define SPI_DEVICE_NO_DUMMY (1u << 6)
+#define SPI_TRANS_VARIABLE_CMD (1u << 5)
+
+typedef struct {
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;    // bits
+    size_t rxlength;  // bits
+    void *user;
+    const void *tx_buffer;
+    void *rx_buffer;
+} spi_transaction_t;
+
+typedef struct {
+    spi_transaction_t base;
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+} spi_transaction_ext_t;
+
+typedef struct {
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    int clock_speed_hz;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+} spi_device_interface_config_t;
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg,
+                             spi_device_handle_t *handle);
+esp_err_t spi_bus_get_max_transaction_len(spi_host_device_t host, size_t *max_bytes);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans,
+                                 TickType_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans,
+                                      TickType_t ticks_to_wait);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+esp_err_t spi_device_polling_start(spi_device_handle_t handle, spi_transaction_t *trans,
+                                   TickType_t ticks_to_wait);
+esp_err_t spi_device_polling_end(spi_device_handle_t handle, TickType_t ticks_to_wait);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait);
+void spi_device_release_bus(spi_device_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
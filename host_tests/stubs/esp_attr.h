@@ -0,0 +1,6 @@
+// Host-test stub for esp_attr.h
+#pragma once
+
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
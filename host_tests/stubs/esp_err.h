@@ -22,6 +22,13 @@ typedef int esp_err_t;
 
 const char *esp_err_to_name(esp_err_t code);
 
+#define ESP_ERROR_CHECK(x)       \
+    do {                         \
+        esp_err_t err_rc_ = (x); \
+        (void) err_rc_;          \
+    } while (0)
+#define ESP_ERROR_CHECK_WITHOUT_ABORT(x) (x)
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,18 +33,51 @@ esp_err_t color_palette_load(color_palette_t *palette)
     return ESP_OK;
 }
 
+// JPEG bitstreams are not decoded on host. A test may register the RGB888
+// frame every "JPEG" decodes to; scaled decodes box-average it the way a
+// DC-only 1/8 decode averages each 8x8 block. Unregistered, decoding fails
+// so PNG paths stay testable.
+const uint8_t *test_jpeg_rgb = NULL;
+int test_jpeg_width = 0;
+int test_jpeg_height = 0;
+int test_jpeg_decode_count[4];  // per esp_jpeg_image_scale_t
+
 esp_err_t esp_jpeg_get_image_info(esp_jpeg_image_cfg_t *cfg, esp_jpeg_image_output_t *img)
 {
-    (void) cfg;
-    img->width = 0;
-    img->height = 0;
-    img->output_len = 0;
-    return ESP_FAIL;
+    if (!test_jpeg_rgb) {
+        img->width = 0;
+        img->height = 0;
+        img->output_len = 0;
+        return ESP_FAIL;
+    }
+    int div = 1 << cfg->out_scale;
+    img->width = test_jpeg_width / div;
+    img->height = test_jpeg_height / div;
+    img->output_len = (size_t) img->width * img->height * 3;
+    return ESP_OK;
 }
 
 esp_err_t esp_jpeg_decode(esp_jpeg_image_cfg_t *cfg, esp_jpeg_image_output_t *img)
 {
-    (void) cfg;
-    (void) img;
-    return ESP_FAIL;
+    if (esp_jpeg_get_image_info(cfg, img) != ESP_OK || cfg->outbuf_size < img->output_len) {
+        return ESP_FAIL;
+    }
+    test_jpeg_decode_count[cfg->out_scale]++;
+    int div = 1 << cfg->out_scale;
+    for (int y = 0; y < img->height; y++) {
+        for (int x = 0; x < img->width; x++) {
+            for (int c = 0; c < 3; c++) {
+                int sum = 0;
+                for (int by = 0; by < div; by++)
+                    for (int bx = 0; bx < div; bx++)
+                        sum += test_jpeg_rgb[((size_t) (y * div + by) * test_jpeg_width +
+                                              x * div + bx) *
+                                                 3 +
+                                             c];
+                cfg->outbuf[((size_t) y * img->width + x) * 3 + c] =
+                    (uint8_t) ((sum + div * div / 2) / (div * div));
+            }
+        }
+    }
+    return ESP_OK;
 }
@@ -0,0 +1,16 @@
+// Host-test stub for esp_timer.h. The panel-driver tests get the simulated
+// clock of fake_spi_panel.c, so driver timing logs and deadlines follow the
+// modelled bus time.
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+// Host-test stub for esp_vfs.h: the context-pointer entry points MemFS
+// registers, captured by fake_vfs.c
+#pragma once
+
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_VFS_FLAG_CONTEXT_PTR 1
+
+typedef struct {
+    int flags;
+    int (*open_p)(void *ctx, const char *path, int flags, int mode);
+    ssize_t (*write_p)(void *ctx, int fd, const void *data, size_t size);
+    ssize_t (*read_p)(void *ctx, int fd, void *dst, size_t size);
+    off_t (*lseek_p)(void *ctx, int fd, off_t offset, int mode);
+    int (*close_p)(void *ctx, int fd);
+    int (*fstat_p)(void *ctx, int fd, struct stat *st);
+    int (*stat_p)(void *ctx, const char *path, struct stat *st);
+    int (*unlink_p)(void *ctx, const char *path);
+    int (*rename_p)(void *ctx, const char *src, const char *dst);
+} esp_vfs_t;
+
+esp_err_t esp_vfs_register(const char *base_path, const esp_vfs_t *vfs, void *ctx);
+esp_err_t esp_vfs_unregister(const char *base_path);
+
+#ifdef __cplusplus
+}
+#endif
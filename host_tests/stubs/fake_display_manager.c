@@ -15,6 +15,9 @@ static int frame_h = 0;
 static bool streaming = false;
 static bool shown = false;
 static int begin_count = 0;
+static int column_push_count = 0;
+static int tile_push_count = 0;
+static int patch_count = 0;
 static char pub_display_name[512];
 static char pub_save_path[512];
 static char pub_fallback_name[512];
@@ -28,6 +31,9 @@ void fake_display_reset(void)
     streaming = false;
     shown = false;
     begin_count = 0;
+    column_push_count = 0;
+    tile_push_count = 0;
+    patch_count = 0;
     pub_display_name[0] = '\0';
     pub_save_path[0] = '\0';
     pub_fallback_name[0] = '\0';
@@ -58,6 +64,21 @@ int fake_display_begin_count(void)
     return begin_count;
 }
 
+int fake_display_column_push_count(void)
+{
+    return column_push_count;
+}
+
+int fake_display_tile_push_count(void)
+{
+    return tile_push_count;
+}
+
+int fake_display_patch_count(void)
+{
+    return patch_count;
+}
+
 const char *fake_display_pub_display_name(void)
 {
     return pub_display_name;
@@ -105,6 +126,19 @@ esp_err_t display_manager_push_rgb_column(int x, const uint8_t *rgb_col, int hei
         return ESP_ERR_INVALID_ARG;
     for (int y = 0; y < height; y++)
         memcpy(frame + ((size_t) y * frame_w + x) * 3, rgb_col + (size_t) y * 3, 3);
+    column_push_count++;
+    return ESP_OK;
+}
+
+esp_err_t display_manager_push_rgb_columns(int x0, int count, const uint8_t *const *cols,
+                                           int height)
+{
+    if (!streaming || !cols || count <= 0 || x0 < 0 || x0 + count > frame_w || height != frame_h)
+        return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < count; i++)
+        for (int y = 0; y < height; y++)
+            memcpy(frame + ((size_t) y * frame_w + x0 + i) * 3, cols[i] + (size_t) y * 3, 3);
+    tile_push_count++;
     return ESP_OK;
 }
 
@@ -122,3 +156,48 @@ esp_err_t display_manager_end_rgb_stream(bool show, const display_publish_t *pub
              pub && pub->fallback_name ? pub->fallback_name : "");
     return ESP_OK;
 }
+
+esp_err_t display_manager_begin_patch(void)
+{
+    if (streaming)
+        return ESP_ERR_INVALID_STATE;
+    // Like the real one: patches start from the frame on display, and fail
+    // when there is none to recover
+    if (!frame)
+        return ESP_ERR_INVALID_STATE;
+    streaming = true;
+    shown = false;
+    patch_count++;
+    return ESP_OK;
+}
+
+esp_err_t display_manager_patch_row(int x, int y, const uint8_t *rgb, int n)
+{
+    if (!streaming || x < 0 || y < 0 || y >= frame_h || x + n > frame_w)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(frame + ((size_t) y * frame_w + x) * 3, rgb, (size_t) n * 3);
+    return ESP_OK;
+}
+
+esp_err_t display_manager_patch_column(int x, int y, const uint8_t *rgb, int n)
+{
+    if (!streaming || x < 0 || x >= frame_w || y < 0 || y + n > frame_h)
+        return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < n; i++)
+        memcpy(frame + ((size_t) (y + i) * frame_w + x) * 3, rgb + (size_t) i * 3, 3);
+    return ESP_OK;
+}
+
+esp_err_t display_manager_patch_columns(int x0, int y, int count, const uint8_t *const *cols,
+                                        int n)
+{
+    if (!streaming || !cols || count <= 0 || x0 < 0 || x0 + count > frame_w || y < 0 ||
+        y + n > frame_h)
+        return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < count; i++)
+        for (int j = 0; j < n; j++)
+            memcpy(frame + ((size_t) (y + j) * frame_w + x0 + i) * 3, cols[i] + (size_t) j * 3,
+                   3);
+    tile_push_count++;
+    return ESP_OK;
+}
@@ -20,6 +20,11 @@ int fake_display_frame_height(void);
 const uint8_t *fake_display_frame(void);  // RGB888, frame_width*frame_height*3
 bool fake_display_was_shown(void);        // end_rgb_stream(show=true) seen
 int fake_display_begin_count(void);
+// Single-column and column-tile pushes seen since the last reset
+int fake_display_column_push_count(void);
+int fake_display_tile_push_count(void);
+// display_manager_begin_patch calls since the last reset
+int fake_display_patch_count(void);
 
 // Copies of the publish spec passed to end_rgb_stream ("" when absent)
 const char *fake_display_pub_display_name(void);
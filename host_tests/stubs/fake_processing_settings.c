@@ -1,11 +1,12 @@
 // Fake processing settings for host tests — only what image_processor.c
-// links; both knobs are test-controllable globals.
+// links; every knob is a test-controllable global.
 #include <stdio.h>
 
 #include "processing_settings.h"
 
 scale_mode_t test_scale_mode = SCALE_MODE_COVER;
 const char *test_background_color = "white";
+bool test_auto_levels = false;
 
 scale_mode_t processing_settings_get_scale_mode(void)
 {
@@ -16,3 +17,8 @@ void processing_settings_get_background_color(char *out, size_t out_size)
 {
     snprintf(out, out_size, "%s", test_background_color);
 }
+
+bool processing_settings_get_auto_levels(void)
+{
+    return test_auto_levels;
+}
@@ -0,0 +1,689 @@
+// Transaction-level SPI/GPIO simulator for the panel-driver host tests; see
+// fake_spi_panel.h.
+#include "fake_spi_panel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#define FAKE_GPIO_PINS 64
+#define FAKE_SPI_MAX_DEVICES 4
+#define FAKE_SPI_MAX_PANELS 4
+#define FAKE_SPI_QUEUE_MAX 16
+#define FAKE_IT8951_ARGS 8
+#define FAKE_IT8951_REGS 32
+#define FAKE_IT8951_RESP 64
+
+// IT8951 protocol (mirrors driver_it8951.c)
+#define IT8951_PRE_CMD 0x6000
+#define IT8951_PRE_WR_DATA 0x0000
+#define IT8951_PRE_RD_DATA 0x1000
+#define IT8951_TCON_REG_RD 0x0010
+#define IT8951_TCON_REG_WR 0x0011
+#define IT8951_TCON_LD_IMG_AREA 0x0021
+#define IT8951_TCON_LD_IMG_END 0x0022
+#define IT8951_CMD_DPY_AREA 0x0034
+#define IT8951_CMD_VCOM 0x0039
+#define IT8951_CMD_GET_DEV_INFO 0x0302
+#define IT8951_IMG_ADDR 0x001236E0
+
+struct fake_spi_device {
+    int clock_hz;
+    int queue_size;
+    spi_transaction_t *queue[FAKE_SPI_QUEUE_MAX];
+    int64_t done_ns[FAKE_SPI_QUEUE_MAX];
+    int head;
+    int count;
+    bool polling;  // polling_start without polling_end
+};
+
+struct fake_ed2208 {
+    int pin_cs;
+    int pin_dc;
+    bool in_dtm;
+    uint8_t *dtm;
+    size_t cap;
+    size_t len;
+    uint32_t refreshes;
+    uint32_t commands;
+};
+
+typedef struct {
+    fake_it8951_area_t *v;
+    int n;
+    int cap;
+} fake_area_list_t;
+
+struct fake_it8951 {
+    int pin_cs;
+    uint16_t width;
+    uint16_t height;
+    uint8_t *mem;
+    // Current CS window
+    bool have_preamble;
+    uint16_t preamble;
+    bool have_half;
+    uint8_t half;
+    // Current command
+    uint16_t cmd;
+    uint16_t args[FAKE_IT8951_ARGS];
+    int nargs;
+    bool loading;
+    fake_it8951_area_t area;
+    size_t load_pos;
+    // Pending read response, dummy word included
+    uint8_t resp[FAKE_IT8951_RESP];
+    size_t resp_len;
+    size_t resp_pos;
+    uint16_t reg_addr[FAKE_IT8951_REGS];
+    uint16_t reg_val[FAKE_IT8951_REGS];
+    int nregs;
+    uint16_t vcom;
+    fake_area_list_t loads;
+    fake_area_list_t displays;
+};
+
+static fake_spi_model_t s_model = FAKE_SPI_MODEL_DEFAULT;
+static int64_t s_now_ns;
+static int64_t s_bus_free_ns;
+static int s_level[FAKE_GPIO_PINS];
+static fake_spi_stats_t s_stats;
+static char s_violation[160];
+static struct fake_spi_device s_devices[FAKE_SPI_MAX_DEVICES];
+static int s_device_count;
+static fake_ed2208_t *s_ed2208[FAKE_SPI_MAX_PANELS];
+static int s_ed2208_count;
+static fake_it8951_t *s_it8951[FAKE_SPI_MAX_PANELS];
+static int s_it8951_count;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+static void fake_violation(const char *what)
+{
+    s_stats.violations++;
+    snprintf(s_violation, sizeof(s_violation), "%s", what);
+    fprintf(stderr, "fake_spi: %s\n", what);
+}
+
+static int fake_level(int pin)
+{
+    return (pin >= 0 && pin < FAKE_GPIO_PINS) ? s_level[pin] : 1;
+}
+
+static int64_t fake_max(int64_t a, int64_t b)
+{
+    return a > b ? a : b;
+}
+
+static bool fake_queued_pending(void)
+{
+    for (int i = 0; i < s_device_count; i++) {
+        if (s_devices[i].count > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---- Simulator control ----
+
+void fake_spi_reset(const fake_spi_model_t *model)
+{
+    fake_spi_model_t def = FAKE_SPI_MODEL_DEFAULT;
+    s_model = model ? *model : def;
+    s_now_ns = 0;
+    s_bus_free_ns = 0;
+    for (int i = 0; i < FAKE_GPIO_PINS; i++) {
+        s_level[i] = 1;
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_violation[0] = '\0';
+    memset(s_devices, 0, sizeof(s_devices));
+    s_device_count = 0;
+    for (int i = 0; i < s_ed2208_count; i++) {
+        free(s_ed2208[i]->dtm);
+        free(s_ed2208[i]);
+    }
+    s_ed2208_count = 0;
+    for (int i = 0; i < s_it8951_count; i++) {
+        free(s_it8951[i]->mem);
+        free(s_it8951[i]->loads.v);
+        free(s_it8951[i]->displays.v);
+        free(s_it8951[i]);
+    }
+    s_it8951_count = 0;
+}
+
+fake_spi_stats_t fake_spi_stats(void)
+{
+    return s_stats;
+}
+
+void fake_spi_clear_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_violation[0] = '\0';
+}
+
+const char *fake_spi_last_violation(void)
+{
+    return s_violation;
+}
+
+int64_t fake_spi_now_us(void)
+{
+    return s_now_ns / 1000;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return fake_spi_now_us();
+}
+
+void fake_gpio_set_input(int pin, int level)
+{
+    if (pin >= 0 && pin < FAKE_GPIO_PINS) {
+        s_level[pin] = level;
+    }
+}
+
+// ---- ED2208 ----
+
+fake_ed2208_t *fake_ed2208_attach(int pin_cs, int pin_dc, size_t dtm_capacity)
+{
+    if (s_ed2208_count == FAKE_SPI_MAX_PANELS) {
+        return NULL;
+    }
+    fake_ed2208_t *c = calloc(1, sizeof(*c));
+    c->pin_cs = pin_cs;
+    c->pin_dc = pin_dc;
+    c->dtm = calloc(1, dtm_capacity);
+    c->cap = dtm_capacity;
+    s_ed2208[s_ed2208_count++] = c;
+    return c;
+}
+
+const uint8_t *fake_ed2208_dtm(const fake_ed2208_t *ctl, size_t *len)
+{
+    *len = ctl->len;
+    return ctl->dtm;
+}
+
+uint32_t fake_ed2208_refreshes(const fake_ed2208_t *ctl)
+{
+    return ctl->refreshes;
+}
+
+uint32_t fake_ed2208_commands(const fake_ed2208_t *ctl)
+{
+    return ctl->commands;
+}
+
+static void fake_ed2208_rx(fake_ed2208_t *c, uint8_t b)
+{
+    if (fake_level(c->pin_dc) == 0) {
+        c->commands++;
+        c->in_dtm = b == 0x10;
+        if (c->in_dtm) {
+            c->len = 0;
+        }
+        if (b == 0x12) {
+            c->refreshes++;
+        }
+    } else if (c->in_dtm) {
+        if (c->len < c->cap) {
+            c->dtm[c->len++] = b;
+        } else {
+            fake_violation("ED2208 DTM data past the frame size");
+        }
+    }
+}
+
+// ---- IT8951 ----
+
+static void fake_area_push(fake_area_list_t *l, fake_it8951_area_t a)
+{
+    if (l->n == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 16;
+        l->v = realloc(l->v, (size_t) l->cap * sizeof(*l->v));
+    }
+    l->v[l->n++] = a;
+}
+
+fake_it8951_t *fake_it8951_attach(int pin_cs, uint16_t width, uint16_t height)
+{
+    if (s_it8951_count == FAKE_SPI_MAX_PANELS) {
+        return NULL;
+    }
+    fake_it8951_t *c = calloc(1, sizeof(*c));
+    c->pin_cs = pin_cs;
+    c->width = width;
+    c->height = height;
+    c->mem = calloc(1, (size_t) width * height / 2);
+    c->vcom = 1500;
+    s_it8951[s_it8951_count++] = c;
+    return c;
+}
+
+const uint8_t *fake_it8951_memory(const fake_it8951_t *ctl)
+{
+    return ctl->mem;
+}
+
+int fake_it8951_load_count(const fake_it8951_t *ctl)
+{
+    return ctl->loads.n;
+}
+
+const fake_it8951_area_t *fake_it8951_load(const fake_it8951_t *ctl, int i)
+{
+    return &ctl->loads.v[i];
+}
+
+int fake_it8951_display_count(const fake_it8951_t *ctl)
+{
+    return ctl->displays.n;
+}
+
+const fake_it8951_area_t *fake_it8951_display(const fake_it8951_t *ctl, int i)
+{
+    return &ctl->displays.v[i];
+}
+
+uint16_t fake_it8951_reg(const fake_it8951_t *ctl, uint16_t reg)
+{
+    for (int i = 0; i < ctl->nregs; i++) {
+        if (ctl->reg_addr[i] == reg) {
+            return ctl->reg_val[i];
+        }
+    }
+    return 0;  // LUTAFSR reads 0: the display engine is always idle
+}
+
+static void fake_it8951_set_reg(fake_it8951_t *c, uint16_t reg, uint16_t val)
+{
+    for (int i = 0; i < c->nregs; i++) {
+        if (c->reg_addr[i] == reg) {
+            c->reg_val[i] = val;
+            return;
+        }
+    }
+    if (c->nregs < FAKE_IT8951_REGS) {
+        c->reg_addr[c->nregs] = reg;
+        c->reg_val[c->nregs++] = val;
+    }
+}
+
+static void fake_it8951_respond(fake_it8951_t *c, const uint16_t *words, size_t n)
+{
+    c->resp_len = 2;  // dummy word
+    c->resp[0] = c->resp[1] = 0;
+    for (size_t i = 0; i < n && c->resp_len + 2 <= FAKE_IT8951_RESP; i++) {
+        c->resp[c->resp_len++] = (uint8_t) (words[i] >> 8);
+        c->resp[c->resp_len++] = (uint8_t) words[i];
+    }
+    c->resp_pos = 0;
+}
+
+static void fake_it8951_command(fake_it8951_t *c, uint16_t cmd)
+{
+    c->cmd = cmd;
+    c->nargs = 0;
+    if (cmd == IT8951_TCON_LD_IMG_END) {
+        c->loading = false;
+    } else if (cmd == IT8951_CMD_GET_DEV_INFO) {
+        uint16_t info[20] = {c->width, c->height, IT8951_IMG_ADDR & 0xFFFF, IT8951_IMG_ADDR >> 16};
+        fake_it8951_respond(c, info, 20);
+    }
+}
+
+static void fake_it8951_arg(fake_it8951_t *c, uint16_t w)
+{
+    if (c->nargs == FAKE_IT8951_ARGS) {
+        fake_violation("IT8951 too many command arguments");
+        return;
+    }
+    const uint16_t *a = c->args;
+    c->args[c->nargs++] = w;
+    switch (c->cmd) {
+    case IT8951_TCON_REG_WR:
+        if (c->nargs == 2) {
+            fake_it8951_set_reg(c, a[0], a[1]);
+        }
+        break;
+    case IT8951_TCON_REG_RD:
+        if (c->nargs == 1) {
+            uint16_t v = fake_it8951_reg(c, a[0]);
+            fake_it8951_respond(c, &v, 1);
+        }
+        break;
+    case IT8951_TCON_LD_IMG_AREA:
+        if (c->nargs == 5) {
+            c->area = (fake_it8951_area_t) {
+                .x = a[1], .y = a[2], .w = a[3], .h = a[4], .mode = a[0]};
+            fake_area_push(&c->loads, c->area);
+            c->loading = true;
+            c->load_pos = 0;
+        }
+        break;
+    case IT8951_CMD_DPY_AREA:
+        if (c->nargs == 5) {
+            fake_it8951_area_t d = {.x = a[0], .y = a[1], .w = a[2], .h = a[3], .mode = a[4]};
+            if (d.x + d.w > c->width || d.y + d.h > c->height) {
+                fake_violation("IT8951 display area outside the panel");
+            }
+            fake_area_push(&c->displays, d);
+        }
+        break;
+    case IT8951_CMD_VCOM:
+        if (c->nargs == 1 && a[0] == 0) {
+            fake_it8951_respond(c, &c->vcom, 1);
+        } else if (c->nargs == 2 && a[0] == 1) {
+            c->vcom = a[1];
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void fake_it8951_pixel(fake_it8951_t *c, uint8_t b)
+{
+    size_t row_bytes = c->area.w / 2;
+    size_t r = row_bytes ? c->load_pos / row_bytes : 0;
+    size_t col = row_bytes ? c->load_pos % row_bytes : 0;
+    c->load_pos++;
+    if (!row_bytes || c->area.y + r >= c->height || c->area.x / 2 + col >= c->width / 2u ||
+        r >= c->area.h) {
+        fake_violation("IT8951 image data outside the load area");
+        return;
+    }
+    c->mem[(c->area.y + r) * (c->width / 2) + c->area.x / 2 + col] = b;
+}
+
+static uint8_t fake_it8951_rx(fake_it8951_t *c, uint8_t b)
+{
+    if (c->have_preamble && c->preamble == IT8951_PRE_WR_DATA && c->loading) {
+        fake_it8951_pixel(c, b);
+        return 0;
+    }
+    if (c->have_preamble && c->preamble == IT8951_PRE_RD_DATA) {
+        return c->resp_pos < c->resp_len ? c->resp[c->resp_pos++] : 0;
+    }
+    if (!c->have_half) {
+        c->half = b;
+        c->have_half = true;
+        return 0;
+    }
+    uint16_t w = (uint16_t) ((c->half << 8) | b);
+    c->have_half = false;
+    if (!c->have_preamble) {
+        c->preamble = w;
+        c->have_preamble = true;
+    } else if (c->preamble == IT8951_PRE_CMD) {
+        fake_it8951_command(c, w);
+    } else if (c->preamble == IT8951_PRE_WR_DATA) {
+        fake_it8951_arg(c, w);
+    }
+    return 0;
+}
+
+// One byte on the wire: every selected controller sees MOSI, the selected
+// IT8951 (if any) drives MISO
+static uint8_t fake_spi_shift(uint8_t mosi)
+{
+    uint8_t miso = 0;
+    for (int i = 0; i < s_ed2208_count; i++) {
+        if (fake_level(s_ed2208[i]->pin_cs) == 0) {
+            fake_ed2208_rx(s_ed2208[i], mosi);
+        }
+    }
+    for (int i = 0; i < s_it8951_count; i++) {
+        if (fake_level(s_it8951[i]->pin_cs) == 0) {
+            miso |= fake_it8951_rx(s_it8951[i], mosi);
+        }
+    }
+    return miso;
+}
+
+// ---- GPIO ----
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    (void) cfg;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    if (pin < 0 || pin >= FAKE_GPIO_PINS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int old = s_level[pin];
+    int now = level ? 1 : 0;
+    s_level[pin] = now;
+    if (old == now) {
+        return ESP_OK;
+    }
+
+    bool framing = false;
+    for (int i = 0; i < s_ed2208_count; i++) {
+        if (s_ed2208[i]->pin_cs == pin) {
+            framing = true;
+            s_stats.cs_windows += now == 0;
+        }
+        if (s_ed2208[i]->pin_dc == pin) {
+            framing = true;
+            s_stats.dc_toggles++;
+        }
+    }
+    for (int i = 0; i < s_it8951_count; i++) {
+        fake_it8951_t *c = s_it8951[i];
+        if (c->pin_cs == pin) {
+            framing = true;
+            if (now == 0) {
+                s_stats.cs_windows++;
+                c->have_preamble = false;
+                c->have_half = false;
+            }
+        }
+    }
+    if (framing && fake_queued_pending()) {
+        fake_violation("CS/DC changed while queued transactions were unfinished");
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    return fake_level(pin);
+}
+
+esp_err_t gpio_hold_en(gpio_num_t pin)
+{
+    (void) pin;
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_dis(gpio_num_t pin)
+{
+    (void) pin;
+    return ESP_OK;
+}
+
+void gpio_deep_sleep_hold_en(void) {}
+
+// ---- SPI master ----
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg,
+                             spi_device_handle_t *handle)
+{
+    (void) host;
+    if (s_device_count == FAKE_SPI_MAX_DEVICES) {
+        return ESP_ERR_NO_MEM;
+    }
+    struct fake_spi_device *dev = &s_devices[s_device_count++];
+    memset(dev, 0, sizeof(*dev));
+    dev->clock_hz = cfg->clock_speed_hz > 0 ? cfg->clock_speed_hz : 1000000;
+    dev->queue_size = cfg->queue_size < FAKE_SPI_QUEUE_MAX ? cfg->queue_size : FAKE_SPI_QUEUE_MAX;
+    *handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_get_max_transaction_len(spi_host_device_t host, size_t *max_bytes)
+{
+    (void) host;
+    *max_bytes = s_model.max_transfer_bytes;
+    return ESP_OK;
+}
+
+// Deliver a transaction's bytes and return its wire time
+static esp_err_t fake_spi_exchange(struct fake_spi_device *dev, spi_transaction_t *t,
+                                   int64_t *wire_ns)
+{
+    size_t cmd_bits = 0;
+    if (t->flags & SPI_TRANS_VARIABLE_CMD) {
+        cmd_bits = ((spi_transaction_ext_t *) t)->command_bits;
+    }
+    size_t bits = t->length ? t->length : t->rxlength;
+    size_t bytes = bits / 8;
+    if (bytes > s_model.max_transfer_bytes) {
+        fake_violation("transaction longer than the bus max_transfer_sz");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_stats.transactions++;
+    s_stats.bytes += bytes + cmd_bits / 8;
+    if (bytes > s_stats.max_transaction_bytes) {
+        s_stats.max_transaction_bytes = bytes;
+    }
+
+    if (cmd_bits) {
+        fake_spi_shift((uint8_t) t->cmd);
+    }
+    const uint8_t *tx = t->tx_buffer;
+    uint8_t *rx = t->rx_buffer;
+    for (size_t i = 0; i < bytes; i++) {
+        uint8_t miso = fake_spi_shift(tx ? tx[i] : 0);
+        if (rx) {
+            rx[i] = miso;
+        }
+    }
+    *wire_ns = (int64_t) (bits + cmd_bits) * 1000000000LL / dev->clock_hz;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t dev, spi_transaction_t *trans,
+                                 TickType_t ticks_to_wait)
+{
+    (void) ticks_to_wait;
+    if (dev->polling) {
+        fake_violation("queued transaction during a polling transaction");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (dev->count >= dev->queue_size) {
+        // Nothing would ever reap the queue: the real call blocks forever
+        fake_violation("queue_trans beyond the device queue_size");
+        return ESP_ERR_TIMEOUT;
+    }
+    int64_t wire_ns;
+    esp_err_t ret = fake_spi_exchange(dev, trans, &wire_ns);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_stats.queued++;
+    // The CPU pays the setup; the wire runs on after the previous transfer
+    s_now_ns += s_model.queued_overhead_ns;
+    s_bus_free_ns = fake_max(s_now_ns, s_bus_free_ns) + wire_ns;
+    int slot = (dev->head + dev->count) % FAKE_SPI_QUEUE_MAX;
+    dev->queue[slot] = trans;
+    dev->done_ns[slot] = s_bus_free_ns;
+    dev->count++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t dev, spi_transaction_t **trans,
+                                      TickType_t ticks_to_wait)
+{
+    (void) ticks_to_wait;
+    if (dev->count == 0) {
+        fake_violation("get_trans_result with nothing queued");
+        return ESP_ERR_TIMEOUT;
+    }
+    *trans = dev->queue[dev->head];
+    s_now_ns = fake_max(s_now_ns, dev->done_ns[dev->head]);
+    dev->head = (dev->head + 1) % FAKE_SPI_QUEUE_MAX;
+    dev->count--;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t dev, spi_transaction_t *trans)
+{
+    if (dev->count > 0) {
+        fake_violation("transmit with queued transactions unfinished");
+    }
+    esp_err_t ret = spi_device_queue_trans(dev, trans, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    spi_transaction_t *done;
+    return spi_device_get_trans_result(dev, &done, portMAX_DELAY);
+}
+
+esp_err_t spi_device_polling_start(spi_device_handle_t dev, spi_transaction_t *trans,
+                                   TickType_t ticks_to_wait)
+{
+    (void) ticks_to_wait;
+    if (dev->count > 0 || dev->polling) {
+        fake_violation("polling transaction with another transaction unfinished");
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t wire_ns;
+    esp_err_t ret = fake_spi_exchange(dev, trans, &wire_ns);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_stats.polling++;
+    s_now_ns = fake_max(s_now_ns + s_model.polling_overhead_ns, s_bus_free_ns) + wire_ns;
+    s_bus_free_ns = s_now_ns;
+    dev->polling = true;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_end(spi_device_handle_t dev, TickType_t ticks_to_wait)
+{
+    (void) ticks_to_wait;
+    dev->polling = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t dev, spi_transaction_t *trans)
+{
+    esp_err_t ret = spi_device_polling_start(dev, trans, portMAX_DELAY);
+    if (ret == ESP_OK) {
+        ret = spi_device_polling_end(dev, portMAX_DELAY);
+    }
+    return ret;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t dev, TickType_t wait)
+{
+    (void) dev;
+    (void) wait;
+    s_stats.acquisitions++;
+    s_now_ns += s_model.acquire_overhead_ns;
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t dev)
+{
+    (void) dev;
+}
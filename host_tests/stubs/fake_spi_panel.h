@@ -0,0 +1,92 @@
+// Test-side view of the SPI/GPIO panel simulator that stands in for the
+// ESP-IDF SPI master and GPIO drivers in the panel-driver tests.
+//
+// Every transaction is recorded and its bytes are delivered to the simulated
+// controllers whose chip select is low: an ED2208 (Spectra 6) controller
+// decodes DC-framed commands and captures the DTM pixel stream, an IT8951
+// decodes its 16-bit preamble protocol into a panel memory image and answers
+// register/info reads. A clock and per-transaction overhead model advances a
+// simulated clock, which esp_timer_get_time() reports, so a test can estimate
+// the transfer time of a driver path.
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cost model. Wire time comes from each device's clock_speed_hz; the
+// overheads are rough ESP32-S3 figures for driver entry, setup and ISR work.
+typedef struct {
+    uint32_t queued_overhead_ns;   // spi_device_queue_trans + completion ISR
+    uint32_t polling_overhead_ns;  // spi_device_polling_* setup
+    uint32_t acquire_overhead_ns;  // spi_device_acquire_bus/release_bus pair
+    size_t max_transfer_bytes;     // bus max_transfer_sz
+} fake_spi_model_t;
+
+#define FAKE_SPI_MODEL_DEFAULT                                                         \
+    {                                                                                  \
+        .queued_overhead_ns = 12000, .polling_overhead_ns = 4000,                      \
+        .acquire_overhead_ns = 2000, .max_transfer_bytes = 4092,                       \
+    }
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t queued;   // through spi_device_queue_trans / spi_device_transmit
+    uint32_t polling;  // through spi_device_polling_*
+    uint64_t bytes;
+    size_t max_transaction_bytes;
+    uint32_t cs_windows;    // falling edges on attached controllers' CS pins
+    uint32_t acquisitions;  // spi_device_acquire_bus calls
+    uint32_t dc_toggles;    // level changes on attached DC pins
+    uint32_t violations;    // API misuse: see fake_spi_last_violation()
+} fake_spi_stats_t;
+
+// Forget devices, controllers, pin levels and statistics; the clock restarts
+// at 0. NULL selects FAKE_SPI_MODEL_DEFAULT.
+void fake_spi_reset(const fake_spi_model_t *model);
+
+fake_spi_stats_t fake_spi_stats(void);
+void fake_spi_clear_stats(void);
+// Description of the most recent violation ("" when none)
+const char *fake_spi_last_violation(void);
+// Simulated time in microseconds
+int64_t fake_spi_now_us(void);
+
+// Level an input pin reads (pins read 1 until set: BUSY/HRDY idle)
+void fake_gpio_set_input(int pin, int level);
+
+// ---- ED2208 controller: DC low = command byte, DC high = data ----
+
+typedef struct fake_ed2208 fake_ed2208_t;
+
+fake_ed2208_t *fake_ed2208_attach(int pin_cs, int pin_dc, size_t dtm_capacity);
+// Bytes received after the most recent DTM (0x10) command
+const uint8_t *fake_ed2208_dtm(const fake_ed2208_t *ctl, size_t *len);
+uint32_t fake_ed2208_refreshes(const fake_ed2208_t *ctl);  // DRF (0x12) commands
+uint32_t fake_ed2208_commands(const fake_ed2208_t *ctl);
+
+// ---- IT8951 controller: 16-bit preamble protocol, manual CS ----
+
+typedef struct fake_it8951 fake_it8951_t;
+
+typedef struct {
+    uint16_t x, y, w, h, mode;
+} fake_it8951_area_t;
+
+fake_it8951_t *fake_it8951_attach(int pin_cs, uint16_t width, uint16_t height);
+// Panel memory, packed 4bpp rows of width / 2 bytes in wire byte order
+const uint8_t *fake_it8951_memory(const fake_it8951_t *ctl);
+// Image areas loaded (LD_IMG_AREA) and displayed (DPY_AREA) so far
+int fake_it8951_load_count(const fake_it8951_t *ctl);
+const fake_it8951_area_t *fake_it8951_load(const fake_it8951_t *ctl, int i);
+int fake_it8951_display_count(const fake_it8951_t *ctl);
+const fake_it8951_area_t *fake_it8951_display(const fake_it8951_t *ctl, int i);
+uint16_t fake_it8951_reg(const fake_it8951_t *ctl, uint16_t reg);
+
+#ifdef __cplusplus
+}
+#endif
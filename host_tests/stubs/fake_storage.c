@@ -7,3 +7,9 @@ bool storage_has_persistent_storage(void)
 {
     return test_storage_persistent;
 }
+
+// Staging follows the primary storage, as without CONFIG_STAGING_IN_RAM
+bool storage_staging_is_persistent(void)
+{
+    return test_storage_persistent;
+}
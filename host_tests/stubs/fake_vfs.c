@@ -0,0 +1,135 @@
+// Fake esp_vfs registry: keeps the entry points each mount registers and
+// dispatches fake_vfs_* calls to them by path prefix.
+#include "fake_vfs.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "esp_vfs.h"
+
+#define MAX_MOUNTS 4
+#define FD_SHIFT 16
+
+typedef struct {
+    char base_path[32];
+    esp_vfs_t vfs;
+    void *ctx;
+} mount_t;
+
+static mount_t mounts[MAX_MOUNTS];
+
+esp_err_t esp_vfs_register(const char *base_path, const esp_vfs_t *vfs, void *ctx)
+{
+    for (int i = 0; i < MAX_MOUNTS; i++) {
+        if (mounts[i].base_path[0] == '\0') {
+            strncpy(mounts[i].base_path, base_path, sizeof(mounts[i].base_path) - 1);
+            mounts[i].vfs = *vfs;
+            mounts[i].ctx = ctx;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_vfs_unregister(const char *base_path)
+{
+    for (int i = 0; i < MAX_MOUNTS; i++) {
+        if (strcmp(mounts[i].base_path, base_path) == 0) {
+            memset(&mounts[i], 0, sizeof(mounts[i]));
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+// Mount index for path, with *rel set to the path inside the mount
+static int find_mount(const char *path, const char **rel)
+{
+    for (int i = 0; i < MAX_MOUNTS; i++) {
+        size_t len = strlen(mounts[i].base_path);
+        if (len > 0 && strncmp(path, mounts[i].base_path, len) == 0 && path[len] == '/') {
+            *rel = path + len;
+            return i;
+        }
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+int fake_vfs_open(const char *path, int flags)
+{
+    const char *rel;
+    int m = find_mount(path, &rel);
+    if (m < 0) {
+        return -1;
+    }
+    int fd = mounts[m].vfs.open_p(mounts[m].ctx, rel, flags, 0666);
+    return fd < 0 ? -1 : (m << FD_SHIFT) | fd;
+}
+
+#define MOUNT_OF(fd) (&mounts[(fd) >> FD_SHIFT])
+#define LOCAL_FD(fd) ((fd) & ((1 << FD_SHIFT) - 1))
+
+ssize_t fake_vfs_write(int fd, const void *data, size_t size)
+{
+    return MOUNT_OF(fd)->vfs.write_p(MOUNT_OF(fd)->ctx, LOCAL_FD(fd), data, size);
+}
+
+ssize_t fake_vfs_read(int fd, void *dst, size_t size)
+{
+    return MOUNT_OF(fd)->vfs.read_p(MOUNT_OF(fd)->ctx, LOCAL_FD(fd), dst, size);
+}
+
+off_t fake_vfs_lseek(int fd, off_t offset, int mode)
+{
+    return MOUNT_OF(fd)->vfs.lseek_p(MOUNT_OF(fd)->ctx, LOCAL_FD(fd), offset, mode);
+}
+
+int fake_vfs_close(int fd)
+{
+    return MOUNT_OF(fd)->vfs.close_p(MOUNT_OF(fd)->ctx, LOCAL_FD(fd));
+}
+
+int fake_vfs_unlink(const char *path)
+{
+    const char *rel;
+    int m = find_mount(path, &rel);
+    return m < 0 ? -1 : mounts[m].vfs.unlink_p(mounts[m].ctx, rel);
+}
+
+int fake_vfs_rename(const char *src, const char *dst)
+{
+    const char *src_rel, *dst_rel;
+    int m = find_mount(src, &src_rel);
+    if (m < 0) {
+        return -1;
+    }
+    if (find_mount(dst, &dst_rel) != m) {
+        errno = EXDEV;
+        return -1;
+    }
+    return mounts[m].vfs.rename_p(mounts[m].ctx, src_rel, dst_rel);
+}
+
+long fake_vfs_size(const char *path)
+{
+    const char *rel;
+    int m = find_mount(path, &rel);
+    struct stat st;
+    if (m < 0 || mounts[m].vfs.stat_p(mounts[m].ctx, rel, &st) != 0) {
+        return -1;
+    }
+    return (long) st.st_size;
+}
+
+int fake_vfs_write_file(const char *path, const void *data, size_t size)
+{
+    int fd = fake_vfs_open(path, O_WRONLY | O_CREAT | O_TRUNC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t n = fake_vfs_write(fd, data, size);
+    fake_vfs_close(fd);
+    return n == (ssize_t) size ? 0 : -1;
+}
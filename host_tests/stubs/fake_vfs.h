@@ -0,0 +1,29 @@
+// Test-side view of the fake VFS: host stdio does not route through it, so
+// tests reach a registered filesystem (MemFS) through these calls instead.
+// They fail with -1 and errno as the real VFS would.
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// path includes the mount point; the fd is only valid for the calls below
+int fake_vfs_open(const char *path, int flags);
+ssize_t fake_vfs_write(int fd, const void *data, size_t size);
+ssize_t fake_vfs_read(int fd, void *dst, size_t size);
+off_t fake_vfs_lseek(int fd, off_t offset, int mode);
+int fake_vfs_close(int fd);
+int fake_vfs_unlink(const char *path);
+int fake_vfs_rename(const char *src, const char *dst);
+// File size, or -1 if absent
+long fake_vfs_size(const char *path);
+
+// Create or replace path with size bytes of data; 0 on success
+int fake_vfs_write_file(const char *path, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
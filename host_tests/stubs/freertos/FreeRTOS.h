@@ -5,6 +5,7 @@ typedef int TickType_t;
 typedef int BaseType_t;
 
 #define pdMS_TO_TICKS(ms) (ms)
+#define portMAX_DELAY ((TickType_t) 0x7fffffff)
 #define portTICK_PERIOD_MS 1
 #define pdTRUE 1
 #define pdFALSE 0
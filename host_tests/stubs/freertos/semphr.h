@@ -0,0 +1,12 @@
+// Host-test stub for freertos/semphr.h — host tests are single-threaded, so
+// mutexes always succeed.
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+#define xSemaphoreCreateMutex() ((SemaphoreHandle_t) 1)
+#define xSemaphoreTake(sem, ticks) ((void) (sem), (void) (ticks), pdTRUE)
+#define xSemaphoreGive(sem) ((void) (sem), pdTRUE)
+#define vSemaphoreDelete(sem) ((void) (sem))
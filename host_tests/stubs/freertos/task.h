@@ -7,11 +7,36 @@
 extern "C" {
 #endif
 
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define tskIDLE_PRIORITY 0
+
 static inline void vTaskDelay(TickType_t ticks)
 {
     (void) ticks;
 }
 
+// Tasks run to completion inside xTaskCreate, so background work finishes
+// before the caller continues
+static inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, unsigned stack,
+                                     void *arg, unsigned priority, TaskHandle_t *handle)
+{
+    (void) name;
+    (void) stack;
+    (void) priority;
+    if (handle) {
+        *handle = NULL;
+    }
+    fn(arg);
+    return pdPASS;
+}
+
+static inline void vTaskDelete(TaskHandle_t task)
+{
+    (void) task;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,6 @@
-// Host-test stub for esp_jpeg's jpeg_decoder.h — JPEG decoding is not
-// exercised on host; the stubs report failure so PNG paths stay testable.
+// Host-test stub for esp_jpeg's jpeg_decoder.h — JPEG bitstreams are not
+// decoded on host; see esp_stubs.c for the test-registered frame the stub
+// decoder serves.
 #pragma once
 
 #include <stddef.h>
@@ -0,0 +1,45 @@
+// Host-test helper: run each test from a fresh directory of its own.
+//
+// The filesystem tests redirect FS_MOUNT_POINT to a relative directory (see
+// CMakeLists). ctest runs every test case as a separate process, several at
+// once under -j, so cases of one executable would otherwise share that tree
+// and clobber each other's files.
+#pragma once
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+class TestWorkDir
+{
+public:
+    // Create a unique directory and make it the working directory
+    void Enter()
+    {
+        char cwd[4096];
+        ASSERT_NE(getcwd(cwd, sizeof(cwd)), nullptr);
+        prev_ = cwd;
+        std::string tmpl = ::testing::TempDir() + "pf_test_XXXXXX";
+        ASSERT_NE(mkdtemp(&tmpl[0]), nullptr);
+        path_ = tmpl;
+        ASSERT_EQ(chdir(path_.c_str()), 0);
+    }
+
+    // Go back to the previous working directory and remove the test's tree
+    void Leave()
+    {
+        if (path_.empty()) {
+            return;
+        }
+        EXPECT_EQ(chdir(prev_.c_str()), 0);
+        std::string cmd = "rm -rf '" + path_ + "'";
+        EXPECT_EQ(system(cmd.c_str()), 0);
+        path_.clear();
+    }
+
+private:
+    std::string prev_;
+    std::string path_;
+};
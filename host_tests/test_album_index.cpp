@@ -0,0 +1,461 @@
+// Tests for the persistent per-album image index (album_index.c).
+// FS_MOUNT_POINT is redirected to a local directory (see CMakeLists) inside
+// a fresh working directory per test, and background re-indexing runs inline
+// (stubs/freertos/task.h).
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "album_index.h"
+#include "config.h"
+}
+
+#include "test_work_dir.h"
+
+namespace
+{
+
+const std::string kAlbum = "Trips";
+
+std::string AlbumDir()
+{
+    return std::string(IMAGE_DIRECTORY) + "/" + kAlbum;
+}
+
+std::string ImagePath(const std::string &name)
+{
+    return AlbumDir() + "/" + name;
+}
+
+std::string IndexPath()
+{
+    return std::string(ALBUM_INDEX_DIRECTORY) + "/" + kAlbum + ".idx";
+}
+
+void Touch(const std::string &path)
+{
+    std::ofstream f(path, std::ios::binary);
+    f << "x";
+}
+
+bool Exists(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+time_t DirMtime()
+{
+    struct stat st;
+    stat(AlbumDir().c_str(), &st);
+    return st.st_mtime;
+}
+
+// Host directory mtimes have one-second granularity in st_mtime; tests set
+// them explicitly instead of relying on the clock ticking
+void SetDirMtime(time_t t)
+{
+    struct utimbuf times = {t, t};
+    utime(AlbumDir().c_str(), &times);
+}
+
+int Count()
+{
+    int count = -1;
+    EXPECT_EQ(album_index_count(kAlbum.c_str(), &count), ESP_OK);
+    return count;
+}
+
+// Every indexed file name, resolved one record at a time
+std::multiset<std::string> IndexedNames()
+{
+    std::multiset<std::string> names;
+    int count = Count();
+    for (int i = 0; i < count; i++) {
+        char path[512];
+        EXPECT_EQ(album_index_get(kAlbum.c_str(), i, path, sizeof(path), NULL), ESP_OK);
+        std::string full(path);
+        names.insert(full.substr(full.rfind('/') + 1));
+    }
+    return names;
+}
+
+class AlbumIndexTest : public ::testing::Test
+{
+protected:
+    TestWorkDir work_dir;
+
+    void SetUp() override
+    {
+        ASSERT_NO_FATAL_FAILURE(work_dir.Enter());
+        mkdir(FS_MOUNT_POINT, 0775);
+        mkdir(IMAGE_DIRECTORY, 0775);
+        mkdir(AlbumDir().c_str(), 0775);
+        ASSERT_EQ(album_index_init(), ESP_OK);
+
+        Touch(ImagePath("a.png"));
+        Touch(ImagePath("b.bmp"));
+        Touch(ImagePath("c.epdgz"));
+        Touch(ImagePath("c.jpg"));     // thumbnail
+        Touch(ImagePath("._a.png"));   // macOS resource fork
+        Touch(ImagePath("notes.txt"));
+    }
+
+    void TearDown() override { work_dir.Leave(); }
+};
+
+TEST_F(AlbumIndexTest, ImageNamesMatchTheRotationFilter)
+{
+    EXPECT_TRUE(album_index_is_image_name("photo.PNG"));
+    EXPECT_TRUE(album_index_is_image_name("photo.bmp"));
+    EXPECT_TRUE(album_index_is_image_name("photo.epdgz"));
+    EXPECT_FALSE(album_index_is_image_name("photo.jpg"));
+    EXPECT_FALSE(album_index_is_image_name("._photo.png"));
+    EXPECT_FALSE(album_index_is_image_name("png"));
+}
+
+TEST_F(AlbumIndexTest, MissingIndexIsBuiltOnFirstCount)
+{
+    EXPECT_FALSE(Exists(IndexPath()));
+    EXPECT_EQ(Count(), 3);
+    EXPECT_TRUE(Exists(IndexPath()));
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"a.png", "b.bmp", "c.epdgz"}));
+}
+
+TEST_F(AlbumIndexTest, RecordsCarryTheFormat)
+{
+    int count = Count();
+    for (int i = 0; i < count; i++) {
+        char path[512];
+        image_format_t format = IMAGE_FORMAT_UNKNOWN;
+        ASSERT_EQ(album_index_get(kAlbum.c_str(), i, path, sizeof(path), &format), ESP_OK);
+        std::string full(path);
+        EXPECT_EQ(full.rfind(AlbumDir() + "/", 0), 0u) << full;
+        if (full.size() > 4 && full.compare(full.size() - 4, 4, ".png") == 0) {
+            EXPECT_EQ(format, IMAGE_FORMAT_PNG);
+        } else if (full.size() > 4 && full.compare(full.size() - 4, 4, ".bmp") == 0) {
+            EXPECT_EQ(format, IMAGE_FORMAT_BMP);
+        } else {
+            EXPECT_EQ(format, IMAGE_FORMAT_EPD_GZ);
+        }
+    }
+}
+
+TEST_F(AlbumIndexTest, OutOfRangeIsRejected)
+{
+    char path[512];
+    ASSERT_EQ(Count(), 3);
+    EXPECT_EQ(album_index_get(kAlbum.c_str(), 3, path, sizeof(path), NULL), ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(album_index_get(kAlbum.c_str(), -1, path, sizeof(path), NULL), ESP_ERR_INVALID_ARG);
+}
+
+TEST_F(AlbumIndexTest, MissingAlbumIsNotFound)
+{
+    int count = -1;
+    EXPECT_EQ(album_index_count("Nope", &count), ESP_ERR_NOT_FOUND);
+}
+
+TEST_F(AlbumIndexTest, AddedFileIsAppended)
+{
+    ASSERT_EQ(Count(), 3);
+    Touch(ImagePath("d.png"));
+    album_index_note_added(ImagePath("d.png").c_str());
+
+    EXPECT_EQ(IndexedNames(),
+              (std::multiset<std::string>{"a.png", "b.bmp", "c.epdgz", "d.png"}));
+}
+
+TEST_F(AlbumIndexTest, OverwrittenFileIsNotIndexedTwice)
+{
+    ASSERT_EQ(Count(), 3);
+    album_index_note_added(ImagePath("a.png").c_str());
+    EXPECT_EQ(Count(), 3);
+}
+
+TEST_F(AlbumIndexTest, UpdatesKeepTheIndexCurrent)
+{
+    ASSERT_EQ(Count(), 3);
+    Touch(ImagePath("d.png"));
+    SetDirMtime(DirMtime() + 10);
+    album_index_note_added(ImagePath("d.png").c_str());
+    time_t recorded = DirMtime();
+
+    // An unnoted file slipped in under the recorded mtime stays invisible:
+    // the index was not rescanned
+    Touch(ImagePath("e.png"));
+    SetDirMtime(recorded);
+    EXPECT_EQ(Count(), 4);
+}
+
+TEST_F(AlbumIndexTest, RemovedFileLeavesNoGap)
+{
+    ASSERT_EQ(Count(), 3);
+    unlink(ImagePath("a.png").c_str());
+    album_index_note_removed(ImagePath("a.png").c_str());
+
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"b.bmp", "c.epdgz"}));
+}
+
+TEST_F(AlbumIndexTest, NonImagesAndForeignPathsAreIgnored)
+{
+    ASSERT_EQ(Count(), 3);
+    album_index_note_added(ImagePath("c.jpg").c_str());
+    album_index_note_added(CURRENT_PNG_PATH);
+    album_index_note_added((std::string(IMAGE_DIRECTORY) + "/loose.png").c_str());
+    album_index_note_removed(ImagePath("notes.txt").c_str());
+    EXPECT_EQ(Count(), 3);
+}
+
+TEST_F(AlbumIndexTest, StaleIndexIsServedThenRebuilt)
+{
+    ASSERT_EQ(Count(), 3);
+    time_t indexed = DirMtime();
+
+    // Files copied onto the card behind the device's back
+    Touch(ImagePath("d.png"));
+    Touch(ImagePath("e.png"));
+    SetDirMtime(indexed + 10);
+
+    // The stale count answers this wake; the re-index (inline here) serves
+    // the next one
+    EXPECT_EQ(Count(), 3);
+    EXPECT_EQ(Count(), 5);
+}
+
+TEST_F(AlbumIndexTest, VerifyFindsCopiesTheMtimeMissed)
+{
+    ASSERT_EQ(Count(), 3);
+    time_t indexed = DirMtime();
+
+    // FAT leaves the directory mtime alone when files are copied in
+    Touch(ImagePath("d.png"));
+    unlink(ImagePath("b.bmp").c_str());
+    Touch(ImagePath("e.png"));
+    SetDirMtime(indexed);
+    EXPECT_EQ(Count(), 3);
+
+    // The verifying pass (inline here) counts entries and re-indexes
+    album_index_verify();
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"a.png", "c.epdgz", "d.png", "e.png"}));
+}
+
+TEST_F(AlbumIndexTest, VanishedFileTriggersReindex)
+{
+    ASSERT_EQ(Count(), 3);
+    time_t indexed = DirMtime();
+    unlink(ImagePath("b.bmp").c_str());
+    SetDirMtime(indexed);  // e.g. a filesystem that keeps directory mtimes
+
+    bool saw_missing = false;
+    for (int i = 0; i < 3; i++) {
+        char path[512];
+        esp_err_t err = album_index_get(kAlbum.c_str(), i, path, sizeof(path), NULL);
+        if (err == ESP_ERR_NOT_FOUND) {
+            saw_missing = true;
+            break;
+        }
+        EXPECT_EQ(err, ESP_OK);
+    }
+    EXPECT_TRUE(saw_missing);
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"a.png", "c.epdgz"}));
+}
+
+TEST_F(AlbumIndexTest, CorruptIndexIsRebuilt)
+{
+    ASSERT_EQ(Count(), 3);
+    {
+        std::ofstream f(IndexPath(), std::ios::binary | std::ios::trunc);
+        f << "garbage";
+    }
+    EXPECT_EQ(Count(), 3);
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"a.png", "b.bmp", "c.epdgz"}));
+}
+
+TEST_F(AlbumIndexTest, TruncatedIndexIsRebuilt)
+{
+    ASSERT_EQ(Count(), 3);
+    ASSERT_EQ(truncate(IndexPath().c_str(), 100), 0);
+    EXPECT_EQ(Count(), 3);
+}
+
+TEST_F(AlbumIndexTest, DropForgetsTheIndex)
+{
+    ASSERT_EQ(Count(), 3);
+    album_index_drop(kAlbum.c_str());
+    EXPECT_FALSE(Exists(IndexPath()));
+}
+
+TEST_F(AlbumIndexTest, RebuildPicksUpEveryFile)
+{
+    ASSERT_EQ(Count(), 3);
+    Touch(ImagePath("d.bmp"));
+    ASSERT_EQ(album_index_rebuild(kAlbum.c_str()), ESP_OK);
+    EXPECT_EQ(Count(), 4);
+}
+
+}  // namespace
+
+namespace
+{
+
+std::vector<album_index_entry_t> ReadAll(int first, int max)
+{
+    std::vector<album_index_entry_t> entries(max > 0 ? max : 1);
+    int read = -1;
+    EXPECT_EQ(album_index_read(kAlbum.c_str(), first, entries.data(), max, &read), ESP_OK);
+    entries.resize(read);
+    return entries;
+}
+
+uint32_t Generation()
+{
+    int count;
+    uint32_t generation = 0;
+    EXPECT_EQ(album_index_stat(kAlbum.c_str(), &count, &generation), ESP_OK);
+    return generation;
+}
+
+}  // namespace
+
+TEST_F(AlbumIndexTest, ThumbnailPresenceIsRecorded)
+{
+    ASSERT_EQ(Count(), 3);
+    std::vector<album_index_entry_t> entries = ReadAll(0, 3);
+    ASSERT_EQ(entries.size(), 3u);
+    for (const album_index_entry_t &e : entries) {
+        // Only c.epdgz has its c.jpg preview alongside
+        EXPECT_EQ(e.has_thumbnail, std::string(e.name) == "c.epdgz") << e.name;
+    }
+}
+
+TEST_F(AlbumIndexTest, ReuploadRefreshesThumbnailPresence)
+{
+    ASSERT_EQ(Count(), 3);
+    Touch(ImagePath("a.jpg"));
+    album_index_note_added(ImagePath("a.png").c_str());
+
+    EXPECT_EQ(Count(), 3);
+    for (const album_index_entry_t &e : ReadAll(0, 3)) {
+        if (std::string(e.name) == "a.png") {
+            EXPECT_TRUE(e.has_thumbnail);
+        }
+    }
+}
+
+TEST_F(AlbumIndexTest, ReadPagesMatchGet)
+{
+    for (const char *name : {"d.png", "e.png", "f.png", "g.png"}) {
+        Touch(ImagePath(name));
+    }
+    ASSERT_EQ(album_index_rebuild(kAlbum.c_str()), ESP_OK);
+    ASSERT_EQ(Count(), 7);
+
+    std::vector<album_index_entry_t> page = ReadAll(2, 3);
+    ASSERT_EQ(page.size(), 3u);
+    for (int i = 0; i < 3; i++) {
+        char path[512];
+        ASSERT_EQ(album_index_get(kAlbum.c_str(), 2 + i, path, sizeof(path), NULL), ESP_OK);
+        EXPECT_EQ(ImagePath(page[i].name), path);
+    }
+
+    EXPECT_EQ(ReadAll(5, 10).size(), 2u);  // clipped at the end
+    EXPECT_EQ(ReadAll(7, 10).size(), 0u);
+    EXPECT_EQ(ReadAll(100, 10).size(), 0u);
+}
+
+TEST_F(AlbumIndexTest, GenerationChangesWithTheIndex)
+{
+    ASSERT_EQ(Count(), 3);
+    uint32_t g0 = Generation();
+    EXPECT_EQ(Generation(), g0);
+
+    Touch(ImagePath("d.png"));
+    album_index_note_added(ImagePath("d.png").c_str());
+    uint32_t g1 = Generation();
+    EXPECT_NE(g1, g0);
+
+    unlink(ImagePath("d.png").c_str());
+    album_index_note_removed(ImagePath("d.png").c_str());
+    uint32_t g2 = Generation();
+    EXPECT_NE(g2, g1);
+
+    ASSERT_EQ(album_index_rebuild(kAlbum.c_str()), ESP_OK);
+    EXPECT_NE(Generation(), g2);
+}
+
+TEST_F(AlbumIndexTest, OrderOnlyChangesWhenImagesMayHaveMoved)
+{
+    int count = 0;
+    uint32_t o0 = 0;
+    ASSERT_EQ(album_index_order(kAlbum.c_str(), &count, &o0), ESP_OK);
+    ASSERT_EQ(count, 3);
+
+    // Appends and in-place re-uploads keep every position
+    Touch(ImagePath("d.png"));
+    album_index_note_added(ImagePath("d.png").c_str());
+    album_index_note_added(ImagePath("a.png").c_str());
+    uint32_t o1 = 0;
+    ASSERT_EQ(album_index_order(kAlbum.c_str(), &count, &o1), ESP_OK);
+    EXPECT_EQ(count, 4);
+    EXPECT_EQ(o1, o0);
+
+    unlink(ImagePath("a.png").c_str());
+    album_index_note_removed(ImagePath("a.png").c_str());
+    uint32_t o2 = 0;
+    ASSERT_EQ(album_index_order(kAlbum.c_str(), &count, &o2), ESP_OK);
+    EXPECT_NE(o2, o1);
+
+    ASSERT_EQ(album_index_rebuild(kAlbum.c_str()), ESP_OK);
+    uint32_t o3 = 0;
+    ASSERT_EQ(album_index_order(kAlbum.c_str(), &count, &o3), ESP_OK);
+    EXPECT_NE(o3, o2);
+}
+
+TEST_F(AlbumIndexTest, VerifyLeavesMatchingIndexesAlone)
+{
+    ASSERT_EQ(Count(), 3);
+    uint32_t before = Generation();
+    album_index_verify();
+    EXPECT_EQ(Generation(), before);
+}
+
+TEST_F(AlbumIndexTest, RecordsAreCompact)
+{
+    ASSERT_EQ(Count(), 3);
+    struct stat st;
+    ASSERT_EQ(stat(IndexPath().c_str(), &st), 0);
+    EXPECT_LE(st.st_size, 64 + 3 * 64);
+}
+
+TEST_F(AlbumIndexTest, LongNamesResolveThroughTheDirectory)
+{
+    // Two names sharing everything the record keeps of them
+    std::string stem(90, 'n');
+    std::string first = stem + "-first.png";
+    std::string second = stem + "-second.png";
+    Touch(ImagePath(first));
+    album_index_note_added(ImagePath(first).c_str());
+    Touch(ImagePath(second));
+    ASSERT_EQ(album_index_rebuild(kAlbum.c_str()), ESP_OK);
+
+    EXPECT_EQ(IndexedNames(),
+              (std::multiset<std::string>{"a.png", "b.bmp", "c.epdgz", first, second}));
+    std::multiset<std::string> listed;
+    for (const album_index_entry_t &e : ReadAll(0, 8)) {
+        listed.insert(e.name);
+    }
+    EXPECT_EQ(listed, IndexedNames());
+
+    unlink(ImagePath(first).c_str());
+    album_index_note_removed(ImagePath(first).c_str());
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"a.png", "b.bmp", "c.epdgz", second}));
+}
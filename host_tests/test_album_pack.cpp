@@ -0,0 +1,338 @@
+// Tests for single-file album packs (album_pack.c) and the album index
+// answering for packed albums. FS_MOUNT_POINT is redirected to a local
+// directory (see CMakeLists) inside a fresh working directory per test.
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+extern "C" {
+#include "album_index.h"
+#include "album_pack.h"
+#include "config.h"
+}
+
+#include "test_work_dir.h"
+
+namespace
+{
+
+const std::string kAlbum = "Trips";
+
+std::string ImagePath(const std::string &name)
+{
+    return std::string(IMAGE_DIRECTORY) + "/" + kAlbum + "/" + name;
+}
+
+std::string PackPath()
+{
+    return ImagePath(ALBUM_PACK_FILE_NAME);
+}
+
+void Write(const std::string &name, const std::string &contents)
+{
+    std::ofstream f(ImagePath(name), std::ios::binary);
+    f << contents;
+}
+
+bool Exists(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+long FileSize(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (long) st.st_size : -1;
+}
+
+// Whole blob behind a packed image or thumbnail path, or "<missing>"
+std::string ReadPacked(const std::string &name)
+{
+    album_pack_blob_t blob;
+    if (album_pack_open(ImagePath(name).c_str(), &blob) != ESP_OK) {
+        return "<missing>";
+    }
+    std::string out;
+    char buf[7];  // odd size to exercise partial reads
+    size_t n;
+    while ((n = album_pack_blob_read(&blob, buf, sizeof(buf))) > 0) {
+        out.append(buf, n);
+    }
+    EXPECT_EQ(out.size(), blob.length);
+    album_pack_blob_close(&blob);
+    return out;
+}
+
+int Count()
+{
+    int count = -1;
+    EXPECT_EQ(album_index_count(kAlbum.c_str(), &count), ESP_OK);
+    return count;
+}
+
+std::set<std::string> Listing(std::set<std::string> *with_thumbnail = nullptr)
+{
+    std::set<std::string> names;
+    album_index_entry_t entries[8];
+    int first = 0;
+    int read = 0;
+    do {
+        EXPECT_EQ(album_index_read(kAlbum.c_str(), first, entries, 8, &read), ESP_OK);
+        for (int i = 0; i < read; i++) {
+            names.insert(entries[i].name);
+            if (with_thumbnail && entries[i].has_thumbnail) {
+                with_thumbnail->insert(entries[i].name);
+            }
+        }
+        first += read;
+    } while (read > 0);
+    return names;
+}
+
+class AlbumPackTest : public ::testing::Test
+{
+protected:
+    TestWorkDir work_dir;
+
+    void SetUp() override
+    {
+        ASSERT_NO_FATAL_FAILURE(work_dir.Enter());
+        mkdir(FS_MOUNT_POINT, 0775);
+        mkdir(IMAGE_DIRECTORY, 0775);
+        mkdir((std::string(IMAGE_DIRECTORY) + "/" + kAlbum).c_str(), 0775);
+        ASSERT_EQ(album_index_init(), ESP_OK);
+        ASSERT_EQ(album_pack_init(), ESP_OK);
+
+        Write("a.epdgz", "epdgz-a");
+        Write("a.jpg", "thumb-a");
+        Write("b.png", "png-b");
+        Write("c.bmp", "bmp-c");
+        Write("c.jpg", "thumb-c");
+    }
+
+    void TearDown() override { work_dir.Leave(); }
+
+    void Pack(int expected)
+    {
+        int packed = -1;
+        ASSERT_EQ(album_pack_build(kAlbum.c_str(), &packed), ESP_OK);
+        EXPECT_EQ(packed, expected);
+    }
+};
+
+TEST_F(AlbumPackTest, BuildMovesImagesAndThumbnailsIntoThePack)
+{
+    EXPECT_FALSE(album_pack_present(kAlbum.c_str()));
+    Pack(2);
+    EXPECT_TRUE(album_pack_present(kAlbum.c_str()));
+
+    EXPECT_FALSE(Exists(ImagePath("a.epdgz")));
+    EXPECT_FALSE(Exists(ImagePath("a.jpg")));
+    EXPECT_FALSE(Exists(ImagePath("b.png")));
+    // BMPs are not packed, nor is the thumbnail of an unpacked image
+    EXPECT_TRUE(Exists(ImagePath("c.bmp")));
+    EXPECT_TRUE(Exists(ImagePath("c.jpg")));
+
+    EXPECT_EQ(ReadPacked("a.epdgz"), "epdgz-a");
+    EXPECT_EQ(ReadPacked("a.jpg"), "thumb-a");
+    EXPECT_EQ(ReadPacked("b.png"), "png-b");
+    EXPECT_EQ(ReadPacked("b.jpg"), "<missing>");
+    EXPECT_EQ(ReadPacked("c.bmp"), "<missing>");
+}
+
+TEST_F(AlbumPackTest, IndexListsPackedThenLooseImages)
+{
+    Pack(2);
+    EXPECT_EQ(Count(), 3);
+
+    std::set<std::string> with_thumbnail;
+    EXPECT_EQ(Listing(&with_thumbnail), (std::set<std::string>{"a.epdgz", "b.png", "c.bmp"}));
+    EXPECT_EQ(with_thumbnail, (std::set<std::string>{"a.epdgz", "c.bmp"}));
+
+    for (int i = 0; i < 2; i++) {
+        char path[512];
+        image_format_t format = IMAGE_FORMAT_UNKNOWN;
+        ASSERT_EQ(album_index_get(kAlbum.c_str(), i, path, sizeof(path), &format), ESP_OK);
+        std::string full(path);
+        EXPECT_EQ(format, full == ImagePath("b.png") ? IMAGE_FORMAT_PNG : IMAGE_FORMAT_EPD_GZ);
+    }
+    char path[512];
+    image_format_t format = IMAGE_FORMAT_UNKNOWN;
+    ASSERT_EQ(album_index_get(kAlbum.c_str(), 2, path, sizeof(path), &format), ESP_OK);
+    EXPECT_EQ(std::string(path), ImagePath("c.bmp"));
+    EXPECT_EQ(format, IMAGE_FORMAT_BMP);
+    EXPECT_EQ(album_index_get(kAlbum.c_str(), 3, path, sizeof(path), NULL), ESP_ERR_INVALID_ARG);
+
+    // Reads starting inside the loose part
+    album_index_entry_t entries[4];
+    int read = 0;
+    ASSERT_EQ(album_index_read(kAlbum.c_str(), 2, entries, 4, &read), ESP_OK);
+    ASSERT_EQ(read, 1);
+    EXPECT_STREQ(entries[0].name, "c.bmp");
+}
+
+TEST_F(AlbumPackTest, UnpackableUploadsStayListed)
+{
+    Pack(2);
+    uint32_t generation = 0;
+    int count = 0;
+    ASSERT_EQ(album_index_stat(kAlbum.c_str(), &count, &generation), ESP_OK);
+
+    Write("e.bmp", "bmp-e");
+    album_index_note_added(ImagePath("e.bmp").c_str());
+    EXPECT_TRUE(Exists(ImagePath("e.bmp")));
+    uint32_t after = 0;
+    ASSERT_EQ(album_index_stat(kAlbum.c_str(), &count, &after), ESP_OK);
+    EXPECT_EQ(count, 4);
+    EXPECT_NE(after, generation);
+    EXPECT_EQ(Listing(), (std::set<std::string>{"a.epdgz", "b.png", "c.bmp", "e.bmp"}));
+
+    // Deleting a loose file of a packed album updates its listing too
+    ASSERT_EQ(remove(ImagePath("c.bmp").c_str()), 0);
+    album_index_note_removed(ImagePath("c.bmp").c_str());
+    EXPECT_EQ(Count(), 3);
+    EXPECT_EQ(Listing(), (std::set<std::string>{"a.epdgz", "b.png", "e.bmp"}));
+}
+
+TEST_F(AlbumPackTest, AddedFilesMoveIntoThePack)
+{
+    Pack(2);
+    uint32_t generation = 0;
+    int count = 0;
+    ASSERT_EQ(album_index_stat(kAlbum.c_str(), &count, &generation), ESP_OK);
+
+    Write("d.epdgz", "epdgz-d");
+    Write("d.jpg", "thumb-d");
+    album_index_note_added(ImagePath("d.epdgz").c_str());
+
+    EXPECT_FALSE(Exists(ImagePath("d.epdgz")));
+    EXPECT_FALSE(Exists(ImagePath("d.jpg")));
+    EXPECT_EQ(ReadPacked("d.jpg"), "thumb-d");
+    uint32_t after = 0;
+    ASSERT_EQ(album_index_stat(kAlbum.c_str(), &count, &after), ESP_OK);
+    EXPECT_EQ(count, 4);
+    EXPECT_NE(after, generation);
+}
+
+TEST_F(AlbumPackTest, ReAddingReplacesAndKeepsTheThumbnail)
+{
+    Pack(2);
+    Write("a.epdgz", "epdgz-a2");
+    album_index_note_added(ImagePath("a.epdgz").c_str());
+
+    EXPECT_EQ(Count(), 3);
+    EXPECT_EQ(ReadPacked("a.epdgz"), "epdgz-a2");
+    EXPECT_EQ(ReadPacked("a.jpg"), "thumb-a");
+}
+
+TEST_F(AlbumPackTest, RemovedImagesAreGone)
+{
+    Pack(2);
+    ASSERT_EQ(album_pack_remove(ImagePath("a.epdgz").c_str()), ESP_OK);
+    EXPECT_EQ(album_pack_remove(ImagePath("a.epdgz").c_str()), ESP_ERR_NOT_FOUND);
+
+    EXPECT_EQ(Listing(), (std::set<std::string>{"b.png", "c.bmp"}));
+    EXPECT_EQ(ReadPacked("a.epdgz"), "<missing>");
+    EXPECT_EQ(ReadPacked("a.jpg"), "<missing>");
+    EXPECT_EQ(ReadPacked("b.png"), "png-b");
+}
+
+TEST_F(AlbumPackTest, DeadSpaceIsCompactedAway)
+{
+    const std::string big(100000, 'x');
+    for (int i = 0; i < 4; i++) {
+        Write("big" + std::to_string(i) + ".epdgz", big + std::to_string(i));
+    }
+    Pack(6);
+    long full = FileSize(PackPath());
+
+    // Removing most of the data crosses the half-dead threshold
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(album_pack_remove(ImagePath("big" + std::to_string(i) + ".epdgz").c_str()),
+                  ESP_OK);
+    }
+    long compacted = FileSize(PackPath());
+    EXPECT_LT(compacted, full / 2);
+    EXPECT_FALSE(Exists(PackPath() + ".tmp"));
+
+    EXPECT_EQ(Listing(), (std::set<std::string>{"a.epdgz", "b.png", "big3.epdgz", "c.bmp"}));
+    EXPECT_EQ(ReadPacked("big3.epdgz"), big + "3");
+    EXPECT_EQ(ReadPacked("a.jpg"), "thumb-a");
+}
+
+TEST_F(AlbumPackTest, OpenBlobsPostponeCompaction)
+{
+    const std::string big(100000, 'x');
+    Write("big.epdgz", big);
+    Pack(3);
+    long full = FileSize(PackPath());
+
+    album_pack_blob_t blob;
+    ASSERT_EQ(album_pack_open(ImagePath("b.png").c_str(), &blob), ESP_OK);
+    ASSERT_EQ(album_pack_remove(ImagePath("big.epdgz").c_str()), ESP_OK);
+    EXPECT_EQ(FileSize(PackPath()), full);
+
+    char buf[16];
+    size_t n = album_pack_blob_read(&blob, buf, sizeof(buf));
+    EXPECT_EQ(std::string(buf, n), "png-b");
+    album_pack_blob_close(&blob);
+
+    // The next removal catches up
+    ASSERT_EQ(album_pack_remove(ImagePath("a.epdgz").c_str()), ESP_OK);
+    EXPECT_LT(FileSize(PackPath()), full / 2);
+    EXPECT_EQ(ReadPacked("b.png"), "png-b");
+}
+
+TEST_F(AlbumPackTest, IndexGrowsPastItsInitialCapacity)
+{
+    Pack(2);
+    for (int i = 0; i < 150; i++) {
+        std::string name = "n" + std::to_string(i) + ".epdgz";
+        Write(name, "image-" + std::to_string(i));
+        ASSERT_EQ(album_pack_add(ImagePath(name).c_str()), ESP_OK);
+    }
+    EXPECT_EQ(Count(), 153);
+    EXPECT_EQ(ReadPacked("n0.epdgz"), "image-0");
+    EXPECT_EQ(ReadPacked("n149.epdgz"), "image-149");
+    EXPECT_EQ(ReadPacked("a.jpg"), "thumb-a");
+}
+
+TEST_F(AlbumPackTest, FailedAddsLeaveTheirBytesAsDeadSpace)
+{
+    Pack(2);
+    long packed = FileSize(PackPath());
+
+    // The image is appended, then its "thumbnail" (a directory) fails to copy
+    const std::string big(100000, 'x');
+    Write("big.epdgz", big);
+    ASSERT_EQ(mkdir(ImagePath("big.jpg").c_str(), 0775), 0);
+    EXPECT_EQ(album_pack_add(ImagePath("big.epdgz").c_str()), ESP_FAIL);
+    EXPECT_TRUE(Exists(ImagePath("big.epdgz")));
+    EXPECT_GT(FileSize(PackPath()), packed + 100000 - 1);
+
+    // Counted as dead, the stray image bytes push the next removal over the
+    // compaction threshold
+    ASSERT_EQ(album_pack_remove(ImagePath("a.epdgz").c_str()), ESP_OK);
+    EXPECT_LT(FileSize(PackPath()), packed);
+    EXPECT_EQ(ReadPacked("b.png"), "png-b");
+    EXPECT_EQ(Listing(), (std::set<std::string>{"b.png", "big.epdgz", "c.bmp"}));
+}
+
+TEST_F(AlbumPackTest, UnpackedAlbumsRejectAdds)
+{
+    EXPECT_EQ(album_pack_add(ImagePath("a.epdgz").c_str()), ESP_ERR_NOT_FOUND);
+    EXPECT_TRUE(Exists(ImagePath("a.epdgz")));
+    Pack(2);
+    Write("e.bmp", "bmp-e");
+    EXPECT_EQ(album_pack_add(ImagePath("e.bmp").c_str()), ESP_ERR_NOT_SUPPORTED);
+    EXPECT_TRUE(Exists(ImagePath("e.bmp")));
+}
+
+}  // namespace
@@ -0,0 +1,185 @@
+// Tests for album transcoding (album_transcode.c). The display render is
+// faked: it writes a marker naming its source, fails for names containing
+// "broken" and reports a busy display while display_busy is set. Background
+// migration runs inline (stubs/freertos/task.h).
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+extern "C" {
+#include "album_index.h"
+#include "album_transcode.h"
+#include "board_hal.h"
+#include "config.h"
+#include "display_manager.h"
+}
+
+#include "test_work_dir.h"
+
+namespace
+{
+
+bool display_busy = false;
+int render_count = 0;
+
+}  // namespace
+
+extern "C" esp_err_t display_manager_render_to_epdgz(const char *src, const char *dst)
+{
+    if (display_busy) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (strstr(src, "broken")) {
+        return ESP_FAIL;
+    }
+    std::ofstream f(dst, std::ios::binary);
+    f << "rendered:" << strrchr(src, '/') + 1;
+    render_count++;
+    return ESP_OK;
+}
+
+extern "C" bool board_hal_is_usb_connected(void)
+{
+    return true;
+}
+
+namespace
+{
+
+const std::string kAlbum = "Trips";
+
+std::string ImagePath(const std::string &name)
+{
+    return std::string(IMAGE_DIRECTORY) + "/" + kAlbum + "/" + name;
+}
+
+void Touch(const std::string &path)
+{
+    std::ofstream f(path, std::ios::binary);
+    f << "x";
+}
+
+bool Exists(const std::string &name)
+{
+    struct stat st;
+    return stat(ImagePath(name).c_str(), &st) == 0;
+}
+
+std::string Contents(const std::string &name)
+{
+    std::ifstream f(ImagePath(name), std::ios::binary);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+std::multiset<std::string> IndexedNames()
+{
+    std::multiset<std::string> names;
+    album_index_entry_t entries[16];
+    int read = 0;
+    EXPECT_EQ(album_index_read(kAlbum.c_str(), 0, entries, 16, &read), ESP_OK);
+    for (int i = 0; i < read; i++) {
+        names.insert(entries[i].name);
+    }
+    return names;
+}
+
+class AlbumTranscodeTest : public ::testing::Test
+{
+protected:
+    TestWorkDir work_dir;
+
+    void SetUp() override
+    {
+        ASSERT_NO_FATAL_FAILURE(work_dir.Enter());
+        mkdir(FS_MOUNT_POINT, 0775);
+        mkdir(IMAGE_DIRECTORY, 0775);
+        mkdir((std::string(IMAGE_DIRECTORY) + "/" + kAlbum).c_str(), 0775);
+        ASSERT_EQ(album_index_init(), ESP_OK);
+        display_busy = false;
+        render_count = 0;
+
+        Touch(ImagePath("a.png"));
+        Touch(ImagePath("a.jpg"));  // thumbnail
+        Touch(ImagePath("b.bmp"));
+        Touch(ImagePath("c.epdgz"));
+        ASSERT_EQ(album_index_rebuild(kAlbum.c_str()), ESP_OK);
+    }
+
+    void TearDown() override { work_dir.Leave(); }
+};
+
+TEST_F(AlbumTranscodeTest, ReplacesTheImageAndKeepsTheThumbnail)
+{
+    char out[512];
+    ASSERT_EQ(album_transcode_file(ImagePath("a.png").c_str(), out, sizeof(out)), ESP_OK);
+    EXPECT_EQ(std::string(out), ImagePath("a.epdgz"));
+    EXPECT_EQ(Contents("a.epdgz"), "rendered:a.png");
+    EXPECT_FALSE(Exists("a.png"));
+    EXPECT_FALSE(Exists("a.epdgz.tmp"));
+    EXPECT_TRUE(Exists("a.jpg"));
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"a.epdgz", "b.bmp", "c.epdgz"}));
+}
+
+TEST_F(AlbumTranscodeTest, ReplacesAnEarlierRenderingOfTheSameName)
+{
+    Touch(ImagePath("c.png"));
+    album_index_note_added(ImagePath("c.png").c_str());
+
+    ASSERT_EQ(album_transcode_file(ImagePath("c.png").c_str(), NULL, 0), ESP_OK);
+    EXPECT_EQ(Contents("c.epdgz"), "rendered:c.png");
+    EXPECT_EQ(IndexedNames(), (std::multiset<std::string>{"a.png", "b.bmp", "c.epdgz"}));
+}
+
+TEST_F(AlbumTranscodeTest, FailuresKeepTheOriginal)
+{
+    display_busy = true;
+    EXPECT_EQ(album_transcode_file(ImagePath("a.png").c_str(), NULL, 0), ESP_ERR_TIMEOUT);
+    EXPECT_TRUE(Exists("a.png"));
+    EXPECT_FALSE(Exists("a.epdgz"));
+
+    display_busy = false;
+    Touch(ImagePath("broken.png"));
+    EXPECT_EQ(album_transcode_file(ImagePath("broken.png").c_str(), NULL, 0), ESP_FAIL);
+    EXPECT_TRUE(Exists("broken.png"));
+    EXPECT_FALSE(Exists("broken.epdgz"));
+}
+
+TEST_F(AlbumTranscodeTest, OnlyPngAndBmpAreTranscoded)
+{
+    EXPECT_EQ(album_transcode_file(ImagePath("c.epdgz").c_str(), NULL, 0),
+              ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(album_transcode_file(ImagePath("a.jpg").c_str(), NULL, 0), ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(album_transcode_file((std::string(IMAGE_DIRECTORY) + "/x.y/png").c_str(), NULL, 0),
+              ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(render_count, 0);
+}
+
+TEST_F(AlbumTranscodeTest, MigrationConvertsEveryAlbum)
+{
+    std::string other = std::string(IMAGE_DIRECTORY) + "/Home";
+    mkdir(other.c_str(), 0775);
+    Touch(other + "/d.png");
+    Touch(ImagePath("broken.bmp"));
+    ASSERT_EQ(album_index_rebuild(kAlbum.c_str()), ESP_OK);
+
+    album_transcode_start_migration();
+
+    EXPECT_EQ(IndexedNames(),
+              (std::multiset<std::string>{"a.epdgz", "b.epdgz", "c.epdgz", "broken.bmp"}));
+    EXPECT_EQ(Contents("b.epdgz"), "rendered:b.bmp");
+    struct stat st;
+    EXPECT_EQ(stat((other + "/d.epdgz").c_str(), &st), 0);
+    EXPECT_NE(stat((other + "/d.png").c_str(), &st), 0);
+    EXPECT_EQ(render_count, 3);
+}
+
+}  // namespace
@@ -0,0 +1,329 @@
+// Tests for the RTC-backed rotation bookkeeping (bookkeeping.c) against a
+// fake NVS that counts commits. The module's record stands in for RTC
+// memory: calling bookkeeping_init again is a wake from deep sleep, and
+// bookkeeping_invalidate followed by init is a power-on.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "bookkeeping.h"
+#include "nvs.h"
+}
+
+namespace
+{
+
+constexpr int kFlushWakes = 4;  // CONFIG_BOOKKEEPING_FLUSH_WAKES for this target
+
+struct FakeNvs {
+    std::map<std::string, std::vector<uint8_t>> committed;
+    std::map<std::string, std::vector<uint8_t>> pending;
+    int commits = 0;
+
+    void Reset()
+    {
+        committed.clear();
+        pending.clear();
+        commits = 0;
+    }
+
+    void Put(const std::string &key, const void *data, size_t len)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        committed[key].assign(p, p + len);
+    }
+
+    std::string Str(const std::string &key)
+    {
+        auto it = committed.find(key);
+        return it == committed.end() ? "<none>" : std::string(it->second.begin(), it->second.end());
+    }
+
+    int32_t I32(const std::string &key)
+    {
+        int32_t v = INT32_MIN;
+        auto it = committed.find(key);
+        if (it != committed.end()) {
+            memcpy(&v, it->second.data(), sizeof(v));
+        }
+        return v;
+    }
+} nvs;
+
+const std::vector<uint8_t> kErased;  // pending marker for an erased key
+
+}  // namespace
+
+extern "C" {
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    (void) open_mode;
+    EXPECT_STREQ(name, NVS_NAMESPACE);
+    nvs.pending.clear();
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void) handle;
+    EXPECT_TRUE(nvs.pending.empty()) << "NVS changes left uncommitted";
+    nvs.pending.clear();
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void) handle;
+    for (auto &kv : nvs.pending) {
+        if (kv.second.empty()) {
+            nvs.committed.erase(kv.first);
+        } else {
+            nvs.committed[kv.first] = kv.second;
+        }
+    }
+    nvs.pending.clear();
+    nvs.commits++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    (void) handle;
+    if (!nvs.committed.count(key)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    nvs.pending[key] = kErased;
+    return ESP_OK;
+}
+
+static esp_err_t get(const char *key, void *out, size_t *length)
+{
+    auto it = nvs.committed.find(key);
+    if (it == nvs.committed.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*length < it->second.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out, it->second.data(), it->second.size());
+    *length = it->second.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+    (void) handle;
+    size_t len = sizeof(*out_value);
+    return get(key, out_value, &len);
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value)
+{
+    return nvs_set_blob(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    (void) handle;
+    auto it = nvs.committed.find(key);
+    if (it == nvs.committed.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*length < it->second.size() + 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, it->second.data(), it->second.size());
+    out_value[it->second.size()] = '\0';
+    *length = it->second.size() + 1;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    return nvs_set_blob(handle, key, value, strlen(value));
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    (void) handle;
+    return get(key, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    (void) handle;
+    const uint8_t *p = static_cast<const uint8_t *>(value);
+    nvs.pending[key].assign(p, p + length);
+    return ESP_OK;
+}
+
+}  // extern "C"
+
+namespace
+{
+
+class BookkeepingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        nvs.Reset();
+        PowerOn();
+    }
+
+    static void PowerOn()
+    {
+        bookkeeping_invalidate();
+        ASSERT_EQ(bookkeeping_init(), ESP_OK);
+    }
+
+    static void DeepSleepAndWake(int battery_percent = 80)
+    {
+        bookkeeping_cycle_done(battery_percent);
+        ASSERT_EQ(bookkeeping_init(), ESP_OK);
+    }
+};
+
+TEST_F(BookkeepingTest, ColdBootLoadsFromNvs)
+{
+    EXPECT_EQ(bookkeeping_get_last_index(), -1);
+    EXPECT_STREQ(bookkeeping_get_last_image(), "");
+    EXPECT_STREQ(bookkeeping_get_image_etag(), "");
+
+    int32_t index = 7;
+    shuffle_bag_t bag = {};
+    bag.seed = 42;
+    bag.half = 3;
+    nvs.Put(NVS_LAST_INDEX_KEY, &index, sizeof(index));
+    nvs.Put(NVS_SHUFFLE_BAG_KEY, &bag, sizeof(bag));
+    nvs.Put(NVS_LAST_IMAGE_KEY, "/sdcard/images/a.png", 20);
+    nvs.Put(NVS_IMAGE_ETAG_KEY, "\"v1\"", 4);
+    PowerOn();
+
+    shuffle_bag_t loaded;
+    bookkeeping_get_shuffle_bag(&loaded);
+    EXPECT_EQ(bookkeeping_get_last_index(), 7);
+    EXPECT_EQ(loaded.seed, 42u);
+    EXPECT_EQ(loaded.half, 3);
+    EXPECT_STREQ(bookkeeping_get_last_image(), "/sdcard/images/a.png");
+    EXPECT_STREQ(bookkeeping_get_image_etag(), "\"v1\"");
+    EXPECT_EQ(nvs.commits, 0);
+}
+
+TEST_F(BookkeepingTest, RotationsAreWrittenBackEveryFlushWakes)
+{
+    for (int i = 0; i < 3 * kFlushWakes; i++) {
+        bookkeeping_set_last_index(i);
+        bookkeeping_set_last_image(("/img" + std::to_string(i)).c_str());
+        DeepSleepAndWake();
+        EXPECT_EQ(nvs.commits, (i + 1) / kFlushWakes);
+        EXPECT_EQ(bookkeeping_get_last_index(), i);
+    }
+    EXPECT_EQ(nvs.I32(NVS_LAST_INDEX_KEY), 3 * kFlushWakes - 1);
+    EXPECT_EQ(nvs.Str(NVS_LAST_IMAGE_KEY), "/img" + std::to_string(3 * kFlushWakes - 1));
+}
+
+TEST_F(BookkeepingTest, DeepSleepKeepsUnflushedState)
+{
+    bookkeeping_set_last_index(3);
+    bookkeeping_set_image_etag("\"abc\"");
+    DeepSleepAndWake();
+
+    EXPECT_EQ(nvs.commits, 0);
+    EXPECT_EQ(bookkeeping_get_last_index(), 3);
+    EXPECT_STREQ(bookkeeping_get_image_etag(), "\"abc\"");
+}
+
+TEST_F(BookkeepingTest, PowerLossFallsBackToTheLastFlush)
+{
+    bookkeeping_set_last_index(1);
+    ASSERT_EQ(bookkeeping_flush(), ESP_OK);
+    bookkeeping_set_last_index(2);
+    DeepSleepAndWake();
+
+    PowerOn();
+    EXPECT_EQ(bookkeeping_get_last_index(), 1);
+    EXPECT_EQ(nvs.commits, 1);
+}
+
+TEST_F(BookkeepingTest, LowBatteryFlushesEveryCycle)
+{
+    bookkeeping_set_last_index(1);
+    DeepSleepAndWake(-1);  // no battery reading
+    EXPECT_EQ(nvs.commits, 0);
+
+    DeepSleepAndWake(10);
+    EXPECT_EQ(nvs.commits, 1);
+    EXPECT_EQ(nvs.I32(NVS_LAST_INDEX_KEY), 1);
+
+    // Nothing pending, nothing written
+    DeepSleepAndWake(10);
+    EXPECT_EQ(nvs.commits, 1);
+}
+
+TEST_F(BookkeepingTest, UnchangedValuesAreNotWritten)
+{
+    bookkeeping_set_last_index(-1);
+    bookkeeping_set_last_image("");
+    bookkeeping_set_image_etag("");
+    shuffle_bag_t bag;
+    bookkeeping_get_shuffle_bag(&bag);
+    bookkeeping_set_shuffle_bag(&bag);
+    for (int i = 0; i < 2 * kFlushWakes; i++) {
+        DeepSleepAndWake();
+    }
+    EXPECT_EQ(nvs.commits, 0);
+}
+
+TEST_F(BookkeepingTest, FlushWritesOnlyChangedFieldsInOneCommit)
+{
+    nvs.Put(NVS_IMAGE_ETAG_KEY, "\"old\"", 5);
+    PowerOn();
+
+    bookkeeping_set_image_etag("");
+    bookkeeping_set_last_index(9);
+    ASSERT_EQ(bookkeeping_flush(), ESP_OK);
+    EXPECT_EQ(nvs.commits, 1);
+    EXPECT_EQ(nvs.Str(NVS_IMAGE_ETAG_KEY), "<none>");
+    EXPECT_EQ(nvs.I32(NVS_LAST_INDEX_KEY), 9);
+    EXPECT_EQ(nvs.Str(NVS_LAST_IMAGE_KEY), "<none>");
+    EXPECT_EQ(nvs.Str(NVS_SHUFFLE_BAG_KEY), "<none>");
+
+    ASSERT_EQ(bookkeeping_flush(), ESP_OK);
+    EXPECT_EQ(nvs.commits, 1);
+}
+
+TEST(BookkeepingRecordTest, ChecksumRejectsCorruptRecords)
+{
+    bookkeeping_record_t record;
+    memset(&record, 0, sizeof(record));
+    EXPECT_FALSE(bookkeeping_record_valid(&record));
+
+    record.last_index = 5;
+    strcpy(record.last_image, "/a.png");
+    bookkeeping_record_seal(&record);
+    EXPECT_TRUE(bookkeeping_record_valid(&record));
+
+    bookkeeping_record_t flipped = record;
+    flipped.last_image[1] ^= 0x10;
+    EXPECT_FALSE(bookkeeping_record_valid(&flipped));
+
+    // A sealed record must still hold terminated strings
+    bookkeeping_record_t unterminated = record;
+    memset(unterminated.image_etag, 'x', sizeof(unterminated.image_etag));
+    bookkeeping_record_seal(&unterminated);
+    EXPECT_FALSE(bookkeeping_record_valid(&unterminated));
+}
+
+}  // namespace
@@ -0,0 +1,220 @@
+// Tests for the decoder input sources (components/byte_source): the same
+// reads, skips and maps over a memory buffer, a stdio file, a borrowed
+// stream and a MemFS file read in place.
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "byte_source.h"
+#include "fake_vfs.h"
+#include "memfs.h"
+}
+
+namespace
+{
+
+std::vector<uint8_t> Pattern(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = uint8_t(i * 7 + (i >> 9));
+    }
+    return data;
+}
+
+std::string WriteTemp(const std::vector<uint8_t> &data)
+{
+    // Per process: ctest -j runs this binary's cases side by side
+    std::string path =
+        ::testing::TempDir() + "byte_source_test_" + std::to_string(getpid()) + ".bin";
+    FILE *fp = fopen(path.c_str(), "wb");
+    EXPECT_NE(fp, nullptr);
+    fwrite(data.data(), 1, data.size(), fp);
+    fclose(fp);
+    return path;
+}
+
+// Reads everything left in odd-sized pieces
+std::vector<uint8_t> Drain(byte_source_t *src)
+{
+    std::vector<uint8_t> out;
+    uint8_t buf[777];
+    size_t n;
+    while ((n = byte_source_read(src, buf, sizeof(buf))) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    return out;
+}
+
+// Reads, skips and rewinds behave the same on every backend
+void ExpectSequentialReads(byte_source_t *src, const std::vector<uint8_t> &data)
+{
+    ASSERT_EQ(byte_source_size(src), data.size());
+
+    uint8_t head[16];
+    ASSERT_EQ(byte_source_read(src, head, sizeof(head)), sizeof(head));
+    EXPECT_EQ(std::vector<uint8_t>(head, head + 16),
+              std::vector<uint8_t>(data.begin(), data.begin() + 16));
+
+    ASSERT_EQ(byte_source_skip(src, 1000), ESP_OK);
+    EXPECT_EQ(byte_source_remaining(src), data.size() - 1016);
+    EXPECT_EQ(Drain(src), std::vector<uint8_t>(data.begin() + 1016, data.end()));
+    EXPECT_EQ(byte_source_skip(src, 1), ESP_ERR_INVALID_SIZE);
+
+    ASSERT_EQ(byte_source_rewind(src), ESP_OK);
+    EXPECT_EQ(Drain(src), data);
+}
+
+TEST(ByteSourceTest, MemoryIsReadAndMappedInPlace)
+{
+    auto data = Pattern(5000);
+    byte_source_t src;
+    byte_source_init_memory(&src, data.data(), data.size());
+    ExpectSequentialReads(&src, data);
+
+    ASSERT_EQ(byte_source_rewind(&src), ESP_OK);
+    ASSERT_EQ(byte_source_skip(&src, 100), ESP_OK);
+    size_t n;
+    const uint8_t *p = byte_source_next(&src, 50, &n);
+    EXPECT_EQ(p, data.data() + 100);
+    EXPECT_EQ(n, 50u);
+
+    const uint8_t *mapped;
+    size_t size;
+    ASSERT_EQ(byte_source_map(&src, &mapped, &size), ESP_OK);
+    EXPECT_EQ(mapped, data.data() + 150);
+    EXPECT_EQ(size, data.size() - 150);
+    EXPECT_EQ(src.copy, nullptr);
+    byte_source_close(&src);
+}
+
+TEST(ByteSourceTest, FilesAreReadThroughStdio)
+{
+    auto data = Pattern(20000);
+    std::string path = WriteTemp(data);
+
+    byte_source_t src;
+    ASSERT_EQ(byte_source_open_file(&src, path.c_str()), ESP_OK);
+    EXPECT_FALSE(byte_source_in_place(&src));
+    ExpectSequentialReads(&src, data);
+
+    size_t n;
+    ASSERT_EQ(byte_source_rewind(&src), ESP_OK);
+    EXPECT_EQ(byte_source_next(&src, 10, &n), nullptr);
+    EXPECT_EQ(n, 0u);
+
+    // Mapping copies; the source then reads the copy
+    ASSERT_EQ(byte_source_skip(&src, 5), ESP_OK);
+    const uint8_t *mapped;
+    size_t size;
+    ASSERT_EQ(byte_source_map(&src, &mapped, &size), ESP_OK);
+    ASSERT_NE(src.copy, nullptr);
+    EXPECT_EQ(std::vector<uint8_t>(mapped, mapped + size),
+              std::vector<uint8_t>(data.begin() + 5, data.end()));
+    EXPECT_TRUE(byte_source_in_place(&src));
+    EXPECT_EQ(Drain(&src), std::vector<uint8_t>(data.begin() + 5, data.end()));
+    byte_source_close(&src);
+
+    remove(path.c_str());
+    EXPECT_EQ(byte_source_open_file(&src, path.c_str()), ESP_FAIL);
+    byte_source_close(&src);
+}
+
+TEST(ByteSourceTest, StreamsStartAtTheCurrentPosition)
+{
+    auto data = Pattern(3000);
+    std::string path = WriteTemp(data);
+    FILE *fp = fopen(path.c_str(), "rb");
+    ASSERT_NE(fp, nullptr);
+    fseek(fp, 1200, SEEK_SET);
+
+    std::vector<uint8_t> tail(data.begin() + 1200, data.end());
+    byte_source_t src;
+    byte_source_init_stream(&src, fp);
+    ExpectSequentialReads(&src, tail);
+    byte_source_close(&src);
+
+    // The borrowed stream is still open
+    EXPECT_EQ(fseek(fp, 0, SEEK_SET), 0);
+    EXPECT_EQ(fgetc(fp), data[0]);
+    fclose(fp);
+    remove(path.c_str());
+}
+
+class ByteSourceMemfsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(memfs_mount("/bs", 4), ESP_OK);
+    }
+
+    void TearDown() override
+    {
+        EXPECT_EQ(memfs_unmount("/bs"), ESP_OK);
+    }
+};
+
+TEST_F(ByteSourceMemfsTest, RamFilesAreReadFromTheirExtents)
+{
+    auto data = Pattern(2 * MEMFS_EXTENT_SIZE + 300);
+    ASSERT_EQ(fake_vfs_write_file("/bs/a", data.data(), data.size()), 0);
+
+    byte_source_t src;
+    ASSERT_EQ(byte_source_open_file(&src, "/bs/a"), ESP_OK);
+    EXPECT_TRUE(byte_source_in_place(&src));
+    ExpectSequentialReads(&src, data);
+
+    // Direct runs stop at extent boundaries
+    ASSERT_EQ(byte_source_rewind(&src), ESP_OK);
+    ASSERT_EQ(byte_source_skip(&src, MEMFS_EXTENT_SIZE - 10), ESP_OK);
+    size_t n;
+    const uint8_t *p = byte_source_next(&src, SIZE_MAX, &n);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(n, 10u);
+    EXPECT_EQ(p[0], data[MEMFS_EXTENT_SIZE - 10]);
+    p = byte_source_next(&src, 4, &n);
+    EXPECT_EQ(n, 4u);
+    EXPECT_EQ(p[0], data[MEMFS_EXTENT_SIZE]);
+
+    // Pinned while open
+    EXPECT_EQ(fake_vfs_unlink("/bs/a"), -1);
+
+    // Spread over extents: mapping copies and unpins the file
+    const uint8_t *mapped;
+    size_t size;
+    ASSERT_EQ(byte_source_map(&src, &mapped, &size), ESP_OK);
+    ASSERT_NE(src.copy, nullptr);
+    EXPECT_EQ(size, data.size() - MEMFS_EXTENT_SIZE - 4);
+    EXPECT_EQ(fake_vfs_unlink("/bs/a"), 0);
+    EXPECT_EQ(std::vector<uint8_t>(mapped, mapped + size),
+              std::vector<uint8_t>(data.begin() + MEMFS_EXTENT_SIZE + 4, data.end()));
+    byte_source_close(&src);
+}
+
+TEST_F(ByteSourceMemfsTest, TheLastExtentMapsInPlace)
+{
+    auto data = Pattern(MEMFS_EXTENT_SIZE + 500);
+    ASSERT_EQ(fake_vfs_write_file("/bs/b", data.data(), data.size()), 0);
+
+    byte_source_t src;
+    ASSERT_EQ(byte_source_open_file(&src, "/bs/b"), ESP_OK);
+    ASSERT_EQ(byte_source_skip(&src, MEMFS_EXTENT_SIZE + 20), ESP_OK);
+    const uint8_t *mapped;
+    size_t size;
+    ASSERT_EQ(byte_source_map(&src, &mapped, &size), ESP_OK);
+    EXPECT_EQ(src.copy, nullptr);
+    EXPECT_EQ(size, 480u);
+    EXPECT_EQ(mapped[0], data[MEMFS_EXTENT_SIZE + 20]);
+    byte_source_close(&src);
+
+    // Closing unpins
+    EXPECT_EQ(fake_vfs_unlink("/bs/b"), 0);
+}
+
+}  // namespace
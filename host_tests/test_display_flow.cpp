@@ -2,7 +2,7 @@
 // flows (display_flow.c), including what /api/current_image ends up serving
 // after each flow's disposal. FS_MOUNT_POINT is redirected to a local
 // directory (see CMakeLists), so every CURRENT_*_PATH lands in
-// pf_storage/ under the test's working directory.
+// pf_storage/ under a fresh working directory per test.
 
 #include <gtest/gtest.h>
 #include <sys/stat.h>
@@ -19,17 +19,13 @@ extern "C" {
 extern bool test_storage_persistent;
 }
 
+#include "test_work_dir.h"
+
 namespace
 {
 
 const char *kStorageDir = FS_MOUNT_POINT;
 
-void RemoveTree(const std::string &dir)
-{
-    std::string cmd = "rm -rf '" + dir + "'";
-    system(cmd.c_str());
-}
-
 void Touch(const std::string &path, const std::string &content)
 {
     std::ofstream f(path, std::ios::binary);
@@ -81,16 +77,18 @@ Served ServeCurrent()
 class DisplayFlowTest : public ::testing::Test
 {
    protected:
+    TestWorkDir work_dir;
+
     void SetUp() override
     {
-        RemoveTree(kStorageDir);
+        ASSERT_NO_FATAL_FAILURE(work_dir.Enter());
         ASSERT_EQ(mkdir(kStorageDir, 0755), 0);
         test_storage_persistent = true;
     }
 
     void TearDown() override
     {
-        RemoveTree(kStorageDir);
+        work_dir.Leave();
     }
 
     std::string Upload(const std::string &content = "original")
@@ -136,6 +134,38 @@ TEST_F(DisplayFlowTest, StageFileFailureConsumesSource)
     EXPECT_FALSE(Exists(src));
 }
 
+// --- display_flow_move_file -----------------------------------------------
+
+TEST_F(DisplayFlowTest, MoveFileKeepsSourceOnFailure)
+{
+    std::string src = Upload("image");
+    std::string dst = std::string(kStorageDir) + "/moved.png";
+    ASSERT_EQ(display_flow_move_file(src.c_str(), dst.c_str()), ESP_OK);
+    EXPECT_FALSE(Exists(src));
+    EXPECT_EQ(ReadAll(dst), "image");
+
+    std::string nowhere = std::string(kStorageDir) + "/missing/dir.png";
+    EXPECT_NE(display_flow_move_file(dst.c_str(), nowhere.c_str()), ESP_OK);
+    EXPECT_EQ(ReadAll(dst), "image");
+}
+
+TEST_F(DisplayFlowTest, MoveFileCopiesAcrossMounts)
+{
+    // Staging and albums sit on different mounts on the device; a tmpfs
+    // stands in for the other one where there is one
+    struct stat here, shm;
+    if (stat(kStorageDir, &here) != 0 || stat("/dev/shm", &shm) != 0 ||
+        here.st_dev == shm.st_dev || access("/dev/shm", W_OK) != 0) {
+        GTEST_SKIP() << "no second filesystem to move across";
+    }
+    std::string src = Upload(std::string(10000, 'x'));
+    std::string dst = "/dev/shm/pf_display_flow_move.png";
+    ASSERT_EQ(display_flow_move_file(src.c_str(), dst.c_str()), ESP_OK);
+    EXPECT_FALSE(Exists(src));
+    EXPECT_EQ(ReadAll(dst), std::string(10000, 'x'));
+    unlink(dst.c_str());
+}
+
 // --- display_flow_retire_source -------------------------------------------
 
 TEST_F(DisplayFlowTest, RetireJpgKeepsOriginalAsThumbnail)
@@ -254,6 +284,23 @@ TEST_F(DisplayFlowTest, DropStaleOnMemFsKeepsNoImageFile)
     EXPECT_TRUE(Exists(CURRENT_JPG_PATH));  // thumbnail kept when requested
 }
 
+TEST_F(DisplayFlowTest, PatchedFrameSnapshotSurvivesOnMemFs)
+{
+    test_storage_persistent = false;
+    Touch(CURRENT_PNG_PATH, "png");
+    Touch(CURRENT_JPG_PATH, "thumb");
+    Touch(CURRENT_EPD_PATH, "epd");
+    WriteLink(CURRENT_EPD_PATH);
+
+    display_flow_keep_frame_snapshot();
+
+    // The link names the snapshot, and the snapshot is still there
+    EXPECT_TRUE(Exists(CURRENT_EPD_PATH));
+    EXPECT_FALSE(Exists(CURRENT_PNG_PATH));
+    EXPECT_FALSE(Exists(CURRENT_JPG_PATH));
+    EXPECT_EQ(ReadAll(CURRENT_IMAGE_LINK), CURRENT_EPD_PATH);
+}
+
 // --- display_flow_open_current (what /api/current_image serves) ----------
 
 TEST_F(DisplayFlowTest, ServeCurrentPrefersThumbnailSibling)
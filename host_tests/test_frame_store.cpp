@@ -0,0 +1,282 @@
+// Tests for the frame store (frame_store.c) against a fake NOR flash
+// partition: erases set bytes to 0xFF, writes can only clear bits, and
+// mappings point straight into the flash image.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "frame_store.h"
+}
+
+namespace
+{
+
+constexpr size_t kFrameBytes = 1000;
+constexpr size_t kSlotSize = 0x10000;  // 256-byte header + frame, rounded to 64 KB
+constexpr int kSlots = 4;
+
+struct FakeFlash {
+    bool present = true;
+    esp_partition_t part = {};
+    std::vector<uint8_t> bytes;
+    std::vector<int> erases;  // per slot
+    int bits_set = 0;         // writes that tried to turn a 0 bit into a 1
+    int mapped = 0;
+
+    void Reset()
+    {
+        present = true;
+        part = {};
+        part.type = ESP_PARTITION_TYPE_DATA;
+        part.size = kSlots * kSlotSize;
+        part.erase_size = 4096;
+        strcpy(part.label, FRAME_STORE_PARTITION_LABEL);
+        bytes.assign(part.size, 0xFF);
+        erases.assign(kSlots, 0);
+        bits_set = 0;
+        mapped = 0;
+    }
+} flash;
+
+}  // namespace
+
+extern "C" {
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label)
+{
+    (void) type;
+    (void) subtype;
+    return flash.present && strcmp(label, FRAME_STORE_PARTITION_LABEL) == 0 ? &flash.part
+                                                                             : nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst,
+                             size_t size)
+{
+    if (src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, flash.bytes.data() + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset,
+                              const void *src, size_t size)
+{
+    if (dst_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    for (size_t i = 0; i < size; i++) {
+        uint8_t &b = flash.bytes[dst_offset + i];
+        if (in[i] & ~b) {
+            flash.bits_set++;
+        }
+        b &= in[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (offset % partition->erase_size || size % partition->erase_size ||
+        offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(flash.bytes.data() + offset, 0xFF, size);
+    for (size_t slot = offset / kSlotSize; slot < (offset + size) / kSlotSize; slot++) {
+        flash.erases[slot]++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle)
+{
+    (void) memory;
+    if (offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_ptr = flash.bytes.data() + offset;
+    *out_handle = ++flash.mapped;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+    (void) handle;
+    flash.mapped--;
+}
+
+}  // extern "C"
+
+namespace
+{
+
+std::vector<uint8_t> FrameOf(uint8_t seed)
+{
+    std::vector<uint8_t> frame(kFrameBytes);
+    for (size_t i = 0; i < frame.size(); i++) {
+        frame[i] = uint8_t(seed + i * 7);
+    }
+    return frame;
+}
+
+// Write a frame in a few pieces and commit it
+void Store(const std::string &key, uint8_t seed, uint32_t stamp = 1, uint32_t layout = 2)
+{
+    auto frame = FrameOf(seed);
+    frame_store_writer_t writer;
+    ASSERT_EQ(frame_store_begin(key.c_str(), stamp, layout, frame.size(), &writer), ESP_OK);
+    ASSERT_EQ(frame_store_append(&writer, frame.data(), 300), ESP_OK);
+    ASSERT_EQ(frame_store_append(&writer, frame.data() + 300, frame.size() - 300), ESP_OK);
+    ASSERT_EQ(frame_store_commit(&writer), ESP_OK);
+}
+
+// Stored frame contents for key, or empty on a miss
+std::vector<uint8_t> Find(const std::string &key, uint32_t stamp = 1, uint32_t layout = 2)
+{
+    frame_store_frame_t frame;
+    if (frame_store_find(key.c_str(), stamp, layout, &frame) != ESP_OK) {
+        return {};
+    }
+    EXPECT_GE(frame.data, flash.bytes.data());
+    EXPECT_LT(frame.data, flash.bytes.data() + flash.bytes.size());
+    std::vector<uint8_t> out(frame.data, frame.data + frame.length);
+    frame_store_release(&frame);
+    return out;
+}
+
+// Slot whose data the frame for key maps to
+int SlotOf(const std::string &key)
+{
+    frame_store_frame_t frame;
+    if (frame_store_find(key.c_str(), 1, 2, &frame) != ESP_OK) {
+        return -1;
+    }
+    int slot = int((frame.data - flash.bytes.data()) / kSlotSize);
+    frame_store_release(&frame);
+    return slot;
+}
+
+class FrameStoreTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        flash.Reset();
+        ASSERT_EQ(frame_store_init(kFrameBytes), ESP_OK);
+    }
+
+    void TearDown() override
+    {
+        EXPECT_EQ(flash.bits_set, 0) << "a write needed an erase first";
+        EXPECT_EQ(flash.mapped, 0) << "a mapping was not released";
+    }
+};
+
+TEST_F(FrameStoreTest, StoredFramesAreMappedFromFlash)
+{
+    EXPECT_EQ(frame_store_slot_count(), kSlots);
+    EXPECT_TRUE(Find("/a.png").empty());
+    Store("/a.png", 1);
+    Store("/b.png", 2);
+    EXPECT_EQ(Find("/a.png"), FrameOf(1));
+    EXPECT_EQ(Find("/b.png"), FrameOf(2));
+}
+
+TEST_F(FrameStoreTest, StampAndLayoutMustMatch)
+{
+    Store("/a.png", 1, 10, 20);
+    EXPECT_EQ(Find("/a.png", 10, 20), FrameOf(1));
+    EXPECT_TRUE(Find("/a.png", 11, 20).empty());
+    EXPECT_TRUE(Find("/a.png", 10, 21).empty());
+}
+
+TEST_F(FrameStoreTest, RewritingAKeyRetiresTheOldFrame)
+{
+    Store("/a.png", 1);
+    int first = SlotOf("/a.png");
+    Store("/a.png", 2);
+    EXPECT_NE(SlotOf("/a.png"), first);
+    EXPECT_EQ(Find("/a.png"), FrameOf(2));
+
+    // The retired copy stays retired across a restart
+    ASSERT_EQ(frame_store_init(kFrameBytes), ESP_OK);
+    EXPECT_EQ(Find("/a.png"), FrameOf(2));
+    frame_store_forget("/a.png");
+    EXPECT_TRUE(Find("/a.png").empty());
+}
+
+TEST_F(FrameStoreTest, UncommittedFramesAreNotFound)
+{
+    auto frame = FrameOf(1);
+    frame_store_writer_t writer;
+    ASSERT_EQ(frame_store_begin("/a.png", 1, 2, frame.size(), &writer), ESP_OK);
+    ASSERT_EQ(frame_store_append(&writer, frame.data(), frame.size() - 1), ESP_OK);
+    EXPECT_EQ(frame_store_commit(&writer), ESP_ERR_INVALID_STATE);
+    EXPECT_EQ(frame_store_append(&writer, frame.data(), 2), ESP_ERR_INVALID_SIZE);
+    EXPECT_TRUE(Find("/a.png").empty());
+
+    ASSERT_EQ(frame_store_init(kFrameBytes), ESP_OK);
+    EXPECT_TRUE(Find("/a.png").empty());
+}
+
+TEST_F(FrameStoreTest, WritesRotateEvenlyAcrossSlotsAndRestarts)
+{
+    for (int i = 0; i < 3 * kSlots; i++) {
+        Store("/img" + std::to_string(i), uint8_t(i));
+        EXPECT_EQ(SlotOf("/img" + std::to_string(i)), i % kSlots);
+        if (i % 5 == 0) {
+            // The round robin resumes after the newest slot
+            ASSERT_EQ(frame_store_init(kFrameBytes), ESP_OK);
+        }
+    }
+    for (int slot = 0; slot < kSlots; slot++) {
+        EXPECT_EQ(flash.erases[slot], 3);
+    }
+}
+
+TEST_F(FrameStoreTest, OldestFrameIsReplaced)
+{
+    for (int i = 0; i <= kSlots; i++) {
+        Store("/img" + std::to_string(i), uint8_t(i));
+    }
+    EXPECT_TRUE(Find("/img0").empty());
+    for (int i = 1; i <= kSlots; i++) {
+        EXPECT_EQ(Find("/img" + std::to_string(i)), FrameOf(uint8_t(i)));
+    }
+}
+
+TEST_F(FrameStoreTest, OversizedFramesAndKeysAreRejected)
+{
+    frame_store_writer_t writer;
+    EXPECT_EQ(frame_store_begin("/a.png", 1, 2, kSlotSize, &writer), ESP_ERR_INVALID_SIZE);
+    std::string long_key(FRAME_STORE_KEY_MAX, 'k');
+    EXPECT_EQ(frame_store_begin(long_key.c_str(), 1, 2, kFrameBytes, &writer),
+              ESP_ERR_INVALID_SIZE);
+    for (int slot = 0; slot < kSlots; slot++) {
+        EXPECT_EQ(flash.erases[slot], 0);
+    }
+}
+
+TEST(FrameStoreSetupTest, MissingOrTinyPartitionDisablesTheStore)
+{
+    flash.Reset();
+    flash.present = false;
+    EXPECT_EQ(frame_store_init(kFrameBytes), ESP_ERR_NOT_FOUND);
+    EXPECT_EQ(frame_store_slot_count(), 0);
+
+    flash.Reset();
+    EXPECT_EQ(frame_store_init(kSlots * kSlotSize), ESP_ERR_INVALID_SIZE);
+    EXPECT_EQ(frame_store_slot_count(), 0);
+    EXPECT_TRUE(Find("/a.png").empty());
+}
+
+}  // namespace
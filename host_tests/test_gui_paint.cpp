@@ -0,0 +1,636 @@
+// Tests for the epaper_src paint layer: the bulk span blits and the
+// streaming .epdgz reader against a per-pixel Paint_SetPixel replay, for
+// every rotation/mirror layout Paint supports, and the indexed PNG frame
+// encoder.
+
+#include <gtest/gtest.h>
+#include <png.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+extern "C" {
+#include "GUI_EPDGZfile.h"
+#include "GUI_FramePNG.h"
+#include "GUI_Paint.h"
+#include "fake_vfs.h"
+#include "memfs.h"
+}
+
+namespace
+{
+
+// Panel memory dimensions (native orientation)
+constexpr int kMemW = 64;
+constexpr int kMemH = 40;
+
+struct Frame {
+    std::vector<uint8_t> image;
+
+    Frame(int rotate, int mirror, int mem_w = kMemW, bool word_mirror = false)
+    {
+        image.assign(static_cast<size_t>((mem_w + 1) / 2) * kMemH, 0x11);
+        Paint_NewImage(image.data(), mem_w, kMemH, rotate, 0x1);
+        Paint_SetScale(6);
+        Paint_SetMirroring(mirror);
+        Paint_SetWordMirror(word_mirror);
+    }
+};
+
+// Logical-orientation payload: one nibble per pixel, packed high nibble
+// first, rows of (Paint.Width + 1) / 2 bytes
+std::vector<uint8_t> MakePayload(int w, int h)
+{
+    std::vector<uint8_t> p(static_cast<size_t>((w + 1) / 2) * h);
+    uint32_t s = 12345;
+    for (auto &b : p) {
+        s = s * 1103515245u + 12345u;
+        b = uint8_t(s >> 16);
+    }
+    return p;
+}
+
+std::vector<uint8_t> Gzip(const std::vector<uint8_t> &payload)
+{
+    z_stream strm = {};
+    EXPECT_EQ(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                           Z_DEFAULT_STRATEGY),
+              Z_OK);
+    std::vector<uint8_t> out(deflateBound(&strm, payload.size()) + 64);
+    strm.next_in = const_cast<uint8_t *>(payload.data());
+    strm.avail_in = payload.size();
+    strm.next_out = out.data();
+    strm.avail_out = out.size();
+    EXPECT_EQ(deflate(&strm, Z_FINISH), Z_STREAM_END);
+    out.resize(strm.total_out);
+    deflateEnd(&strm);
+    return out;
+}
+
+std::string WriteEpdgz(const std::vector<uint8_t> &payload, size_t truncate_to = 0)
+{
+    std::vector<uint8_t> out = Gzip(payload);
+    if (truncate_to)
+        out.resize(truncate_to);
+
+    // Per process: ctest -j runs this binary's cases side by side
+    std::string path =
+        ::testing::TempDir() + "gui_paint_test_" + std::to_string(getpid()) + ".epdgz";
+    FILE *fp = fopen(path.c_str(), "wb");
+    EXPECT_NE(fp, nullptr);
+    fwrite(out.data(), 1, out.size(), fp);
+    fclose(fp);
+    return path;
+}
+
+// Pixel (x, y) of a logical-orientation payload
+uint8_t PayloadPixel(const std::vector<uint8_t> &p, int w, int x, int y)
+{
+    uint8_t b = p[static_cast<size_t>(y) * ((w + 1) / 2) + x / 2];
+    return (x % 2 == 0) ? (b >> 4) : (b & 0x0F);
+}
+
+class EpdgzLayoutTest : public ::testing::TestWithParam<std::tuple<int, int>>
+{
+};
+
+TEST_P(EpdgzLayoutTest, StreamedFrameMatchesPerPixelReplay)
+{
+    int rotate = std::get<0>(GetParam());
+    int mirror = std::get<1>(GetParam());
+
+    // Reference: the pre-streaming reader's per-pixel replay
+    Frame ref(rotate, mirror);
+    int w = Paint.Width, h = Paint.Height;
+    auto payload = MakePayload(w, h);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            Paint_SetPixel(x, y, PayloadPixel(payload, w, x, y));
+
+    Frame got(rotate, mirror);
+    std::string path = WriteEpdgz(payload);
+    ASSERT_EQ(GUI_ReadEPDGZ(path.c_str()), 0);
+    remove(path.c_str());
+
+    EXPECT_EQ(got.image, ref.image);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            ASSERT_EQ(Paint_GetPixel(x, y), PayloadPixel(payload, w, x, y))
+                << "at (" << x << "," << y << ")";
+}
+
+TEST_P(EpdgzLayoutTest, RawRowsMatchTheStreamedFrame)
+{
+    int rotate = std::get<0>(GetParam());
+    int mirror = std::get<1>(GetParam());
+
+    Frame ref(rotate, mirror);
+    auto payload = MakePayload(Paint.Width, Paint.Height);
+    std::string path = WriteEpdgz(payload);
+    ASSERT_EQ(GUI_ReadEPDGZ(path.c_str()), 0);
+    remove(path.c_str());
+
+    Frame got(rotate, mirror);
+    ASSERT_EQ(GUI_ReadEPDRows(payload.data(), payload.size()), 0);
+    EXPECT_EQ(got.image, ref.image);
+    EXPECT_NE(GUI_ReadEPDRows(payload.data(), payload.size() - 1), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllLayouts, EpdgzLayoutTest,
+                         ::testing::Combine(::testing::Values(ROTATE_0, ROTATE_90, ROTATE_180,
+                                                              ROTATE_270),
+                                            ::testing::Values(MIRROR_NONE, MIRROR_HORIZONTAL,
+                                                              MIRROR_VERTICAL, MIRROR_ORIGIN)));
+
+// A .epdgz on a RAM filesystem inflates straight out of its extents, with
+// the same result as the stdio path, also when the gzip stream spans several
+// extents (the 1024-wide frame)
+TEST(EpdgzMemfsTest, InPlaceReadsMatchTheFileRead)
+{
+    ASSERT_EQ(memfs_mount("/mem", 4), ESP_OK);
+    const std::tuple<int, int> layouts[] = {{kMemW, ROTATE_90}, {1024, ROTATE_180}};
+    for (const auto &layout : layouts) {
+        int mem_w = std::get<0>(layout);
+        int rotate = std::get<1>(layout);
+
+        Frame ref(rotate, MIRROR_NONE, mem_w);
+        auto payload = MakePayload(Paint.Width, Paint.Height);
+        std::string path = WriteEpdgz(payload);
+        ASSERT_EQ(GUI_ReadEPDGZ(path.c_str()), 0);
+        remove(path.c_str());
+
+        auto gz = Gzip(payload);
+        if (mem_w > kMemW) {
+            EXPECT_GT(gz.size(), size_t(MEMFS_EXTENT_SIZE));
+        }
+        ASSERT_EQ(fake_vfs_write_file("/mem/frame.epdgz", gz.data(), gz.size()), 0);
+        Frame got(rotate, MIRROR_NONE, mem_w);
+        ASSERT_EQ(GUI_ReadEPDGZ("/mem/frame.epdgz"), 0);
+        EXPECT_EQ(got.image, ref.image);
+
+        // A memory source too, with trailing bytes past the gzip member
+        auto padded = gz;
+        padded.insert(padded.end(), 16, 0xEE);
+        byte_source_t src;
+        byte_source_init_memory(&src, padded.data(), padded.size());
+        Frame from_memory(rotate, MIRROR_NONE, mem_w);
+        ASSERT_EQ(GUI_ReadEPDGZSource(&src), 0);
+        byte_source_close(&src);
+        EXPECT_EQ(from_memory.image, ref.image);
+
+        // A truncated stream fails the same way
+        gz.resize(gz.size() - 10);
+        ASSERT_EQ(fake_vfs_write_file("/mem/frame.epdgz", gz.data(), gz.size()), 0);
+        EXPECT_NE(GUI_ReadEPDGZ("/mem/frame.epdgz"), 0);
+
+        // The file is not left pinned
+        EXPECT_EQ(fake_vfs_unlink("/mem/frame.epdgz"), 0);
+    }
+    EXPECT_EQ(memfs_unmount("/mem"), ESP_OK);
+}
+
+// Spans as (x, y, count): both nibble alignments, odd and even counts,
+// single pixels and spans running past the right edge
+const int kSpans[][3] = {{0, 0, 64}, {1, 1, 9},  {2, 2, 7},   {3, 3, 1},  {0, 4, 1},
+                         {5, 5, 30}, {6, 6, 31}, {30, 7, 200}, {31, 8, 2}, {0, 39, 300}};
+
+std::vector<uint8_t> SpanIndices(int count, int seed)
+{
+    std::vector<uint8_t> v(count);
+    for (int i = 0; i < count; i++)
+        v[i] = uint8_t((i * 7 + seed * 3) & 0x0F);
+    return v;
+}
+
+// The reference blit: one clipped Paint_SetPixel per pixel
+void SetPixelSpan(int x0, int y, const std::vector<uint8_t> &idx)
+{
+    for (int i = 0; i < (int) idx.size(); i++)
+        if (x0 + i < Paint.Width && y < Paint.Height)
+            Paint_SetPixel(x0 + i, y, idx[i]);
+}
+
+std::vector<uint8_t> Pack(const std::vector<uint8_t> &idx)
+{
+    std::vector<uint8_t> p((idx.size() + 1) / 2, 0);
+    for (size_t i = 0; i < idx.size(); i++)
+        p[i / 2] |= (i % 2 == 0) ? uint8_t(idx[i] << 4) : idx[i];
+    return p;
+}
+
+class BlitLayoutTest : public ::testing::TestWithParam<std::tuple<int, int, int>>
+{
+  protected:
+    int rotate() const { return std::get<0>(GetParam()); }
+    int mirror() const { return std::get<1>(GetParam()); }
+    int mem_w() const { return std::get<2>(GetParam()); }
+};
+
+TEST_P(BlitLayoutTest, SpanIndicesMatchesSetPixel)
+{
+    Frame ref(rotate(), mirror(), mem_w());
+    int seed = 0;
+    for (auto &s : kSpans)
+        SetPixelSpan(s[0], s[1], SpanIndices(s[2], seed++));
+
+    Frame got(rotate(), mirror(), mem_w());
+    seed = 0;
+    for (auto &s : kSpans) {
+        auto idx = SpanIndices(s[2], seed++);
+        Paint_BlitSpanIndices(s[0], s[1], idx.data(), s[2]);
+    }
+    EXPECT_EQ(got.image, ref.image);
+}
+
+TEST_P(BlitLayoutTest, Row4bppMatchesSetPixel)
+{
+    Frame ref(rotate(), mirror(), mem_w());
+    int seed = 0;
+    for (auto &s : kSpans)
+        SetPixelSpan(s[0], s[1], SpanIndices(s[2], seed++));
+
+    Frame got(rotate(), mirror(), mem_w());
+    seed = 0;
+    for (auto &s : kSpans) {
+        auto packed = Pack(SpanIndices(s[2], seed++));
+        Paint_BlitRow4bpp(s[0], s[1], packed.data(), s[2]);
+    }
+    EXPECT_EQ(got.image, ref.image);
+}
+
+TEST_P(BlitLayoutTest, ReadRow4bppMatchesGetPixel)
+{
+    Frame f(rotate(), mirror(), mem_w());
+    int w = Paint.Width, h = Paint.Height;
+    for (int y = 0; y < h; y++)
+        SetPixelSpan(0, y, SpanIndices(w, y));
+
+    for (auto &s : kSpans) {
+        std::vector<uint8_t> expect(s[2], 0);
+        for (int i = 0; i < s[2]; i++)
+            if (s[0] + i < w && s[1] < h)
+                expect[i] = Paint_GetPixel(s[0] + i, s[1]);
+        std::vector<uint8_t> got((s[2] + 1) / 2, 0xAA);
+        Paint_ReadRow4bpp(s[0], s[1], got.data(), s[2]);
+        EXPECT_EQ(got, Pack(expect)) << "span at (" << s[0] << "," << s[1] << ")";
+    }
+}
+
+TEST_P(BlitLayoutTest, OffImageSpansAreIgnored)
+{
+    Frame f(rotate(), mirror(), mem_w());
+    std::vector<uint8_t> before = f.image;
+    auto idx = SpanIndices(8, 1);
+    Paint_BlitSpanIndices(Paint.Width, 0, idx.data(), 8);
+    Paint_BlitSpanIndices(0, Paint.Height, idx.data(), 8);
+    Paint_BlitRow4bpp(0, Paint.Height, Pack(idx).data(), 8);
+    Paint_BlitSpanIndices(3, 3, idx.data(), 0);
+    EXPECT_EQ(f.image, before);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllLayouts, BlitLayoutTest,
+                         ::testing::Combine(::testing::Values(ROTATE_0, ROTATE_90, ROTATE_180,
+                                                              ROTATE_270),
+                                            ::testing::Values(MIRROR_NONE, MIRROR_HORIZONTAL,
+                                                              MIRROR_VERTICAL, MIRROR_ORIGIN),
+                                            ::testing::Values(kMemW, kMemW - 1)));
+
+// Frames kept in the panel's reversed 16-bit word order must agree with the
+// per-pixel reference in every layout; only the memory placement differs
+class WordMirrorLayoutTest : public ::testing::TestWithParam<std::tuple<int, int>>
+{
+  protected:
+    int rotate() const { return std::get<0>(GetParam()); }
+    int mirror() const { return std::get<1>(GetParam()); }
+};
+
+TEST_P(WordMirrorLayoutTest, BlitsMatchSetPixel)
+{
+    Frame ref(rotate(), mirror(), kMemW, true);
+    int seed = 0;
+    for (auto &s : kSpans)
+        SetPixelSpan(s[0], s[1], SpanIndices(s[2], seed++));
+
+    Frame spans(rotate(), mirror(), kMemW, true);
+    seed = 0;
+    for (auto &s : kSpans) {
+        auto idx = SpanIndices(s[2], seed++);
+        Paint_BlitSpanIndices(s[0], s[1], idx.data(), s[2]);
+    }
+    EXPECT_EQ(spans.image, ref.image);
+
+    Frame rows(rotate(), mirror(), kMemW, true);
+    seed = 0;
+    for (auto &s : kSpans) {
+        auto packed = Pack(SpanIndices(s[2], seed++));
+        Paint_BlitRow4bpp(s[0], s[1], packed.data(), s[2]);
+    }
+    EXPECT_EQ(rows.image, ref.image);
+}
+
+TEST_P(WordMirrorLayoutTest, ReadRow4bppAndEpdgzRoundTrip)
+{
+    Frame f(rotate(), mirror(), kMemW, true);
+    int w = Paint.Width, h = Paint.Height;
+    auto payload = MakePayload(w, h);
+    std::string path = WriteEpdgz(payload);
+    ASSERT_EQ(GUI_ReadEPDGZ(path.c_str()), 0);
+    remove(path.c_str());
+
+    size_t row_bytes = (w + 1) / 2;
+    std::vector<uint8_t> row(row_bytes);
+    for (int y = 0; y < h; y++) {
+        Paint_ReadRow4bpp(0, y, row.data(), w);
+        ASSERT_TRUE(std::equal(row.begin(), row.end(), payload.begin() + y * row_bytes))
+            << "row " << y;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllLayouts, WordMirrorLayoutTest,
+                         ::testing::Combine(::testing::Values(ROTATE_0, ROTATE_90, ROTATE_180,
+                                                              ROTATE_270),
+                                            ::testing::Values(MIRROR_NONE, MIRROR_HORIZONTAL,
+                                                              MIRROR_VERTICAL, MIRROR_ORIGIN)));
+
+TEST(WordMirrorTest, RowsAreStoredInReversedWordOrder)
+{
+    Frame f(ROTATE_0, MIRROR_NONE, kMemW, true);
+    ASSERT_EQ(Paint.WordMirror, 1);
+    std::vector<uint8_t> idx = {0x2, 0x3, 0x4, 0x5, 0x6};
+    Paint_BlitSpanIndices(0, 0, idx.data(), idx.size());
+
+    // Pixels 0-3 form the last word of the row, pixel 4 the one before it
+    const size_t last = kMemW / 2 - 2;
+    EXPECT_EQ(f.image[last], 0x23);
+    EXPECT_EQ(f.image[last + 1], 0x45);
+    EXPECT_EQ(f.image[last - 2], 0x61);
+}
+
+TEST(WordMirrorTest, OddMemoryWidthIsRefused)
+{
+    Frame f(ROTATE_0, MIRROR_NONE, kMemW - 1, true);
+    EXPECT_EQ(Paint.WordMirror, 0);
+}
+
+TEST(EpdgzReaderTest, TruncatedFileFails)
+{
+    Frame f(ROTATE_0, MIRROR_NONE);
+    auto payload = MakePayload(Paint.Width, Paint.Height);
+    std::string path = WriteEpdgz(payload, 200);
+    EXPECT_NE(GUI_ReadEPDGZ(path.c_str()), 0);
+    remove(path.c_str());
+}
+
+TEST(EpdgzReaderTest, ShortPayloadLeavesRestCleared)
+{
+    Frame f(ROTATE_180, MIRROR_NONE);
+    int w = Paint.Width;
+    auto payload = MakePayload(w, 10);  // 10 of 40 rows
+    std::string path = WriteEpdgz(payload);
+    ASSERT_EQ(GUI_ReadEPDGZ(path.c_str()), 0);
+    remove(path.c_str());
+    for (int x = 0; x < w; x++) {
+        ASSERT_EQ(Paint_GetPixel(x, 9), PayloadPixel(payload, w, x, 9));
+        ASSERT_EQ(Paint_GetPixel(x, 10), 0x1);
+    }
+}
+
+TEST(EpdgzReaderTest, EmbeddedPayloadIsReadFromTheStreamPosition)
+{
+    Frame f(ROTATE_0, MIRROR_NONE);
+    int w = Paint.Width;
+    auto payload = MakePayload(w, Paint.Height);
+    std::string path = WriteEpdgz(payload);
+
+    // Surround the payload with unrelated bytes, as in an album pack
+    FILE *in = fopen(path.c_str(), "rb");
+    ASSERT_NE(in, nullptr);
+    std::vector<uint8_t> gz(4096);
+    gz.resize(fread(gz.data(), 1, gz.size(), in));
+    fclose(in);
+    const std::vector<uint8_t> junk(300, 0xA5);
+    FILE *fp = fopen(path.c_str(), "wb+");
+    ASSERT_NE(fp, nullptr);
+    fwrite(junk.data(), 1, junk.size(), fp);
+    fwrite(gz.data(), 1, gz.size(), fp);
+    fwrite(junk.data(), 1, junk.size(), fp);
+
+    ASSERT_EQ(fseek(fp, (long) junk.size(), SEEK_SET), 0);
+    EXPECT_EQ(GUI_ReadEPDGZStream(fp), 0);
+    fclose(fp);
+    remove(path.c_str());
+    for (int y = 0; y < Paint.Height; y++) {
+        for (int x = 0; x < w; x++) {
+            ASSERT_EQ(Paint_GetPixel(x, y), PayloadPixel(payload, w, x, y));
+        }
+    }
+}
+
+TEST(EpdgzReaderTest, MissingFileFails)
+{
+    Frame f(ROTATE_0, MIRROR_NONE);
+    EXPECT_NE(GUI_ReadEPDGZ("/nonexistent/frame.epdgz"), 0);
+}
+
+// --- Indexed PNG frame encoder ---------------------------------------------
+
+struct PngCapture {
+    std::vector<uint8_t> bytes;
+    size_t calls = 0;
+    size_t largest = 0;
+    size_t fail_after = SIZE_MAX;  // reject the call after this many
+};
+
+int CapturePng(void *ctx, const UBYTE *data, size_t len)
+{
+    auto *c = static_cast<PngCapture *>(ctx);
+    if (c->calls++ >= c->fail_after)
+        return 1;
+    c->bytes.insert(c->bytes.end(), data, data + len);
+    c->largest = std::max(c->largest, len);
+    return 0;
+}
+
+struct DecodedPng {
+    int w = 0, h = 0;
+    int bit_depth = 0;
+    int color_type = -1;
+    std::vector<png_color> palette;
+    std::vector<uint8_t> index;  // one byte per pixel
+
+    uint8_t at(int x, int y) const { return index[static_cast<size_t>(y) * w + x]; }
+};
+
+DecodedPng DecodePng(const std::vector<uint8_t> &bytes)
+{
+    DecodedPng d;
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png_create_info_struct(png);
+    struct Src {
+        const std::vector<uint8_t> *v;
+        size_t off;
+    } src{&bytes, 0};
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        ADD_FAILURE() << "PNG decode failed";
+        return {};
+    }
+    png_set_read_fn(png, &src, [](png_structp p, png_bytep out, png_size_t len) {
+        auto *s = static_cast<Src *>(png_get_io_ptr(p));
+        if (s->off + len > s->v->size())
+            png_error(p, "read past end");
+        memcpy(out, s->v->data() + s->off, len);
+        s->off += len;
+    });
+    png_read_info(png, info);
+    d.w = png_get_image_width(png, info);
+    d.h = png_get_image_height(png, info);
+    d.bit_depth = png_get_bit_depth(png, info);
+    d.color_type = png_get_color_type(png, info);
+    png_colorp pal = nullptr;
+    int n = 0;
+    if (png_get_PLTE(png, info, &pal, &n))
+        d.palette.assign(pal, pal + n);
+    png_set_packing(png);
+    png_read_update_info(png, info);
+    d.index.resize(static_cast<size_t>(d.w) * d.h);
+    for (int y = 0; y < d.h; y++)
+        png_read_row(png, d.index.data() + static_cast<size_t>(y) * d.w, nullptr);
+    png_read_end(png, nullptr);
+    png_destroy_read_struct(&png, &info, nullptr);
+    return d;
+}
+
+void FillFrame()
+{
+    int w = Paint.Width, h = Paint.Height;
+    for (int y = 0; y < h; y++)
+        SetPixelSpan(0, y, SpanIndices(w, y));
+}
+
+class FramePngLayoutTest : public BlitLayoutTest
+{
+};
+
+TEST_P(FramePngLayoutTest, PixelsAreFrameNibbles)
+{
+    Frame f(rotate(), mirror(), mem_w());
+    FillFrame();
+    PngCapture out;
+    ASSERT_EQ(GUI_WritePng_6Color(CapturePng, &out, 1), 0);
+    DecodedPng d = DecodePng(out.bytes);
+    ASSERT_EQ(d.w, Paint.Width);
+    ASSERT_EQ(d.h, Paint.Height);
+    EXPECT_EQ(d.color_type, PNG_COLOR_TYPE_PALETTE);
+    EXPECT_EQ(d.bit_depth, 4);
+    for (int y = 0; y < d.h; y++)
+        for (int x = 0; x < d.w; x++)
+            ASSERT_EQ(d.at(x, y), Paint_GetPixel(x, y)) << "at (" << x << "," << y << ")";
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, FramePngLayoutTest,
+                         ::testing::Combine(::testing::Values(ROTATE_0, ROTATE_90, ROTATE_180,
+                                                              ROTATE_270),
+                                            ::testing::Values(MIRROR_NONE, MIRROR_HORIZONTAL),
+                                            ::testing::Values(kMemW, kMemW - 1)));
+
+TEST(FramePngTest, PalettesMatchThePanelType)
+{
+    Frame f(ROTATE_0, MIRROR_NONE);
+    PngCapture color, gray;
+    ASSERT_EQ(GUI_WritePng_6Color(CapturePng, &color, 1), 0);
+    ASSERT_EQ(GUI_WritePng_Gray16(CapturePng, &gray, 1), 0);
+    DecodedPng c = DecodePng(color.bytes);
+    DecodedPng g = DecodePng(gray.bytes);
+    ASSERT_EQ(c.palette.size(), 16u);
+    ASSERT_EQ(g.palette.size(), 16u);
+    const png_color spectra[7] = {{0, 0, 0},     {255, 255, 255}, {255, 255, 0}, {255, 0, 0},
+                                  {255, 255, 255}, {0, 0, 255},   {0, 255, 0}};
+    for (int i = 0; i < 16; i++) {
+        png_color want = i < 7 ? spectra[i] : spectra[1];
+        EXPECT_EQ(c.palette[i].red, want.red) << i;
+        EXPECT_EQ(c.palette[i].green, want.green) << i;
+        EXPECT_EQ(c.palette[i].blue, want.blue) << i;
+        EXPECT_EQ(g.palette[i].red, i * 17) << i;
+        EXPECT_EQ(g.palette[i].blue, i * 17) << i;
+    }
+}
+
+TEST(FramePngTest, ShrinkKeepsEveryNthPixel)
+{
+    Frame f(ROTATE_90, MIRROR_NONE);
+    FillFrame();
+    PngCapture out;
+    ASSERT_EQ(GUI_WritePng_Gray16(CapturePng, &out, 3), 0);
+    DecodedPng d = DecodePng(out.bytes);
+    ASSERT_EQ(d.w, (Paint.Width + 2) / 3);
+    ASSERT_EQ(d.h, (Paint.Height + 2) / 3);
+    for (int y = 0; y < d.h; y++)
+        for (int x = 0; x < d.w; x++)
+            ASSERT_EQ(d.at(x, y), Paint_GetPixel(x * 3, y * 3)) << "at (" << x << "," << y << ")";
+}
+
+TEST(FramePngTest, OutputArrivesInBoundedPieces)
+{
+    // A frame big enough to need several pieces
+    std::vector<uint8_t> image(static_cast<size_t>(400) * 300, 0);
+    Paint_NewImage(image.data(), 800, 300, ROTATE_0, 0x1);
+    Paint_SetMirroring(MIRROR_NONE);
+    Paint_SetWordMirror(0);
+    uint32_t s = 7;
+    for (auto &b : image) {
+        s = s * 1103515245u + 12345u;
+        b = uint8_t(s >> 16);
+    }
+    PngCapture out;
+    ASSERT_EQ(GUI_WritePng_6Color(CapturePng, &out, 1), 0);
+    EXPECT_GT(out.calls, 2u);
+    EXPECT_LE(out.largest, 4096u);
+    EXPECT_EQ(DecodePng(out.bytes).w, 800);
+}
+
+TEST(FramePngTest, CopiedFrameEncodesAfterThePaintTargetChanges)
+{
+    Frame f(ROTATE_180, MIRROR_NONE);
+    FillFrame();
+    std::vector<uint8_t> want(static_cast<size_t>(Paint.Width) * Paint.Height);
+    for (int y = 0; y < Paint.Height; y++)
+        for (int x = 0; x < Paint.Width; x++)
+            want[static_cast<size_t>(y) * Paint.Width + x] = Paint_GetPixel(x, y);
+
+    UWORD w = 0, h = 0;
+    UBYTE *rows = GUI_ReadFrame4bpp(1, &w, &h);
+    ASSERT_NE(rows, nullptr);
+    EXPECT_EQ(w, Paint.Width);
+    EXPECT_EQ(h, Paint.Height);
+
+    // The next frame is drawn before the copy is encoded
+    Paint_Clear(0x1);
+    PngCapture out;
+    ASSERT_EQ(GUI_WritePng4bpp(rows, w, h, false, CapturePng, &out), 0);
+    free(rows);
+    DecodedPng d = DecodePng(out.bytes);
+    ASSERT_EQ(d.w, w);
+    ASSERT_EQ(d.h, h);
+    EXPECT_EQ(d.index, want);
+}
+
+TEST(FramePngTest, RejectedOutputFails)
+{
+    std::vector<uint8_t> image(static_cast<size_t>(400) * 300, 0x35);
+    Paint_NewImage(image.data(), 800, 300, ROTATE_0, 0x1);
+    Paint_SetMirroring(MIRROR_NONE);
+    Paint_SetWordMirror(0);
+    PngCapture out;
+    out.fail_after = 0;
+    EXPECT_NE(GUI_WritePng_6Color(CapturePng, &out, 1), 0);
+    EXPECT_NE(GUI_WritePng_6Color(CapturePng, &out, 0), 0);
+}
+
+}  // namespace
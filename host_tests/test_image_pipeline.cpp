@@ -13,6 +13,7 @@
 
 #include <gtest/gtest.h>
 #include <png.h>
+#include <unistd.h>
 
 #include <cstdint>
 #include <cstdio>
@@ -26,7 +27,10 @@
 extern "C" {
 #include "config_manager.h"
 #include "fake_display_manager.h"
+#include "fake_vfs.h"
 #include "image_processor.h"
+#include "jpeg_decoder.h"
+#include "memfs.h"
 #include "processing_settings.h"
 
 extern int test_board_display_width;
@@ -35,6 +39,11 @@ extern const char *test_board_display_type;
 extern display_orientation_t test_display_orientation;
 extern scale_mode_t test_scale_mode;
 extern const char *test_background_color;
+extern bool test_auto_levels;
+extern const uint8_t *test_jpeg_rgb;
+extern int test_jpeg_width;
+extern int test_jpeg_height;
+extern int test_jpeg_decode_count[4];
 }
 
 namespace
@@ -82,7 +91,8 @@ bool InGc16Palette(const Rgb &c)
 // Encode an RGB(A) image as a PNG in memory using a per-pixel generator.
 using PixelFn = std::function<Rgb(int x, int y)>;
 
-std::vector<uint8_t> EncodePng(int w, int h, const PixelFn &pixel, bool with_alpha = false)
+std::vector<uint8_t> EncodePng(int w, int h, const PixelFn &pixel, bool with_alpha = false,
+                               bool interlaced = false)
 {
     std::vector<uint8_t> out;
     png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
@@ -99,11 +109,13 @@ std::vector<uint8_t> EncodePng(int w, int h, const PixelFn &pixel, bool with_alp
         },
         nullptr);
     png_set_IHDR(png, info, w, h, 8, with_alpha ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB,
-                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+                 interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
     png_write_info(png, info);
     const int ch = with_alpha ? 4 : 3;
-    std::vector<uint8_t> row(static_cast<size_t>(w) * ch);
+    std::vector<uint8_t> image(static_cast<size_t>(w) * h * ch);
     for (int y = 0; y < h; y++) {
+        uint8_t *row = &image[static_cast<size_t>(y) * w * ch];
         for (int x = 0; x < w; x++) {
             Rgb c = pixel(x, y);
             row[x * ch] = c.r;
@@ -112,7 +124,13 @@ std::vector<uint8_t> EncodePng(int w, int h, const PixelFn &pixel, bool with_alp
             if (with_alpha)
                 row[x * ch + 3] = 255;
         }
-        png_write_row(png, row.data());
+    }
+    // Adam7 writes every row once per pass
+    int passes = png_set_interlace_handling(png);
+    for (int pass = 0; pass < passes; pass++) {
+        for (int y = 0; y < h; y++) {
+            png_write_row(png, &image[static_cast<size_t>(y) * w * ch]);
+        }
     }
     png_write_end(png, nullptr);
     png_destroy_write_struct(&png, &info);
@@ -211,17 +229,32 @@ Processed RunPipeline(const std::vector<uint8_t> &png)
     return CaptureFrame();
 }
 
-// File entry point used by the PNG display fast path.
-Processed RunPngFile(const std::vector<uint8_t> &png)
+// File entry point used by the PNG display fast path. With in_ram the file
+// lives on a RAM filesystem, which the decoders read in place.
+Processed RunPngFile(const std::vector<uint8_t> &png, bool in_ram = false)
 {
-    std::string path = ::testing::TempDir() + "pipeline_test.png";
-    FILE *fp = fopen(path.c_str(), "wb");
-    EXPECT_NE(fp, nullptr);
-    fwrite(png.data(), 1, png.size(), fp);
-    fclose(fp);
-    esp_err_t err = image_processor_process_or_display_png(path.c_str(), DITHER_FLOYD_STEINBERG,
-                                                           nullptr, false);
-    remove(path.c_str());
+    // Per process on disk: ctest -j runs this binary's cases side by side
+    std::string path = in_ram ? std::string("/mem/pipeline_test.png")
+                              : ::testing::TempDir() + "pipeline_test_" +
+                                    std::to_string(getpid()) + ".png";
+    if (in_ram) {
+        EXPECT_EQ(memfs_mount("/mem", 4), ESP_OK);
+        EXPECT_EQ(fake_vfs_write_file(path.c_str(), png.data(), png.size()), 0);
+    } else {
+        FILE *fp = fopen(path.c_str(), "wb");
+        EXPECT_NE(fp, nullptr);
+        fwrite(png.data(), 1, png.size(), fp);
+        fclose(fp);
+    }
+    esp_err_t err =
+        image_processor_process_or_display_png(path.c_str(), DITHER_FLOYD_STEINBERG, nullptr);
+    if (in_ram) {
+        // Unpinned again once the display returns
+        EXPECT_EQ(fake_vfs_unlink(path.c_str()), 0);
+        EXPECT_EQ(memfs_unmount("/mem"), ESP_OK);
+    } else {
+        remove(path.c_str());
+    }
     EXPECT_EQ(err, ESP_OK) << "display failed: " << image_processor_get_last_error();
     if (err != ESP_OK)
         return {};
@@ -239,7 +272,11 @@ class ImagePipelineTest : public ::testing::Test
         test_display_orientation = DISPLAY_ORIENTATION_LANDSCAPE;
         test_scale_mode = SCALE_MODE_COVER;
         test_background_color = "white";
+        test_auto_levels = false;
+        test_jpeg_rgb = nullptr;
+        memset(test_jpeg_decode_count, 0, sizeof(test_jpeg_decode_count));
         fake_display_reset();
+        image_processor_set_source_cache(false);
         ASSERT_EQ(image_processor_init(), ESP_OK);
     }
 };
@@ -372,6 +409,33 @@ TEST_F(ImagePipelineTest, PortraitOrientationRotationIsClockwise)
     EXPECT_EQ(p.dominant(720, 400, 40, 40), kRed) << "bottom-right";
 }
 
+// Rotated streaming buffers processing rows and paints them as column
+// tiles; the panel frame must still be the exact clockwise rotation of the
+// unrotated run's frame.
+TEST_F(ImagePipelineTest, RotatedStreamPaintsExactRotationInColumnTiles)
+{
+    auto png = EncodePng(1000, 700, [](int x, int y) {
+        return Rgb{uint8_t((x * 7 + y * 3) % 256), uint8_t((x * 2 + y * 11) % 256),
+                   uint8_t((x * 5 + y * 5) % 256)};
+    });
+    Processed upright = RunPipeline(png);
+    ASSERT_EQ(upright.w, 800);
+    ASSERT_EQ(upright.h, 480);
+
+    test_board_display_width = 480;
+    test_board_display_height = 800;
+    fake_display_reset();
+    Processed rotated = RunPipeline(png);
+    ASSERT_EQ(rotated.w, 480);
+    ASSERT_EQ(rotated.h, 800);
+    EXPECT_EQ(fake_display_column_push_count(), 0);
+    EXPECT_EQ(fake_display_tile_push_count(), 480 / 16);
+
+    for (int y = 0; y < upright.h; y++)
+        for (int x = 0; x < upright.w; x++)
+            ASSERT_EQ(rotated.at(479 - y, x), upright.at(x, y)) << "at (" << x << "," << y << ")";
+}
+
 // --- Color mapping --------------------------------------------------------
 
 // ~1% red/yellow speckle on solid white is inherent to the fast luminance
@@ -483,6 +547,29 @@ TEST_F(ImagePipelineTest, NonPaletteColorsFallBackToProcessing)
     EXPECT_TRUE(p.allInPalette());
 }
 
+// Files are decoded through a byte source rather than a RAM copy. An
+// interlaced source cannot stream, so the fallback reads the file a third
+// time, into the buffered decoder; every route must show the same frame.
+TEST_F(ImagePipelineTest, FileSourcesMatchTheBufferPipeline)
+{
+    auto pixel = [](int x, int y) {
+        return Rgb{uint8_t((x * 3 + y) % 256), uint8_t((x + y * 5) % 256), uint8_t(x ^ y)};
+    };
+    for (bool interlaced : {false, true}) {
+        SCOPED_TRACE(interlaced ? "interlaced" : "progressive");
+        auto png = EncodePng(1000, 600, pixel, false, interlaced);
+        fake_display_reset();
+        Processed buffered = RunPipeline(png);
+        fake_display_reset();
+        Processed file = RunPngFile(png);
+        fake_display_reset();
+        Processed ram = RunPngFile(png, /*in_ram=*/true);
+        ASSERT_EQ(buffered.w, 800);
+        EXPECT_TRUE(file.rgb == buffered.rgb);
+        EXPECT_TRUE(ram.rgb == buffered.rgb);
+    }
+}
+
 TEST_F(ImagePipelineTest, GarbageInputFails)
 {
     std::vector<uint8_t> junk(64, 0xAB);
@@ -584,6 +671,315 @@ TEST_F(ImagePipelineTest, CoverModeIsUnchangedByDefault)
     EXPECT_GT(p.fraction(kRed), 0.95);
 }
 
+// --- Decoded-source cache -------------------------------------------------
+
+Processed RunPipelineWith(const std::vector<uint8_t> &png, dither_algorithm_t algo)
+{
+    fake_display_reset();
+    esp_err_t err =
+        image_processor_process_to_display(png.data(), png.size(), IMAGE_FORMAT_PNG, algo, nullptr);
+    EXPECT_EQ(err, ESP_OK) << "pipeline failed: " << image_processor_get_last_error();
+    if (err != ESP_OK)
+        return {};
+    return CaptureFrame();
+}
+
+std::vector<uint8_t> CachePhoto()
+{
+    return EncodePng(1000, 700, [](int x, int y) {
+        return Rgb{uint8_t((x * 7 + y * 3) % 256), uint8_t((x * 2 + y * 11) % 256),
+                   uint8_t((x * 5 + y * 5) % 256)};
+    });
+}
+
+TEST_F(ImagePipelineTest, SourceCacheReplayMatchesFullRun)
+{
+    auto png = CachePhoto();
+    Processed expected = RunPipelineWith(png, DITHER_STUCKI);
+    EXPECT_FALSE(image_processor_source_cache_hit());
+
+    image_processor_set_source_cache(true);
+    RunPipelineWith(png, DITHER_FLOYD_STEINBERG);
+    EXPECT_FALSE(image_processor_source_cache_hit()) << "first run fills the cache";
+
+    // Only the dither setting changed: the tail replays the cached rows and
+    // must produce exactly what a full decode would
+    Processed replayed = RunPipelineWith(png, DITHER_STUCKI);
+    EXPECT_TRUE(image_processor_source_cache_hit());
+    ASSERT_EQ(replayed.w, expected.w);
+    ASSERT_EQ(replayed.h, expected.h);
+    EXPECT_EQ(replayed.rgb, expected.rgb);
+}
+
+TEST_F(ImagePipelineTest, SourceCacheMissesOnDifferentSource)
+{
+    image_processor_set_source_cache(true);
+    RunPipelineWith(CachePhoto(), DITHER_FLOYD_STEINBERG);
+    Processed p =
+        RunPipelineWith(EncodePng(1000, 700, [](int, int) { return kRed; }), DITHER_STUCKI);
+    EXPECT_FALSE(image_processor_source_cache_hit());
+    EXPECT_GT(p.fraction(kRed), 0.95);
+}
+
+TEST_F(ImagePipelineTest, SourceCacheInvalidatedByGeometryChange)
+{
+    auto png = CachePhoto();
+    image_processor_set_source_cache(true);
+    RunPipelineWith(png, DITHER_FLOYD_STEINBERG);
+
+    test_scale_mode = SCALE_MODE_FIT;
+    RunPipelineWith(png, DITHER_FLOYD_STEINBERG);
+    EXPECT_FALSE(image_processor_source_cache_hit());
+
+    test_display_orientation = DISPLAY_ORIENTATION_PORTRAIT;
+    Processed p = RunPipelineWith(png, DITHER_FLOYD_STEINBERG);
+    EXPECT_FALSE(image_processor_source_cache_hit());
+    EXPECT_EQ(p.w, 800);
+    EXPECT_EQ(p.h, 480);
+}
+
+TEST_F(ImagePipelineTest, SourceCacheReleasedWhenDisabled)
+{
+    auto png = CachePhoto();
+    image_processor_set_source_cache(true);
+    RunPipelineWith(png, DITHER_FLOYD_STEINBERG);
+    image_processor_set_source_cache(false);
+    image_processor_set_source_cache(true);
+    RunPipelineWith(png, DITHER_FLOYD_STEINBERG);
+    EXPECT_FALSE(image_processor_source_cache_hit());
+}
+
+// --- Auto-levels (JPEG 1/8-scale pre-pass) --------------------------------
+
+// The stub decoder serves `frame` for any JPEG buffer
+Processed RunJpegFrame(const std::vector<uint8_t> &frame, int w, int h)
+{
+    test_jpeg_rgb = frame.data();
+    test_jpeg_width = w;
+    test_jpeg_height = h;
+    static const uint8_t kSoi[] = {0xFF, 0xD8, 0xFF, 0xE0, 0, 0, 0, 0};
+    fake_display_reset();
+    esp_err_t err = image_processor_process_to_display(kSoi, sizeof(kSoi), IMAGE_FORMAT_JPG,
+                                                       DITHER_FLOYD_STEINBERG, nullptr);
+    test_jpeg_rgb = nullptr;
+    EXPECT_EQ(err, ESP_OK) << "pipeline failed: " << image_processor_get_last_error();
+    if (err != ESP_OK)
+        return {};
+    return CaptureFrame();
+}
+
+// Low-contrast horizontal gray ramp (90..165), no pure black or white
+std::vector<uint8_t> FlatRamp(int w, int h)
+{
+    std::vector<uint8_t> f(static_cast<size_t>(w) * h * 3);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            uint8_t v = uint8_t(90 + x * 75 / (w - 1));
+            size_t i = (static_cast<size_t>(y) * w + x) * 3;
+            f[i] = f[i + 1] = f[i + 2] = v;
+        }
+    return f;
+}
+
+TEST_F(ImagePipelineTest, AutoLevelsOffSkipsPrepass)
+{
+    Processed p = RunJpegFrame(FlatRamp(800, 480), 800, 480);
+    EXPECT_EQ(test_jpeg_decode_count[JPEG_IMAGE_SCALE_1_8], 0);
+    EXPECT_EQ(test_jpeg_decode_count[JPEG_IMAGE_SCALE_0], 1);
+    EXPECT_TRUE(p.allInPalette());
+}
+
+TEST_F(ImagePipelineTest, AutoLevelsStretchesLowContrastJpeg)
+{
+    auto frame = FlatRamp(800, 480);
+    Processed plain = RunJpegFrame(frame, 800, 480);
+
+    test_auto_levels = true;
+    Processed leveled = RunJpegFrame(frame, 800, 480);
+    EXPECT_EQ(test_jpeg_decode_count[JPEG_IMAGE_SCALE_1_8], 1) << "one DC-only pre-pass";
+    ASSERT_EQ(leveled.w, 800);
+    ASSERT_TRUE(leveled.allInPalette());
+
+    // The ramp ends become the black and white points: the dark edge turns
+    // (near) solid black and the bright edge (near) solid white, which the
+    // unleveled pass leaves as mid-tone dither
+    auto black_share = [](const Processed &p, int x0) {
+        size_t n = 0;
+        for (int y = 0; y < p.h; y++)
+            for (int x = x0; x < x0 + 16; x++)
+                n += p.at(x, y) == kBlack;
+        return double(n) / (16.0 * p.h);
+    };
+    auto white_share = [](const Processed &p, int x0) {
+        size_t n = 0;
+        for (int y = 0; y < p.h; y++)
+            for (int x = x0; x < x0 + 16; x++)
+                n += p.at(x, y) == kWhite;
+        return double(n) / (16.0 * p.h);
+    };
+    EXPECT_GT(black_share(leveled, 0), 0.9);
+    EXPECT_LT(black_share(plain, 0), 0.7);
+    EXPECT_GT(white_share(leveled, 784), 0.9);
+    EXPECT_LT(white_share(plain, 784), 0.7);
+}
+
+TEST_F(ImagePipelineTest, AutoLevelsIgnoresPngSources)
+{
+    test_auto_levels = true;
+    auto png = EncodePng(800, 480, [](int x, int) {
+        uint8_t v = uint8_t(90 + x * 75 / 799);
+        return Rgb{v, v, v};
+    });
+    Processed leveled = RunPipeline(png);
+    test_auto_levels = false;
+    fake_display_reset();
+    Processed plain = RunPipeline(png);
+    EXPECT_EQ(leveled.rgb, plain.rgb);
+}
+
+// --- Region patches -------------------------------------------------------
+
+Processed RunRegion(const std::vector<uint8_t> &data, image_format_t format, int x, int y, int w,
+                    int h)
+{
+    esp_err_t err = image_processor_process_region(data.data(), data.size(), format, x, y, w, h,
+                                                   DITHER_FLOYD_STEINBERG, nullptr);
+    EXPECT_EQ(err, ESP_OK) << "region failed: " << image_processor_get_last_error();
+    if (err != ESP_OK)
+        return {};
+    EXPECT_TRUE(fake_display_was_shown());
+    return CaptureFrame();
+}
+
+// Packed 4bpp payload, high nibble first, rows padded to whole bytes
+std::vector<uint8_t> PackNibbles(int w, int h, const std::function<uint8_t(int, int)> &value)
+{
+    const int row_bytes = (w + 1) / 2;
+    std::vector<uint8_t> out(static_cast<size_t>(row_bytes) * h, 0);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            out[y * row_bytes + x / 2] |= uint8_t(value(x, y) << ((x & 1) ? 0 : 4));
+    return out;
+}
+
+TEST_F(ImagePipelineTest, RegionPatchChangesOnlyItsRectangle)
+{
+    auto photo = [](int x, int y) {
+        return Rgb{uint8_t((x * 7 + y * 3) % 256), uint8_t((x * 2 + y * 11) % 256),
+                   uint8_t((x * 5 + y * 5) % 256)};
+    };
+    Processed before = RunPipeline(EncodePng(800, 480, photo));
+    Processed after =
+        RunRegion(EncodePng(50, 30, [](int, int) { return kRed; }), IMAGE_FORMAT_PNG, 101, 60,
+                  200, 120);
+    ASSERT_EQ(after.w, 800);
+    ASSERT_EQ(after.h, 480);
+    EXPECT_EQ(fake_display_patch_count(), 1);
+    EXPECT_EQ(fake_display_begin_count(), 1) << "a patch must not restart the frame";
+
+    for (int y = 0; y < 480; y++) {
+        for (int x = 0; x < 800; x++) {
+            if (x < 101 || x >= 301 || y < 60 || y >= 180) {
+                ASSERT_EQ(after.at(x, y), before.at(x, y)) << "at (" << x << "," << y << ")";
+            }
+        }
+    }
+    // The source is scaled into the rectangle, edge to edge
+    EXPECT_EQ(after.dominant(101, 60, 8, 8), kRed);
+    EXPECT_EQ(after.dominant(293, 172, 8, 8), kRed);
+}
+
+TEST_F(ImagePipelineTest, RawRegionIsPaintedVerbatim)
+{
+    RunPipeline(EncodePng(800, 480, [](int, int) { return kWhite; }));
+    // Odd origin and width exercise the nibble padding; index 4 is reserved
+    // and paints white
+    const Rgb colors[7] = {kBlack, kWhite, kYellow, kRed, kWhite, kBlue, kGreen};
+    auto index = [](int x, int y) { return uint8_t((x + y * 3) % 7); };
+    Processed p = RunRegion(PackNibbles(13, 9, index), IMAGE_FORMAT_RAW_4BPP, 7, 5, 13, 9);
+    for (int y = 0; y < 9; y++)
+        for (int x = 0; x < 13; x++)
+            ASSERT_EQ(p.at(7 + x, 5 + y), colors[index(x, y)]) << "at (" << x << "," << y << ")";
+    EXPECT_EQ(p.at(6, 5), kWhite);
+    EXPECT_EQ(p.at(20, 5), kWhite);
+}
+
+TEST_F(ImagePipelineTest, RawRegionOfWrongSizeIsRejected)
+{
+    RunPipeline(EncodePng(800, 480, [](int, int) { return kWhite; }));
+    // 13 pixels pack into 7 bytes per row; this payload is one row short
+    std::vector<uint8_t> data(7 * 8, 0);
+    EXPECT_EQ(image_processor_process_region(data.data(), data.size(), IMAGE_FORMAT_RAW_4BPP, 0, 0,
+                                             13, 9, DITHER_FLOYD_STEINBERG, nullptr),
+              ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(fake_display_patch_count(), 0);
+}
+
+TEST_F(ImagePipelineTest, RegionOutsideTheDisplayIsRejected)
+{
+    RunPipeline(EncodePng(800, 480, [](int, int) { return kWhite; }));
+    auto data = PackNibbles(16, 16, [](int, int) { return uint8_t(0); });
+    EXPECT_EQ(image_processor_process_region(data.data(), data.size(), IMAGE_FORMAT_RAW_4BPP, 790,
+                                             0, 16, 16, DITHER_FLOYD_STEINBERG, nullptr),
+              ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(image_processor_process_region(data.data(), data.size(), IMAGE_FORMAT_RAW_4BPP, -1,
+                                             0, 16, 16, DITHER_FLOYD_STEINBERG, nullptr),
+              ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(fake_display_patch_count(), 0);
+}
+
+TEST_F(ImagePipelineTest, RegionNeedsAFrameOnDisplay)
+{
+    auto data = PackNibbles(16, 16, [](int, int) { return uint8_t(0); });
+    EXPECT_EQ(image_processor_process_region(data.data(), data.size(), IMAGE_FORMAT_RAW_4BPP, 0, 0,
+                                             16, 16, DITHER_FLOYD_STEINBERG, nullptr),
+              ESP_ERR_INVALID_STATE);
+}
+
+// Region coordinates are in the displayed orientation; on a rotated
+// orientation the patch lands where the full-frame rotation puts those
+// pixels (processing (x, y) -> panel (proc_h - 1 - y, x))
+TEST_F(ImagePipelineTest, RotatedRegionLandsWhereTheImageShowsIt)
+{
+    test_display_orientation = DISPLAY_ORIENTATION_PORTRAIT;
+    Processed before = RunPipeline(EncodePng(480, 800, [](int, int) { return kWhite; }));
+    auto index = [](int x, int y) { return uint8_t(x < 10 && y < 4 ? 3 : 5); };
+    Processed p = RunRegion(PackNibbles(20, 6, index), IMAGE_FORMAT_RAW_4BPP, 30, 100, 20, 6);
+    ASSERT_EQ(p.w, 800);
+    ASSERT_EQ(p.h, 480);
+    for (int y = 0; y < 6; y++)
+        for (int x = 0; x < 20; x++)
+            ASSERT_EQ(p.at(799 - (100 + y), 30 + x), index(x, y) == 3 ? kRed : kBlue)
+                << "at (" << x << "," << y << ")";
+    // Panel columns 694..699, rows 30..49 hold the patch
+    for (int y = 0; y < p.h; y++) {
+        for (int x = 0; x < p.w; x++) {
+            if (x < 694 || x >= 700 || y < 30 || y >= 50) {
+                ASSERT_EQ(p.at(x, y), before.at(x, y)) << "at (" << x << "," << y << ")";
+            }
+        }
+    }
+}
+
+// Rotated regions go out as column tiles; a region taller than one tile
+// (and not a multiple of it) still lands pixel for pixel
+TEST_F(ImagePipelineTest, RotatedRegionIsPatchedInColumnTiles)
+{
+    test_display_orientation = DISPLAY_ORIENTATION_PORTRAIT;
+    RunPipeline(EncodePng(480, 800, [](int, int) { return kWhite; }));
+    int tiles_before = fake_display_tile_push_count();
+    auto index = [](int x, int y) { return uint8_t((x + y) % 3 == 0 ? 3 : 5); };
+    Processed p = RunRegion(PackNibbles(24, 37, index), IMAGE_FORMAT_RAW_4BPP, 11, 200, 24, 37);
+    EXPECT_EQ(fake_display_tile_push_count() - tiles_before, 3);  // 16 + 16 + 5 rows
+    EXPECT_EQ(fake_display_column_push_count(), 0);
+    for (int y = 0; y < 37; y++)
+        for (int x = 0; x < 24; x++)
+            ASSERT_EQ(p.at(799 - (200 + y), 11 + x), index(x, y) == 3 ? kRed : kBlue)
+                << "at (" << x << "," << y << ")";
+    EXPECT_EQ(p.at(799 - 199, 11), kWhite);
+    EXPECT_EQ(p.at(799 - 237, 11), kWhite);
+}
+
 // --- GC16 grayscale panels (new in the streaming rewrite) ------------------
 
 class Gc16PipelineTest : public ImagePipelineTest
@@ -612,6 +1008,18 @@ TEST_F(Gc16PipelineTest, RampRendersVerbatim)
     EXPECT_EQ(fake_display_begin_count(), 1);
 }
 
+TEST_F(Gc16PipelineTest, RawRegionKeepsEveryGrayLevel)
+{
+    RunPipeline(EncodePng(800, 480, [](int, int) { return kWhite; }));
+    auto level = [](int x, int y) { return uint8_t((x + y) % 16); };
+    Processed p = RunRegion(PackNibbles(32, 4, level), IMAGE_FORMAT_RAW_4BPP, 400, 200, 32, 4);
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 32; x++) {
+            uint8_t v = uint8_t(level(x, y) * 17);
+            ASSERT_EQ(p.at(400 + x, 200 + y), (Rgb{v, v, v})) << "at (" << x << "," << y << ")";
+        }
+}
+
 TEST_F(Gc16PipelineTest, SolidWhiteStaysWhite)
 {
     Processed p = RunPipeline(EncodePng(800, 480, [](int, int) { return kWhite; }));
@@ -0,0 +1,133 @@
+// Tests for the IT8951 driver's dirty-rectangle tracking
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include "it8951_dirty.h"
+}
+
+namespace
+{
+
+constexpr uint16_t kWidth = 96;  // pixels
+constexpr uint16_t kHeight = 200;
+constexpr size_t kStride = kWidth / 2;
+
+struct Frames {
+    std::vector<uint8_t> prev = std::vector<uint8_t>(kStride * kHeight, 0xFF);
+    std::vector<uint8_t> next = prev;
+
+    // Change pixel (x, y) of the new frame
+    void Touch(int x, int y)
+    {
+        uint8_t &b = next[y * kStride + x / 2];
+        b ^= (x % 2 == 0) ? 0xF0 : 0x0F;
+    }
+
+    it8951_dirty_t Diff() const
+    {
+        it8951_dirty_t d;
+        it8951_dirty_begin(&d, kWidth);
+        for (uint16_t y = 0; y < kHeight; y++)
+            it8951_dirty_row(&d, y, next.data() + y * kStride, prev.data() + y * kStride,
+                             kStride);
+        it8951_dirty_end(&d);
+        return d;
+    }
+};
+
+TEST(It8951DirtyTest, UnchangedFrameHasNoRects)
+{
+    Frames f;
+    it8951_dirty_t d = f.Diff();
+    EXPECT_EQ(d.count, 0);
+    EXPECT_EQ(it8951_dirty_area(&d), 0u);
+}
+
+TEST(It8951DirtyTest, SingleChangeIsAlignedRect)
+{
+    Frames f;
+    f.Touch(37, 50);
+    f.Touch(40, 53);
+    it8951_dirty_t d = f.Diff();
+    ASSERT_EQ(d.count, 1);
+    EXPECT_EQ(d.rects[0].x, 32);
+    EXPECT_EQ(d.rects[0].w, 16);
+    EXPECT_EQ(d.rects[0].y, 50);
+    EXPECT_EQ(d.rects[0].h, 4);
+}
+
+TEST(It8951DirtyTest, DistantBandsGetSeparateRects)
+{
+    Frames f;
+    f.Touch(0, 10);
+    f.Touch(95, 11 + IT8951_DIRTY_GAP_ROWS);
+    f.Touch(50, 150);
+    it8951_dirty_t d = f.Diff();
+    ASSERT_EQ(d.count, 3);
+    EXPECT_EQ(d.rects[0].x, 0);
+    EXPECT_EQ(d.rects[0].w, 16);
+    EXPECT_EQ(d.rects[1].x, 80);
+    EXPECT_EQ(d.rects[1].w, 16);
+    EXPECT_EQ(d.rects[1].y, 11 + IT8951_DIRTY_GAP_ROWS);
+    EXPECT_EQ(d.rects[2].y, 150);
+    EXPECT_EQ(it8951_dirty_area(&d), 3u * 16);
+}
+
+TEST(It8951DirtyTest, NearbyRowsShareRect)
+{
+    Frames f;
+    f.Touch(20, 10);
+    f.Touch(70, 10 + IT8951_DIRTY_GAP_ROWS - 1);
+    it8951_dirty_t d = f.Diff();
+    ASSERT_EQ(d.count, 1);
+    EXPECT_EQ(d.rects[0].x, 16);
+    EXPECT_EQ(d.rects[0].w, 80 - 16);
+    EXPECT_EQ(d.rects[0].h, IT8951_DIRTY_GAP_ROWS);
+}
+
+TEST(It8951DirtyTest, ExtraBandsWidenTheLastRect)
+{
+    Frames f;
+    for (int i = 0; i <= IT8951_DIRTY_MAX_RECTS; i++)
+        f.Touch(i * 16, i * (IT8951_DIRTY_GAP_ROWS + 1));
+    it8951_dirty_t d = f.Diff();
+    ASSERT_EQ(d.count, IT8951_DIRTY_MAX_RECTS);
+    const it8951_rect_t &last = d.rects[IT8951_DIRTY_MAX_RECTS - 1];
+    EXPECT_EQ(last.y, (IT8951_DIRTY_MAX_RECTS - 1) * (IT8951_DIRTY_GAP_ROWS + 1));
+    EXPECT_EQ(last.y + last.h - 1, IT8951_DIRTY_MAX_RECTS * (IT8951_DIRTY_GAP_ROWS + 1));
+    EXPECT_EQ(last.x, (IT8951_DIRTY_MAX_RECTS - 1) * 16);
+    EXPECT_EQ(last.w, 32);
+}
+
+TEST(It8951DirtyTest, RectsCoverEveryChange)
+{
+    Frames f;
+    uint32_t s = 7;
+    for (int i = 0; i < 40; i++) {
+        s = s * 1103515245u + 12345u;
+        f.Touch((s >> 8) % kWidth, (s >> 20) % kHeight);
+    }
+    it8951_dirty_t d = f.Diff();
+    for (uint16_t y = 0; y < kHeight; y++)
+        for (uint16_t x = 0; x < kWidth; x++) {
+            uint8_t a = f.next[y * kStride + x / 2], b = f.prev[y * kStride + x / 2];
+            if (((x % 2 == 0) ? (a ^ b) >> 4 : (a ^ b) & 0x0F) == 0)
+                continue;
+            bool covered = false;
+            for (int i = 0; i < d.count; i++) {
+                const it8951_rect_t &r = d.rects[i];
+                covered |= x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h;
+            }
+            ASSERT_TRUE(covered) << "(" << x << "," << y << ")";
+        }
+    for (int i = 0; i < d.count; i++) {
+        EXPECT_EQ(d.rects[i].x % IT8951_DIRTY_ALIGN_PX, 0);
+        EXPECT_EQ(d.rects[i].w % IT8951_DIRTY_ALIGN_PX, 0);
+    }
+}
+
+}  // namespace
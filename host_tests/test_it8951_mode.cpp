@@ -0,0 +1,161 @@
+// Tests for the IT8951 driver's content-aware waveform selection
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include "it8951_mode.h"
+}
+
+namespace
+{
+
+constexpr size_t kRowBytes = 32;
+constexpr int kRows = 10;
+constexpr uint16_t kBudget = 12;
+
+using Frame = std::vector<uint8_t>;
+
+// Scan a whole frame, optionally against the previous one
+it8951_scan_t Scan(const Frame &frame, const Frame *prev)
+{
+    it8951_scan_t scan;
+    it8951_scan_begin(&scan, prev != nullptr);
+    for (int r = 0; r < kRows; r++)
+        it8951_scan_row(&scan, frame.data() + r * kRowBytes,
+                        prev ? prev->data() + r * kRowBytes : nullptr, kRowBytes);
+    return scan;
+}
+
+Frame Filled(uint8_t byte)
+{
+    return Frame(kRowBytes * kRows, byte);
+}
+
+// A grayscale photo-like frame
+Frame Gray()
+{
+    Frame f(kRowBytes * kRows);
+    for (size_t i = 0; i < f.size(); i++)
+        f[i] = uint8_t(i * 37);
+    return f;
+}
+
+// Known panel state after one full refresh of a gray frame
+it8951_mode_state_t AfterGray()
+{
+    it8951_mode_state_t st = {};
+    Frame g = Gray();
+    it8951_scan_t scan = Scan(g, nullptr);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_FULL);
+    return st;
+}
+
+TEST(It8951ScanTest, CountsLevelsAndChangedPixels)
+{
+    Frame prev = Filled(0xFF);
+    Frame next = prev;
+    next[0] = 0x0F;   // one pixel
+    next[40] = 0x70;  // two pixels
+    it8951_scan_t scan = Scan(next, &prev);
+    EXPECT_EQ(scan.pixels, kRowBytes * kRows * 2);
+    EXPECT_EQ(scan.changed, 3u);
+    EXPECT_EQ(scan.levels, (1u << 0) | (1u << 7) | (1u << 15));
+}
+
+TEST(It8951ScanTest, NoPreviousFrameCountsNoChanges)
+{
+    Frame f = Gray();
+    it8951_scan_t scan = Scan(f, nullptr);
+    EXPECT_FALSE(scan.has_prev);
+    EXPECT_EQ(scan.changed, 0u);
+}
+
+TEST(It8951ModeTest, UnknownPanelGetsFullRefresh)
+{
+    it8951_mode_state_t st = {};
+    Frame bw = Filled(0xF0);
+    it8951_scan_t scan = Scan(bw, nullptr);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_FULL);
+    EXPECT_TRUE(st.known);
+    EXPECT_TRUE(st.prev_bilevel);
+    EXPECT_EQ(st.ghost, 0);
+}
+
+TEST(It8951ModeTest, BilevelUsesDuFromGrayThenA2)
+{
+    it8951_mode_state_t st = AfterGray();
+    Frame bw = Filled(0x0F);
+    it8951_scan_t scan = Scan(bw, nullptr);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_DU);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_A2);
+    EXPECT_EQ(st.ghost, IT8951_GHOST_COST_DU + IT8951_GHOST_COST_A2);
+}
+
+TEST(It8951ModeTest, SmallGrayDeltaUsesGl16)
+{
+    it8951_mode_state_t st = AfterGray();
+    Frame prev = Gray();
+    Frame next = prev;
+    for (size_t i = 0; i < next.size() / 10; i++)
+        next[i] ^= 0x11;
+    it8951_scan_t scan = Scan(next, &prev);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_GL16);
+}
+
+TEST(It8951ModeTest, LargeOrUnknownDeltaUsesGc16)
+{
+    it8951_mode_state_t st = AfterGray();
+    Frame prev = Gray();
+    Frame next = prev;
+    for (auto &b : next)
+        b ^= 0x11;
+    it8951_scan_t scan = Scan(next, &prev);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_GC16);
+
+    // Without the previous frame a delta cannot be shown to be small
+    scan = Scan(prev, nullptr);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_GC16);
+}
+
+TEST(It8951ModeTest, SpentBudgetForcesFullRefreshAndResets)
+{
+    it8951_mode_state_t st = AfterGray();
+    Frame g = Gray();
+    it8951_scan_t scan = Scan(g, nullptr);
+    int partial = 0;
+    while (it8951_mode_select(&st, &scan, kBudget) == IT8951_WAVE_GC16)
+        partial++;
+    EXPECT_EQ(partial, (kBudget + IT8951_GHOST_COST_GC16 - 1) / IT8951_GHOST_COST_GC16);
+    EXPECT_EQ(st.ghost, 0);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_GC16);
+}
+
+TEST(It8951ModeTest, A2DependsOnThePreviousContentOfTheScannedArea)
+{
+    it8951_mode_state_t st = AfterGray();
+    Frame bw = Filled(0xF0);
+
+    // The scanned rows were gray before: DU even though the state says bilevel
+    st.prev_bilevel = true;
+    Frame gray = Gray();
+    it8951_scan_t scan = Scan(bw, &gray);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_DU);
+
+    Frame bw_prev = Filled(0x0F);
+    scan = Scan(bw, &bw_prev);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, kBudget), IT8951_WAVE_A2);
+}
+
+TEST(It8951ModeTest, ZeroBudgetAlwaysRefreshesFully)
+{
+    it8951_mode_state_t st = AfterGray();
+    Frame bw = Filled(0xFF);
+    it8951_scan_t scan = Scan(bw, nullptr);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, 0), IT8951_WAVE_FULL);
+    EXPECT_EQ(it8951_mode_select(&st, &scan, 0), IT8951_WAVE_FULL);
+}
+
+}  // namespace
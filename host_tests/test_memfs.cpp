@@ -0,0 +1,226 @@
+// Tests for the RAM filesystem (components/memfs) through the VFS entry
+// points it registers: extent-backed file data, hashed name lookup, and the
+// in-place extents view.
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "fake_vfs.h"
+#include "memfs.h"
+}
+
+namespace
+{
+
+std::vector<uint8_t> Pattern(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = uint8_t(seed + i * 31 + (i >> 12));
+    }
+    return data;
+}
+
+std::vector<uint8_t> ReadAll(const std::string &path, size_t chunk)
+{
+    std::vector<uint8_t> out;
+    int fd = fake_vfs_open(path.c_str(), O_RDONLY);
+    EXPECT_GE(fd, 0);
+    if (fd < 0) {
+        return out;
+    }
+    std::vector<uint8_t> buf(chunk);
+    ssize_t n;
+    while ((n = fake_vfs_read(fd, buf.data(), buf.size())) > 0) {
+        out.insert(out.end(), buf.begin(), buf.begin() + n);
+    }
+    fake_vfs_close(fd);
+    return out;
+}
+
+// File contents through the extents view
+std::vector<uint8_t> Mapped(const memfs_extents_t &ext)
+{
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i < ext.count; i++) {
+        out.insert(out.end(), ext.extents[i], ext.extents[i] + memfs_extent_len(&ext, i));
+    }
+    return out;
+}
+
+class MemfsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(memfs_mount("/mem", 12), ESP_OK);
+    }
+
+    void TearDown() override
+    {
+        EXPECT_EQ(memfs_unmount("/mem"), ESP_OK);
+        EXPECT_EQ(memfs_get_total_used(), 0u);
+    }
+};
+
+TEST_F(MemfsTest, FilesGrowByExtentsAndReadBack)
+{
+    const size_t size = 3 * MEMFS_EXTENT_SIZE + 1234;
+    auto data = Pattern(size, 1);
+
+    // Uneven writes that straddle extent boundaries
+    int fd = fake_vfs_open("/mem/a.bin", O_WRONLY | O_CREAT | O_TRUNC);
+    ASSERT_GE(fd, 0);
+    for (size_t off = 0; off < size; off += 1000) {
+        size_t n = std::min<size_t>(1000, size - off);
+        ASSERT_EQ(fake_vfs_write(fd, data.data() + off, n), (ssize_t) n);
+    }
+    fake_vfs_close(fd);
+
+    EXPECT_EQ(fake_vfs_size("/mem/a.bin"), (long) size);
+    EXPECT_EQ(memfs_get_total_used(), 4u * MEMFS_EXTENT_SIZE);
+    EXPECT_EQ(ReadAll("/mem/a.bin", 4096), data);
+    EXPECT_EQ(ReadAll("/mem/a.bin", 7), data);
+
+    // Overwrite in the middle, across a boundary
+    fd = fake_vfs_open("/mem/a.bin", O_RDWR);
+    ASSERT_GE(fd, 0);
+    auto patch = Pattern(100, 9);
+    ASSERT_EQ(fake_vfs_lseek(fd, MEMFS_EXTENT_SIZE - 50, SEEK_SET), MEMFS_EXTENT_SIZE - 50);
+    ASSERT_EQ(fake_vfs_write(fd, patch.data(), patch.size()), 100);
+    fake_vfs_close(fd);
+    std::copy(patch.begin(), patch.end(), data.begin() + MEMFS_EXTENT_SIZE - 50);
+    EXPECT_EQ(ReadAll("/mem/a.bin", 4096), data);
+
+    // Truncation gives the extents back
+    fd = fake_vfs_open("/mem/a.bin", O_WRONLY | O_TRUNC);
+    ASSERT_GE(fd, 0);
+    fake_vfs_close(fd);
+    EXPECT_EQ(fake_vfs_size("/mem/a.bin"), 0);
+    EXPECT_EQ(memfs_get_total_used(), 0u);
+}
+
+TEST_F(MemfsTest, WritePastTheEndLeavesAZeroHole)
+{
+    int fd = fake_vfs_open("/mem/hole.bin", O_RDWR | O_CREAT);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(fake_vfs_write(fd, "ab", 2), 2);
+    ASSERT_EQ(fake_vfs_lseek(fd, MEMFS_EXTENT_SIZE + 10, SEEK_SET), MEMFS_EXTENT_SIZE + 10);
+    ASSERT_EQ(fake_vfs_write(fd, "z", 1), 1);
+    fake_vfs_close(fd);
+
+    auto data = ReadAll("/mem/hole.bin", 4096);
+    ASSERT_EQ(data.size(), MEMFS_EXTENT_SIZE + 11u);
+    EXPECT_EQ(data[0], 'a');
+    EXPECT_EQ(data[1], 'b');
+    EXPECT_EQ(data.back(), 'z');
+    for (size_t i = 2; i < data.size() - 1; i++) {
+        ASSERT_EQ(data[i], 0) << "at " << i;
+    }
+}
+
+TEST_F(MemfsTest, NamesAreFoundAcrossBuckets)
+{
+    for (int i = 0; i < 12; i++) {
+        std::string path = "/mem/f" + std::to_string(i);
+        ASSERT_EQ(fake_vfs_write_file(path.c_str(), path.data(), path.size()), 0);
+    }
+    errno = 0;
+    EXPECT_LT(fake_vfs_open("/mem/one-too-many", O_WRONLY | O_CREAT), 0);
+    EXPECT_EQ(errno, ENOSPC);
+
+    for (int i = 0; i < 12; i++) {
+        std::string path = "/mem/f" + std::to_string(i);
+        EXPECT_EQ(fake_vfs_size(path.c_str()), (long) path.size());
+    }
+    EXPECT_EQ(fake_vfs_size("/mem/f12"), -1);
+
+    // Rename over an existing name replaces it; the old name is gone
+    ASSERT_EQ(fake_vfs_rename("/mem/f3", "/mem/f7"), 0);
+    EXPECT_EQ(fake_vfs_size("/mem/f3"), -1);
+    auto data = ReadAll("/mem/f7", 64);
+    EXPECT_EQ(std::string(data.begin(), data.end()), "/mem/f3");
+
+    // Freed entries can be reused
+    ASSERT_EQ(fake_vfs_unlink("/mem/f0"), 0);
+    EXPECT_EQ(fake_vfs_unlink("/mem/f0"), -1);
+    EXPECT_EQ(fake_vfs_write_file("/mem/new-a", "x", 1), 0);
+    EXPECT_EQ(fake_vfs_write_file("/mem/new-b", "x", 1), 0);
+}
+
+TEST_F(MemfsTest, ExtentsMapTheDataInPlace)
+{
+    auto data = Pattern(2 * MEMFS_EXTENT_SIZE + 5, 3);
+    ASSERT_EQ(fake_vfs_write_file("/mem/img.png", data.data(), data.size()), 0);
+
+    memfs_extents_t ext;
+    ASSERT_EQ(memfs_get_extents("/mem/img.png", &ext), ESP_OK);
+    EXPECT_EQ(ext.size, data.size());
+    EXPECT_EQ(ext.count, 3u);
+    EXPECT_EQ(memfs_extent_len(&ext, 2), 5u);
+    EXPECT_EQ(Mapped(ext), data);
+
+    // Pinned: the data cannot change or go away, but can still be read
+    errno = 0;
+    EXPECT_EQ(fake_vfs_unlink("/mem/img.png"), -1);
+    EXPECT_EQ(errno, EBUSY);
+    EXPECT_EQ(fake_vfs_rename("/mem/img.png", "/mem/other.png"), -1);
+    EXPECT_LT(fake_vfs_open("/mem/img.png", O_WRONLY | O_TRUNC), 0);
+    EXPECT_EQ(ReadAll("/mem/img.png", 4096), data);
+
+    memfs_put_extents(&ext);
+    EXPECT_EQ(fake_vfs_unlink("/mem/img.png"), 0);
+}
+
+TEST_F(MemfsTest, ExtentsNeedAFinishedRamFile)
+{
+    memfs_extents_t ext;
+    EXPECT_EQ(memfs_get_extents("/mem/missing", &ext), ESP_ERR_NOT_FOUND);
+    EXPECT_EQ(memfs_get_extents("/memx/a", &ext), ESP_ERR_NOT_FOUND);
+    EXPECT_EQ(memfs_get_extents("/sdcard/a", &ext), ESP_ERR_NOT_FOUND);
+
+    int fd = fake_vfs_open("/mem/partial", O_WRONLY | O_CREAT);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(fake_vfs_write(fd, "abc", 3), 3);
+    EXPECT_EQ(memfs_get_extents("/mem/partial", &ext), ESP_ERR_INVALID_STATE);
+    fake_vfs_close(fd);
+
+    ASSERT_EQ(memfs_get_extents("/mem/partial", &ext), ESP_OK);
+    EXPECT_EQ(ext.count, 1u);
+    EXPECT_EQ(memcmp(ext.extents[0], "abc", 3), 0);
+    memfs_put_extents(&ext);
+
+    // An empty file maps to no extents
+    ASSERT_EQ(fake_vfs_write_file("/mem/empty", "", 0), 0);
+    ASSERT_EQ(memfs_get_extents("/mem/empty", &ext), ESP_OK);
+    EXPECT_EQ(ext.count, 0u);
+    memfs_put_extents(&ext);
+}
+
+TEST(MemfsMountTest, MountsAreIndependent)
+{
+    ASSERT_EQ(memfs_mount("/one", 4), ESP_OK);
+    ASSERT_EQ(memfs_mount("/two", 4), ESP_OK);
+    EXPECT_EQ(memfs_mount("/one", 4), ESP_ERR_INVALID_STATE);
+
+    ASSERT_EQ(fake_vfs_write_file("/one/x", "1", 1), 0);
+    ASSERT_EQ(fake_vfs_write_file("/two/x", "22", 2), 0);
+    EXPECT_EQ(fake_vfs_size("/one/x"), 1);
+    EXPECT_EQ(fake_vfs_size("/two/x"), 2);
+    EXPECT_EQ(memfs_get_total_used(), 2u * MEMFS_EXTENT_SIZE);
+
+    EXPECT_EQ(memfs_unmount("/one"), ESP_OK);
+    EXPECT_EQ(memfs_get_total_used(), 1u * MEMFS_EXTENT_SIZE);
+    EXPECT_EQ(memfs_unmount("/two"), ESP_OK);
+    EXPECT_EQ(memfs_unmount("/two"), ESP_ERR_INVALID_STATE);
+}
+
+}  // namespace
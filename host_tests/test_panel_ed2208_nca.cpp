@@ -0,0 +1,122 @@
+// ED2208-NCA (13.3" Spectra 6, dual controller) driver against the SPI/GPIO
+// panel simulator
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include "epaper.h"
+#include "fake_spi_panel.h"
+}
+
+namespace
+{
+
+constexpr uint16_t kWidth = 1200;
+constexpr uint16_t kHeight = 1600;
+constexpr size_t kStride = kWidth / 2;
+constexpr size_t kHalf = kStride / 2;  // bytes of a row each controller takes
+constexpr int kPinCs = 10;
+constexpr int kPinDc = 11;
+constexpr int kPinCs1 = 14;
+
+// Hardware color of a frame nibble: unknown indices become white
+uint8_t HwColor(uint8_t c)
+{
+    return (c == 4 || c > 6) ? 1 : c;
+}
+
+class PanelEd2208NcaTest : public ::testing::Test
+{
+  protected:
+    fake_ed2208_t *left = nullptr;
+    fake_ed2208_t *right = nullptr;
+
+    void SetUp() override
+    {
+        Start(nullptr);
+    }
+
+    // Fresh simulator and driver; model NULL selects the default
+    void Start(const fake_spi_model_t *model)
+    {
+        fake_spi_reset(model);
+        left = fake_ed2208_attach(kPinCs, kPinDc, kHalf * kHeight + 64);
+        right = fake_ed2208_attach(kPinCs1, kPinDc, kHalf * kHeight + 64);
+        epaper_config_t cfg = {.spi_host = 1,
+                               .pin_cs = kPinCs,
+                               .pin_dc = kPinDc,
+                               .pin_rst = 12,
+                               .pin_busy = 13,
+                               .pin_cs1 = kPinCs1,
+                               .pin_enable = -1};
+        epaper_init(&cfg);
+        fake_spi_clear_stats();
+    }
+
+    void TearDown() override
+    {
+        EXPECT_EQ(fake_spi_stats().violations, 0u) << fake_spi_last_violation();
+    }
+
+    // Displays a frame holding every byte value, so all 16 nibbles appear on
+    // both sides, and checks that each controller got its color-mapped half
+    void DisplayAndExpectHalves()
+    {
+        std::vector<uint8_t> fb(kStride * kHeight);
+        for (size_t i = 0; i < fb.size(); i++) {
+            fb[i] = (uint8_t) (i * 7 + i / kStride);
+        }
+        epaper_display(fb.data());
+
+        std::vector<uint8_t> want_left, want_right;
+        for (size_t y = 0; y < kHeight; y++) {
+            for (size_t i = 0; i < kStride; i++) {
+                uint8_t b = fb[y * kStride + i];
+                uint8_t hw = (uint8_t) ((HwColor(b >> 4) << 4) | HwColor(b & 0x0F));
+                (i < kHalf ? want_left : want_right).push_back(hw);
+            }
+        }
+
+        size_t len = 0;
+        const uint8_t *dtm = fake_ed2208_dtm(left, &len);
+        ASSERT_EQ(len, want_left.size());
+        EXPECT_TRUE(std::vector<uint8_t>(dtm, dtm + len) == want_left);
+        dtm = fake_ed2208_dtm(right, &len);
+        ASSERT_EQ(len, want_right.size());
+        EXPECT_TRUE(std::vector<uint8_t>(dtm, dtm + len) == want_right);
+    }
+};
+
+TEST_F(PanelEd2208NcaTest, EachControllerGetsItsColorMappedHalf)
+{
+    DisplayAndExpectHalves();
+
+    EXPECT_EQ(fake_ed2208_refreshes(left), 1u);
+    EXPECT_EQ(fake_ed2208_refreshes(right), 1u);
+    // The pixel transfer holds the bus once for both halves
+    EXPECT_EQ(fake_spi_stats().acquisitions, 1u);
+}
+
+TEST_F(PanelEd2208NcaTest, StreamingIsUnsupported)
+{
+    EXPECT_FALSE(epaper_stream_begin());
+    EXPECT_EQ(fake_spi_stats().transactions, 0u);
+}
+
+TEST_F(PanelEd2208NcaTest, HalvesArePolledWithoutBounceBuffers)
+{
+    // A bus limit below the smallest bounce buffer makes the engine init fail
+    fake_spi_model_t model = FAKE_SPI_MODEL_DEFAULT;
+    model.max_transfer_bytes = 256;
+    Start(&model);
+
+    DisplayAndExpectHalves();
+    EXPECT_EQ(fake_ed2208_refreshes(left), 1u);
+    EXPECT_EQ(fake_ed2208_refreshes(right), 1u);
+    EXPECT_LE(fake_spi_stats().max_transaction_bytes, 256u);
+}
+
+}  // namespace
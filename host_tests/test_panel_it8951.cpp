@@ -0,0 +1,199 @@
+// IT8951 driver against the SPI/GPIO panel simulator: what reaches the
+// controller's image memory, which areas get loaded and refreshed, and the
+// simulated cost of a frame push
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+#include "epaper.h"
+#include "fake_spi_panel.h"
+}
+
+namespace
+{
+
+constexpr uint16_t kWidth = 256;  // small panel; GetSystemInfo reports it
+constexpr uint16_t kHeight = 128;
+constexpr size_t kStride = kWidth / 2;
+constexpr int kPinCs = 10;
+constexpr uint16_t kModeGl16 = 3;
+
+std::vector<uint8_t> GrayFrame(uint32_t seed)
+{
+    std::vector<uint8_t> fb(kStride * kHeight);
+    for (auto &b : fb) {
+        seed = seed * 1103515245u + 12345u;
+        b = (uint8_t) (seed >> 16);
+    }
+    return fb;
+}
+
+// Panel memory expected after loading fb: rows leave word-reversed unless the
+// frame buffer is already in panel word order
+std::vector<uint8_t> PanelMemory(const std::vector<uint8_t> &fb)
+{
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+    return fb;
+#else
+    std::vector<uint8_t> mem(fb.size());
+    const size_t words = kStride / 2;
+    for (size_t y = 0; y < kHeight; y++) {
+        for (size_t i = 0; i < words; i++) {
+            mem[y * kStride + i * 2] = fb[y * kStride + (words - 1 - i) * 2];
+            mem[y * kStride + i * 2 + 1] = fb[y * kStride + (words - 1 - i) * 2 + 1];
+        }
+    }
+    return mem;
+#endif
+}
+
+uint16_t MemoryX(uint16_t x, uint16_t w)
+{
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+    (void) w;
+    return x;
+#else
+    return kWidth - x - w;
+#endif
+}
+
+class PanelIt8951Test : public ::testing::Test
+{
+  protected:
+    fake_it8951_t *ctl = nullptr;
+
+    void SetUp() override
+    {
+        fake_spi_reset(nullptr);
+        ctl = fake_it8951_attach(kPinCs, kWidth, kHeight);
+        epaper_config_t cfg = {.spi_host = 1,
+                               .pin_cs = kPinCs,
+                               .pin_dc = -1,
+                               .pin_rst = 12,
+                               .pin_busy = 13,
+                               .pin_cs1 = -1,
+                               .pin_enable = -1};
+        epaper_init(&cfg);
+        ASSERT_EQ(epaper_get_width(), kWidth);
+        ASSERT_EQ(epaper_get_height(), kHeight);
+        fake_spi_clear_stats();
+    }
+
+    void TearDown() override
+    {
+        EXPECT_EQ(fake_spi_stats().violations, 0u) << fake_spi_last_violation();
+    }
+
+    void ExpectMemory(const std::vector<uint8_t> &fb)
+    {
+        std::vector<uint8_t> want = PanelMemory(fb);
+        std::vector<uint8_t> got(fake_it8951_memory(ctl), fake_it8951_memory(ctl) + want.size());
+        EXPECT_TRUE(got == want);
+    }
+};
+
+TEST_F(PanelIt8951Test, FullFrameLandsInPanelMemory)
+{
+    std::vector<uint8_t> fb = GrayFrame(1);
+    epaper_display(fb.data());
+
+    ExpectMemory(fb);
+    ASSERT_EQ(fake_it8951_load_count(ctl), 1);
+    const fake_it8951_area_t *ld = fake_it8951_load(ctl, 0);
+    EXPECT_EQ(ld->x, 0);
+    EXPECT_EQ(ld->y, 0);
+    EXPECT_EQ(ld->w, kWidth);
+    EXPECT_EQ(ld->h, kHeight);
+
+    // The image stream holds the bus once, in a single CS window of queued rows
+    fake_spi_stats_t st = fake_spi_stats();
+    EXPECT_EQ(st.acquisitions, 1u);
+    EXPECT_EQ(st.queued, (uint32_t) kHeight);
+
+    ASSERT_GE(fake_it8951_display_count(ctl), 1);
+    const fake_it8951_area_t *d =
+        fake_it8951_display(ctl, fake_it8951_display_count(ctl) - 1);
+    EXPECT_EQ(d->w, kWidth);
+    EXPECT_EQ(d->h, kHeight);
+}
+
+TEST_F(PanelIt8951Test, SmallChangeLoadsAndRefreshesOnlyItsArea)
+{
+    std::vector<uint8_t> a = GrayFrame(2);
+    epaper_display(a.data());
+    const int loads = fake_it8951_load_count(ctl);
+    const int displays = fake_it8951_display_count(ctl);
+
+    // Opposite corners of an 8x8 block at (100, 40): the rectangle widens to
+    // 16-pixel columns, and so few changed pixels keep it on GL16
+    std::vector<uint8_t> b = a;
+    b[40 * kStride + 100 / 2] ^= 0xF0;
+    b[47 * kStride + 107 / 2] ^= 0x0F;
+    epaper_display(b.data());
+
+    ExpectMemory(b);
+    ASSERT_EQ(fake_it8951_load_count(ctl), loads + 1);
+    const fake_it8951_area_t *ld = fake_it8951_load(ctl, loads);
+    EXPECT_EQ(ld->x, MemoryX(96, 16));
+    EXPECT_EQ(ld->y, 40);
+    EXPECT_EQ(ld->w, 16);
+    EXPECT_EQ(ld->h, 8);
+
+    ASSERT_EQ(fake_it8951_display_count(ctl), displays + 1);
+    const fake_it8951_area_t *d = fake_it8951_display(ctl, displays);
+    EXPECT_EQ(d->x, MemoryX(96, 16));
+    EXPECT_EQ(d->y, 40);
+    EXPECT_EQ(d->w, 16);
+    EXPECT_EQ(d->h, 8);
+    EXPECT_EQ(d->mode, kModeGl16);
+}
+
+TEST_F(PanelIt8951Test, UnchangedFrameSendsNothing)
+{
+    std::vector<uint8_t> a = GrayFrame(3);
+    epaper_display(a.data());
+    const uint32_t transactions = fake_spi_stats().transactions;
+    const int displays = fake_it8951_display_count(ctl);
+
+    epaper_display(a.data());
+
+    EXPECT_EQ(fake_spi_stats().transactions, transactions);
+    EXPECT_EQ(fake_it8951_display_count(ctl), displays);
+}
+
+TEST_F(PanelIt8951Test, StreamedBandsMatchTheFrame)
+{
+    std::vector<uint8_t> fb = GrayFrame(4);
+    ASSERT_TRUE(epaper_stream_begin());
+    for (uint16_t y = 0; y < kHeight; y += 32) {
+        epaper_stream_rows(fb.data() + y * kStride, y, 32);
+    }
+    epaper_stream_commit(true);
+
+    ExpectMemory(fb);
+    EXPECT_EQ(fake_it8951_load_count(ctl), kHeight / 32);
+    EXPECT_EQ(fake_spi_stats().acquisitions, (uint32_t) kHeight / 32);
+    ASSERT_GE(fake_it8951_display_count(ctl), 1);
+}
+
+TEST_F(PanelIt8951Test, RowPushOverlapsCopyWithWire)
+{
+    std::vector<uint8_t> fb = GrayFrame(6);
+    const int64_t t0 = fake_spi_now_us();
+    epaper_display(fb.data());
+    const int64_t took = fake_spi_now_us() - t0;
+
+    // 4 MHz: every frame byte costs 2 us on the wire. Queued rows hide the
+    // per-transaction overhead behind the previous row's transfer, leaving
+    // the wire time plus the small command traffic.
+    const int64_t wire_us = (int64_t) kStride * kHeight * 8 / 4;
+    printf("IT8951 %ux%u frame: %lld us simulated, %lld us on the wire\n", kWidth, kHeight,
+           (long long) took, (long long) wire_us);
+    EXPECT_LT(took, wire_us + wire_us / 10 + 1000);
+}
+
+}  // namespace
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "shuffle_bag.h"
+
+namespace
+{
+
+// Draw until the round ends, against a fixed count
+std::vector<uint32_t> DrawRound(shuffle_bag_t *bag, uint32_t count)
+{
+    std::vector<uint32_t> drawn;
+    uint32_t pos;
+    while (shuffle_bag_next(bag, count, 0, &pos)) {
+        drawn.push_back(pos);
+    }
+    return drawn;
+}
+
+}  // namespace
+
+TEST(ShuffleBagTest, PermutationIsABijection)
+{
+    for (int half = 1; half <= 6; half++) {
+        uint32_t domain = 1u << (2 * half);
+        std::set<uint32_t> seen;
+        for (uint32_t i = 0; i < domain; i++) {
+            uint32_t v = shuffle_bag_permute(0x1234abcd, half, i);
+            EXPECT_LT(v, domain);
+            seen.insert(v);
+        }
+        EXPECT_EQ(seen.size(), domain) << "half=" << half;
+    }
+}
+
+TEST(ShuffleBagTest, RoundVisitsEveryPositionOnce)
+{
+    for (uint32_t count : {1u, 2u, 3u, 7u, 16u, 17u, 100u, 1000u}) {
+        shuffle_bag_t bag = {};
+        shuffle_bag_reset(&bag, 42 + count, count, 0);
+        std::vector<uint32_t> drawn = DrawRound(&bag, count);
+        ASSERT_EQ(drawn.size(), count);
+        std::set<uint32_t> unique(drawn.begin(), drawn.end());
+        EXPECT_EQ(unique.size(), count);
+        EXPECT_LT(*unique.rbegin(), count);
+    }
+}
+
+TEST(ShuffleBagTest, SeedsGiveDifferentOrders)
+{
+    shuffle_bag_t a = {};
+    shuffle_bag_t b = {};
+    shuffle_bag_reset(&a, 1, 50, 0);
+    shuffle_bag_reset(&b, 2, 50, 0);
+    EXPECT_NE(DrawRound(&a, 50), DrawRound(&b, 50));
+}
+
+TEST(ShuffleBagTest, NoRoundWithoutReset)
+{
+    shuffle_bag_t bag = {};
+    uint32_t pos;
+    EXPECT_FALSE(shuffle_bag_next(&bag, 10, 0, &pos));
+}
+
+TEST(ShuffleBagTest, DrawsSkipFewPositions)
+{
+    // The domain is under four times the count, so a round walks fewer
+    // than four domain slots per image
+    for (uint32_t count : {5u, 64u, 65u, 300u}) {
+        shuffle_bag_t bag = {};
+        shuffle_bag_reset(&bag, 7, count, 0);
+        DrawRound(&bag, count);
+        EXPECT_LT(bag.cursor, 4 * count) << "count=" << count;
+    }
+}
+
+TEST(ShuffleBagTest, PersistedBagResumesTheSameRound)
+{
+    shuffle_bag_t bag = {};
+    shuffle_bag_reset(&bag, 99, 40, 0);
+    uint32_t pos;
+    for (int i = 0; i < 15; i++) {
+        ASSERT_TRUE(shuffle_bag_next(&bag, 40, 0, &pos));
+    }
+
+    // What NVS holds between wakes is the struct itself
+    shuffle_bag_t restored = bag;
+    EXPECT_EQ(DrawRound(&restored, 40), DrawRound(&bag, 40));
+}
+
+TEST(ShuffleBagTest, AppendedPositionsJoinTheRoundWithoutRepeats)
+{
+    shuffle_bag_t bag = {};
+    shuffle_bag_reset(&bag, 5, 20, 0);  // domain of 64
+
+    std::vector<uint32_t> drawn;
+    uint32_t pos;
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(shuffle_bag_next(&bag, 20, 0, &pos));
+        drawn.push_back(pos);
+    }
+
+    // Ten positions appended mid-round: the round goes on without reshuffling and
+    // never repeats, and the new positions show up in it unless their slot
+    // had already been walked past
+    std::vector<uint32_t> rest = DrawRound(&bag, 30);
+    drawn.insert(drawn.end(), rest.begin(), rest.end());
+    std::set<uint32_t> unique(drawn.begin(), drawn.end());
+    EXPECT_EQ(unique.size(), drawn.size());
+    for (uint32_t p = 0; p < 20; p++) {
+        EXPECT_TRUE(unique.count(p)) << p;
+    }
+    EXPECT_GT(drawn.size(), 20u);
+}
+
+TEST(ShuffleBagTest, ANewLayoutEndsTheRound)
+{
+    shuffle_bag_t bag = {};
+    shuffle_bag_reset(&bag, 3, 20, 0xabc);
+    uint32_t pos;
+    ASSERT_TRUE(shuffle_bag_next(&bag, 20, 0xabc, &pos));
+
+    // A removal moved positions: the rest of the round is void
+    uint32_t cursor = bag.cursor;
+    EXPECT_FALSE(shuffle_bag_next(&bag, 19, 0xabd, &pos));
+    EXPECT_EQ(bag.cursor, cursor);
+
+    shuffle_bag_reset(&bag, 4, 19, 0xabd);
+    EXPECT_EQ(DrawRound(&bag, 19).size(), 0u) << "drawn under another layout";
+    EXPECT_TRUE(shuffle_bag_next(&bag, 19, 0xabd, &pos));
+}
+
+TEST(ShuffleBagTest, UploadsMidRoundJoinTheirAlbumsSlotWithoutRepeats)
+{
+    // Three albums shuffled together; the first and last grow mid-round
+    int counts[3] = {5, 3, 4};
+    shuffle_bag_t bag = {};
+    shuffle_bag_reset_slots(&bag, 11, 3, 0x77);
+
+    std::set<std::pair<int, uint32_t>> seen;
+    int album;
+    uint32_t index;
+    for (int i = 0; i < 6; i++) {
+        ASSERT_TRUE(shuffle_bag_next_slot(&bag, counts, 3, 0x77, &album, &index));
+        ASSERT_LT(index, (uint32_t) counts[album]);
+        EXPECT_TRUE(seen.insert({album, index}).second) << album << "/" << index;
+    }
+
+    // Uploads append to their albums: the same layout, only counts rise,
+    // and every earlier image keeps its slot position
+    counts[0] = 9;
+    counts[2] = 6;
+    while (shuffle_bag_next_slot(&bag, counts, 3, 0x77, &album, &index)) {
+        ASSERT_LT(index, (uint32_t) counts[album]);
+        EXPECT_TRUE(seen.insert({album, index}).second) << album << "/" << index;
+    }
+
+    // Every image there before the uploads was shown exactly once; the
+    // uploads are shown in this round too unless their slot had been passed
+    std::pair<int, uint32_t> before[] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 0},
+                                         {1, 1}, {1, 2}, {2, 0}, {2, 1}, {2, 2}, {2, 3}};
+    for (const auto &image : before) {
+        EXPECT_TRUE(seen.count(image)) << image.first << "/" << image.second;
+    }
+    EXPECT_GT(seen.size(), 12u);
+}
+
+TEST(ShuffleBagTest, SlottedRoundVisitsEveryImageOnce)
+{
+    int counts[4] = {1, 0, 17, 3};
+    shuffle_bag_t bag = {};
+    shuffle_bag_reset_slots(&bag, 3, 4, 0);
+    std::set<std::pair<int, uint32_t>> seen;
+    int album;
+    uint32_t index;
+    while (shuffle_bag_next_slot(&bag, counts, 4, 0, &album, &index)) {
+        EXPECT_TRUE(seen.insert({album, index}).second);
+    }
+    EXPECT_EQ(seen.size(), 21u);
+}
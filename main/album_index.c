@@ -0,0 +1,790 @@
+#include "album_index.h"
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "album_pack.h"
+#include "config.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "album_index";
+
+#define ALBUM_INDEX_MAGIC 0x34584441  // "ADX4"
+#define ALBUM_INDEX_TMP_PATH ALBUM_INDEX_DIRECTORY "/.rebuild.tmp"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t record_size;
+    int64_t dir_mtime;  // album directory mtime the records describe
+    uint32_t count;
+    uint32_t generation;  // bumped on every change, for listing ETags
+    uint32_t order;       // bumped whenever records may have moved (removals, rebuilds)
+} index_header_t;
+
+#define RECORD_HAS_THUMBNAIL 0x01
+#define RECORD_LONG_NAME 0x02  // name holds only the start of the file name
+
+// Fixed-size so the nth record is a single seek, and small so an index stays
+// a few KiB. Names longer than the record holds (longer than any the device
+// writes itself) keep their start and are resolved through the directory by
+// length and hash; names of ALBUM_INDEX_NAME_MAX and up are left out.
+#define RECORD_NAME_LEN 56
+
+typedef struct {
+    uint8_t format;      // image_format_t
+    uint8_t flags;       // RECORD_*
+    uint16_t name_len;   // full file name length
+    uint32_t name_hash;  // FNV-1a of the full file name
+    char name[RECORD_NAME_LEN];
+} index_record_t;
+
+static SemaphoreHandle_t index_mutex = NULL;
+static bool rebuild_running = false;
+static bool rebuild_again = false;
+static bool rebuild_verify = false;  // next pass also counts directory entries
+
+static void index_lock(void)
+{
+    xSemaphoreTake(index_mutex, portMAX_DELAY);
+}
+
+static void index_unlock(void)
+{
+    xSemaphoreGive(index_mutex);
+}
+
+static void index_path(const char *album, char *path, size_t path_len)
+{
+    snprintf(path, path_len, "%s/%s.idx", ALBUM_INDEX_DIRECTORY, album);
+}
+
+static bool album_dir_mtime(const char *album, int64_t *mtime)
+{
+    char dir_path[256];
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", IMAGE_DIRECTORY, album);
+    struct stat st;
+    if (stat(dir_path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return false;
+    }
+    *mtime = (int64_t) st.st_mtime;
+    return true;
+}
+
+image_format_t album_index_format_of(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    if (!ext) {
+        return IMAGE_FORMAT_UNKNOWN;
+    }
+    if (strcasecmp(ext, ".png") == 0) {
+        return IMAGE_FORMAT_PNG;
+    }
+    if (strcasecmp(ext, ".bmp") == 0) {
+        return IMAGE_FORMAT_BMP;
+    }
+    if (strcasecmp(ext, ".epdgz") == 0) {
+        return IMAGE_FORMAT_EPD_GZ;
+    }
+    return IMAGE_FORMAT_UNKNOWN;
+}
+
+// Whether the image's JPEG preview (same base name, .jpg) exists; recorded
+// at ingest so listings need no per-image stat
+static bool image_has_thumbnail(const char *album, const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s/%.*s.jpg", IMAGE_DIRECTORY, album,
+             (int) (ext ? ext - name : (long) strlen(name)), name);
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static uint32_t name_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (const char *p = name; *p; p++) {
+        hash = (hash ^ (uint8_t) *p) * 16777619u;
+    }
+    return hash;
+}
+
+static void fill_record(index_record_t *rec, const char *album, const char *name, size_t len)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->format = (uint8_t) album_index_format_of(name);
+    rec->flags = image_has_thumbnail(album, name) ? RECORD_HAS_THUMBNAIL : 0;
+    rec->name_len = (uint16_t) len;
+    rec->name_hash = name_hash(name);
+    if (len >= sizeof(rec->name)) {
+        rec->flags |= RECORD_LONG_NAME;
+        len = sizeof(rec->name) - 1;
+    }
+    memcpy(rec->name, name, len);
+}
+
+static bool record_matches(const index_record_t *rec, const char *name)
+{
+    return rec->name_len == strlen(name) && rec->name_hash == name_hash(name) &&
+           strncmp(rec->name, name, sizeof(rec->name) - 1) == 0;
+}
+
+// Full file name of a record into out (ALBUM_INDEX_NAME_MAX bytes). A long
+// name is looked up in the album directory; false when it is gone.
+static bool record_name(const char *album, index_record_t *rec, char *out)
+{
+    rec->name[sizeof(rec->name) - 1] = '\0';
+    if (!(rec->flags & RECORD_LONG_NAME)) {
+        snprintf(out, ALBUM_INDEX_NAME_MAX, "%s", rec->name);
+        return true;
+    }
+
+    char dir_path[256];
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", IMAGE_DIRECTORY, album);
+    DIR *dir = opendir(dir_path);
+    bool found = false;
+    struct dirent *entry;
+    while (dir && !found && (entry = readdir(dir)) != NULL) {
+        found = record_matches(rec, entry->d_name);
+        if (found) {
+            snprintf(out, ALBUM_INDEX_NAME_MAX, "%s", entry->d_name);
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+    if (!found) {
+        snprintf(out, ALBUM_INDEX_NAME_MAX, "%s", rec->name);
+    }
+    return found;
+}
+
+bool album_index_is_image_name(const char *name)
+{
+    if (name[0] == '.' && name[1] == '_') {
+        return false;
+    }
+    return album_index_format_of(name) != IMAGE_FORMAT_UNKNOWN;
+}
+
+// Open an album's index and read its header. Returns NULL when the index is
+// missing, corrupt or shorter than its header claims.
+static FILE *index_open(const char *album, const char *mode, index_header_t *hdr)
+{
+    char path[320];
+    index_path(album, path, sizeof(path));
+    FILE *fp = fopen(path, mode);
+    if (!fp) {
+        return NULL;
+    }
+
+    bool valid = fread(hdr, sizeof(*hdr), 1, fp) == 1 && hdr->magic == ALBUM_INDEX_MAGIC &&
+                 hdr->record_size == sizeof(index_record_t);
+    if (valid) {
+        long expected = (long) sizeof(*hdr) + (long) hdr->count * (long) sizeof(index_record_t);
+        valid = fseek(fp, 0, SEEK_END) == 0 && ftell(fp) >= expected;
+    }
+    if (!valid) {
+        ESP_LOGW(TAG, "Discarding invalid index of album %s", album);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+// Scan an album directory into a fresh index. The directory mtime is taken
+// before the scan, so a change racing with it leaves the index stale rather
+// than silently incomplete.
+static esp_err_t rebuild_locked(const char *album, int *count)
+{
+    int64_t mtime;
+    if (!album_dir_mtime(album, &mtime)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    struct stat st;
+    if (stat(ALBUM_INDEX_DIRECTORY, &st) != 0 && mkdir(ALBUM_INDEX_DIRECTORY, 0775) != 0) {
+        ESP_LOGE(TAG, "Failed to create index directory");
+        return ESP_FAIL;
+    }
+
+    char dir_path[256];
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", IMAGE_DIRECTORY, album);
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        return ESP_FAIL;
+    }
+
+    FILE *fp = fopen(ALBUM_INDEX_TMP_PATH, "wb");
+    if (!fp) {
+        ESP_LOGE(TAG, "Failed to create index of album %s", album);
+        closedir(dir);
+        return ESP_FAIL;
+    }
+
+    // Carry the generation on, so a listing ETag from before the rebuild
+    // cannot match after it
+    index_header_t old;
+    FILE *old_fp = index_open(album, "rb", &old);
+    uint32_t generation = (uint32_t) mtime;
+    uint32_t order = (uint32_t) mtime;
+    if (old_fp) {
+        generation = old.generation + 1;
+        order = old.order + 1;
+        fclose(old_fp);
+    }
+
+    index_header_t hdr = {
+        .magic = ALBUM_INDEX_MAGIC,
+        .record_size = sizeof(index_record_t),
+        .dir_mtime = mtime,
+        .generation = generation,
+        .order = order,
+    };
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_REG || !album_index_is_image_name(entry->d_name)) {
+            continue;
+        }
+        size_t len = strlen(entry->d_name);
+        index_record_t rec;
+        if (len >= ALBUM_INDEX_NAME_MAX) {
+            ESP_LOGW(TAG, "File name too long to index: %s/%s", album, entry->d_name);
+            continue;
+        }
+        fill_record(&rec, album, entry->d_name, len);
+        ok = fwrite(&rec, sizeof(rec), 1, fp) == 1;
+        hdr.count++;
+    }
+    closedir(dir);
+
+    if (ok) {
+        ok = fseek(fp, 0, SEEK_SET) == 0 && fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    }
+    // Buffered writes can surface a full-disk error only at close
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+
+    char path[320];
+    index_path(album, path, sizeof(path));
+    unlink(path);
+    if (!ok || rename(ALBUM_INDEX_TMP_PATH, path) != 0) {
+        ESP_LOGE(TAG, "Failed to write index of album %s", album);
+        unlink(ALBUM_INDEX_TMP_PATH);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Indexed %lu image(s) in album %s", (unsigned long) hdr.count, album);
+    if (count) {
+        *count = (int) hdr.count;
+    }
+    return ESP_OK;
+}
+
+static bool index_is_current_locked(const char *album)
+{
+    int64_t mtime;
+    if (!album_dir_mtime(album, &mtime)) {
+        return true;  // nothing to index
+    }
+    index_header_t hdr;
+    FILE *fp = index_open(album, "rb", &hdr);
+    if (!fp) {
+        return false;
+    }
+    fclose(fp);
+    return hdr.dir_mtime == mtime;
+}
+
+// Number of files an album directory holds that its index would list
+static int count_indexable(const char *album)
+{
+    char dir_path[256];
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", IMAGE_DIRECTORY, album);
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        return -1;
+    }
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_REG && album_index_is_image_name(entry->d_name) &&
+            strlen(entry->d_name) < ALBUM_INDEX_NAME_MAX) {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static bool index_count_matches_locked(const char *album, int count)
+{
+    index_header_t hdr;
+    FILE *fp = index_open(album, "rb", &hdr);
+    if (!fp) {
+        return false;
+    }
+    fclose(fp);
+    return count < 0 || hdr.count == (uint32_t) count;
+}
+
+// Re-index every stale album. Runs at low priority after a wake found a
+// stale index; an interrupted run (deep sleep) leaves the old indexes in
+// place, and the next wake starts over. A verifying pass also compares each
+// index with a count of its directory's entries, for changes the directory
+// mtime missed.
+static void rebuild_task(void *arg)
+{
+    (void) arg;
+    bool again;
+    do {
+        index_lock();
+        bool verify = rebuild_verify;
+        rebuild_verify = false;
+        index_unlock();
+
+        DIR *dir = opendir(IMAGE_DIRECTORY);
+        if (dir) {
+            struct dirent *entry;
+            while ((entry = readdir(dir)) != NULL) {
+                if (entry->d_type != DT_DIR || entry->d_name[0] == '.') {
+                    continue;
+                }
+                // Counted outside the lock, so rotations are not held up
+                int count = verify ? count_indexable(entry->d_name) : -1;
+                index_lock();
+                if (!index_is_current_locked(entry->d_name) ||
+                    !index_count_matches_locked(entry->d_name, count)) {
+                    rebuild_locked(entry->d_name, NULL);
+                }
+                index_unlock();
+            }
+            closedir(dir);
+        }
+
+        index_lock();
+        again = rebuild_again;
+        rebuild_again = false;
+        if (!again) {
+            rebuild_running = false;
+        }
+        index_unlock();
+    } while (again);
+
+    vTaskDelete(NULL);
+}
+
+static void schedule_rebuild(void)
+{
+    index_lock();
+    bool start = !rebuild_running;
+    if (start) {
+        rebuild_running = true;
+    } else {
+        rebuild_again = true;
+    }
+    index_unlock();
+
+    if (start && xTaskCreate(rebuild_task, "album_index", 6144, NULL, tskIDLE_PRIORITY + 1,
+                             NULL) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to start background re-index");
+        index_lock();
+        rebuild_running = false;
+        index_unlock();
+    }
+}
+
+bool album_index_split_path(const char *path, char *album, size_t album_len, const char **name)
+{
+    size_t prefix = strlen(IMAGE_DIRECTORY);
+    if (!path || strncmp(path, IMAGE_DIRECTORY, prefix) != 0 || path[prefix] != '/') {
+        return false;
+    }
+    const char *start = path + prefix + 1;
+    const char *slash = strchr(start, '/');
+    if (!slash || slash == start || (size_t) (slash - start) >= album_len ||
+        strchr(slash + 1, '/') != NULL || slash[1] == '\0') {
+        return false;
+    }
+    memcpy(album, start, slash - start);
+    album[slash - start] = '\0';
+    *name = slash + 1;
+    return true;
+}
+
+// Position of a file name among an index's records; -1 when absent
+static long find_record(FILE *fp, const index_header_t *hdr, const char *name)
+{
+    if (fseek(fp, sizeof(*hdr), SEEK_SET) != 0) {
+        return -1;
+    }
+    index_record_t rec;
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        if (fread(&rec, sizeof(rec), 1, fp) != 1) {
+            return -1;
+        }
+        if (record_matches(&rec, name)) {
+            return (long) i;
+        }
+    }
+    return -1;
+}
+
+// Write back the header after an incremental update. The update itself
+// moved the directory mtime, so the header adopts the new one.
+static void index_finish_update(const char *album, FILE *fp, index_header_t *hdr)
+{
+    album_dir_mtime(album, &hdr->dir_mtime);
+    hdr->generation++;
+    if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(hdr, sizeof(*hdr), 1, fp) != 1) {
+        ESP_LOGW(TAG, "Failed to update index of album %s", album);
+    }
+    fclose(fp);
+}
+
+esp_err_t album_index_init(void)
+{
+    if (!index_mutex) {
+        index_mutex = xSemaphoreCreateMutex();
+        if (!index_mutex) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t album_index_count(const char *album, int *count)
+{
+    return album_index_stat(album, count, NULL);
+}
+
+// The loose-file index of an album. For a packed album it lists only the
+// images left outside the pack, which follow the packed ones in position.
+static esp_err_t loose_stat(const char *album, int *count, uint32_t *generation,
+                            uint32_t *order)
+{
+    esp_err_t err = ESP_OK;
+    bool stale = false;
+    int64_t mtime;
+
+    index_lock();
+    if (!album_dir_mtime(album, &mtime)) {
+        err = ESP_ERR_NOT_FOUND;
+    } else {
+        index_header_t hdr;
+        FILE *fp = index_open(album, "rb", &hdr);
+        if (!fp) {
+            err = rebuild_locked(album, NULL);
+            fp = err == ESP_OK ? index_open(album, "rb", &hdr) : NULL;
+            if (err == ESP_OK && !fp) {
+                err = ESP_FAIL;
+            }
+        }
+        if (fp) {
+            fclose(fp);
+            *count = (int) hdr.count;
+            *generation = hdr.generation;
+            *order = hdr.order;
+            stale = hdr.dir_mtime != mtime;
+        }
+    }
+    index_unlock();
+
+    if (stale) {
+        ESP_LOGI(TAG, "Index of album %s is stale, re-indexing in background", album);
+        schedule_rebuild();
+    }
+    return err;
+}
+
+static esp_err_t loose_get(const char *album, int n, char *path, size_t path_len,
+                           image_format_t *format)
+{
+    index_lock();
+    index_header_t hdr;
+    FILE *fp = index_open(album, "rb", &hdr);
+    if (!fp) {
+        rebuild_locked(album, NULL);
+        index_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (n < 0 || (uint32_t) n >= hdr.count) {
+        fclose(fp);
+        index_unlock();
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    index_record_t rec;
+    long offset = (long) sizeof(hdr) + (long) n * (long) sizeof(rec);
+    bool read_ok = fseek(fp, offset, SEEK_SET) == 0 && fread(&rec, sizeof(rec), 1, fp) == 1;
+    fclose(fp);
+    if (!read_ok) {
+        rebuild_locked(album, NULL);
+        index_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+    char name[ALBUM_INDEX_NAME_MAX];
+    bool named = record_name(album, &rec, name);
+
+    esp_err_t err = ESP_OK;
+    snprintf(path, path_len, "%s/%s/%s", IMAGE_DIRECTORY, album, name);
+    struct stat st;
+    if (!named || stat(path, &st) != 0) {
+        ESP_LOGW(TAG, "Indexed image %s is gone, re-indexing album %s", name, album);
+        rebuild_locked(album, NULL);
+        err = ESP_ERR_NOT_FOUND;
+    } else if (format) {
+        *format = (image_format_t) rec.format;
+    }
+    index_unlock();
+    return err;
+}
+
+static esp_err_t loose_read(const char *album, int first, album_index_entry_t *entries, int max,
+                            int *read)
+{
+    *read = 0;
+
+    index_lock();
+    index_header_t hdr;
+    FILE *fp = index_open(album, "rb", &hdr);
+    if (!fp && rebuild_locked(album, NULL) == ESP_OK) {
+        fp = index_open(album, "rb", &hdr);
+    }
+    if (!fp) {
+        index_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    long offset = (long) sizeof(hdr) + (long) first * (long) sizeof(index_record_t);
+    if ((uint32_t) first < hdr.count && fseek(fp, offset, SEEK_SET) == 0) {
+        int n = (int) hdr.count - first < max ? (int) hdr.count - first : max;
+        index_record_t rec;
+        while (*read < n && fread(&rec, sizeof(rec), 1, fp) == 1) {
+            album_index_entry_t *e = &entries[(*read)++];
+            record_name(album, &rec, e->name);
+            e->format = (image_format_t) rec.format;
+            e->has_thumbnail = (rec.flags & RECORD_HAS_THUMBNAIL) != 0;
+        }
+    }
+    fclose(fp);
+    index_unlock();
+    return ESP_OK;
+}
+
+// Drop a loose file's record, e.g. after it moved into the album's pack
+static void loose_forget(const char *album, const char *name)
+{
+    index_lock();
+    index_header_t hdr;
+    FILE *fp = index_open(album, "r+b", &hdr);
+    if (!fp) {
+        rebuild_locked(album, NULL);
+        index_unlock();
+        return;
+    }
+
+    // Move the last record into the removed one's slot
+    long pos = find_record(fp, &hdr, name);
+    if (pos >= 0) {
+        index_record_t last;
+        long last_offset = (long) sizeof(hdr) + (long) (hdr.count - 1) * (long) sizeof(last);
+        long offset = (long) sizeof(hdr) + pos * (long) sizeof(last);
+        if (fseek(fp, last_offset, SEEK_SET) == 0 && fread(&last, sizeof(last), 1, fp) == 1 &&
+            fseek(fp, offset, SEEK_SET) == 0 && fwrite(&last, sizeof(last), 1, fp) == 1) {
+            hdr.count--;
+            hdr.order++;
+        }
+    }
+    index_finish_update(album, fp, &hdr);
+    index_unlock();
+}
+
+static esp_err_t stat_album(const char *album, int *count, uint32_t *generation,
+                            uint32_t *order)
+{
+    if (!album || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int packed = 0;
+    uint32_t pack_generation = 0;
+    if (album_pack_present(album) &&
+        album_pack_stat(album, &packed, &pack_generation) != ESP_OK) {
+        packed = 0;
+    }
+
+    int loose;
+    uint32_t loose_generation;
+    uint32_t loose_order;
+    esp_err_t err = loose_stat(album, &loose, &loose_generation, &loose_order);
+    if (err != ESP_OK) {
+        return err;
+    }
+    *count = packed + loose;
+    if (generation) {
+        // Both parts only ever move forward, so their sum changes with either
+        *generation = pack_generation + loose_generation;
+    }
+    if (order) {
+        // A pack bumps its generation on every change, and only an append
+        // also adds a record: generation - count moves on removals and
+        // replacements. Loose positions follow the packed ones, so they move
+        // whenever the pack's count changes.
+        uint32_t mix[3] = {pack_generation - (uint32_t) packed, loose_order,
+                           loose > 0 ? (uint32_t) packed : 0};
+        uint32_t hash = 2166136261u;
+        const uint8_t *bytes = (const uint8_t *) mix;
+        for (size_t i = 0; i < sizeof(mix); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        *order = hash;
+    }
+    return ESP_OK;
+}
+
+esp_err_t album_index_stat(const char *album, int *count, uint32_t *generation)
+{
+    return stat_album(album, count, generation, NULL);
+}
+
+esp_err_t album_index_order(const char *album, int *count, uint32_t *order)
+{
+    return stat_album(album, count, NULL, order);
+}
+
+esp_err_t album_index_get(const char *album, int n, char *path, size_t path_len,
+                          image_format_t *format)
+{
+    if (!album || !path || path_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int packed = 0;
+    if (album_pack_present(album) && album_pack_stat(album, &packed, NULL) == ESP_OK &&
+        n >= 0 && n < packed) {
+        return album_pack_get(album, n, path, path_len, format);
+    }
+    return loose_get(album, n - packed, path, path_len, format);
+}
+
+esp_err_t album_index_read(const char *album, int first, album_index_entry_t *entries, int max,
+                           int *read)
+{
+    if (!album || !entries || !read || first < 0 || max < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int packed = 0;
+    int from_pack = 0;
+    if (album_pack_present(album) && album_pack_stat(album, &packed, NULL) == ESP_OK &&
+        album_pack_read(album, first, entries, max, &from_pack) != ESP_OK) {
+        from_pack = 0;
+    }
+
+    int loose_first = first > packed ? first - packed : 0;
+    esp_err_t err = loose_read(album, loose_first, entries + from_pack, max - from_pack, read);
+    *read += from_pack;
+    return err == ESP_ERR_NOT_FOUND && from_pack > 0 ? ESP_OK : err;
+}
+
+esp_err_t album_index_rebuild(const char *album)
+{
+    if (!album) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    index_lock();
+    esp_err_t err = rebuild_locked(album, NULL);
+    index_unlock();
+    return err;
+}
+
+void album_index_note_added(const char *path)
+{
+    char album[128];
+    const char *name;
+    if (!album_index_split_path(path, album, sizeof(album), &name) ||
+        !album_index_is_image_name(name)) {
+        return;
+    }
+    // A packed album takes the file into its pack; what the pack cannot
+    // hold stays loose and is indexed as in any other album
+    if (album_pack_present(album)) {
+        if (album_pack_add(path) == ESP_OK) {
+            loose_forget(album, name);
+            return;
+        }
+        ESP_LOGW(TAG, "Could not pack %s, leaving it loose", path);
+    }
+
+    index_lock();
+    index_header_t hdr;
+    FILE *fp = index_open(album, "r+b", &hdr);
+    if (!fp) {
+        // A fresh scan picks the new file up
+        rebuild_locked(album, NULL);
+        index_unlock();
+        return;
+    }
+
+    index_record_t rec;
+    size_t len = strlen(name);
+    if (len < ALBUM_INDEX_NAME_MAX) {
+        fill_record(&rec, album, name, len);
+        // Uploads overwrite same-named files: refresh that record in place
+        long pos = find_record(fp, &hdr, name);
+        bool append = pos < 0;
+        if (append) {
+            pos = hdr.count;
+        }
+        long offset = (long) sizeof(hdr) + pos * (long) sizeof(rec);
+        if (fseek(fp, offset, SEEK_SET) == 0 && fwrite(&rec, sizeof(rec), 1, fp) == 1 &&
+            append) {
+            hdr.count++;
+        }
+    }
+    index_finish_update(album, fp, &hdr);
+    index_unlock();
+}
+
+void album_index_note_removed(const char *path)
+{
+    char album[128];
+    const char *name;
+    if (!album_index_split_path(path, album, sizeof(album), &name) ||
+        !album_index_is_image_name(name)) {
+        return;
+    }
+    if (album_pack_present(album) && album_pack_remove(path) == ESP_OK) {
+        return;
+    }
+    loose_forget(album, name);
+}
+
+void album_index_verify(void)
+{
+    index_lock();
+    rebuild_verify = true;
+    index_unlock();
+    schedule_rebuild();
+}
+
+void album_index_drop(const char *album)
+{
+    if (!album) {
+        return;
+    }
+    char path[320];
+    index_path(album, path, sizeof(path));
+    index_lock();
+    unlink(path);
+    index_unlock();
+}
@@ -0,0 +1,132 @@
+#ifndef ALBUM_INDEX_H
+#define ALBUM_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "image_processor.h"
+
+// Persistent per-album image indexes, so rotation and album listings do not
+// rescan album directories. Each album has one file under
+// ALBUM_INDEX_DIRECTORY holding a header and one fixed-size record (format,
+// thumbnail presence and file name) per image, which makes the nth image a
+// single seek.
+//
+// Uploads, deletes and album operations keep the indexes current
+// incrementally. An index is validated against its album directory's mtime;
+// a stale one is still served (every pick is checked against the file) while
+// it is rebuilt in the background. A missing or corrupt index is rebuilt on
+// the spot. FAT does not move a directory's mtime when entries change, so
+// files copied onto the card elsewhere are found by album_index_verify.
+//
+// In a packed album (album_pack.h) the packed images come first, answered
+// from the pack, followed by the files left loose (BMPs, and uploads that
+// could not be packed), which keep a regular index. Noting a file added
+// moves it into the pack when it can.
+
+// Longest indexed file name, terminator included
+#define ALBUM_INDEX_NAME_MAX 254
+
+typedef struct {
+    char name[ALBUM_INDEX_NAME_MAX];
+    image_format_t format;
+    bool has_thumbnail;  // a same-named .jpg preview sits next to the image
+} album_index_entry_t;
+
+esp_err_t album_index_init(void);
+
+/**
+ * @brief Whether a directory entry name is a displayable album image
+ *
+ * .bmp, .png and .epdgz files, excluding macOS "._" resource forks.
+ */
+bool album_index_is_image_name(const char *name);
+
+/**
+ * @brief Image format of an album file name, by extension
+ */
+image_format_t album_index_format_of(const char *name);
+
+/**
+ * @brief Split IMAGE_DIRECTORY/<album>/<file> into album and file name
+ *
+ * @return false for any other path
+ */
+bool album_index_split_path(const char *path, char *album, size_t album_len, const char **name);
+
+/**
+ * @brief Number of images in an album
+ */
+esp_err_t album_index_count(const char *album, int *count);
+
+/**
+ * @brief Number of images in an album and the index generation
+ *
+ * The generation changes whenever the album's index does, so it can tag
+ * cached listings. generation may be NULL.
+ */
+esp_err_t album_index_stat(const char *album, int *count, uint32_t *generation);
+
+/**
+ * @brief Number of images in an album and its order tag
+ *
+ * The order tag changes whenever an image may have moved to another
+ * position (a removal or a re-index). Appending an image leaves it alone, so
+ * state kept per position survives uploads.
+ */
+esp_err_t album_index_order(const char *album, int *count, uint32_t *order);
+
+/**
+ * @brief Read up to max index entries starting at position first
+ *
+ * Sets *read to the number of entries filled (0 past the end). Positions
+ * match album_index_get.
+ */
+esp_err_t album_index_read(const char *album, int first, album_index_entry_t *entries, int max,
+                           int *read);
+
+/**
+ * @brief Full path (and optionally format) of an album's nth image
+ *
+ * @return ESP_OK; ESP_ERR_INVALID_ARG when n is out of range;
+ *         ESP_ERR_NOT_FOUND when the indexed file has gone, in which case
+ *         the album was re-indexed and counts must be re-read
+ */
+esp_err_t album_index_get(const char *album, int n, char *path, size_t path_len,
+                          image_format_t *format);
+
+/**
+ * @brief Rescan an album directory and rewrite its index
+ */
+esp_err_t album_index_rebuild(const char *album);
+
+/**
+ * @brief Record a file that was just written into an album
+ *
+ * path is the full path (IMAGE_DIRECTORY/<album>/<file>); anything else,
+ * and files that are not album images, are ignored.
+ */
+void album_index_note_added(const char *path);
+
+/**
+ * @brief Record a file that was just removed from an album
+ */
+void album_index_note_removed(const char *path);
+
+/**
+ * @brief Check every album's index against its directory in the background
+ *
+ * Re-indexes albums whose directory holds a different number of images than
+ * the index lists, as after files were copied onto the card from a computer.
+ * Reads every album directory, so it runs on interactive boots only.
+ */
+void album_index_verify(void);
+
+/**
+ * @brief Forget an album's index (the album is being deleted)
+ */
+void album_index_drop(const char *album);
+
+#endif
@@ -5,6 +5,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "album_index.h"
 #include "config.h"
 #include "esp_log.h"
 #include "nvs.h"
@@ -148,6 +149,9 @@ esp_err_t album_manager_create_album(const char *album_name)
         return ESP_FAIL;
     }
 
+    // Start the album with an (empty) index
+    album_index_rebuild(album_name);
+
     ESP_LOGI(TAG, "Created album: %s", album_name);
     return ESP_OK;
 }
@@ -189,6 +193,7 @@ esp_err_t album_manager_delete_album(const char *album_name)
     }
 
     album_manager_set_album_enabled(album_name, false);
+    album_index_drop(album_name);
 
     ESP_LOGI(TAG, "Deleted album: %s", album_name);
     return ESP_OK;
@@ -0,0 +1,751 @@
+#include "album_pack.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "album_pack";
+
+#define ALBUM_PACK_MAGIC 0x314B5041  // "APK1"
+// Index slots in a new pack; a full index moves to the end of the file with
+// twice the slots
+#define PACK_INITIAL_CAPACITY 64
+#define PACK_COPY_CHUNK 4096
+#define PACK_NAME_MAX 236
+
+typedef struct {
+    uint32_t magic;
+    uint32_t record_size;
+    uint32_t count;     // live records, packed at the start of the index
+    uint32_t capacity;  // record slots at index_offset
+    uint32_t index_offset;
+    uint32_t data_end;    // blobs are appended here
+    uint32_t dead_bytes;  // bytes no record refers to any more
+    uint32_t generation;  // bumped on every change, for listing ETags
+} pack_header_t;
+
+typedef struct {
+    uint32_t offset;  // image blob
+    uint32_t length;
+    uint32_t thumb_offset;
+    uint32_t thumb_length;  // 0: no thumbnail
+    uint8_t format;         // image_format_t
+    uint8_t reserved[3];
+    char name[PACK_NAME_MAX];
+} pack_record_t;
+
+static SemaphoreHandle_t pack_mutex = NULL;
+// Blobs handed out by album_pack_open; compaction waits for them to close
+static int open_blobs = 0;
+static bool compact_running = false;
+static bool compact_again = false;
+
+static void pack_lock(void)
+{
+    xSemaphoreTake(pack_mutex, portMAX_DELAY);
+}
+
+static void pack_unlock(void)
+{
+    xSemaphoreGive(pack_mutex);
+}
+
+static void pack_path(const char *album, char *path, size_t path_len)
+{
+    snprintf(path, path_len, "%s/%s/%s", IMAGE_DIRECTORY, album, ALBUM_PACK_FILE_NAME);
+}
+
+static bool pack_holds_format(image_format_t format)
+{
+    return format == IMAGE_FORMAT_EPD_GZ || format == IMAGE_FORMAT_PNG;
+}
+
+// Length of a file name without its extension
+static size_t base_len(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    return ext ? (size_t) (ext - name) : strlen(name);
+}
+
+// Open an album's pack and read its header. Returns NULL when the pack is
+// missing or its header is inconsistent.
+static FILE *pack_open(const char *album, const char *mode, pack_header_t *hdr)
+{
+    char path[320];
+    pack_path(album, path, sizeof(path));
+    FILE *fp = fopen(path, mode);
+    if (!fp) {
+        return NULL;
+    }
+
+    bool valid = fread(hdr, sizeof(*hdr), 1, fp) == 1 && hdr->magic == ALBUM_PACK_MAGIC &&
+                 hdr->record_size == sizeof(pack_record_t) && hdr->count <= hdr->capacity &&
+                 (uint64_t) hdr->index_offset + (uint64_t) hdr->capacity * sizeof(pack_record_t) <=
+                     hdr->data_end;
+    if (!valid) {
+        ESP_LOGE(TAG, "Invalid pack in album %s", album);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+static bool write_header(FILE *fp, const pack_header_t *hdr)
+{
+    return fseek(fp, 0, SEEK_SET) == 0 && fwrite(hdr, sizeof(*hdr), 1, fp) == 1 &&
+           fflush(fp) == 0;
+}
+
+static bool read_record(FILE *fp, const pack_header_t *hdr, uint32_t i, pack_record_t *rec)
+{
+    long offset = (long) hdr->index_offset + (long) i * (long) sizeof(*rec);
+    if (fseek(fp, offset, SEEK_SET) != 0 || fread(rec, sizeof(*rec), 1, fp) != 1) {
+        return false;
+    }
+    rec->name[sizeof(rec->name) - 1] = '\0';
+    return true;
+}
+
+static bool write_record(FILE *fp, uint32_t index_offset, uint32_t i, const pack_record_t *rec)
+{
+    long offset = (long) index_offset + (long) i * (long) sizeof(*rec);
+    return fseek(fp, offset, SEEK_SET) == 0 && fwrite(rec, sizeof(*rec), 1, fp) == 1;
+}
+
+// Position of an image among a pack's records; -1 when absent. With
+// thumbnail set, name is a thumbnail's and matches by base name.
+static long find_record(FILE *fp, const pack_header_t *hdr, const char *name, bool thumbnail,
+                        pack_record_t *rec)
+{
+    size_t len = thumbnail ? base_len(name) : strlen(name);
+    if (fseek(fp, hdr->index_offset, SEEK_SET) != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        if (fread(rec, sizeof(*rec), 1, fp) != 1) {
+            return -1;
+        }
+        rec->name[sizeof(rec->name) - 1] = '\0';
+        bool match = thumbnail ? base_len(rec->name) == len && strncmp(rec->name, name, len) == 0
+                               : strcmp(rec->name, name) == 0;
+        if (match) {
+            return (long) i;
+        }
+    }
+    return -1;
+}
+
+// Copy up to max bytes from in to out at their current positions; stops
+// early only at the end of in. Returns false on I/O errors.
+static bool copy_bytes(FILE *in, FILE *out, uint32_t max, uint32_t *copied)
+{
+    uint8_t *buf = malloc(PACK_COPY_CHUNK);
+    if (!buf) {
+        return false;
+    }
+    bool ok = true;
+    *copied = 0;
+    while (*copied < max) {
+        size_t want = max - *copied < PACK_COPY_CHUNK ? max - *copied : PACK_COPY_CHUNK;
+        size_t n = fread(buf, 1, want, in);
+        if (n == 0) {
+            ok = !ferror(in);
+            break;
+        }
+        if (fwrite(buf, 1, n, out) != n) {
+            ok = false;
+            break;
+        }
+        *copied += (uint32_t) n;
+    }
+    free(buf);
+    return ok;
+}
+
+// Append a loose file's bytes at the pack's data end
+static bool append_file(FILE *fp, pack_header_t *hdr, const char *path, uint32_t *offset,
+                        uint32_t *length)
+{
+    struct stat st;
+    if (stat(path, &st) != 0 || (uint64_t) hdr->data_end + (uint64_t) st.st_size > UINT32_MAX) {
+        return false;
+    }
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        return false;
+    }
+    uint32_t copied = 0;
+    bool ok = fseek(fp, hdr->data_end, SEEK_SET) == 0 && copy_bytes(in, fp, UINT32_MAX, &copied);
+    fclose(in);
+    // A failed copy may already have written part of the file; data_end
+    // covers it either way so the caller can account for those bytes
+    *offset = hdr->data_end;
+    *length = copied;
+    hdr->data_end += copied;
+    return ok;
+}
+
+// Move a full index to the end of the file with twice the slots. Only the
+// header written by the caller commits the move.
+static bool grow_index(FILE *fp, pack_header_t *hdr)
+{
+    uint32_t capacity = hdr->capacity * 2;
+    uint32_t offset = hdr->data_end;
+    if ((uint64_t) offset + (uint64_t) capacity * sizeof(pack_record_t) > UINT32_MAX) {
+        return false;
+    }
+
+    pack_record_t rec;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (i < hdr->count) {
+            if (!read_record(fp, hdr, i, &rec)) {
+                return false;
+            }
+        } else {
+            memset(&rec, 0, sizeof(rec));
+        }
+        if (!write_record(fp, offset, i, &rec)) {
+            return false;
+        }
+    }
+
+    hdr->dead_bytes += hdr->capacity * sizeof(pack_record_t);
+    hdr->index_offset = offset;
+    hdr->capacity = capacity;
+    hdr->data_end = offset + capacity * sizeof(pack_record_t);
+    return true;
+}
+
+static esp_err_t create_locked(const char *album)
+{
+    char path[320];
+    pack_path(album, path, sizeof(path));
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        ESP_LOGE(TAG, "Failed to create pack in album %s", album);
+        return ESP_FAIL;
+    }
+
+    pack_header_t hdr = {
+        .magic = ALBUM_PACK_MAGIC,
+        .record_size = sizeof(pack_record_t),
+        .capacity = PACK_INITIAL_CAPACITY,
+        .index_offset = sizeof(pack_header_t),
+    };
+    hdr.data_end = hdr.index_offset + hdr.capacity * sizeof(pack_record_t);
+
+    pack_record_t empty = {0};
+    bool ok = write_header(fp, &hdr);
+    for (uint32_t i = 0; ok && i < hdr.capacity; i++) {
+        ok = write_record(fp, hdr.index_offset, i, &empty);
+    }
+    if (fclose(fp) != 0 || !ok) {
+        unlink(path);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Created pack for album %s", album);
+    return ESP_OK;
+}
+
+// Rewrite a pack with only its live blobs, into a temporary file that then
+// replaces it
+static esp_err_t compact_locked(const char *album)
+{
+    char path[320];
+    char tmp_path[330];
+    pack_path(album, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    pack_header_t hdr;
+    FILE *fp = pack_open(album, "rb", &hdr);
+    if (!fp) {
+        return ESP_FAIL;
+    }
+    FILE *out = fopen(tmp_path, "wb");
+    if (!out) {
+        fclose(fp);
+        return ESP_FAIL;
+    }
+
+    uint32_t capacity = PACK_INITIAL_CAPACITY;
+    while (capacity <= hdr.count) {
+        capacity *= 2;
+    }
+    pack_header_t fresh = hdr;
+    fresh.capacity = capacity;
+    fresh.index_offset = sizeof(pack_header_t);
+    fresh.data_end = fresh.index_offset + capacity * sizeof(pack_record_t);
+    fresh.dead_bytes = 0;
+
+    // Lay out the header and an empty index first, then fill in the blobs
+    // and their records
+    pack_record_t rec = {0};
+    bool ok = write_header(out, &fresh);
+    for (uint32_t i = 0; ok && i < capacity; i++) {
+        ok = write_record(out, fresh.index_offset, i, &rec);
+    }
+    for (uint32_t i = 0; ok && i < hdr.count; i++) {
+        uint32_t copied = 0;
+        ok = read_record(fp, &hdr, i, &rec) && fseek(fp, rec.offset, SEEK_SET) == 0 &&
+             fseek(out, fresh.data_end, SEEK_SET) == 0 &&
+             copy_bytes(fp, out, rec.length, &copied) && copied == rec.length;
+        rec.offset = fresh.data_end;
+        fresh.data_end += rec.length;
+        if (ok && rec.thumb_length > 0) {
+            ok = fseek(fp, rec.thumb_offset, SEEK_SET) == 0 &&
+                 copy_bytes(fp, out, rec.thumb_length, &copied) && copied == rec.thumb_length;
+            rec.thumb_offset = fresh.data_end;
+            fresh.data_end += rec.thumb_length;
+        }
+        ok = ok && write_record(out, fresh.index_offset, i, &rec);
+    }
+    ok = ok && write_header(out, &fresh);
+    fclose(fp);
+    if (fclose(out) != 0 || !ok) {
+        ESP_LOGE(TAG, "Failed to compact pack of album %s", album);
+        unlink(tmp_path);
+        return ESP_FAIL;
+    }
+
+    // FAT renames do not replace an existing target
+    unlink(path);
+    if (rename(tmp_path, path) != 0) {
+        ESP_LOGE(TAG, "Failed to replace pack of album %s", album);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Compacted pack of album %s: %lu -> %lu bytes", album,
+             (unsigned long) hdr.data_end, (unsigned long) fresh.data_end);
+    return ESP_OK;
+}
+
+// Compact once at least half the pack is dead space
+static bool needs_compaction(const pack_header_t *hdr)
+{
+    return hdr->dead_bytes > hdr->data_end / 2;
+}
+
+// Compact every pack that has crossed the threshold. Runs at low priority
+// after a removal, so deletes do not wait for a whole pack to be copied;
+// packs with open blobs are left for the next removal.
+static void compact_task(void *arg)
+{
+    (void) arg;
+    bool again;
+    do {
+        DIR *dir = opendir(IMAGE_DIRECTORY);
+        if (dir) {
+            struct dirent *entry;
+            while ((entry = readdir(dir)) != NULL) {
+                if (entry->d_type != DT_DIR || entry->d_name[0] == '.' ||
+                    !album_pack_present(entry->d_name)) {
+                    continue;
+                }
+                pack_lock();
+                pack_header_t hdr;
+                FILE *fp = open_blobs == 0 ? pack_open(entry->d_name, "rb", &hdr) : NULL;
+                if (fp) {
+                    fclose(fp);
+                    if (needs_compaction(&hdr)) {
+                        compact_locked(entry->d_name);
+                    }
+                }
+                pack_unlock();
+            }
+            closedir(dir);
+        }
+
+        pack_lock();
+        again = compact_again;
+        compact_again = false;
+        if (!again) {
+            compact_running = false;
+        }
+        pack_unlock();
+    } while (again);
+
+    vTaskDelete(NULL);
+}
+
+static void schedule_compaction(void)
+{
+    pack_lock();
+    bool start = !compact_running;
+    if (start) {
+        compact_running = true;
+    } else {
+        compact_again = true;
+    }
+    pack_unlock();
+
+    if (start && xTaskCreate(compact_task, "album_pack", 6144, NULL, tskIDLE_PRIORITY + 1,
+                             NULL) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to start background pack compaction");
+        pack_lock();
+        compact_running = false;
+        pack_unlock();
+    }
+}
+
+static esp_err_t add_locked(const char *album, const char *name)
+{
+    image_format_t format = album_index_format_of(name);
+    if (!pack_holds_format(format) || strlen(name) >= PACK_NAME_MAX) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    char image_path[512];
+    char thumb_path[512];
+    snprintf(image_path, sizeof(image_path), "%s/%s/%s", IMAGE_DIRECTORY, album, name);
+    snprintf(thumb_path, sizeof(thumb_path), "%s/%s/%.*s.jpg", IMAGE_DIRECTORY, album,
+             (int) base_len(name), name);
+
+    pack_header_t hdr;
+    FILE *fp = pack_open(album, "r+b", &hdr);
+    if (!fp) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    pack_record_t old;
+    long pos = find_record(fp, &hdr, name, false, &old);
+    if (pos < 0 && hdr.count == hdr.capacity && !grow_index(fp, &hdr)) {
+        fclose(fp);
+        return ESP_FAIL;
+    }
+
+    pack_record_t rec = {0};
+    rec.format = (uint8_t) format;
+    strcpy(rec.name, name);
+    uint32_t data_start = hdr.data_end;
+    bool ok = append_file(fp, &hdr, image_path, &rec.offset, &rec.length);
+    struct stat st;
+    if (ok && stat(thumb_path, &st) == 0) {
+        ok = append_file(fp, &hdr, thumb_path, &rec.thumb_offset, &rec.thumb_length);
+    } else if (ok && pos >= 0) {
+        // Re-added without a thumbnail: keep the one already packed
+        rec.thumb_offset = old.thumb_offset;
+        rec.thumb_length = old.thumb_length;
+        old.thumb_length = 0;
+    }
+
+    if (!ok && hdr.data_end != data_start) {
+        // Whatever was appended before the failure stays in the file: commit
+        // it as dead space so compaction reclaims it
+        hdr.dead_bytes += hdr.data_end - data_start;
+        write_header(fp, &hdr);
+    } else if (ok) {
+        if (pos >= 0) {
+            hdr.dead_bytes += old.length + old.thumb_length;
+        } else {
+            pos = (long) hdr.count++;
+        }
+        hdr.generation++;
+        // The header commits the record; until then the pack reads as before
+        ok = write_record(fp, hdr.index_offset, (uint32_t) pos, &rec) && write_header(fp, &hdr);
+    }
+    if (fclose(fp) != 0 || !ok) {
+        ESP_LOGE(TAG, "Failed to pack %s into album %s", name, album);
+        return ESP_FAIL;
+    }
+
+    unlink(image_path);
+    unlink(thumb_path);
+    return ESP_OK;
+}
+
+esp_err_t album_pack_init(void)
+{
+    if (!pack_mutex) {
+        pack_mutex = xSemaphoreCreateMutex();
+        if (!pack_mutex) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+bool album_pack_present(const char *album)
+{
+    char path[320];
+    pack_path(album, path, sizeof(path));
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+esp_err_t album_pack_build(const char *album, int *packed)
+{
+    if (!album) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (packed) {
+        *packed = 0;
+    }
+
+    char dir_path[256];
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", IMAGE_DIRECTORY, album);
+
+    pack_lock();
+    esp_err_t err = album_pack_present(album) ? ESP_OK : create_locked(album);
+    DIR *dir = err == ESP_OK ? opendir(dir_path) : NULL;
+    if (err == ESP_OK && !dir) {
+        err = ESP_ERR_NOT_FOUND;
+    }
+
+    // Packing unlinks the loose files, so the names are collected before
+    // any is added rather than while readdir is still walking the directory
+    char **names = NULL;
+    int count = 0;
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (album_index_is_image_name(entry->d_name)) {
+                count++;
+            }
+        }
+        names = count > 0 ? calloc(count, sizeof(char *)) : NULL;
+        if (count > 0 && !names) {
+            err = ESP_ERR_NO_MEM;
+            count = 0;
+        }
+
+        rewinddir(dir);
+        int idx = 0;
+        while (err == ESP_OK && idx < count && (entry = readdir(dir)) != NULL) {
+            if (!album_index_is_image_name(entry->d_name)) {
+                continue;
+            }
+            names[idx] = strdup(entry->d_name);
+            if (!names[idx]) {
+                err = ESP_ERR_NO_MEM;
+            }
+            idx++;
+        }
+        count = idx;
+        closedir(dir);
+    }
+
+    for (int i = 0; i < count && err == ESP_OK; i++) {
+        esp_err_t add_err = add_locked(album, names[i]);
+        if (add_err == ESP_OK) {
+            if (packed) {
+                (*packed)++;
+            }
+        } else if (add_err == ESP_ERR_NOT_SUPPORTED) {
+            ESP_LOGW(TAG, "Leaving %s/%s unpacked", album, names[i]);
+        } else {
+            err = add_err;
+        }
+    }
+    pack_unlock();
+
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+    return err;
+}
+
+esp_err_t album_pack_add(const char *path)
+{
+    char album[128];
+    const char *name;
+    if (!album_index_split_path(path, album, sizeof(album), &name)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pack_lock();
+    esp_err_t err = add_locked(album, name);
+    pack_unlock();
+    return err;
+}
+
+esp_err_t album_pack_remove(const char *path)
+{
+    char album[128];
+    const char *name;
+    if (!album_index_split_path(path, album, sizeof(album), &name)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pack_lock();
+    pack_header_t hdr;
+    FILE *fp = pack_open(album, "r+b", &hdr);
+    if (!fp) {
+        pack_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // The last record moves into the removed one's slot
+    pack_record_t rec;
+    pack_record_t last;
+    long pos = find_record(fp, &hdr, name, false, &rec);
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    if (pos >= 0) {
+        uint32_t last_pos = hdr.count - 1;
+        bool ok = (uint32_t) pos == last_pos ||
+                  (read_record(fp, &hdr, last_pos, &last) &&
+                   write_record(fp, hdr.index_offset, (uint32_t) pos, &last));
+        if (ok) {
+            hdr.count--;
+            hdr.dead_bytes += rec.length + rec.thumb_length;
+            hdr.generation++;
+            ok = write_header(fp, &hdr);
+        }
+        err = ok ? ESP_OK : ESP_FAIL;
+    }
+    fclose(fp);
+    bool compact = err == ESP_OK && open_blobs == 0 && needs_compaction(&hdr);
+    pack_unlock();
+
+    if (compact) {
+        schedule_compaction();
+    }
+    return err;
+}
+
+esp_err_t album_pack_stat(const char *album, int *count, uint32_t *generation)
+{
+    if (!album || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pack_lock();
+    pack_header_t hdr;
+    FILE *fp = pack_open(album, "rb", &hdr);
+    if (fp) {
+        fclose(fp);
+        *count = (int) hdr.count;
+        if (generation) {
+            *generation = hdr.generation;
+        }
+    }
+    pack_unlock();
+    return fp ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t album_pack_read(const char *album, int first, album_index_entry_t *entries, int max,
+                          int *read)
+{
+    if (!album || !entries || !read || first < 0 || max < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *read = 0;
+
+    pack_lock();
+    pack_header_t hdr;
+    FILE *fp = pack_open(album, "rb", &hdr);
+    if (!fp) {
+        pack_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+    pack_record_t rec;
+    for (uint32_t i = (uint32_t) first; i < hdr.count && *read < max; i++) {
+        if (!read_record(fp, &hdr, i, &rec)) {
+            break;
+        }
+        album_index_entry_t *e = &entries[(*read)++];
+        snprintf(e->name, sizeof(e->name), "%s", rec.name);
+        e->format = (image_format_t) rec.format;
+        e->has_thumbnail = rec.thumb_length > 0;
+    }
+    fclose(fp);
+    pack_unlock();
+    return ESP_OK;
+}
+
+esp_err_t album_pack_get(const char *album, int n, char *path, size_t path_len,
+                         image_format_t *format)
+{
+    if (!album || !path || path_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pack_lock();
+    pack_header_t hdr;
+    FILE *fp = pack_open(album, "rb", &hdr);
+    if (!fp) {
+        pack_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+    pack_record_t rec;
+    esp_err_t err = ESP_ERR_INVALID_ARG;
+    if (n >= 0 && (uint32_t) n < hdr.count) {
+        err = read_record(fp, &hdr, (uint32_t) n, &rec) ? ESP_OK : ESP_FAIL;
+    }
+    fclose(fp);
+    pack_unlock();
+
+    if (err == ESP_OK) {
+        snprintf(path, path_len, "%s/%s/%s", IMAGE_DIRECTORY, album, rec.name);
+        if (format) {
+            *format = (image_format_t) rec.format;
+        }
+    }
+    return err;
+}
+
+esp_err_t album_pack_open(const char *path, album_pack_blob_t *blob)
+{
+    char album[128];
+    const char *name;
+    if (!blob || !album_index_split_path(path, album, sizeof(album), &name)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *ext = strrchr(name, '.');
+    bool thumbnail = ext && strcasecmp(ext, ".jpg") == 0;
+
+    pack_lock();
+    pack_header_t hdr;
+    FILE *fp = pack_open(album, "rb", &hdr);
+    if (!fp) {
+        pack_unlock();
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    pack_record_t rec;
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    if (find_record(fp, &hdr, name, thumbnail, &rec) >= 0 &&
+        (!thumbnail || rec.thumb_length > 0)) {
+        uint32_t offset = thumbnail ? rec.thumb_offset : rec.offset;
+        err = fseek(fp, offset, SEEK_SET) == 0 ? ESP_OK : ESP_FAIL;
+    }
+    if (err == ESP_OK) {
+        blob->fp = fp;
+        blob->length = thumbnail ? rec.thumb_length : rec.length;
+        blob->remaining = blob->length;
+        blob->format = thumbnail ? IMAGE_FORMAT_JPG : (image_format_t) rec.format;
+        open_blobs++;
+    } else {
+        fclose(fp);
+    }
+    pack_unlock();
+    return err;
+}
+
+size_t album_pack_blob_read(album_pack_blob_t *blob, void *buf, size_t len)
+{
+    if (len > blob->remaining) {
+        len = blob->remaining;
+    }
+    size_t n = len > 0 ? fread(buf, 1, len, blob->fp) : 0;
+    blob->remaining -= (uint32_t) n;
+    return n;
+}
+
+void album_pack_blob_close(album_pack_blob_t *blob)
+{
+    if (!blob->fp) {
+        return;
+    }
+    fclose(blob->fp);
+    blob->fp = NULL;
+    pack_lock();
+    open_blobs--;
+    pack_unlock();
+}
@@ -0,0 +1,95 @@
+#ifndef ALBUM_PACK_H
+#define ALBUM_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "album_index.h"
+#include "esp_err.h"
+#include "image_processor.h"
+
+// Single-file album containers. A packed album's directory holds one
+// ALBUM_PACK_FILE_NAME file instead of an image and a thumbnail per picture:
+// a header, an index of fixed-size records (name, format and the offset and
+// length of the image and thumbnail blobs) and the blobs themselves, which
+// are only ever appended. Removing an image leaves its blobs as dead space
+// until enough has accumulated to compact the pack into a fresh file, which
+// a low-priority background task does.
+//
+// Packed images keep their usual paths (IMAGE_DIRECTORY/<album>/<name>, and
+// <base>.jpg for the thumbnail); readers that find no such file open the
+// blob through album_pack_open. The album index lists a packed album's
+// packed images first, then its loose ones. Packs hold .epdgz and PNG
+// images, which the display reads as streams; BMPs stay loose.
+
+typedef struct {
+    FILE *fp;               // positioned at the blob's next byte
+    uint32_t length;        // blob size
+    uint32_t remaining;     // bytes not yet read
+    image_format_t format;  // IMAGE_FORMAT_JPG for thumbnails
+} album_pack_blob_t;
+
+esp_err_t album_pack_init(void);
+
+/**
+ * @brief Whether an album is packed
+ */
+bool album_pack_present(const char *album);
+
+/**
+ * @brief Pack an album, creating its pack if needed
+ *
+ * Moves every loose .epdgz and PNG image (with its .jpg thumbnail) into the
+ * pack. packed (may be NULL) receives the number of images moved.
+ */
+esp_err_t album_pack_build(const char *album, int *packed);
+
+/**
+ * @brief Move a loose image (and its thumbnail) into its album's pack
+ *
+ * path is IMAGE_DIRECTORY/<album>/<file>. A packed image of the same name is
+ * replaced; its thumbnail is kept when the new image has none.
+ *
+ * @return ESP_ERR_NOT_FOUND when the album is not packed;
+ *         ESP_ERR_NOT_SUPPORTED for formats packs do not hold
+ */
+esp_err_t album_pack_add(const char *path);
+
+/**
+ * @brief Remove a packed image and its thumbnail
+ */
+esp_err_t album_pack_remove(const char *path);
+
+/**
+ * @brief Number of packed images and the pack generation (may be NULL)
+ */
+esp_err_t album_pack_stat(const char *album, int *count, uint32_t *generation);
+
+/**
+ * @brief Packed image entries, as album_index_read
+ */
+esp_err_t album_pack_read(const char *album, int first, album_index_entry_t *entries, int max,
+                          int *read);
+
+/**
+ * @brief Path (and optionally format) of a packed album's nth image
+ *
+ * @return ESP_ERR_INVALID_ARG when n is out of range
+ */
+esp_err_t album_pack_get(const char *album, int n, char *path, size_t path_len,
+                         image_format_t *format);
+
+/**
+ * @brief Open a packed image or thumbnail by its path for streaming
+ *
+ * A .jpg name opens the thumbnail of the image with the same base name.
+ * The blob must be closed with album_pack_blob_close; while any blob is
+ * open the pack is not compacted.
+ */
+esp_err_t album_pack_open(const char *path, album_pack_blob_t *blob);
+size_t album_pack_blob_read(album_pack_blob_t *blob, void *buf, size_t len);
+void album_pack_blob_close(album_pack_blob_t *blob);
+
+#endif
@@ -0,0 +1,172 @@
+#include "album_transcode.h"
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "album_index.h"
+#include "album_pack.h"
+#include "board_hal.h"
+#include "config.h"
+#include "display_manager.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "album_transcode";
+
+// Pause between migration passes while work is held up (display busy, no
+// USB power)
+#define MIGRATE_RETRY_MS (30 * 1000)
+
+static bool migration_running = false;
+
+esp_err_t album_transcode_file(const char *path, char *out_path, size_t out_len)
+{
+    if (!path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *ext = strrchr(path, '.');
+    if (!ext || strchr(ext, '/') ||
+        (strcasecmp(ext, ".png") != 0 && strcasecmp(ext, ".bmp") != 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The thumbnail is keyed by base name, so the rendering takes the same
+    // base and an image re-uploaded as PNG replaces its earlier .epdgz
+    // Only loose files: a packed image has no file to replace
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char dst[512];
+    char tmp[520];
+    int base_len = (int) (ext - path);
+    if (snprintf(dst, sizeof(dst), "%.*s.epdgz", base_len, path) >= (int) sizeof(dst)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    snprintf(tmp, sizeof(tmp), "%s.tmp", dst);
+
+    esp_err_t err = display_manager_render_to_epdgz(path, tmp);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_TIMEOUT) {
+            ESP_LOGW(TAG, "Failed to render %s, keeping it", path);
+        }
+        return err;
+    }
+
+    // FAT renames do not replace an existing target
+    unlink(dst);
+    if (rename(tmp, dst) != 0) {
+        ESP_LOGE(TAG, "Failed to move rendering to %s", dst);
+        unlink(tmp);
+        return ESP_FAIL;
+    }
+    unlink(path);
+
+    album_index_note_removed(path);
+    album_index_note_added(dst);
+    ESP_LOGI(TAG, "Transcoded %s", dst);
+
+    if (out_path) {
+        snprintf(out_path, out_len, "%s", dst);
+    }
+    return ESP_OK;
+}
+
+// Convert everything one pass over the albums can; returns how many images
+// are left for a later pass
+static int migrate_pass(int *converted)
+{
+    DIR *dir = opendir(IMAGE_DIRECTORY);
+    if (!dir) {
+        return 0;
+    }
+
+    int left = 0;
+    struct dirent *entry;
+    while (left == 0 && (entry = readdir(dir)) != NULL) {
+        // Packs hold PNGs as they are
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.' ||
+            album_pack_present(entry->d_name)) {
+            continue;
+        }
+
+        // Counting first indexes an album that has no index yet
+        int count;
+        if (album_index_count(entry->d_name, &count) != ESP_OK) {
+            continue;
+        }
+
+        int pos = 0;
+        int read;
+        album_index_entry_t image;
+        while (album_index_read(entry->d_name, pos, &image, 1, &read) == ESP_OK && read == 1) {
+            if (image.format != IMAGE_FORMAT_PNG && image.format != IMAGE_FORMAT_BMP) {
+                pos++;
+                continue;
+            }
+            // Unplugged: stop converting and let the device go to sleep
+            if (!board_hal_is_usb_connected()) {
+                left++;
+                break;
+            }
+
+            // A truncated path would name some other file; leave this one be
+            char path[512];
+            int len = snprintf(path, sizeof(path), "%s/%s/%s", IMAGE_DIRECTORY, entry->d_name,
+                               image.name);
+            if (len < 0 || (size_t) len >= sizeof(path)) {
+                ESP_LOGW(TAG, "Path too long, not converting %s/%s", entry->d_name, image.name);
+                pos++;
+                continue;
+            }
+            esp_err_t err = album_transcode_file(path, NULL, 0);
+            if (err == ESP_OK) {
+                // The album's last record has moved into this slot
+                (*converted)++;
+                continue;
+            }
+            if (err == ESP_ERR_TIMEOUT) {
+                left++;
+            }
+            pos++;
+        }
+    }
+    closedir(dir);
+    return left;
+}
+
+static void migrate_task(void *arg)
+{
+    (void) arg;
+    int converted = 0;
+    while (!board_hal_is_usb_connected() || migrate_pass(&converted) > 0) {
+        vTaskDelay(pdMS_TO_TICKS(MIGRATE_RETRY_MS));
+    }
+    ESP_LOGI(TAG, "Album migration done, %d image(s) converted", converted);
+
+    migration_running = false;
+    vTaskDelete(NULL);
+}
+
+void album_transcode_start_migration(void)
+{
+#if CONFIG_ALBUM_TRANSCODE_MIGRATE
+    if (migration_running) {
+        return;
+    }
+    migration_running = true;
+    // Decoding a PNG runs on this task's stack
+    if (xTaskCreate(migrate_task, "album_migrate", 8192, NULL, tskIDLE_PRIORITY + 1, NULL) !=
+        pdPASS) {
+        ESP_LOGW(TAG, "Failed to start album migration");
+        migration_running = false;
+    }
+#endif
+}
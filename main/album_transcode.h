@@ -0,0 +1,33 @@
+#ifndef ALBUM_TRANSCODE_H
+#define ALBUM_TRANSCODE_H
+
+#include <stddef.h>
+
+#include "esp_err.h"
+
+// Album images stored once in the panel-native packed .epdgz format, so a
+// rotation is a bounded inflate into the frame buffer instead of a PNG/BMP
+// decode with per-pixel color mapping. The .jpg thumbnail next to an image
+// shares its base name and is kept as is.
+
+/**
+ * @brief Replace an album PNG or BMP with a same-named .epdgz rendering
+ *
+ * On success the original is removed, the album index updated and the new
+ * path written to out_path (may be NULL). On failure the original is left in
+ * place; ESP_ERR_TIMEOUT means the display was busy and a retry may succeed.
+ * Only loose files are transcoded (ESP_ERR_NOT_FOUND otherwise, e.g. for
+ * packed images).
+ */
+esp_err_t album_transcode_file(const char *path, char *out_path, size_t out_len);
+
+/**
+ * @brief Start converting the albums' remaining PNGs and BMPs in the background
+ *
+ * A low-priority task converts one image at a time while USB power is
+ * connected and exits once nothing is left. Does nothing unless
+ * CONFIG_ALBUM_TRANSCODE_MIGRATE is set, or when a migration is running.
+ */
+void album_transcode_start_migration(void);
+
+#endif
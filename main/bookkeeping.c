@@ -0,0 +1,235 @@
+#include "bookkeeping.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "bookkeeping";
+
+#define BOOKKEEPING_MAGIC 0x324B4B42  // "BKK2"; bump when the record layout changes
+
+#define DIRTY_LAST_INDEX (1 << 0)
+#define DIRTY_SHUFFLE_BAG (1 << 1)
+#define DIRTY_LAST_IMAGE (1 << 2)
+#define DIRTY_IMAGE_ETAG (1 << 3)
+
+#if CONFIG_BOOKKEEPING_IN_RTC
+#define FLUSH_CYCLES CONFIG_BOOKKEEPING_FLUSH_WAKES
+#define LOW_BATTERY_PERCENT CONFIG_BOOKKEEPING_LOW_BATTERY_PERCENT
+// Not zeroed at boot: the checksum tells a record kept over deep sleep or a
+// reset from power-on garbage
+RTC_NOINIT_ATTR static bookkeeping_record_t record;
+#else
+#define FLUSH_CYCLES 0  // write through
+#define LOW_BATTERY_PERCENT 0
+static bookkeeping_record_t record;
+#endif
+
+// FNV-1a over the record up to the checksum
+static uint32_t record_checksum(const bookkeeping_record_t *rec)
+{
+    const uint8_t *bytes = (const uint8_t *) rec;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(bookkeeping_record_t, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void bookkeeping_record_seal(bookkeeping_record_t *rec)
+{
+    rec->magic = BOOKKEEPING_MAGIC;
+    rec->checksum = record_checksum(rec);
+}
+
+bool bookkeeping_record_valid(const bookkeeping_record_t *rec)
+{
+    return rec->magic == BOOKKEEPING_MAGIC && rec->checksum == record_checksum(rec) &&
+           memchr(rec->last_image, '\0', sizeof(rec->last_image)) != NULL &&
+           memchr(rec->image_etag, '\0', sizeof(rec->image_etag)) != NULL;
+}
+
+static void load_from_nvs(void)
+{
+    memset(&record, 0, sizeof(record));
+    record.last_index = -1;
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+
+    nvs_get_i32(nvs_handle, NVS_LAST_INDEX_KEY, &record.last_index);
+
+    size_t bag_len = sizeof(record.shuffle_bag);
+    if (nvs_get_blob(nvs_handle, NVS_SHUFFLE_BAG_KEY, &record.shuffle_bag, &bag_len) != ESP_OK ||
+        bag_len != sizeof(record.shuffle_bag)) {
+        memset(&record.shuffle_bag, 0, sizeof(record.shuffle_bag));
+    }
+
+    size_t len = sizeof(record.last_image);
+    if (nvs_get_str(nvs_handle, NVS_LAST_IMAGE_KEY, record.last_image, &len) != ESP_OK) {
+        record.last_image[0] = '\0';
+    }
+
+    len = sizeof(record.image_etag);
+    if (nvs_get_str(nvs_handle, NVS_IMAGE_ETAG_KEY, record.image_etag, &len) != ESP_OK) {
+        record.image_etag[0] = '\0';
+    }
+
+    nvs_close(nvs_handle);
+}
+
+esp_err_t bookkeeping_init(void)
+{
+    if (bookkeeping_record_valid(&record)) {
+        ESP_LOGI(TAG, "Restored from RTC memory (%lu cycles, fields 0x%lx unflushed)",
+                 (unsigned long) record.cycles, (unsigned long) record.dirty);
+        return ESP_OK;
+    }
+
+    load_from_nvs();
+    bookkeeping_record_seal(&record);
+    ESP_LOGI(TAG, "Loaded from NVS (last index %ld, last image '%s')", (long) record.last_index,
+             record.last_image);
+    return ESP_OK;
+}
+
+static void mark_dirty(uint32_t field)
+{
+    record.dirty |= field;
+    bookkeeping_record_seal(&record);
+    if (FLUSH_CYCLES == 0) {
+        bookkeeping_flush();
+    }
+}
+
+int32_t bookkeeping_get_last_index(void)
+{
+    return record.last_index;
+}
+
+void bookkeeping_set_last_index(int32_t index)
+{
+    if (record.last_index == index) {
+        return;
+    }
+    record.last_index = index;
+    mark_dirty(DIRTY_LAST_INDEX);
+}
+
+void bookkeeping_get_shuffle_bag(shuffle_bag_t *bag)
+{
+    *bag = record.shuffle_bag;
+}
+
+void bookkeeping_set_shuffle_bag(const shuffle_bag_t *bag)
+{
+    if (memcmp(&record.shuffle_bag, bag, sizeof(*bag)) == 0) {
+        return;
+    }
+    record.shuffle_bag = *bag;
+    mark_dirty(DIRTY_SHUFFLE_BAG);
+}
+
+const char *bookkeeping_get_last_image(void)
+{
+    return record.last_image;
+}
+
+void bookkeeping_set_last_image(const char *path)
+{
+    if (strncmp(record.last_image, path, sizeof(record.last_image) - 1) == 0) {
+        return;
+    }
+    strncpy(record.last_image, path, sizeof(record.last_image) - 1);
+    record.last_image[sizeof(record.last_image) - 1] = '\0';
+    mark_dirty(DIRTY_LAST_IMAGE);
+}
+
+const char *bookkeeping_get_image_etag(void)
+{
+    return record.image_etag;
+}
+
+void bookkeeping_set_image_etag(const char *etag)
+{
+    if (strncmp(record.image_etag, etag, sizeof(record.image_etag) - 1) == 0) {
+        return;
+    }
+    strncpy(record.image_etag, etag, sizeof(record.image_etag) - 1);
+    record.image_etag[sizeof(record.image_etag) - 1] = '\0';
+    mark_dirty(DIRTY_IMAGE_ETAG);
+}
+
+esp_err_t bookkeeping_flush(void)
+{
+    if (record.dirty == 0) {
+        record.cycles = 0;
+        bookkeeping_record_seal(&record);
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    if (record.dirty & DIRTY_LAST_INDEX) {
+        err = nvs_set_i32(nvs_handle, NVS_LAST_INDEX_KEY, record.last_index);
+    }
+    if (err == ESP_OK && (record.dirty & DIRTY_SHUFFLE_BAG)) {
+        err = nvs_set_blob(nvs_handle, NVS_SHUFFLE_BAG_KEY, &record.shuffle_bag,
+                           sizeof(record.shuffle_bag));
+    }
+    if (err == ESP_OK && (record.dirty & DIRTY_LAST_IMAGE)) {
+        err = nvs_set_str(nvs_handle, NVS_LAST_IMAGE_KEY, record.last_image);
+    }
+    if (err == ESP_OK && (record.dirty & DIRTY_IMAGE_ETAG)) {
+        if (record.image_etag[0] != '\0') {
+            err = nvs_set_str(nvs_handle, NVS_IMAGE_ETAG_KEY, record.image_etag);
+        } else {
+            err = nvs_erase_key(nvs_handle, NVS_IMAGE_ETAG_KEY);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        }
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to flush to NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Flushed fields 0x%lx to NVS after %lu cycles", (unsigned long) record.dirty,
+             (unsigned long) record.cycles);
+    record.dirty = 0;
+    record.cycles = 0;
+    bookkeeping_record_seal(&record);
+    return ESP_OK;
+}
+
+void bookkeeping_cycle_done(int battery_percent)
+{
+    record.cycles++;
+    bookkeeping_record_seal(&record);
+
+    bool low_battery = battery_percent >= 0 && battery_percent <= LOW_BATTERY_PERCENT;
+    if (record.dirty != 0 && (record.cycles >= FLUSH_CYCLES || low_battery)) {
+        bookkeeping_flush();
+    }
+}
+
+void bookkeeping_invalidate(void)
+{
+    memset(&record, 0, sizeof(record));
+}
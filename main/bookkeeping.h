@@ -0,0 +1,97 @@
+#ifndef BOOKKEEPING_H
+#define BOOKKEEPING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "esp_err.h"
+#include "shuffle_bag.h"
+
+// Per-rotation bookkeeping cached in RTC memory
+//
+// Every rotation moves the rotation position (last index or shuffle bag) and
+// the last displayed image, and every URL download can change the ETag.
+// Writing each straight to NVS costs an nvs_commit per rotation: thousands a
+// month on a frame rotating every few minutes, plus the commit latency on
+// every wake. These values live in a record in RTC slow memory instead, which
+// survives deep sleep and software resets, and go back to NVS in a single
+// commit only when
+//  - the configuration changes (config_manager_touch_config),
+//  - the battery is low, as a brownout would lose RTC memory, or
+//  - CONFIG_BOOKKEEPING_FLUSH_WAKES sleep cycles have passed since the last
+//    flush.
+//
+// The record carries a magic and a checksum. After a power-on, when RTC
+// memory holds garbage, it is rebuilt from NVS, so a power loss only forgets
+// the rotations since the last flush.
+
+#define BOOKKEEPING_IMAGE_PATH_MAX 256
+
+typedef struct {
+    uint32_t magic;
+    uint32_t dirty;   // fields not yet written back to NVS
+    uint32_t cycles;  // sleep cycles since the last flush
+    int32_t last_index;
+    shuffle_bag_t shuffle_bag;
+    char last_image[BOOKKEEPING_IMAGE_PATH_MAX];
+    char image_etag[HTTP_ETAG_MAX_LEN];
+    uint32_t checksum;  // over everything above
+} bookkeeping_record_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Restore the record from RTC memory, or load it from NVS
+ *
+ * Call once NVS is initialized, before any getter.
+ */
+esp_err_t bookkeeping_init(void);
+
+int32_t bookkeeping_get_last_index(void);
+void bookkeeping_set_last_index(int32_t index);
+
+void bookkeeping_get_shuffle_bag(shuffle_bag_t *bag);
+void bookkeeping_set_shuffle_bag(const shuffle_bag_t *bag);
+
+// Path of the last displayed image, "" for none
+const char *bookkeeping_get_last_image(void);
+void bookkeeping_set_last_image(const char *path);
+
+// ETag of the last downloaded image, "" for none
+const char *bookkeeping_get_image_etag(void);
+void bookkeeping_set_image_etag(const char *etag);
+
+/**
+ * @brief Write changed fields back to NVS in one commit
+ */
+esp_err_t bookkeeping_flush(void);
+
+/**
+ * @brief Count a sleep cycle and flush if one is due
+ *
+ * Called before deep sleep, and after each timed rotation while the device
+ * stays awake.
+ *
+ * @param battery_percent Battery level, or -1 when unknown
+ */
+void bookkeeping_cycle_done(int battery_percent);
+
+/**
+ * @brief Drop the RTC record, e.g. before NVS is erased
+ *
+ * The next boot then loads from NVS instead of restoring stale values.
+ */
+void bookkeeping_invalidate(void);
+
+// Record checksum helpers, exposed for tests
+void bookkeeping_record_seal(bookkeeping_record_t *record);
+bool bookkeeping_record_valid(const bookkeeping_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
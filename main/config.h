@@ -8,7 +8,11 @@
 
 typedef enum { ROTATION_MODE_STORAGE = 0, ROTATION_MODE_URL = 1 } rotation_mode_t;
 
-typedef enum { SD_ROTATION_RANDOM = 0, SD_ROTATION_SEQUENTIAL = 1 } sd_rotation_mode_t;
+typedef enum {
+    SD_ROTATION_RANDOM = 0,
+    SD_ROTATION_SEQUENTIAL = 1,
+    SD_ROTATION_SHUFFLE = 2  // every image once per round (shuffle_bag.h)
+} sd_rotation_mode_t;
 
 typedef enum {
     DISPLAY_ORIENTATION_LANDSCAPE = 0,
@@ -54,14 +58,33 @@ typedef enum { IP_MODE_DHCP = 0, IP_MODE_STATIC = 1 } ip_mode_t;
 
 #define IMAGE_DIRECTORY FS_MOUNT_POINT "/images"
 #define DOWNLOAD_DIRECTORY IMAGE_DIRECTORY "/Downloads"
+// Per-album image indexes (album_index.c); kept outside the album
+// directories so rewriting an index leaves their mtimes alone
+#define ALBUM_INDEX_DIRECTORY FS_MOUNT_POINT "/.album_index"
+// Packed albums keep every image and thumbnail in this one file inside the
+// album directory (album_pack.c)
+#define ALBUM_PACK_FILE_NAME "album.pack"
+
+// Transient display files (downloads, direct uploads, the .current.*
+// scheme and the current-image link). With CONFIG_STAGING_IN_RAM they live
+// in a PSRAM MemFS of their own, so displaying an image writes no flash and
+// only album data touches FS_MOUNT_POINT.
+#ifndef STAGING_MOUNT_POINT
+#if CONFIG_STAGING_IN_RAM
+#define STAGING_MOUNT_POINT "/staging"
+#else
+#define STAGING_MOUNT_POINT FS_MOUNT_POINT
+#endif
+#endif
+#define STAGING_MAX_FILES 12
 
-#define CURRENT_UPLOAD_PATH FS_MOUNT_POINT "/.current.tmp"
-#define CURRENT_JPG_PATH FS_MOUNT_POINT "/.current.jpg"
-#define CURRENT_BMP_PATH FS_MOUNT_POINT "/.current.bmp"
-#define CURRENT_PNG_PATH FS_MOUNT_POINT "/.current.png"
-#define CURRENT_EPD_PATH FS_MOUNT_POINT "/.current.epdgz"
-#define CURRENT_IMAGE_LINK FS_MOUNT_POINT "/.current.lnk"
-#define CURRENT_CALIBRATION_PATH FS_MOUNT_POINT "/.calibration.png"
+#define CURRENT_UPLOAD_PATH STAGING_MOUNT_POINT "/.current.tmp"
+#define CURRENT_JPG_PATH STAGING_MOUNT_POINT "/.current.jpg"
+#define CURRENT_BMP_PATH STAGING_MOUNT_POINT "/.current.bmp"
+#define CURRENT_PNG_PATH STAGING_MOUNT_POINT "/.current.png"
+#define CURRENT_EPD_PATH STAGING_MOUNT_POINT "/.current.epdgz"
+#define CURRENT_IMAGE_LINK STAGING_MOUNT_POINT "/.current.lnk"
+#define CURRENT_CALIBRATION_PATH STAGING_MOUNT_POINT "/.calibration.png"
 
 #ifdef DEBUG_DEEP_SLEEP_WAKE
 #define AUTO_SLEEP_TIMEOUT_SEC 60
@@ -132,6 +155,8 @@ typedef enum { IP_MODE_DHCP = 0, IP_MODE_STATIC = 1 } ip_mode_t;
 // Auto Rotate - SDCard
 #define NVS_SD_ROTATION_MODE_KEY "sd_rot_mode"
 #define NVS_LAST_INDEX_KEY "last_idx"
+#define NVS_SHUFFLE_BAG_KEY "shuffle_bag"
+#define NVS_LAST_IMAGE_KEY "last_image"
 #define NVS_ENABLED_ALBUMS_KEY "enabled_albums"
 
 // Auto Rotate - URL
@@ -5,6 +5,7 @@
 #include <time.h>
 
 #include "board_hal.h"
+#include "bookkeeping.h"
 #include "config.h"
 #include "esp_log.h"
 #include "nvs.h"
@@ -39,7 +40,6 @@ static rotation_mode_t rotation_mode =
 
 // Auto Rotate - SDCARD
 static sd_rotation_mode_t sd_rotation_mode = SD_ROTATION_RANDOM;
-static int32_t last_index = -1;
 
 // Auto Rotate - URL
 static char image_url[IMAGE_URL_MAX_LEN] = {0};
@@ -49,7 +49,6 @@ static char access_token[ACCESS_TOKEN_MAX_LEN] = {0};
 static char http_header_key[HTTP_HEADER_KEY_MAX_LEN] = {0};
 static char http_header_value[HTTP_HEADER_VALUE_MAX_LEN] = {0};
 static bool save_downloaded_images = false;
-static char image_etag[HTTP_ETAG_MAX_LEN] = {0};
 
 // Home Assistant
 static char ha_url[HA_URL_MAX_LEN] = {0};
@@ -147,6 +146,8 @@ esp_err_t config_manager_init(void)
 {
     ESP_LOGI(TAG, "Initializing config manager");
 
+    bookkeeping_init();
+
     // Rotation-schedule load is resolved after the read-only NVS handle closes
     // (migration / default seeding may need a read-write handle).
     char cron_buf[MAX_CRON_RULES * CRON_RULE_MAX_LEN] = {0};
@@ -283,13 +284,7 @@ esp_err_t config_manager_init(void)
         if (nvs_get_u8(nvs_handle, NVS_SD_ROTATION_MODE_KEY, &stored_sd_mode) == ESP_OK) {
             sd_rotation_mode = (sd_rotation_mode_t) stored_sd_mode;
             ESP_LOGI(TAG, "Loaded SD rotation mode from NVS: %s",
-                     sd_rotation_mode == SD_ROTATION_SEQUENTIAL ? "sequential" : "random");
-        }
-
-        int32_t stored_last_index = -1;
-        if (nvs_get_i32(nvs_handle, NVS_LAST_INDEX_KEY, &stored_last_index) == ESP_OK) {
-            last_index = stored_last_index;
-            ESP_LOGI(TAG, "Loaded last index from NVS: %ld", (long) last_index);
+                     config_manager_sd_rotation_mode_name(sd_rotation_mode));
         }
 
         // Auto Rotate - URL
@@ -342,11 +337,6 @@ esp_err_t config_manager_init(void)
                      save_downloaded_images ? "yes" : "no");
         }
 
-        size_t etag_len = HTTP_ETAG_MAX_LEN;
-        if (nvs_get_str(nvs_handle, NVS_IMAGE_ETAG_KEY, image_etag, &etag_len) == ESP_OK) {
-            ESP_LOGI(TAG, "Loaded image ETag from NVS (length: %zu)", etag_len);
-        }
-
         // Home Assistant
         size_t ha_url_len = HA_URL_MAX_LEN;
         if (nvs_get_str(nvs_handle, NVS_HA_URL_KEY, ha_url, &ha_url_len) == ESP_OK) {
@@ -816,8 +806,7 @@ void config_manager_set_sd_rotation_mode(sd_rotation_mode_t mode)
         nvs_close(nvs_handle);
     }
 
-    ESP_LOGI(TAG, "SD rotation mode set to: %s",
-             mode == SD_ROTATION_SEQUENTIAL ? "sequential" : "random");
+    ESP_LOGI(TAG, "SD rotation mode set to: %s", config_manager_sd_rotation_mode_name(mode));
 }
 
 sd_rotation_mode_t config_manager_get_sd_rotation_mode(void)
@@ -825,21 +814,49 @@ sd_rotation_mode_t config_manager_get_sd_rotation_mode(void)
     return sd_rotation_mode;
 }
 
-void config_manager_set_last_index(int32_t index)
+const char *config_manager_sd_rotation_mode_name(sd_rotation_mode_t mode)
 {
-    last_index = index;
+    switch (mode) {
+    case SD_ROTATION_SEQUENTIAL:
+        return "sequential";
+    case SD_ROTATION_SHUFFLE:
+        return "shuffle";
+    default:
+        return "random";
+    }
+}
 
-    nvs_handle_t nvs_handle;
-    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
-        nvs_set_i32(nvs_handle, NVS_LAST_INDEX_KEY, index);
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
+sd_rotation_mode_t config_manager_parse_sd_rotation_mode(const char *name)
+{
+    if (strcmp(name, "sequential") == 0) {
+        return SD_ROTATION_SEQUENTIAL;
     }
+    if (strcmp(name, "shuffle") == 0) {
+        return SD_ROTATION_SHUFFLE;
+    }
+    return SD_ROTATION_RANDOM;
+}
+
+// The rotation position changes on every rotation, so it lives in the
+// RTC-backed bookkeeping record rather than going straight to NVS
+void config_manager_set_last_index(int32_t index)
+{
+    bookkeeping_set_last_index(index);
 }
 
 int32_t config_manager_get_last_index(void)
 {
-    return last_index;
+    return bookkeeping_get_last_index();
+}
+
+void config_manager_set_shuffle_bag(const shuffle_bag_t *bag)
+{
+    bookkeeping_set_shuffle_bag(bag);
+}
+
+void config_manager_get_shuffle_bag(shuffle_bag_t *bag)
+{
+    bookkeeping_get_shuffle_bag(bag);
 }
 
 // ============================================================================
@@ -1003,32 +1020,14 @@ bool config_manager_get_save_downloaded_images(void)
 
 void config_manager_set_image_etag(const char *etag)
 {
-    const char *new_etag = etag ? etag : "";
-
-    // No-op if value unchanged — avoids NVS wear when the server does not send
-    // an ETag (empty stays empty across every 200) or repeats the same ETag.
-    if (strncmp(image_etag, new_etag, HTTP_ETAG_MAX_LEN) == 0) {
-        return;
-    }
-
-    strncpy(image_etag, new_etag, HTTP_ETAG_MAX_LEN - 1);
-    image_etag[HTTP_ETAG_MAX_LEN - 1] = '\0';
-
-    nvs_handle_t nvs_handle;
-    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
-        if (image_etag[0] != '\0') {
-            nvs_set_str(nvs_handle, NVS_IMAGE_ETAG_KEY, image_etag);
-        } else {
-            nvs_erase_key(nvs_handle, NVS_IMAGE_ETAG_KEY);
-        }
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-    }
+    // Unchanged values are a no-op; new ones are batched with the rest of the
+    // per-rotation bookkeeping
+    bookkeeping_set_image_etag(etag ? etag : "");
 }
 
 const char *config_manager_get_image_etag(void)
 {
-    return image_etag;
+    return bookkeeping_get_image_etag();
 }
 // ============================================================================
 // Home Assistant
@@ -1174,4 +1173,8 @@ void config_manager_touch_config(void)
     time_t now;
     time(&now);
     config_manager_set_config_last_updated((int64_t) now);
+
+    // A config change is already a flash commit; write the pending
+    // bookkeeping along with it
+    bookkeeping_flush();
 }
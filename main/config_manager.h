@@ -8,6 +8,7 @@
 #include "config.h"
 #include "cron.h"
 #include "esp_err.h"
+#include "shuffle_bag.h"
 
 esp_err_t config_manager_init(void);
 
@@ -81,9 +82,17 @@ rotation_mode_t config_manager_get_rotation_mode(void);
 void config_manager_set_sd_rotation_mode(sd_rotation_mode_t mode);
 sd_rotation_mode_t config_manager_get_sd_rotation_mode(void);
 
+const char *config_manager_sd_rotation_mode_name(sd_rotation_mode_t mode);
+// Unknown names map to SD_ROTATION_RANDOM
+sd_rotation_mode_t config_manager_parse_sd_rotation_mode(const char *name);
+
 void config_manager_set_last_index(int32_t index);
 int32_t config_manager_get_last_index(void);
 
+// Shuffle-mode round in progress (all zero when none)
+void config_manager_set_shuffle_bag(const shuffle_bag_t *bag);
+void config_manager_get_shuffle_bag(shuffle_bag_t *bag);
+
 // ============================================================================
 // Auto Rotate - URL
 // ============================================================================
@@ -1,5 +1,6 @@
 #include "display_flow.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <strings.h>
@@ -13,6 +14,8 @@
 
 static const char *TAG = "display_flow";
 
+#define MOVE_CHUNK 4096
+
 esp_err_t display_flow_read_file(const char *path, uint8_t **out_buf, size_t *out_size)
 {
     FILE *fp = fopen(path, "rb");
@@ -53,22 +56,30 @@ esp_err_t display_flow_stream_file(const char *path, image_format_t format,
 {
     if (format == IMAGE_FORMAT_PNG) {
         // File-backed fused path: no RAM copy of the source
-        return image_processor_process_or_display_png(path, algorithm, pub, release_source);
+        return image_processor_process_or_display_png(path, algorithm, pub);
     }
 
-    uint8_t *buf = NULL;
-    size_t size = 0;
-    esp_err_t err = display_flow_read_file(path, &buf, &size);
+    // The JPEG decoder needs the source contiguous: in place for a RAM file
+    // that fits one extent, otherwise a PSRAM copy
+    byte_source_t src;
+    esp_err_t err = byte_source_open_file(&src, path);
+    if (err != ESP_OK) {
+        return err;
+    }
+    const uint8_t *data;
+    size_t size;
+    err = byte_source_map(&src, &data, &size);
     if (err != ESP_OK) {
+        byte_source_close(&src);
         return err;
     }
-    if (release_source) {
+    if (release_source && src.copy) {
         // MemFS-backed source lives in PSRAM; drop the file now that the
         // compressed copy exists
         unlink(path);
     }
-    err = image_processor_process_to_display(buf, size, format, algorithm, pub);
-    heap_caps_free(buf);
+    err = image_processor_process_source_to_display(&src, format, algorithm, pub);
+    byte_source_close(&src);
     return err;
 }
 
@@ -84,10 +95,48 @@ const char *display_flow_stage_file(const char *source_path, image_format_t form
     return slot;
 }
 
+esp_err_t display_flow_move_file(const char *source_path, const char *dest_path)
+{
+    if (rename(source_path, dest_path) == 0) {
+        return ESP_OK;
+    }
+    if (errno != EXDEV) {
+        return ESP_FAIL;
+    }
+
+    // Staging and albums are separate mounts: copy, then drop the source
+    FILE *in = fopen(source_path, "rb");
+    FILE *out = in ? fopen(dest_path, "wb") : NULL;
+    uint8_t *buf = heap_caps_malloc(MOVE_CHUNK, MALLOC_CAP_SPIRAM);
+    bool ok = in && out && buf;
+    size_t n;
+    while (ok && (n = fread(buf, 1, MOVE_CHUNK, in)) > 0) {
+        ok = fwrite(buf, 1, n, out) == n;
+    }
+    ok = ok && !ferror(in);
+    heap_caps_free(buf);
+    if (in) {
+        fclose(in);
+    }
+    // Buffered writes can surface a full-disk error only at close
+    if (out && fclose(out) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to copy %s to %s", source_path, dest_path);
+        if (out) {
+            unlink(dest_path);
+        }
+        return ESP_FAIL;
+    }
+    unlink(source_path);
+    return ESP_OK;
+}
+
 void display_flow_retire_source(const char *source_path, image_format_t format,
                                 bool fresh_thumbnail)
 {
-    if (storage_has_persistent_storage()) {
+    if (storage_staging_is_persistent()) {
         if (format == IMAGE_FORMAT_JPG) {
             unlink(CURRENT_PNG_PATH);
             if (fresh_thumbnail) {
@@ -115,7 +164,7 @@ void display_flow_retire_source(const char *source_path, image_format_t format,
             }
         }
     } else {
-        // MemFS-backed /storage retains nothing full-size
+        // RAM-backed staging retains nothing full-size
         if (source_path) {
             unlink(source_path);
         }
@@ -130,7 +179,7 @@ void display_flow_retire_source(const char *source_path, image_format_t format,
 
 void display_flow_drop_stale_current(const char *keep_path, bool keep_thumbnail)
 {
-    bool keep = storage_has_persistent_storage() && keep_path != NULL;
+    bool keep = storage_staging_is_persistent() && keep_path != NULL;
     if (!keep || strcmp(keep_path, CURRENT_PNG_PATH) != 0) {
         unlink(CURRENT_PNG_PATH);
     }
@@ -145,6 +194,13 @@ void display_flow_drop_stale_current(const char *keep_path, bool keep_thumbnail)
     }
 }
 
+void display_flow_keep_frame_snapshot(void)
+{
+    unlink(CURRENT_PNG_PATH);
+    unlink(CURRENT_BMP_PATH);
+    unlink(CURRENT_JPG_PATH);
+}
+
 FILE *display_flow_open_current(const char **out_content_type)
 {
     char displayed[512] = {0};
@@ -16,7 +16,8 @@
 //     a failure never breaks /api/current_image
 //   - the device cannot encode JPEG, so the displayed ORIGINAL is what gets
 //     retired into the .current.* slot for its format and served back
-//   - MemFS-backed /storage retains nothing full-size: the panel keeps the
+//   - RAM-backed staging (a MemFS /storage, or the staging MemFS of
+//     CONFIG_STAGING_IN_RAM) retains nothing full-size: the panel keeps the
 //     image without power, and the file would occupy the PSRAM the next
 //     upload needs
 
@@ -29,10 +30,11 @@ esp_err_t display_flow_read_file(const char *path, uint8_t **out_buf, size_t *ou
  * @brief Stream a PNG/JPG source file to the display
  *
  * PNG uses the fused validate-or-process single-decode path straight from
- * the file; JPG is read into PSRAM and processed from there. With
- * release_source set (MemFS-backed sources), the file is unlinked as soon
- * as an in-RAM copy exists. The source file is not otherwise disposed of --
- * on success the caller retires it (see display_flow_retire_source).
+ * the file; JPG is mapped (see byte_source_map) and processed from there.
+ * With release_source set (MemFS-backed sources), the file is unlinked as
+ * soon as an in-RAM copy exists; a source read in place is kept until the
+ * caller retires it. The source file is not otherwise disposed of -- on
+ * success the caller retires it (see display_flow_retire_source).
  *
  * @return ESP_OK, ESP_ERR_NOT_FINISHED (displayed but the pub->save_path
  *         snapshot failed), or an error
@@ -49,6 +51,15 @@ esp_err_t display_flow_stream_file(const char *path, image_format_t format,
  */
 const char *display_flow_stage_file(const char *source_path, image_format_t format);
 
+/**
+ * @brief Move a file, copying when source and destination are on different
+ *        mounts (staging files into or out of an album)
+ *
+ * Like rename, an existing destination may or may not be replaced; unlink
+ * it first. The source is gone on success and kept on failure.
+ */
+esp_err_t display_flow_move_file(const char *source_path, const char *dest_path);
+
 /**
  * @brief Retire a displayed original into the .current.* scheme
  *
@@ -56,7 +67,7 @@ const char *display_flow_stage_file(const char *source_path, image_format_t form
  * .current.jpg thumbnail (unless a fresh thumbnail for this image already
  * claims that slot); a PNG original is kept full-size as .current.png for
  * the thumbnail fallback. Stale siblings from earlier displays are dropped.
- * On MemFS nothing is retained. source_path may be NULL when the source was
+ * With staging in RAM nothing full-size is retained. source_path may be NULL when the source was
  * already consumed.
  *
  * @param fresh_thumbnail a thumbnail belonging to THIS image occupies (or is
@@ -84,9 +95,18 @@ FILE *display_flow_open_current(const char **out_content_type);
  * @brief Drop stale .current.* image files after a successful file display
  *
  * Unlinks .current.{png,bmp,epdgz} except keep_path (NULL keeps none), and
- * the .current.jpg thumbnail unless keep_thumbnail. On MemFS nothing is kept
- * regardless of keep_path.
+ * the .current.jpg thumbnail unless keep_thumbnail. With staging in RAM no
+ * image file is kept regardless of keep_path.
  */
 void display_flow_drop_stale_current(const char *keep_path, bool keep_thumbnail);
 
+/**
+ * @brief Drop the .current.* files a patched frame has replaced
+ *
+ * Unlinks .current.{png,bmp,jpg} but keeps the .current.epdgz snapshot of
+ * the patched frame, even with staging in RAM: it is panel-sized and the
+ * current-image link names it.
+ */
+void display_flow_keep_frame_snapshot(void);
+
 #endif
@@ -1,6 +1,5 @@
 #include "display_manager.h"
 
-#include <dirent.h>
 #include <string.h>
 #include <strings.h>
 #include <sys/stat.h>
@@ -9,11 +8,15 @@
 #include "GUI_BMPfile.h"
 #include "GUI_ColorMap.h"
 #include "GUI_EPDGZfile.h"
+#include "GUI_FramePNG.h"
 #include "GUI_PNGfile.h"
 #include "GUI_Paint.h"
 #include "GUI_RawBuffer.h"
+#include "album_index.h"
 #include "album_manager.h"
+#include "album_pack.h"
 #include "board_hal.h"
+#include "bookkeeping.h"
 #include "config.h"
 #include "config_manager.h"
 #include "epaper.h"
@@ -21,20 +24,25 @@
 #include "esp_log.h"
 #include "esp_random.h"
 #include "esp_system.h"
+#include "esp_timer.h"
+#include "frame_store.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "freertos/semphr.h"
-#include "nvs.h"
+#include "freertos/task.h"
+#include "shuffle_bag.h"
 #include "storage.h"
 #include "utils.h"
 #include "zlib.h"
 
 static const char *TAG = "display_manager";
-#define NVS_LAST_IMAGE_KEY "last_image"
 
 // Display operations (streamed processing plus the panel refresh) can
 // legitimately hold the display mutex for a minute or more; waiters queue
 // for a matching window instead of failing spuriously.
 #define DISPLAY_LOCK_TIMEOUT_MS (120 * 1000)
+// Frame reads only wait briefly; a display in progress makes them fail fast
+#define DISPLAY_READ_TIMEOUT_MS 2000
 
 // Grayscale (gc*) panels take linear-intensity nibbles (0=black..15=white)
 // rather than Spectra ink-color indices, so both the decode mapping and the
@@ -51,46 +59,65 @@ static UWORD display_white_color(void)
 
 static SemaphoreHandle_t display_mutex = NULL;
 static char current_image[64] = {0};
-static char last_displayed_image[256] = {0};  // Internal state: last displayed image path
+// Internal state: last displayed image path
+static char last_displayed_image[BOOKKEEPING_IMAGE_PATH_MAX] = {0};
 
-static uint8_t *epd_image_buffer = NULL;
+static uint8_t *epd_image_buffer = NULL;  // Paint target
 static uint32_t image_buffer_size;
-
-// Load last displayed image from NVS
+// The buffer holding the frame the panel shows, or NULL once that frame has
+// been drawn over (or was never drawn, e.g. after a wake) -- region patches
+// start from it
+static uint8_t *shown_frame = NULL;
+// Bumped whenever the panel is handed a new frame; starts at a random value
+// so generations from different boots don't collide
+static uint32_t display_generation;
+
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+// Double buffering: a committed frame is refreshed by a background task
+// while the next one is drawn into the other buffer. At most one refresh is
+// in flight; panel_idle is held while it runs, and panel_frame is the buffer
+// it reads (only touched under the display mutex).
+static uint8_t *epd_spare_buffer = NULL;
+static SemaphoreHandle_t panel_idle = NULL;
+static uint8_t *panel_frame = NULL;
+#endif
+
+// Load last displayed image from the bookkeeping record
 static void load_last_displayed_image(void)
 {
-    nvs_handle_t nvs_handle;
-    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
-        size_t len = sizeof(last_displayed_image);
-        if (nvs_get_str(nvs_handle, NVS_LAST_IMAGE_KEY, last_displayed_image, &len) == ESP_OK) {
-            ESP_LOGI(TAG, "Loaded last displayed image: %s", last_displayed_image);
-        } else {
-            last_displayed_image[0] = '\0';
-        }
-        nvs_close(nvs_handle);
+    strncpy(last_displayed_image, bookkeeping_get_last_image(), sizeof(last_displayed_image) - 1);
+    last_displayed_image[sizeof(last_displayed_image) - 1] = '\0';
+    if (last_displayed_image[0] != '\0') {
+        ESP_LOGI(TAG, "Loaded last displayed image: %s", last_displayed_image);
     }
 }
 
-// Save last displayed image to NVS
+// Save last displayed image; the bookkeeping record batches the NVS write
 static void save_last_displayed_image(const char *filename)
 {
-    if (filename == NULL) {
+    if (filename == NULL || strcmp(filename, last_displayed_image) == 0) {
         return;
     }
 
     strncpy(last_displayed_image, filename, sizeof(last_displayed_image) - 1);
     last_displayed_image[sizeof(last_displayed_image) - 1] = '\0';
-
-    nvs_handle_t nvs_handle;
-    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
-        nvs_set_str(nvs_handle, NVS_LAST_IMAGE_KEY, last_displayed_image);
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-    }
+    bookkeeping_set_last_image(last_displayed_image);
 
     ESP_LOGI(TAG, "Saved last displayed image: %s", last_displayed_image);
 }
 
+#if CONFIG_STAGING_IN_RAM
+// With the link file in RAM, the last-image NVS key is what survives a
+// reboot: it names the displayed image while that is a file outside staging
+// and is cleared otherwise, so a reboot cannot bring back an older image
+static void record_durable_image(const char *target_path)
+{
+    const char *staging = STAGING_MOUNT_POINT "/";
+    bool staged = target_path == NULL || strncmp(target_path, staging, strlen(staging)) == 0;
+    save_last_displayed_image(staged ? "" : target_path);
+}
+#endif
+
 // Helper function to create link file pointing to current image
 static void create_image_link(const char *target_path)
 {
@@ -102,6 +129,17 @@ static void create_image_link(const char *target_path)
     } else {
         ESP_LOGE(TAG, "Failed to create link file");
     }
+#if CONFIG_STAGING_IN_RAM
+    record_durable_image(target_path);
+#endif
+}
+
+static void remove_image_link(void)
+{
+    unlink(CURRENT_IMAGE_LINK);
+#if CONFIG_STAGING_IN_RAM
+    record_durable_image(NULL);
+#endif
 }
 
 esp_err_t display_manager_init(void)
@@ -123,7 +161,43 @@ esp_err_t display_manager_init(void)
         return ESP_FAIL;
     }
 
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+    panel_idle = xSemaphoreCreateBinary();
+    epd_spare_buffer = (uint8_t *) heap_caps_malloc(image_buffer_size, MALLOC_CAP_SPIRAM);
+    if (panel_idle && epd_spare_buffer) {
+        xSemaphoreGive(panel_idle);
+        ESP_LOGI(TAG, "Double-buffered display (%lu bytes per frame)",
+                 (unsigned long) image_buffer_size);
+    } else {
+        ESP_LOGW(TAG, "No room for a second frame buffer; display is single-buffered");
+        if (panel_idle) {
+            vSemaphoreDelete(panel_idle);
+            panel_idle = NULL;
+        }
+        heap_caps_free(epd_spare_buffer);
+        epd_spare_buffer = NULL;
+    }
+#endif
+
     display_manager_initialize_paint();
+    display_generation = esp_random();
+
+    load_last_displayed_image();
+#if CONFIG_STAGING_IN_RAM
+    // The link file was lost with RAM; an album image that was on the panel
+    // is still there
+    struct stat st;
+    if (last_displayed_image[0] != '\0' && stat(CURRENT_IMAGE_LINK, &st) != 0 &&
+        stat(last_displayed_image, &st) == 0) {
+        create_image_link(last_displayed_image);
+    }
+#endif
+
+#if CONFIG_FRAME_STORE_PARTITION
+    // Logical rows only differ from the memory layout under 90/270
+    // rotation, which is not allowed, so one frame is one buffer's worth
+    frame_store_init(image_buffer_size);
+#endif
 
     ESP_LOGI(TAG, "Display manager initialized");
     return ESP_OK;
@@ -134,26 +208,145 @@ void display_manager_initialize_paint(void)
     Paint_NewImage(epd_image_buffer, BOARD_HAL_DISPLAY_WIDTH, BOARD_HAL_DISPLAY_HEIGHT,
                    config_manager_get_display_rotation_deg() % 360, display_white_color());
     Paint_SetScale(display_is_grayscale() ? 16 : 6);
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+    // Draw rows in the panel's scan order so the driver pushes them verbatim
+    Paint_SetWordMirror(1);
+#endif
     Paint_SelectImage(epd_image_buffer);
 }
 
-esp_err_t display_manager_show_image(const char *filename)
+// Core for background work that should overlap the caller (snapshot
+// deflate, panel row push, background refresh)
+static BaseType_t display_other_core(void)
 {
-    if (!filename || strlen(filename) == 0) {
-        return ESP_ERR_INVALID_ARG;
+#if CONFIG_FREERTOS_UNICORE
+    return tskNO_AFFINITY;
+#else
+    return xPortGetCoreID() == 0 ? 1 : 0;
+#endif
+}
+
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+static void panel_refresh_task(void *arg)
+{
+    int64_t start = esp_timer_get_time();
+    epaper_display((uint8_t *) arg);
+    ESP_LOGI(TAG, "Background refresh took %lld ms",
+             (long long) ((esp_timer_get_time() - start) / 1000));
+    xSemaphoreGive(panel_idle);
+    vTaskDelete(NULL);
+}
+
+static bool panel_is_idle(void)
+{
+    if (xSemaphoreTake(panel_idle, 0) != pdTRUE) {
+        return false;
     }
+    xSemaphoreGive(panel_idle);
+    return true;
+}
+#endif
 
-    if (xSemaphoreTake(display_mutex, pdMS_TO_TICKS(DISPLAY_LOCK_TIMEOUT_MS)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire display mutex");
-        return ESP_FAIL;
+void display_manager_wait_idle(void)
+{
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+    if (panel_idle) {
+        xSemaphoreTake(panel_idle, portMAX_DELAY);
+        xSemaphoreGive(panel_idle);
     }
+#endif
+}
 
-    // Expect absolute path from caller
-    ESP_LOGI(TAG, "Displaying image: %s", filename);
-    ESP_LOGI(TAG, "Free heap before display: %lu bytes", esp_get_free_heap_size());
+// The Paint target now holds what the panel shows (display mutex held)
+static void display_mark_shown(void)
+{
+    shown_frame = epd_image_buffer;
+    display_generation++;
+}
 
-    ESP_LOGI(TAG, "Clearing display buffer");
+// Start drawing a new frame (display mutex held). While the panel is still
+// refreshing from the Paint target, drawing moves to the other buffer.
+static void display_begin_frame(void)
+{
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+    if (panel_idle && panel_frame == epd_image_buffer && !panel_is_idle()) {
+        epd_image_buffer = epd_spare_buffer;
+        epd_spare_buffer = panel_frame;
+        Paint_SelectImage(epd_image_buffer);
+    }
+#endif
+    if (shown_frame == epd_image_buffer) {
+        shown_frame = NULL;
+    }
     Paint_Clear(display_white_color());
+}
+
+// Refresh the panel with the finished frame (display mutex held). Double
+// buffered, this only waits for the previous refresh and hands the frame to
+// a background task; the frame buffer must then stay untouched until the
+// next display_begin_frame. Otherwise it blocks for the whole refresh.
+static void display_commit_frame(void)
+{
+    display_mark_shown();
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+    if (panel_idle) {
+        xSemaphoreTake(panel_idle, portMAX_DELAY);
+        panel_frame = epd_image_buffer;
+        // The refresh mostly sleeps on BUSY; the pixel push is CPU-bound, so
+        // it goes to the core the next job is not processing on
+        if (xTaskCreatePinnedToCore(panel_refresh_task, "panel_refresh", 4096, panel_frame,
+                                    uxTaskPriorityGet(NULL), NULL,
+                                    display_other_core()) == pdPASS) {
+            ESP_LOGI(TAG, "Refreshing in the background");
+            return;
+        }
+        ESP_LOGW(TAG, "Failed to start background refresh; refreshing inline");
+        epaper_display(panel_frame);
+        xSemaphoreGive(panel_idle);
+        return;
+    }
+#endif
+    epaper_display(epd_image_buffer);
+}
+
+// Decode a packed album image into the Paint target (display mutex held)
+static esp_err_t display_load_packed(const char *path)
+{
+    album_pack_blob_t blob;
+    if (album_pack_open(path, &blob) != ESP_OK) {
+        ESP_LOGE(TAG, "Image not found: %s", path);
+        return ESP_FAIL;
+    }
+
+    // Both readers stop at the end of their own data, so they can run on
+    // the pack file directly
+    UBYTE result = 1;
+    if (blob.format == IMAGE_FORMAT_EPD_GZ) {
+        ESP_LOGI(TAG, "Reading packed EPDGZ into buffer");
+        result = GUI_ReadEPDGZStream(blob.fp) == 0 ? 0 : 1;
+    } else if (blob.format == IMAGE_FORMAT_PNG) {
+        ESP_LOGI(TAG, "Reading packed PNG into buffer");
+        result = display_is_grayscale() ? GUI_ReadPngStream_Gray16(blob.fp, 0, 0)
+                                        : GUI_ReadPngStream_RGB_6Color(blob.fp, 0, 0);
+    }
+    album_pack_blob_close(&blob);
+
+    if (result != 0) {
+        ESP_LOGE(TAG, "Failed to read packed image %s", path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// Decode an image file into the Paint target (display mutex held), by
+// extension: .epdgz, .png, anything else as BMP. Images of a packed album
+// are read from its pack.
+static esp_err_t display_load_file(const char *filename)
+{
+    struct stat st;
+    if (stat(filename, &st) != 0) {
+        return display_load_packed(filename);
+    }
 
     // Detect file type by extension
     const char *ext = strrchr(filename, '.');
@@ -165,7 +358,6 @@ esp_err_t display_manager_show_image(const char *filename)
         ESP_LOGI(TAG, "Reading EPDGZ file into buffer");
         if (GUI_ReadEPDGZ(filename) != 0) {
             ESP_LOGE(TAG, "Failed to read EPDGZ file");
-            xSemaphoreGive(display_mutex);
             return ESP_FAIL;
         }
     } else if (is_png) {
@@ -174,7 +366,6 @@ esp_err_t display_manager_show_image(const char *filename)
                                               : GUI_ReadPng_RGB_6Color(filename, 0, 0);
         if (result != 0) {
             ESP_LOGE(TAG, "Failed to read PNG file");
-            xSemaphoreGive(display_mutex);
             return ESP_FAIL;
         }
     } else {
@@ -183,19 +374,123 @@ esp_err_t display_manager_show_image(const char *filename)
                                               : GUI_ReadBmp_RGB_6Color(filename, 0, 0);
         if (result != 0) {
             ESP_LOGE(TAG, "Failed to read BMP file");
-            xSemaphoreGive(display_mutex);
             return ESP_FAIL;
         }
     }
+    return ESP_OK;
+}
+
+// Version tag of an image for the frame store: loose files by size and
+// mtime, packed ones by blob length and format
+static uint32_t display_source_stamp(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        return (uint32_t) st.st_size ^ ((uint32_t) st.st_mtime * 2654435761u);
+    }
+    album_pack_blob_t blob;
+    if (album_pack_open(path, &blob) == ESP_OK) {
+        uint32_t stamp = blob.length ^ ((uint32_t) blob.format << 28);
+        album_pack_blob_close(&blob);
+        return stamp;
+    }
+    return 0;
+}
+
+// Geometry tag of a stored frame; logical rows do not depend on rotation
+static uint32_t display_frame_layout(void)
+{
+    return ((uint32_t) Paint.Width << 16 | Paint.Height) ^ ((uint32_t) Paint.Scale << 12);
+}
+
+// Copy the stored frame for an image out of the mapped frame store
+// partition into the Paint target (display mutex held)
+static esp_err_t display_load_stored(const char *filename)
+{
+    if (frame_store_slot_count() == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    frame_store_frame_t frame;
+    esp_err_t err = frame_store_find(filename, display_source_stamp(filename),
+                                     display_frame_layout(), &frame);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ESP_LOGI(TAG, "Reading stored frame into buffer");
+    int result = GUI_ReadEPDRows(frame.data, frame.length);
+    frame_store_release(&frame);
+    return result == 0 ? ESP_OK : ESP_FAIL;
+}
+
+// Keep the frame just shown for an image in the frame store (display mutex
+// held). Only reads the frame buffer, so a background refresh may still be
+// running from it.
+static void display_store_frame(const char *filename)
+{
+    const int width = Paint.Width;
+    const int height = Paint.Height;
+    const size_t row_bytes = ((size_t) width + 1) / 2;
+
+    uint8_t *row = (uint8_t *) heap_caps_malloc(row_bytes, MALLOC_CAP_SPIRAM);
+    if (!row) {
+        return;
+    }
+
+    frame_store_writer_t writer;
+    esp_err_t err = frame_store_begin(filename, display_source_stamp(filename),
+                                      display_frame_layout(), row_bytes * height, &writer);
+    for (int y = 0; y < height && err == ESP_OK; y++) {
+        Paint_ReadRow4bpp(0, y, row, width);
+        err = frame_store_append(&writer, row, row_bytes);
+
+        // Yield periodically so the IDLE task can feed the watchdog
+        if ((y & 63) == 0) {
+            vTaskDelay(1);
+        }
+    }
+    if (err == ESP_OK) {
+        err = frame_store_commit(&writer);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store frame for %s", filename);
+    }
+    heap_caps_free(row);
+}
+
+// Show an image file. A frame stored for it is used instead of decoding the
+// file; with store_frame set, a decoded frame is stored for next time.
+static esp_err_t display_show_file(const char *filename, bool store_frame)
+{
+    if (!filename || strlen(filename) == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xSemaphoreTake(display_mutex, pdMS_TO_TICKS(DISPLAY_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to acquire display mutex");
+        return ESP_FAIL;
+    }
+
+    // Expect absolute path from caller
+    ESP_LOGI(TAG, "Displaying image: %s", filename);
+    ESP_LOGI(TAG, "Free heap before display: %lu bytes", esp_get_free_heap_size());
+
+    ESP_LOGI(TAG, "Clearing display buffer");
+    display_begin_frame();
+
+    bool stored = display_load_stored(filename) == ESP_OK;
+    if (!stored && display_load_file(filename) != ESP_OK) {
+        xSemaphoreGive(display_mutex);
+        return ESP_FAIL;
+    }
 
     ESP_LOGI(TAG, "Starting e-paper display update (this takes ~30 seconds)");
     ESP_LOGI(TAG, "Free heap before epaper_display: %lu bytes", esp_get_free_heap_size());
 
     // 4. Update E-Paper Display
-    // This is a blocking call that takes ~25-30 seconds for 7-color e-paper
-    // It handles: Power On -> Send Data -> Refresh -> Power Off
+    // The refresh takes ~25-30 seconds for 7-color e-paper (Power On -> Send
+    // Data -> Refresh -> Power Off); double buffered it runs in the background
     ESP_LOGI(TAG, "Calling epaper_display...");
-    epaper_display(epd_image_buffer);
+    display_commit_frame();
     ESP_LOGI(TAG, "epaper_display returned successfully");
 
     ESP_LOGI(TAG, "E-paper display update complete");
@@ -206,12 +501,21 @@ esp_err_t display_manager_show_image(const char *filename)
     create_image_link(filename);
     ESP_LOGD(TAG, "Created link to: %s", filename);
 
+    if (store_frame && !stored) {
+        display_store_frame(filename);
+    }
+
     xSemaphoreGive(display_mutex);
 
     ESP_LOGI(TAG, "Image displayed successfully");
     return ESP_OK;
 }
 
+esp_err_t display_manager_show_image(const char *filename)
+{
+    return display_show_file(filename, false);
+}
+
 esp_err_t display_manager_show_rgb_buffer(const uint8_t *rgb_buffer, int width, int height)
 {
     if (!rgb_buffer || width <= 0 || height <= 0) {
@@ -227,7 +531,7 @@ esp_err_t display_manager_show_rgb_buffer(const uint8_t *rgb_buffer, int width,
     ESP_LOGI(TAG, "Free heap before display: %lu bytes", esp_get_free_heap_size());
 
     ESP_LOGI(TAG, "Clearing display buffer");
-    Paint_Clear(display_white_color());
+    display_begin_frame();
 
     ESP_LOGI(TAG, "Painting RGB buffer to display");
     UBYTE result = display_is_grayscale()
@@ -243,7 +547,7 @@ esp_err_t display_manager_show_rgb_buffer(const uint8_t *rgb_buffer, int width,
     ESP_LOGI(TAG, "Free heap before epaper_display: %lu bytes", esp_get_free_heap_size());
 
     ESP_LOGI(TAG, "Calling epaper_display...");
-    epaper_display(epd_image_buffer);
+    display_commit_frame();
     ESP_LOGI(TAG, "epaper_display returned successfully");
 
     ESP_LOGI(TAG, "E-paper display update complete");
@@ -258,6 +562,119 @@ esp_err_t display_manager_show_rgb_buffer(const uint8_t *rgb_buffer, int width,
     return ESP_OK;
 }
 
+// Streamed panel updates. When an RGB stream fills the frame buffer in
+// panel row order, every finished row is queued to a sender task on the
+// other core that loads it into the controller right away, so the SPI push
+// overlaps processing instead of following it. The frame buffer is still
+// filled as usual for snapshots and the full-push fallback.
+#define PANEL_STREAM_QUEUE_LEN 64
+#define PANEL_STREAM_MAX_BAND 16
+#define PANEL_STREAM_STOP 0xFFFF
+
+static struct {
+    bool armed;   // rows of the current RGB stream arrive in panel order
+    bool active;  // the controller is receiving rows
+    bool broken;  // a row arrived out of order; refresh with a full push
+    int next_row;
+    QueueHandle_t rows;
+    SemaphoreHandle_t done;
+} panel_stream;
+
+static void panel_stream_task(void *arg)
+{
+    (void) arg;
+    const size_t row_bytes = Paint.WidthByte;
+    uint16_t y;
+    while (xQueueReceive(panel_stream.rows, &y, portMAX_DELAY) == pdTRUE &&
+           y != PANEL_STREAM_STOP) {
+        // Send whatever consecutive rows are already queued as one band
+        uint16_t count = 1;
+        uint16_t next;
+        while (count < PANEL_STREAM_MAX_BAND &&
+               xQueuePeek(panel_stream.rows, &next, 0) == pdTRUE && next == y + count) {
+            xQueueReceive(panel_stream.rows, &next, 0);
+            count++;
+        }
+        epaper_stream_rows(epd_image_buffer + (size_t) y * row_bytes, y, count);
+    }
+    xSemaphoreGive(panel_stream.done);
+    vTaskDelete(NULL);
+}
+
+// Called for the first row of an armed stream
+static void panel_stream_start(void)
+{
+    panel_stream.armed = false;
+    if (!panel_stream.rows) {
+        panel_stream.rows = xQueueCreate(PANEL_STREAM_QUEUE_LEN, sizeof(uint16_t));
+    }
+    if (!panel_stream.done) {
+        panel_stream.done = xSemaphoreCreateBinary();
+    }
+    if (!panel_stream.rows || !panel_stream.done) {
+        return;
+    }
+    xQueueReset(panel_stream.rows);
+
+    if (!epaper_stream_begin()) {
+        ESP_LOGD(TAG, "Panel driver does not stream; refreshing after processing");
+        return;
+    }
+    if (xTaskCreatePinnedToCore(panel_stream_task, "panel_stream", 4096, NULL,
+                                uxTaskPriorityGet(NULL), NULL, display_other_core()) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to start panel stream task");
+        epaper_stream_commit(false);
+        return;
+    }
+    ESP_LOGI(TAG, "Streaming rows to the panel while processing");
+    panel_stream.active = true;
+    panel_stream.broken = false;
+    panel_stream.next_row = 0;
+}
+
+// Queue frame buffer row y (complete) for the panel
+static void panel_stream_row(int y)
+{
+    if (panel_stream.armed && y == 0) {
+        panel_stream_start();
+    }
+    if (!panel_stream.active || panel_stream.broken) {
+        return;
+    }
+    if (y != panel_stream.next_row) {
+        ESP_LOGW(TAG, "Row %d out of panel order, dropping the streamed frame", y);
+        panel_stream.broken = true;
+        return;
+    }
+    uint16_t row = (uint16_t) y;
+    xQueueSend(panel_stream.rows, &row, portMAX_DELAY);
+    panel_stream.next_row++;
+}
+
+// Stop the sender and finish the controller update. Returns true when the
+// streamed frame was complete and the panel refreshed from it; false means
+// the caller still has to push the frame buffer (if refreshing at all).
+static bool panel_stream_finish(bool refresh)
+{
+    panel_stream.armed = false;
+    if (!panel_stream.active) {
+        return false;
+    }
+
+    uint16_t stop = PANEL_STREAM_STOP;
+    xQueueSend(panel_stream.rows, &stop, portMAX_DELAY);
+    xSemaphoreTake(panel_stream.done, portMAX_DELAY);
+    panel_stream.active = false;
+
+    bool complete = !panel_stream.broken && panel_stream.next_row == Paint.HeightMemory;
+    if (refresh && !complete) {
+        ESP_LOGW(TAG, "Streamed frame incomplete (%d rows), pushing the full frame",
+                 panel_stream.next_row);
+    }
+    epaper_stream_commit(refresh && complete);
+    return refresh && complete;
+}
+
 esp_err_t display_manager_begin_rgb_stream(void)
 {
     if (xSemaphoreTake(display_mutex, pdMS_TO_TICKS(DISPLAY_LOCK_TIMEOUT_MS)) != pdTRUE) {
@@ -266,10 +683,72 @@ esp_err_t display_manager_begin_rgb_stream(void)
     }
 
     ESP_LOGI(TAG, "Beginning streamed RGB display");
-    Paint_Clear(display_white_color());
+    display_begin_frame();
+
+    // Logical rows are whole frame buffer rows in ascending order only at
+    // rotation 0/180 without a net vertical flip; the panel is started when
+    // the first row arrives, so column-painted (rotated) streams never
+    // touch it
+    bool flip_y = (Paint.Rotate == ROTATE_180) != ((Paint.Mirror & MIRROR_VERTICAL) != 0);
+    panel_stream.armed = (Paint.Rotate == ROTATE_0 || Paint.Rotate == ROTATE_180) && !flip_y &&
+                         Paint.Width == Paint.WidthMemory;
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+    // The controller is still busy with a background refresh; this frame is
+    // pushed whole at commit instead
+    if (panel_idle && !panel_is_idle()) {
+        panel_stream.armed = false;
+    }
+#endif
     return ESP_OK;
 }
 
+// Paint width RGB pixels of row y starting at column x (clipped to the frame)
+static void paint_rgb_span(int x, int y, const uint8_t *rgb, int width)
+{
+    // Map in stack-sized chunks and paint each as one span, so rotation and
+    // mirror are resolved per chunk rather than per pixel
+    GUI_RGBMapFn map_rgb = display_is_grayscale() ? GUI_RGBToGray16 : GUI_RGBToSpectra6;
+    UBYTE chunk[128];
+    if (width > Paint.Width - x) {
+        width = Paint.Width - x;
+    }
+    for (int x0 = 0; x0 < width; x0 += sizeof(chunk)) {
+        int n = width - x0 < (int) sizeof(chunk) ? width - x0 : (int) sizeof(chunk);
+        for (int i = 0; i < n; i++) {
+            const uint8_t *p = &rgb[(x0 + i) * 3];
+            chunk[i] = map_rgb(p[0], p[1], p[2]);
+        }
+        Paint_BlitSpanIndices(x + x0, y, chunk, n);
+    }
+}
+
+// Paint count adjacent columns x0..x0+count-1 of height RGB pixels from row
+// y down, cols[i] being column x0 + i (clipped to the frame)
+static void paint_rgb_columns(int x0, int y, int count, const uint8_t *const *cols, int height)
+{
+    // Transpose the tile one display row at a time: each row's pixels are
+    // adjacent in the framebuffer, so they go out as a single span
+    GUI_RGBMapFn map_rgb = display_is_grayscale() ? GUI_RGBToGray16 : GUI_RGBToSpectra6;
+    UBYTE span[32];
+    if (x0 >= Paint.Width) {
+        return;
+    }
+    if (count > Paint.Width - x0) {
+        count = Paint.Width - x0;
+    }
+    for (int i = 0; i < height && y + i < Paint.Height; i++) {
+        size_t offset = (size_t) i * 3;
+        for (int c0 = 0; c0 < count; c0 += sizeof(span)) {
+            int n = count - c0 < (int) sizeof(span) ? count - c0 : (int) sizeof(span);
+            for (int c = 0; c < n; c++) {
+                const uint8_t *p = cols[c0 + c] + offset;
+                span[c] = map_rgb(p[0], p[1], p[2]);
+            }
+            Paint_BlitSpanIndices(x0 + c0, y + i, span, n);
+        }
+    }
+}
+
 esp_err_t display_manager_push_rgb_row(int y, const uint8_t *rgb_row, int width)
 {
     if (!rgb_row) {
@@ -279,11 +758,112 @@ esp_err_t display_manager_push_rgb_row(int y, const uint8_t *rgb_row, int width)
         return ESP_OK;
     }
 
-    GUI_RGBMapFn map_rgb = display_is_grayscale() ? GUI_RGBToGray16 : GUI_RGBToSpectra6;
-    for (int x = 0; x < width && x < Paint.Width; x++) {
-        const uint8_t *p = &rgb_row[x * 3];
-        Paint_SetPixel(x, y, map_rgb(p[0], p[1], p[2]));
+    paint_rgb_span(0, y, rgb_row, width);
+    panel_stream_row(y);
+    return ESP_OK;
+}
+
+// Bring the frame the panel shows back into the Paint target. A frame that
+// was drawn over is decoded again from the current image, which only works
+// when that file holds rendered output -- .current.png is the unprocessed
+// original and JPEG cannot be painted directly.
+static esp_err_t display_restore_shown_frame(void)
+{
+    if (shown_frame == epd_image_buffer) {
+        return ESP_OK;
+    }
+    if (shown_frame) {
+        // Double buffered: the panel refreshed from the other buffer, which
+        // only ever gets read
+        memcpy(epd_image_buffer, shown_frame, image_buffer_size);
+        shown_frame = epd_image_buffer;
+        return ESP_OK;
+    }
+
+    char displayed[256] = {0};
+    FILE *fp = fopen(CURRENT_IMAGE_LINK, "r");
+    if (fp) {
+        if (!fgets(displayed, sizeof(displayed), fp)) {
+            displayed[0] = '\0';
+        }
+        fclose(fp);
+    }
+    size_t len = strlen(displayed);
+    if (len > 0 && displayed[len - 1] == '\n') {
+        displayed[len - 1] = '\0';
+    }
+    const char *ext = strrchr(displayed, '.');
+    if (displayed[0] == '\0' || strcmp(displayed, CURRENT_PNG_PATH) == 0 ||
+        (ext && strcasecmp(ext, ".jpg") == 0)) {
+        ESP_LOGE(TAG, "Displayed frame is unknown (%s); cannot patch it",
+                 displayed[0] ? displayed : "no current image");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "Restoring displayed frame from %s", displayed);
+    Paint_Clear(display_white_color());
+    if (display_load_file(displayed) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
     }
+    shown_frame = epd_image_buffer;
+    return ESP_OK;
+}
+
+esp_err_t display_manager_begin_patch(void)
+{
+    if (xSemaphoreTake(display_mutex, pdMS_TO_TICKS(DISPLAY_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to acquire display mutex");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Beginning region patch");
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+    // The panel is still refreshing from the Paint target: patch a copy in
+    // the other buffer instead
+    if (panel_idle && panel_frame == epd_image_buffer && !panel_is_idle()) {
+        epd_image_buffer = epd_spare_buffer;
+        epd_spare_buffer = panel_frame;
+        Paint_SelectImage(epd_image_buffer);
+    }
+#endif
+    esp_err_t err = display_restore_shown_frame();
+    if (err != ESP_OK) {
+        xSemaphoreGive(display_mutex);
+        return err;
+    }
+    // Patches are refreshed with a whole-frame push at end; the panel
+    // stream stays disarmed
+    panel_stream.armed = false;
+    return ESP_OK;
+}
+
+esp_err_t display_manager_patch_row(int x, int y, const uint8_t *rgb, int n)
+{
+    if (!rgb || x < 0 || y < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (x >= Paint.Width || y >= Paint.Height) {
+        return ESP_OK;
+    }
+    paint_rgb_span(x, y, rgb, n);
+    return ESP_OK;
+}
+
+esp_err_t display_manager_patch_column(int x, int y, const uint8_t *rgb, int n)
+{
+    if (!rgb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return display_manager_patch_columns(x, y, 1, &rgb, n);
+}
+
+esp_err_t display_manager_patch_columns(int x0, int y, int count, const uint8_t *const *cols,
+                                        int n)
+{
+    if (!cols || count < 0 || x0 < 0 || y < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    paint_rgb_columns(x0, y, count, cols, n);
     return ESP_OK;
 }
 
@@ -302,10 +882,11 @@ static void zfree_psram(voidpf opaque, voidpf address)
 }
 
 // Gzip-deflate the current frame to path, producing the same .epdgz format
-// GUI_ReadEPDGZ renders. The reader replays the payload through
-// Paint_SetPixel in logical coordinates, so pixels are read back through
-// Paint_GetPixel (undoing the configured rotation/mirror) and streamed to
-// the deflater one logical row at a time.
+// GUI_ReadEPDGZ renders. The reader places the payload in logical
+// coordinates (as Paint_SetPixel would), so rows are read back packed with
+// Paint_ReadRow4bpp (undoing the configured rotation/mirror) and streamed to
+// the deflater one logical row at a time. Only reads the frame buffer, so it
+// can run while the panel is being refreshed from it.
 //
 // Like every .epdgz in this ecosystem (converter output, splash), the
 // payload is logical-orientation rows replayed under the rotation active at
@@ -338,11 +919,7 @@ static esp_err_t display_save_frame_epdgz(const char *path)
     esp_err_t err = zready ? ESP_OK : ESP_ERR_NO_MEM;
 
     for (int y = 0; y < height && err == ESP_OK; y++) {
-        for (int x = 0; x < width; x += 2) {
-            UBYTE p1 = Paint_GetPixel(x, y);
-            UBYTE p2 = (x + 1 < width) ? Paint_GetPixel(x + 1, y) : 0;
-            row[x / 2] = (UBYTE) ((p1 << 4) | p2);
-        }
+        Paint_ReadRow4bpp(0, y, row, width);
 
         strm.next_in = row;
         strm.avail_in = row_bytes;
@@ -391,35 +968,192 @@ static esp_err_t display_save_frame_epdgz(const char *path)
     return err;
 }
 
+// A frame snapshot deflated on the other core while the panel refreshes
+typedef struct {
+    const char *path;
+    esp_err_t err;
+    SemaphoreHandle_t done;
+} snapshot_job_t;
+
+static void snapshot_task(void *arg)
+{
+    snapshot_job_t *job = (snapshot_job_t *) arg;
+    int64_t start = esp_timer_get_time();
+    job->err = display_save_frame_epdgz(job->path);
+    ESP_LOGI(TAG, "Frame snapshot took %lld ms",
+             (long long) ((esp_timer_get_time() - start) / 1000));
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+// Start deflating the frame to path in the background. Returns false when
+// the task cannot be started; the caller then saves inline.
+static bool snapshot_start(snapshot_job_t *job, const char *path)
+{
+    job->path = path;
+    job->err = ESP_FAIL;
+    job->done = xSemaphoreCreateBinary();
+    if (!job->done) {
+        return false;
+    }
+    // The refresh mostly sleeps on BUSY, but the pixel transfer before it
+    // is CPU-bound on this core
+    if (xTaskCreatePinnedToCore(snapshot_task, "frame_snapshot", 6144, job,
+                                uxTaskPriorityGet(NULL), NULL, display_other_core()) != pdPASS) {
+        vSemaphoreDelete(job->done);
+        job->done = NULL;
+        return false;
+    }
+    return true;
+}
+
+static esp_err_t snapshot_wait(snapshot_job_t *job)
+{
+    xSemaphoreTake(job->done, portMAX_DELAY);
+    vSemaphoreDelete(job->done);
+    job->done = NULL;
+    return job->err;
+}
+
 esp_err_t display_manager_push_rgb_column(int x, const uint8_t *rgb_col, int height)
 {
     if (!rgb_col) {
         return ESP_ERR_INVALID_ARG;
     }
-    if (x >= Paint.Width) {
-        return ESP_OK;
-    }
+    paint_rgb_columns(x, 0, 1, &rgb_col, height);
+    return ESP_OK;
+}
 
-    GUI_RGBMapFn map_rgb = display_is_grayscale() ? GUI_RGBToGray16 : GUI_RGBToSpectra6;
-    for (int y = 0; y < height && y < Paint.Height; y++) {
-        const uint8_t *p = &rgb_col[y * 3];
-        Paint_SetPixel(x, y, map_rgb(p[0], p[1], p[2]));
+esp_err_t display_manager_push_rgb_columns(int x0, int count, const uint8_t *const *cols,
+                                           int height)
+{
+    if (!cols || count < 0) {
+        return ESP_ERR_INVALID_ARG;
     }
+    paint_rgb_columns(x0, 0, count, cols, height);
     return ESP_OK;
 }
 
+uint32_t display_manager_get_generation(void)
+{
+    return display_generation;
+}
+
+esp_err_t display_manager_read_frame(int shrink, display_frame_t *frame)
+{
+    if (!frame || shrink < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(frame, 0, sizeof(*frame));
+    if (xSemaphoreTake(display_mutex, pdMS_TO_TICKS(DISPLAY_READ_TIMEOUT_MS)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    esp_err_t err = display_restore_shown_frame();
+    if (err == ESP_OK) {
+        UWORD width, height;
+        frame->rows = GUI_ReadFrame4bpp((UWORD) shrink, &width, &height);
+        frame->width = width;
+        frame->height = height;
+        frame->generation = display_generation;
+        frame->grayscale = display_is_grayscale();
+        err = frame->rows ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(display_mutex);
+    return err;
+}
+
+esp_err_t display_manager_write_frame_png(const display_frame_t *frame, display_write_fn write,
+                                          void *ctx)
+{
+    if (!frame || !frame->rows || !write) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    UBYTE result = GUI_WritePng4bpp(frame->rows, frame->width, frame->height, frame->grayscale,
+                                    write, ctx);
+    return result == 0 ? ESP_OK : ESP_FAIL;
+}
+
+void display_manager_free_frame(display_frame_t *frame)
+{
+    heap_caps_free(frame->rows);
+    frame->rows = NULL;
+}
+
+esp_err_t display_manager_render_to_epdgz(const char *src, const char *dst)
+{
+    if (!src || !dst) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t *scratch = (uint8_t *) heap_caps_malloc(image_buffer_size, MALLOC_CAP_SPIRAM);
+    if (!scratch) {
+        ESP_LOGE(TAG, "No memory for a render frame");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Paint is shared with the display path; a busy display defers the
+    // render rather than stalling the caller for a whole refresh
+    if (xSemaphoreTake(display_mutex, pdMS_TO_TICKS(DISPLAY_READ_TIMEOUT_MS)) != pdTRUE) {
+        heap_caps_free(scratch);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Decode into a private frame so neither the shown frame nor a refresh
+    // still reading the Paint target is touched. The payload is logical rows,
+    // so the scratch frame needs no rotation or word mirror.
+    PAINT saved = Paint;
+    Paint_NewImage(scratch, BOARD_HAL_DISPLAY_WIDTH, BOARD_HAL_DISPLAY_HEIGHT, ROTATE_0,
+                   display_white_color());
+    Paint_SetScale(display_is_grayscale() ? 16 : 6);
+    Paint_SelectImage(scratch);
+    Paint_Clear(display_white_color());
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = display_load_file(src);
+    if (err == ESP_OK) {
+        err = display_save_frame_epdgz(dst);
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Rendered %s to %s in %lld ms", src, dst,
+                 (long long) ((esp_timer_get_time() - start) / 1000));
+    }
+
+    Paint = saved;
+    xSemaphoreGive(display_mutex);
+    heap_caps_free(scratch);
+    return err;
+}
+
 esp_err_t display_manager_end_rgb_stream(bool show, const display_publish_t *pub)
 {
     esp_err_t result = ESP_OK;
 
     if (show) {
+        // The snapshot only reads the frame buffer, so it is deflated on the
+        // other core while the panel refresh waits on BUSY
+        snapshot_job_t snapshot;
+        bool snapshot_async = pub && pub->save_path && snapshot_start(&snapshot, pub->save_path);
+
         ESP_LOGI(TAG, "Starting e-paper display update (this takes ~30 seconds)");
-        epaper_display(epd_image_buffer);
+        if (panel_stream_finish(true)) {
+            display_mark_shown();
+        } else {
+            display_commit_frame();
+        }
         ESP_LOGI(TAG, "E-paper display update complete");
 
         const char *record = pub ? pub->display_name : NULL;
 
-        if (pub && pub->save_path && display_save_frame_epdgz(pub->save_path) != ESP_OK) {
+        // The link is published only once the snapshot has finished and the
+        // refresh has completed (double buffered: been handed off)
+        esp_err_t snapshot_err = ESP_OK;
+        if (snapshot_async) {
+            snapshot_err = snapshot_wait(&snapshot);
+        } else if (pub && pub->save_path) {
+            snapshot_err = display_save_frame_epdgz(pub->save_path);
+        }
+
+        if (snapshot_err != ESP_OK) {
             // The album entry does not exist -- publish the fallback name
             // (or nothing) instead, atomically under the display mutex, so
             // the link never points at a missing album entry
@@ -437,7 +1171,14 @@ esp_err_t display_manager_end_rgb_stream(bool show, const display_publish_t *pub
             // Displayed from an anonymous buffer (or no usable fallback):
             // remove the stale link rather than reporting the previous image
             current_image[0] = '\0';
-            unlink(CURRENT_IMAGE_LINK);
+            remove_image_link();
+        }
+    } else {
+        // Abandon any rows already sent; the panel keeps the old image, but
+        // an abandoned patch has already drawn over the buffer's copy of it
+        panel_stream_finish(false);
+        if (shown_frame == epd_image_buffer) {
+            shown_frame = NULL;
         }
     }
 
@@ -451,11 +1192,14 @@ esp_err_t display_manager_clear(void)
         return ESP_FAIL;
     }
 
+    // Both draw into the Paint target and refresh inline
+    display_manager_wait_idle();
     epaper_clear(epd_image_buffer, EPD_7IN3E_WHITE);
     epaper_display(epd_image_buffer);
+    display_mark_shown();
 
     // Remove the current image link so API returns 404
-    unlink(CURRENT_IMAGE_LINK);
+    remove_image_link();
     current_image[0] = '\0';
     save_last_displayed_image("");
 
@@ -471,6 +1215,7 @@ esp_err_t display_manager_show_calibration(void)
     }
 
     ESP_LOGI(TAG, "Displaying calibration pattern");
+    display_manager_wait_idle();
 
     // Re-initialize paint with current orientation
     display_manager_initialize_paint();
@@ -485,6 +1230,7 @@ esp_err_t display_manager_show_calibration(void)
 
     // Display the buffer
     epaper_display(epd_image_buffer);
+    display_mark_shown();
 
     xSemaphoreGive(display_mutex);
 
@@ -494,6 +1240,13 @@ esp_err_t display_manager_show_calibration(void)
 
 bool display_manager_is_busy(void)
 {
+#if CONFIG_DISPLAY_DOUBLE_BUFFER
+    // A committed frame holds panel_idle from before its refresh task starts
+    // until the refresh is done, long after the mutex was released
+    if (panel_idle && !panel_is_idle()) {
+        return true;
+    }
+#endif
     // Try to take the mutex without blocking
     if (xSemaphoreTake(display_mutex, 0) == pdTRUE) {
         // Mutex was available, give it back
@@ -509,202 +1262,201 @@ const char *display_manager_get_current_image(void)
     return current_image;
 }
 
-static void rotate_sequential(char **enabled_albums, int album_count)
+// FNV-1a step over len bytes
+static uint32_t layout_hash(uint32_t hash, const void *data, size_t len)
 {
-    ESP_LOGI(TAG, "Sequential rotation mode");
-    int32_t last_idx = config_manager_get_last_index();
-    int32_t target_idx = last_idx + 1;
-    int32_t current_idx = 0;
-    char first_image[512] = {0};
-    bool found_target = false;
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
 
+// Image counts of the enabled albums, read from their indexes. Returns the
+// total; albums whose index cannot be read count as empty. layout (may be
+// NULL) receives a hash of the album names and index order tags: it changes
+// when the set of enabled albums does or when an image within one may have
+// moved (a delete or a re-index), but not when an upload appends one.
+static int count_album_images(char **enabled_albums, int album_count, int *counts,
+                              uint32_t *layout)
+{
+    int total = 0;
+    uint32_t hash = 2166136261u;
     for (int i = 0; i < album_count; i++) {
-        char album_path[256];
-        album_manager_get_album_path(enabled_albums[i], album_path, sizeof(album_path));
-
-        DIR *dir = opendir(album_path);
-        if (!dir) {
-            continue;
+        uint32_t order = 0;
+        if (album_index_order(enabled_albums[i], &counts[i], &order) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to index album: %s", enabled_albums[i]);
+            counts[i] = 0;
         }
+        total += counts[i];
+        hash = layout_hash(hash, enabled_albums[i], strlen(enabled_albums[i]) + 1);
+        hash = layout_hash(hash, &order, sizeof(order));
+    }
+    if (layout) {
+        *layout = hash;
+    }
+    return total;
+}
 
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL) {
-            if (entry->d_type == DT_REG) {
-                if (entry->d_name[0] == '.' && entry->d_name[1] == '_') {
-                    continue;
-                }
-
-                const char *ext = strrchr(entry->d_name, '.');
-                if (ext && (strcasecmp(ext, ".bmp") == 0 || strcasecmp(ext, ".png") == 0 ||
-                            strcasecmp(ext, ".epdgz") == 0)) {
-                    char fullpath[512];
-                    snprintf(fullpath, sizeof(fullpath), "%s/%s", album_path, entry->d_name);
-                    ESP_LOGD(TAG, "  Found image [%ld]: %s", (long) current_idx, fullpath);
-
-                    // Keep track of the very first image in case we need to wrap
-                    if (first_image[0] == '\0') {
-                        strncpy(first_image, fullpath, sizeof(first_image) - 1);
-                    }
-
-                    if (current_idx == target_idx) {
-                        ESP_LOGI(TAG, "Found target index %ld: %s", (long) target_idx, fullpath);
-                        display_manager_show_image(fullpath);
-                        save_last_displayed_image(fullpath);
-                        config_manager_set_last_index(target_idx);
-                        found_target = true;
-                        closedir(dir);
-                        return;
-                    }
-                    current_idx++;
-                }
-            }
-        }
-        closedir(dir);
-    }
-
-    ESP_LOGI(
-        TAG,
-        "Sequential rotation finished traversal. current_idx=%ld, target_idx=%ld, found_target=%d",
-        (long) current_idx, (long) target_idx, found_target);
-
-    // If we reached here, we didn't find the target index (or the list has changed and is
-    // shorter) Wrap around to the first image
-    if (!found_target) {
-        if (first_image[0] != '\0') {
-            ESP_LOGI(TAG, "Wrapping around to start. Displaying: %s", first_image);
-            display_manager_show_image(first_image);
-            save_last_displayed_image(first_image);
-            config_manager_set_last_index(0);  // Reset index to 0
-        } else {
-            ESP_LOGW(TAG, "No images found in any enabled albums.");
+// Resolve the nth image across the enabled albums, in album order
+static esp_err_t pick_album_image(char **enabled_albums, int album_count, const int *counts,
+                                  int n, char *path, size_t path_len)
+{
+    for (int i = 0; i < album_count; i++) {
+        if (n < counts[i]) {
+            return album_index_get(enabled_albums[i], n, path, path_len, NULL);
         }
+        n -= counts[i];
     }
+    return ESP_ERR_NOT_FOUND;
 }
 
-static void rotate_random(char **enabled_albums, int album_count)
+// Show a rotation pick. Its frame is stored when the whole rotation fits in
+// the frame store, so each later round is a copy out of flash; a larger
+// rotation would only cycle frames through the slots and wear the flash.
+static void display_show_album_image(const char *path, int total)
 {
-    ESP_LOGI(TAG, "Random rotation mode");
+    display_show_file(path, total <= frame_store_slot_count());
+}
 
-    // Count total images across all enabled albums
-    int total_image_count = 0;
-    for (int i = 0; i < album_count; i++) {
-        char album_path[256];
-        album_manager_get_album_path(enabled_albums[i], album_path, sizeof(album_path));
+static void rotate_sequential(char **enabled_albums, int album_count, int *counts)
+{
+    ESP_LOGI(TAG, "Sequential rotation mode");
+    int32_t target_idx = config_manager_get_last_index() + 1;
+    char fullpath[512];
 
-        DIR *dir = opendir(album_path);
-        if (!dir) {
-            ESP_LOGW(TAG, "Failed to open album: %s", enabled_albums[i]);
-            continue;
+    // A vanished file re-indexes its album; count again and retry once
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int total = count_album_images(enabled_albums, album_count, counts, NULL);
+        if (total == 0) {
+            ESP_LOGW(TAG, "No images found in any enabled albums.");
+            return;
         }
 
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL) {
-            if (entry->d_type == DT_REG) {
-                if (entry->d_name[0] == '.' && entry->d_name[1] == '_') {
-                    continue;
-                }
-                const char *ext = strrchr(entry->d_name, '.');
-                if (ext && (strcasecmp(ext, ".bmp") == 0 || strcasecmp(ext, ".png") == 0 ||
-                            strcasecmp(ext, ".epdgz") == 0)) {
-                    total_image_count++;
-                }
-            }
+        // Wrap around when past the end (or the albums have shrunk)
+        int32_t idx = target_idx < total ? target_idx : 0;
+        if (pick_album_image(enabled_albums, album_count, counts, idx, fullpath,
+                             sizeof(fullpath)) == ESP_OK) {
+            ESP_LOGI(TAG, "Displaying image %ld/%d: %s", (long) idx + 1, total, fullpath);
+            display_show_album_image(fullpath, total);
+            save_last_displayed_image(fullpath);
+            config_manager_set_last_index(idx);
+            return;
         }
-        closedir(dir);
     }
+    ESP_LOGW(TAG, "Sequential rotation could not resolve an image");
+}
 
-    if (total_image_count == 0) {
-        ESP_LOGW(TAG, "No images found in enabled albums");
-        return;
-    }
+static void rotate_random(char **enabled_albums, int album_count, int *counts)
+{
+    ESP_LOGI(TAG, "Random rotation mode");
 
-    // Build image list with absolute paths from all enabled albums
-    char **image_list = malloc(total_image_count * sizeof(char *));
-    if (!image_list) {
-        ESP_LOGE(TAG, "Failed to allocate image list");
-        return;
+    // Load last displayed image if not already loaded
+    if (last_displayed_image[0] == '\0') {
+        load_last_displayed_image();
     }
-    int idx = 0;
-
-    for (int i = 0; i < album_count; i++) {
-        char album_path[256];
-        album_manager_get_album_path(enabled_albums[i], album_path, sizeof(album_path));
 
-        DIR *dir = opendir(album_path);
-        if (!dir) {
-            continue;
+    char fullpath[512];
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int total = count_album_images(enabled_albums, album_count, counts, NULL);
+        if (total == 0) {
+            ESP_LOGW(TAG, "No images found in enabled albums");
+            return;
         }
 
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL && idx < total_image_count) {
-            if (entry->d_type == DT_REG) {
-                if (entry->d_name[0] == '.' && entry->d_name[1] == '_') {
-                    continue;
-                }
-
-                const char *ext = strrchr(entry->d_name, '.');
-                if (ext && (strcasecmp(ext, ".bmp") == 0 || strcasecmp(ext, ".png") == 0 ||
-                            strcasecmp(ext, ".epdgz") == 0)) {
-                    char *fullpath = malloc(512);
-                    if (!fullpath) {
-                        ESP_LOGE(TAG, "Failed to allocate path buffer");
-                        continue;
-                    }
-                    snprintf(fullpath, 512, "%s/%s", album_path, entry->d_name);
-                    image_list[idx] = fullpath;
-                    idx++;
-                }
+        // Select random image, avoiding the last displayed image if possible
+        int random_index = esp_random() % total;
+        esp_err_t err = pick_album_image(enabled_albums, album_count, counts, random_index,
+                                         fullpath, sizeof(fullpath));
+
+        // If we have more than one image and the random selection matches the last image,
+        // try to pick a different one (up to 10 attempts)
+        if (err == ESP_OK && total > 1 && last_displayed_image[0] != '\0') {
+            int tries = 0;
+            while (err == ESP_OK && tries < 10 && strcmp(fullpath, last_displayed_image) == 0) {
+                random_index = esp_random() % total;
+                err = pick_album_image(enabled_albums, album_count, counts, random_index,
+                                       fullpath, sizeof(fullpath));
+                tries++;
+            }
+            if (err == ESP_OK && strcmp(fullpath, last_displayed_image) == 0) {
+                ESP_LOGW(TAG, "Could not avoid repeating last image after 10 attempts");
             }
         }
-        closedir(dir);
-    }
+        if (err != ESP_OK) {
+            continue;
+        }
 
-    // Update total_image_count to actual number of images found
-    total_image_count = idx;
+        ESP_LOGI(TAG, "Auto-rotate: Displaying random image %d/%d: %s", random_index + 1, total,
+                 fullpath);
+        display_show_album_image(fullpath, total);
 
-    if (total_image_count == 0) {
-        ESP_LOGW(TAG, "No displayable images found in enabled albums");
-        free(image_list);
+        // Store the displayed image filename in NVS
+        save_last_displayed_image(fullpath);
         return;
     }
+    ESP_LOGW(TAG, "Random rotation could not resolve an image");
+}
+
+static void rotate_shuffle(char **enabled_albums, int album_count, int *counts)
+{
+    ESP_LOGI(TAG, "Shuffle rotation mode");
 
-    // Load last displayed image if not already loaded
     if (last_displayed_image[0] == '\0') {
         load_last_displayed_image();
     }
 
-    // Select random image, avoiding the last displayed image if possible
-    int random_index = esp_random() % total_image_count;
-
-    // If we have more than one image and the random selection matches the last image,
-    // try to pick a different one (up to 10 attempts)
-    if (total_image_count > 1 && last_displayed_image[0] != '\0') {
-        int attempts = 0;
-        while (attempts < 10 && strcmp(image_list[random_index], last_displayed_image) == 0) {
-            random_index = esp_random() % total_image_count;
-            attempts++;
+    shuffle_bag_t bag;
+    config_manager_get_shuffle_bag(&bag);
+    char fullpath[512];
+
+    // Each enabled album owns a fixed slot of bag positions, so an upload
+    // only raises its album's count and the new image joins the current
+    // round. Once a delete or re-index has moved images within an album, or
+    // the enabled albums change, a new round starts rather than skipping or
+    // repeating images. A vanished file re-indexes its album, which ends the
+    // round the same way.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t layout;
+        int total = count_album_images(enabled_albums, album_count, counts, &layout);
+        if (total == 0) {
+            ESP_LOGW(TAG, "No images found in enabled albums");
+            return;
         }
 
-        if (strcmp(image_list[random_index], last_displayed_image) == 0) {
-            ESP_LOGW(TAG, "Could not avoid repeating last image after 10 attempts");
+        int album;
+        uint32_t index;
+        esp_err_t err = ESP_ERR_NOT_FOUND;
+        if (shuffle_bag_next_slot(&bag, counts, album_count, layout, &album, &index)) {
+            err = album_index_get(enabled_albums[album], (int) index, fullpath, sizeof(fullpath),
+                                  NULL);
         } else {
-            ESP_LOGI(TAG, "Successfully avoided repeating last image");
+            // Round over: start a new one, re-seeding (a few times at most)
+            // rather than opening with the image the last round ended on
+            ESP_LOGI(TAG, "Starting a new shuffle round over %d image(s)", total);
+            int tries = 0;
+            do {
+                shuffle_bag_reset_slots(&bag, esp_random(), album_count, layout);
+                if (!shuffle_bag_next_slot(&bag, counts, album_count, layout, &album, &index)) {
+                    break;  // every image sits past its album's slot
+                }
+                err = album_index_get(enabled_albums[album], (int) index, fullpath,
+                                      sizeof(fullpath), NULL);
+            } while (err == ESP_OK && total > 1 && ++tries < 4 &&
+                     strcmp(fullpath, last_displayed_image) == 0);
+        }
+        if (err != ESP_OK) {
+            continue;
         }
-    }
-
-    // Display random image
-    ESP_LOGI(TAG, "Auto-rotate: Displaying random image %d/%d: %s", random_index + 1,
-             total_image_count, image_list[random_index]);
-    display_manager_show_image(image_list[random_index]);
-
-    // Store the displayed image filename in NVS
-    save_last_displayed_image(image_list[random_index]);
 
-    // Free image list
-    for (int i = 0; i < total_image_count; i++) {
-        free(image_list[i]);
+        ESP_LOGI(TAG, "Auto-rotate: Displaying shuffled image %lu of album %s: %s",
+                 (unsigned long) index + 1, enabled_albums[album], fullpath);
+        display_show_album_image(fullpath, total);
+        save_last_displayed_image(fullpath);
+        config_manager_set_shuffle_bag(&bag);
+        return;
     }
-    free(image_list);
+    ESP_LOGW(TAG, "Shuffle rotation could not resolve an image");
 }
 
 void display_manager_rotate_from_storage(void)
@@ -759,11 +1511,17 @@ void display_manager_rotate_from_storage(void)
     // Get rotation mode
     sd_rotation_mode_t mode = config_manager_get_sd_rotation_mode();
 
-    if (mode == SD_ROTATION_SEQUENTIAL) {
-        rotate_sequential(enabled_albums, album_count);
+    int *counts = malloc(album_count * sizeof(int));
+    if (!counts) {
+        ESP_LOGE(TAG, "Failed to allocate album counts");
+    } else if (mode == SD_ROTATION_SEQUENTIAL) {
+        rotate_sequential(enabled_albums, album_count, counts);
+    } else if (mode == SD_ROTATION_SHUFFLE) {
+        rotate_shuffle(enabled_albums, album_count, counts);
     } else {
-        rotate_random(enabled_albums, album_count);
+        rotate_random(enabled_albums, album_count, counts);
     }
+    free(counts);
 
     album_manager_free_album_list(enabled_albums, album_count);
     ESP_LOGI(TAG, "Rotation complete");
@@ -12,7 +12,12 @@ esp_err_t display_manager_show_image(const char *filename);
 
 esp_err_t display_manager_show_calibration(void);
 esp_err_t display_manager_clear(void);
+// True while a frame is being drawn or the panel is still refreshing,
+// including a background refresh (CONFIG_DISPLAY_DOUBLE_BUFFER)
 bool display_manager_is_busy(void);
+// Block until a background refresh (CONFIG_DISPLAY_DOUBLE_BUFFER) has
+// finished; returns at once otherwise. Call before powering the panel down.
+void display_manager_wait_idle(void);
 void display_manager_rotate_from_storage(void);
 const char *display_manager_get_current_image(void);
 void display_manager_initialize_paint(void);
@@ -61,8 +66,70 @@ esp_err_t display_manager_push_rgb_row(int y, const uint8_t *rgb_row, int width)
 // Column variant for rotated streaming: paints pixels (x, 0..height-1). Used
 // when rows are produced in processing-space order on a rotated orientation.
 esp_err_t display_manager_push_rgb_column(int x, const uint8_t *rgb_col, int height);
+// Tile variant: paints count adjacent columns x0..x0+count-1, cols[i] being
+// column x0 + i. Each display row of the tile is written as one span.
+esp_err_t display_manager_push_rgb_columns(int x0, int count, const uint8_t *const *cols,
+                                           int height);
 // Returns ESP_ERR_NOT_FINISHED when the display succeeded but the snapshot
 // failed (the fallback_name, when given, has been published in its place).
 esp_err_t display_manager_end_rgb_stream(bool show, const display_publish_t *pub);
 
+/**
+ * @brief Patch a rectangle of the displayed frame
+ *
+ * begin acquires the display like display_manager_begin_rgb_stream but keeps
+ * the frame the panel shows instead of clearing it (restoring it from the
+ * current image when the buffer no longer holds it). Only the patched spans
+ * are repainted; display_manager_end_rgb_stream then refreshes and publishes
+ * the whole frame as usual, which the IT8951 driver turns into an update of
+ * just the changed area. Returns ESP_ERR_INVALID_STATE (display released)
+ * when the displayed frame cannot be recovered.
+ */
+esp_err_t display_manager_begin_patch(void);
+// Paint n RGB pixels from (x, y) rightwards
+esp_err_t display_manager_patch_row(int x, int y, const uint8_t *rgb, int n);
+// Paint n RGB pixels from (x, y) downwards
+esp_err_t display_manager_patch_column(int x, int y, const uint8_t *rgb, int n);
+// Tile variant: paints count adjacent columns from (x0, y) downwards, cols[i]
+// being column x0 + i. Each display row of the tile is written as one span.
+esp_err_t display_manager_patch_columns(int x0, int y, int count, const uint8_t *const *cols,
+                                        int n);
+
+/**
+ * @brief Read back the frame the panel shows
+ *
+ * read_frame holds the display only while it copies the frame (restoring it
+ * from the current image when the buffer no longer holds it), keeping every
+ * shrink-th pixel, and records the frame's generation, which changes with
+ * every refresh. Fails with ESP_ERR_TIMEOUT while a display is in progress,
+ * ESP_ERR_INVALID_STATE when the frame is unknown and ESP_ERR_NO_MEM.
+ * write_frame_png encodes the copy as a 4-bit indexed PNG and hands it to
+ * write in pieces of at most 4 KB (a non-zero return aborts); a slow writer
+ * therefore never holds up the display.
+ */
+typedef struct {
+    uint32_t generation;
+    uint16_t width;
+    uint16_t height;
+    bool grayscale;
+    uint8_t *rows;  // packed 4bpp logical rows, PSRAM
+} display_frame_t;
+
+typedef int (*display_write_fn)(void *ctx, const uint8_t *data, size_t len);
+uint32_t display_manager_get_generation(void);
+esp_err_t display_manager_read_frame(int shrink, display_frame_t *frame);
+esp_err_t display_manager_write_frame_png(const display_frame_t *frame, display_write_fn write,
+                                          void *ctx);
+void display_manager_free_frame(display_frame_t *frame);
+
+/**
+ * @brief Render an image file into a panel-native .epdgz file
+ *
+ * src is decoded exactly as display_manager_show_image would (PNG, BMP or
+ * .epdgz) into a scratch frame, which is deflated to dst; the panel and the
+ * shown frame are left alone. Fails with ESP_ERR_TIMEOUT while a display is
+ * in progress.
+ */
+esp_err_t display_manager_render_to_epdgz(const char *src, const char *dst);
+
 #endif
@@ -0,0 +1,226 @@
+#include "frame_store.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+
+static const char *TAG = "frame_store";
+
+#define FRAME_STORE_MAGIC 0x31534D46  // "FMS1"
+// Slots are whole MMU pages, which are also whole erase blocks
+#define SLOT_ALIGN 0x10000
+#define SLOT_DATA_OFFSET 256
+#define SLOT_LIVE 0xFFFFFFFF
+
+typedef struct {
+    uint32_t magic;     // written last; erased (0xFFFFFFFF) until committed
+    uint32_t live;      // cleared in place when the frame is superseded
+    uint32_t sequence;  // write order, for the round robin
+    uint32_t layout;
+    uint32_t stamp;
+    uint32_t length;
+    char key[FRAME_STORE_KEY_MAX];
+} slot_header_t;
+
+_Static_assert(sizeof(slot_header_t) == SLOT_DATA_OFFSET, "slot header must fill its space");
+
+static const esp_partition_t *partition = NULL;
+static uint32_t slot_size;
+static int slot_count;
+static int next_slot;  // slot the next write erases
+static uint32_t next_sequence;
+
+static size_t slot_offset(int slot)
+{
+    return (size_t) slot * slot_size;
+}
+
+// Header of a committed slot; false for an empty or half-written one
+static bool read_header(int slot, slot_header_t *hdr)
+{
+    if (esp_partition_read(partition, slot_offset(slot), hdr, sizeof(*hdr)) != ESP_OK) {
+        return false;
+    }
+    hdr->key[FRAME_STORE_KEY_MAX - 1] = '\0';
+    return hdr->magic == FRAME_STORE_MAGIC && hdr->length <= slot_size - SLOT_DATA_OFFSET;
+}
+
+esp_err_t frame_store_init(size_t frame_bytes)
+{
+    partition = NULL;
+    slot_count = 0;
+
+    const esp_partition_t *part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, FRAME_STORE_PARTITION_LABEL);
+    if (!part) {
+        ESP_LOGI(TAG, "No frame store partition");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    slot_size = (SLOT_DATA_OFFSET + frame_bytes + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    if (part->size < slot_size) {
+        ESP_LOGW(TAG, "Frame store partition (%lu bytes) holds no %lu-byte slot",
+                 (unsigned long) part->size, (unsigned long) slot_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    partition = part;
+    slot_count = part->size / slot_size;
+
+    // Resume the round robin after the newest committed slot
+    int frames = 0;
+    int newest = -1;
+    uint32_t newest_sequence = 0;
+    for (int i = 0; i < slot_count; i++) {
+        slot_header_t hdr;
+        if (!read_header(i, &hdr)) {
+            continue;
+        }
+        if (hdr.live == SLOT_LIVE) {
+            frames++;
+        }
+        if (newest < 0 || (int32_t) (hdr.sequence - newest_sequence) > 0) {
+            newest = i;
+            newest_sequence = hdr.sequence;
+        }
+    }
+    next_slot = newest < 0 ? 0 : (newest + 1) % slot_count;
+    next_sequence = newest < 0 ? 0 : newest_sequence + 1;
+
+    ESP_LOGI(TAG, "Frame store: %d slots of %lu bytes, %d frames", slot_count,
+             (unsigned long) slot_size, frames);
+    return ESP_OK;
+}
+
+int frame_store_slot_count(void)
+{
+    return partition ? slot_count : 0;
+}
+
+// Slot holding the live frame for key, or -1
+static int find_slot(const char *key, slot_header_t *hdr)
+{
+    for (int i = 0; i < frame_store_slot_count(); i++) {
+        if (read_header(i, hdr) && hdr->live == SLOT_LIVE && strcmp(hdr->key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t frame_store_find(const char *key, uint32_t stamp, uint32_t layout,
+                           frame_store_frame_t *frame)
+{
+    slot_header_t hdr;
+    int slot = find_slot(key, &hdr);
+    if (slot < 0 || hdr.stamp != stamp || hdr.layout != layout) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void *ptr = NULL;
+    esp_err_t err = esp_partition_mmap(partition, slot_offset(slot) + SLOT_DATA_OFFSET, hdr.length,
+                                       ESP_PARTITION_MMAP_DATA, &ptr, &frame->handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to map slot %d", slot);
+        return err;
+    }
+    frame->data = (const uint8_t *) ptr;
+    frame->length = hdr.length;
+    return ESP_OK;
+}
+
+void frame_store_release(frame_store_frame_t *frame)
+{
+    if (frame->data) {
+        esp_partition_munmap(frame->handle);
+        frame->data = NULL;
+    }
+}
+
+void frame_store_forget(const char *key)
+{
+    slot_header_t hdr;
+    int slot;
+    // NOR flash can clear bits without an erase
+    while ((slot = find_slot(key, &hdr)) >= 0) {
+        uint32_t retired = 0;
+        if (esp_partition_write(partition, slot_offset(slot) + offsetof(slot_header_t, live),
+                                &retired, sizeof(retired)) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to retire slot %d", slot);
+            return;
+        }
+    }
+}
+
+esp_err_t frame_store_begin(const char *key, uint32_t stamp, uint32_t layout, uint32_t length,
+                            frame_store_writer_t *writer)
+{
+    if (!partition) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (strlen(key) >= FRAME_STORE_KEY_MAX || length > slot_size - SLOT_DATA_OFFSET) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    frame_store_forget(key);
+
+    // The slot counts as used from its erase on, so an abandoned write
+    // still moves the round robin along
+    writer->slot = next_slot;
+    next_slot = (next_slot + 1) % slot_count;
+    esp_err_t err = esp_partition_erase_range(partition, slot_offset(writer->slot), slot_size);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase slot %d", writer->slot);
+        return err;
+    }
+
+    writer->written = 0;
+    writer->length = length;
+    writer->stamp = stamp;
+    writer->layout = layout;
+    strcpy(writer->key, key);
+    return ESP_OK;
+}
+
+esp_err_t frame_store_append(frame_store_writer_t *writer, const void *data, size_t len)
+{
+    if (len > writer->length - writer->written) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = esp_partition_write(
+        partition, slot_offset(writer->slot) + SLOT_DATA_OFFSET + writer->written, data, len);
+    if (err == ESP_OK) {
+        writer->written += len;
+    }
+    return err;
+}
+
+esp_err_t frame_store_commit(frame_store_writer_t *writer)
+{
+    if (writer->written != writer->length) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    slot_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = 0xFFFFFFFF;  // left erased until the rest is down
+    hdr.live = SLOT_LIVE;
+    hdr.sequence = next_sequence;
+    hdr.layout = writer->layout;
+    hdr.stamp = writer->stamp;
+    hdr.length = writer->length;
+    strcpy(hdr.key, writer->key);
+
+    size_t offset = slot_offset(writer->slot);
+    esp_err_t err = esp_partition_write(partition, offset, &hdr, sizeof(hdr));
+    if (err == ESP_OK) {
+        uint32_t magic = FRAME_STORE_MAGIC;
+        err = esp_partition_write(partition, offset, &magic, sizeof(magic));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit slot %d", writer->slot);
+        return err;
+    }
+    next_sequence++;
+    ESP_LOGI(TAG, "Stored frame for %s in slot %d", writer->key, writer->slot);
+    return ESP_OK;
+}
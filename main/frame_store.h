@@ -0,0 +1,105 @@
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+// Raw image-store partition: rendered frames in fixed-size slots
+//
+// Boards without an SD card keep their photos in LittleFS, so each rotation
+// reads a file through the VFS and the LittleFS block cache and then
+// inflates or decodes it. The frame store keeps the finished frames of a
+// small gallery in a dedicated data partition instead, one per slot, as
+// packed 4bpp logical rows (the .epdgz payload, uninflated). Showing a
+// stored frame maps its slot with esp_partition_mmap and copies the rows
+// into the frame buffer straight from flash: no file system, no inflate, no
+// heap beyond the mapping.
+//
+// Each slot is a 256-byte header followed by the rows, rounded up to the
+// 64 KB MMU page so slots map and erase on whole blocks. Slots are written
+// strictly round robin (the one after the newest), so every slot is erased
+// equally often; a write erases the whole slot, programs the rows and then
+// the header, whose magic goes last so a slot interrupted mid-write reads
+// as empty. Superseded frames are retired by clearing a flag in place,
+// without an erase.
+//
+// Frames are found by key (the source image path) and must also match the
+// caller's stamp (source version) and layout (frame geometry) tags. Not
+// thread safe: the display manager calls it under its mutex.
+
+#define FRAME_STORE_PARTITION_LABEL "frames"
+// Longest key, terminator included
+#define FRAME_STORE_KEY_MAX 232
+
+typedef struct {
+    const uint8_t *data;  // mapped rows, valid until frame_store_release
+    uint32_t length;
+    esp_partition_mmap_handle_t handle;
+} frame_store_frame_t;
+
+typedef struct {
+    int slot;
+    uint32_t written;
+    uint32_t length;
+    uint32_t stamp;
+    uint32_t layout;
+    char key[FRAME_STORE_KEY_MAX];
+} frame_store_writer_t;
+
+/**
+ * @brief Find the frame store partition and scan its slots
+ *
+ * @param frame_bytes Size of one frame; sets the slot size
+ * @return ESP_ERR_NOT_FOUND without the partition, ESP_ERR_INVALID_SIZE
+ *         when not even one frame fits
+ */
+esp_err_t frame_store_init(size_t frame_bytes);
+
+/**
+ * @brief Number of slots, 0 when the store is unavailable
+ */
+int frame_store_slot_count(void);
+
+/**
+ * @brief Map the stored frame for key, stamp and layout
+ *
+ * @return ESP_OK with frame filled in; ESP_ERR_NOT_FOUND on a miss
+ */
+esp_err_t frame_store_find(const char *key, uint32_t stamp, uint32_t layout,
+                           frame_store_frame_t *frame);
+
+/**
+ * @brief Unmap a frame returned by frame_store_find
+ */
+void frame_store_release(frame_store_frame_t *frame);
+
+/**
+ * @brief Start writing a frame of length bytes into the next slot
+ *
+ * Retires any frame already stored under key and erases the slot. The
+ * frame becomes visible at frame_store_commit; a writer that is dropped
+ * before that leaves the slot empty.
+ */
+esp_err_t frame_store_begin(const char *key, uint32_t stamp, uint32_t layout, uint32_t length,
+                            frame_store_writer_t *writer);
+
+/**
+ * @brief Append frame data; the total must not exceed the declared length
+ */
+esp_err_t frame_store_append(frame_store_writer_t *writer, const void *data, size_t len);
+
+/**
+ * @brief Publish a fully written frame
+ */
+esp_err_t frame_store_commit(frame_store_writer_t *writer);
+
+/**
+ * @brief Retire the frame stored under key, if any
+ */
+void frame_store_forget(const char *key);
+
+#endif
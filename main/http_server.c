@@ -2,6 +2,7 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,8 +11,12 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "album_index.h"
 #include "album_manager.h"
+#include "album_pack.h"
+#include "album_transcode.h"
 #include "board_hal.h"
+#include "bookkeeping.h"
 #include "cJSON.h"
 #include "color_palette.h"
 #include "config.h"
@@ -381,6 +386,7 @@ static esp_err_t send_display_success(httpd_req_t *req)
     cJSON *response = cJSON_CreateObject();
     cJSON_AddStringToObject(response, "status", "success");
     cJSON_AddStringToObject(response, "message", "Image displayed successfully");
+    cJSON_AddBoolToObject(response, "sourceCached", image_processor_source_cache_hit());
     char *json_str = cJSON_Print(response);
     httpd_resp_set_type(req, "application/json");
     esp_err_t send_err = httpd_resp_sendstr(req, json_str);
@@ -470,7 +476,7 @@ static esp_err_t display_received_image(httpd_req_t *req, const char *image_path
 
         esp_err_t err = display_flow_stream_file(image_path, format,
                                                  processing_settings_get_dithering_algorithm(),
-                                                 &pub, !storage_has_persistent_storage());
+                                                 &pub, !storage_staging_is_persistent());
         if (err != ESP_OK) {
             unlink(image_path);
             if (has_thumbnail)
@@ -595,6 +601,19 @@ static esp_err_t display_image_direct_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
+    // ?cache=1 keeps the decoded source around so re-sending the same image
+    // with different processing settings skips decode and resampling; any
+    // request without it releases the cache
+    bool use_cache = false;
+    char query[64];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char cache_param[8];
+        if (httpd_query_key_value(query, "cache", cache_param, sizeof(cache_param)) == ESP_OK) {
+            use_cache = strcmp(cache_param, "1") == 0 || strcmp(cache_param, "true") == 0;
+        }
+    }
+    image_processor_set_source_cache(use_cache);
+
     // Get content type to determine if it's JPG, BMP, PNG, or multipart
     char content_type[128] = {0};
     if (httpd_req_get_hdr_value_str(req, "Content-Type", content_type, sizeof(content_type)) !=
@@ -605,7 +624,7 @@ static esp_err_t display_image_direct_handler(httpd_req_t *req)
     if (strstr(content_type, "multipart/form-data") != NULL) {
         // Multipart upload with an optional pre-rendered thumbnail
         multipart_result_t result;
-        esp_err_t err = parse_multipart_upload(req, FS_MOUNT_POINT, ".current_upload.tmp",
+        esp_err_t err = parse_multipart_upload(req, STAGING_MOUNT_POINT, ".current_upload.tmp",
                                                ".current_thumb.tmp", &result, false);
         if (err != ESP_OK) {
             return ESP_FAIL;
@@ -657,6 +676,123 @@ static esp_err_t display_image_direct_handler(httpd_req_t *req)
     return display_received_image(req, CURRENT_UPLOAD_PATH, format, NULL);
 }
 
+// POST /api/display-region?x=&y=&w=&h= -- patch one rectangle of the
+// displayed image. The body is a PNG or JPG (scaled into the rectangle and
+// dithered) or, as application/octet-stream, packed 4bpp framebuffer values
+// painted verbatim. Coordinates are in the displayed orientation.
+static esp_err_t display_region_handler(httpd_req_t *req)
+{
+    if (!system_ready) {
+        httpd_resp_set_status(req, HTTPD_503);
+        httpd_resp_sendstr(req, "System is still initializing");
+        return ESP_FAIL;
+    }
+
+    power_manager_reset_sleep_timer();
+
+    if (display_manager_is_busy()) {
+        ESP_LOGW(TAG, "Display is busy, rejecting request");
+        cJSON *response = cJSON_CreateObject();
+        cJSON_AddStringToObject(response, "status", "busy");
+        cJSON_AddStringToObject(response, "message", "Display is currently updating, please wait");
+
+        char *json_str = cJSON_Print(response);
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, json_str);
+
+        free(json_str);
+        cJSON_Delete(response);
+        return ESP_OK;
+    }
+
+    int rect[4];
+    const char *keys[4] = {"x", "y", "w", "h"};
+    char query[96];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing x, y, w and h parameters");
+        return ESP_FAIL;
+    }
+    for (int i = 0; i < 4; i++) {
+        char value[12];
+        char *end = value;
+        if (httpd_query_key_value(query, keys[i], value, sizeof(value)) == ESP_OK) {
+            rect[i] = (int) strtol(value, &end, 10);
+        }
+        if (end == value || *end != '\0') {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing x, y, w and h parameters");
+            return ESP_FAIL;
+        }
+    }
+
+    char content_type[128] = {0};
+    if (httpd_req_get_hdr_value_str(req, "Content-Type", content_type, sizeof(content_type)) !=
+        ESP_OK) {
+        strcpy(content_type, "image/jpeg");  // Default to JPEG, as for direct display
+    }
+
+    image_format_t format = IMAGE_FORMAT_UNKNOWN;
+    if (strstr(content_type, "image/png")) {
+        format = IMAGE_FORMAT_PNG;
+    } else if (strstr(content_type, "image/jpeg")) {
+        format = IMAGE_FORMAT_JPG;
+    } else if (strstr(content_type, "application/octet-stream")) {
+        format = IMAGE_FORMAT_RAW_4BPP;
+    } else {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unsupported region format");
+        return ESP_FAIL;
+    }
+
+    if (receive_raw_body(req, CURRENT_UPLOAD_PATH) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    uint8_t *buf = NULL;
+    size_t size = 0;
+    esp_err_t err = display_flow_read_file(CURRENT_UPLOAD_PATH, &buf, &size);
+    unlink(CURRENT_UPLOAD_PATH);
+    if (err != ESP_OK) {
+        send_process_error(req, err);
+        return ESP_FAIL;
+    }
+
+    // The patched frame is no longer any original: snapshot it as the
+    // current image. The snapshot is kept even with staging in RAM so the
+    // link never names a missing file; if it cannot be saved, no link is
+    // published.
+    display_publish_t pub = {
+        .display_name = CURRENT_EPD_PATH,
+        .save_path = CURRENT_EPD_PATH,
+        .fallback_name = NULL,
+    };
+    err = image_processor_process_region(buf, size, format, rect[0], rect[1], rect[2], rect[3],
+                                         processing_settings_get_dithering_algorithm(), &pub);
+    heap_caps_free(buf);
+
+    if (err == ESP_ERR_INVALID_ARG) {
+        const char *detail = image_processor_get_last_error();
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, detail[0] ? detail : "Invalid region");
+        return ESP_FAIL;
+    }
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "The displayed image is unknown; display a full image first");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK && err != ESP_ERR_NOT_FINISHED) {
+        send_process_error(req, err);
+        return ESP_FAIL;
+    }
+
+    if (err == ESP_OK) {
+        display_flow_keep_frame_snapshot();
+    } else {
+        display_flow_drop_stale_current(NULL, false);
+    }
+    ha_notify_update();
+    return send_display_success(req);
+}
+
 // URL decode helper function to handle encoded characters like %20 for space
 static void url_decode(char *dst, const char *src, size_t dst_size)
 {
@@ -788,6 +924,21 @@ static esp_err_t upload_image_handler(httpd_req_t *req)
 
     ESP_LOGI(TAG, "Image saved successfully: %s (thumbnail: %s)", dest_filename, jpg_filename);
 
+    // Indexing moves the files into the album's pack when it has one, so it
+    // comes last
+    bool indexed = false;
+#if CONFIG_ALBUM_TRANSCODE_ON_INGEST
+    // Keep the panel-native rendering instead, so rotations skip the PNG
+    // decode; if the display is busy the PNG stays as uploaded
+    if (strcmp(file_ext, ".png") == 0) {
+        indexed = album_transcode_file(final_dest_path, final_dest_path,
+                                       sizeof(final_dest_path)) == ESP_OK;
+    }
+#endif
+    if (!indexed) {
+        album_index_note_added(final_dest_path);
+    }
+
     cJSON *response = cJSON_CreateObject();
     cJSON_AddStringToObject(response, "status", "success");
     cJSON_AddStringToObject(response, "filepath", final_dest_path);
@@ -888,9 +1039,14 @@ static esp_err_t serve_image_handler(httpd_req_t *req)
         }
     }
 
+    // Images of a packed album, thumbnails included, are read from its pack
+    album_pack_blob_t blob = {0};
     if (!fp) {
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Image not found");
-        return ESP_FAIL;
+        snprintf(filepath, sizeof(filepath), "%s/%s", IMAGE_DIRECTORY, decoded_filename);
+        if (album_pack_open(filepath, &blob) != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Image not found");
+            return ESP_FAIL;
+        }
     }
 
     httpd_resp_set_type(req, content_type);
@@ -899,14 +1055,23 @@ static esp_err_t serve_image_handler(httpd_req_t *req)
 
     char buffer[1024];
     size_t read_bytes;
-    while ((read_bytes = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+    esp_err_t err = ESP_OK;
+    while ((read_bytes = fp ? fread(buffer, 1, sizeof(buffer), fp)
+                            : album_pack_blob_read(&blob, buffer, sizeof(buffer))) > 0) {
         if (httpd_resp_send_chunk(req, buffer, read_bytes) != ESP_OK) {
-            fclose(fp);
-            return ESP_FAIL;
+            err = ESP_FAIL;
+            break;
         }
     }
 
-    fclose(fp);
+    if (fp) {
+        fclose(fp);
+    } else {
+        album_pack_blob_close(&blob);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
     httpd_resp_send_chunk(req, NULL, 0);
 
     return ESP_OK;
@@ -978,15 +1143,17 @@ static esp_err_t delete_image_handler(httpd_req_t *req)
     // Delete JSON before file operations
     cJSON_Delete(root);
 
-    if (unlink(filepath) != 0) {
+    if (unlink(filepath) == 0) {
+        // Delete thumbnail (ignore errors if it doesn't exist)
+        unlink(jpg_path);
+        album_index_note_removed(filepath);
+    } else if (album_pack_remove(filepath) != ESP_OK) {
+        // Not a loose file, nor an image of a packed album
         ESP_LOGE(TAG, "Failed to delete file: %s", filepath);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to delete file");
         return ESP_FAIL;
     }
 
-    // Delete thumbnail (ignore errors if it doesn't exist)
-    unlink(jpg_path);
-
     ESP_LOGI(TAG, "Image deleted successfully: %s", filepath_copy);
 
     cJSON *response = cJSON_CreateObject();
@@ -1259,6 +1426,65 @@ static esp_err_t rotate_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static int send_frame_chunk(void *ctx, const uint8_t *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *) ctx, (const char *) data, len) == ESP_OK ? 0 : 1;
+}
+
+// Stream the live framebuffer as a 4-bit indexed PNG. The ETag names the
+// display generation, so repeat polls get 304 until the panel changes.
+static esp_err_t send_frame_png(httpd_req_t *req, int shrink)
+{
+    char etag[32];
+    snprintf(etag, sizeof(etag), "\"fb-%08lx-%d\"",
+             (unsigned long) display_manager_get_generation(), shrink);
+
+    char if_none_match[48];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) ==
+            ESP_OK &&
+        strcmp(if_none_match, etag) == 0) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_set_hdr(req, "ETag", etag);
+        httpd_resp_send(req, NULL, 0);
+        return ESP_OK;
+    }
+
+    // The display is held only for the copy, not for the encode and send
+    display_frame_t frame;
+    esp_err_t err = display_manager_read_frame(shrink, &frame);
+    if (err == ESP_ERR_TIMEOUT) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "30");
+        httpd_resp_sendstr(req, "Display is currently updating, please wait");
+        return ESP_FAIL;
+    }
+    if (err == ESP_ERR_NO_MEM) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No image currently displayed");
+        return ESP_FAIL;
+    }
+
+    // Tag the frame actually rendered, in case a refresh landed in between
+    snprintf(etag, sizeof(etag), "\"fb-%08lx-%d\"", (unsigned long) frame.generation, shrink);
+    ESP_LOGI(TAG, "Rendering current frame as PNG (1/%d)", shrink);
+    httpd_resp_set_type(req, "image/png");
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    err = display_manager_write_frame_png(&frame, send_frame_chunk, req);
+    display_manager_free_frame(&frame);
+    if (err != ESP_OK) {
+        // Headers are already out; dropping the connection is all that's left
+        ESP_LOGW(TAG, "Failed to stream current frame");
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
 static esp_err_t current_image_handler(httpd_req_t *req)
 {
     if (!system_ready) {
@@ -1267,11 +1493,40 @@ static esp_err_t current_image_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    // ?render=1 always renders the framebuffer; ?shrink=N (1..8) keeps
+    // every Nth pixel of the render for a cheaper preview
+    bool render = false;
+    int shrink = 1;
+    char query[64];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char param[8];
+        if (httpd_query_key_value(query, "render", param, sizeof(param)) == ESP_OK) {
+            render = strcmp(param, "1") == 0 || strcmp(param, "true") == 0;
+        }
+        if (httpd_query_key_value(query, "shrink", param, sizeof(param)) == ESP_OK) {
+            shrink = atoi(param);
+            if (shrink < 1 || shrink > 8) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "shrink must be 1..8");
+                return ESP_FAIL;
+            }
+        }
+    }
+
+    if (render) {
+        return send_frame_png(req, shrink);
+    }
+
     const char *content_type = NULL;
     FILE *fp = display_flow_open_current(&content_type);
     if (!fp) {
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No image currently displayed");
-        return ESP_FAIL;
+        struct stat st;
+        if (stat(CURRENT_IMAGE_LINK, &st) != 0) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No image currently displayed");
+            return ESP_FAIL;
+        }
+        // No browser-displayable file (e.g. an album .epdgz without a .jpg
+        // sibling, or a region-patched frame): render what the panel shows
+        return send_frame_png(req, shrink);
     }
     ESP_LOGI(TAG, "Serving current image (%s)", content_type);
 
@@ -1408,10 +1663,9 @@ static esp_err_t config_handler(httpd_req_t *req)
         cJSON_AddStringToObject(root, "rotation_mode", rotation_mode_str);
 
         // Auto Rotate - SDCARD
-        cJSON_AddStringToObject(root, "sd_rotation_mode",
-                                config_manager_get_sd_rotation_mode() == SD_ROTATION_SEQUENTIAL
-                                    ? "sequential"
-                                    : "random");
+        cJSON_AddStringToObject(
+            root, "sd_rotation_mode",
+            config_manager_sd_rotation_mode_name(config_manager_get_sd_rotation_mode()));
 
         // Auto Rotate - URL
         const char *image_url = config_manager_get_image_url();
@@ -1469,7 +1723,7 @@ static esp_err_t config_handler(httpd_req_t *req)
         }
         char *buf = malloc(buf_size);
         if (!buf) {
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
             return ESP_FAIL;
         }
 
@@ -1749,6 +2003,102 @@ static esp_err_t album_enabled_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// Move an album's images into a single-file pack (album_pack.c). Repeating
+// it packs images that were copied into the album directory since.
+static esp_err_t album_pack_handler(httpd_req_t *req)
+{
+    if (!system_ready) {
+        httpd_resp_set_status(req, HTTPD_503);
+        httpd_resp_sendstr(req, "System not ready");
+        return ESP_OK;
+    }
+    if (!storage_has_persistent_storage()) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Storage not found");
+        return ESP_FAIL;
+    }
+
+    char query[256];
+    char album_name[128];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "name", album_name, sizeof(album_name)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing album name parameter");
+        return ESP_FAIL;
+    }
+    char decoded_album_name[128];
+    url_decode(decoded_album_name, album_name, sizeof(decoded_album_name));
+
+    if (!album_manager_album_exists(decoded_album_name)) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Album not found");
+        return ESP_FAIL;
+    }
+
+    power_manager_reset_sleep_timer();
+
+    int packed = 0;
+    esp_err_t err = album_pack_build(decoded_album_name, &packed);
+    // The pack now indexes the album itself
+    album_index_drop(decoded_album_name);
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to pack album");
+        return ESP_FAIL;
+    }
+
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddStringToObject(response, "status", "success");
+    cJSON_AddNumberToObject(response, "packed", packed);
+    char *json_str = cJSON_Print(response);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, json_str);
+    free(json_str);
+    cJSON_Delete(response);
+    return ESP_OK;
+}
+
+// Album listings are read from the album index a batch at a time and sent
+// in chunks, so neither the listing nor a JSON tree of it is held in RAM
+#define ALBUM_LISTING_BATCH 16
+#define ALBUM_LISTING_CHUNK 2048
+
+typedef struct {
+    httpd_req_t *req;
+    char *buf;
+    size_t used;
+} listing_writer_t;
+
+static esp_err_t listing_write(listing_writer_t *w, const char *text)
+{
+    size_t len = strlen(text);
+    if (w->used + len > ALBUM_LISTING_CHUNK) {
+        if (w->used > 0 && httpd_resp_send_chunk(w->req, w->buf, w->used) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        w->used = 0;
+        if (len > ALBUM_LISTING_CHUNK) {
+            return httpd_resp_send_chunk(w->req, text, len);
+        }
+    }
+    memcpy(w->buf + w->used, text, len);
+    w->used += len;
+    return ESP_OK;
+}
+
+// Parse an optional non-negative integer query parameter. Returns false
+// only when the parameter is present but malformed.
+static bool query_get_count(const char *query, const char *key, int *out)
+{
+    char value[12];
+    if (httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+        return true;
+    }
+    char *end = value;
+    long v = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || v < 0 || v > INT32_MAX) {
+        return false;
+    }
+    *out = (int) v;
+    return true;
+}
+
 static esp_err_t album_images_handler(httpd_req_t *req)
 {
     if (!system_ready) {
@@ -1763,9 +2113,17 @@ static esp_err_t album_images_handler(httpd_req_t *req)
 
     char query[256];
     char album_name[128] = "";
+    int offset = 0;
+    int limit = -1;  // everything from offset on
 
     if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
         httpd_query_key_value(query, "album", album_name, sizeof(album_name));
+        if (!query_get_count(query, "offset", &offset) ||
+            !query_get_count(query, "limit", &limit)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                "offset and limit must be non-negative integers");
+            return ESP_FAIL;
+        }
     }
 
     if (strlen(album_name) == 0) {
@@ -1784,54 +2142,98 @@ static esp_err_t album_images_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    DIR *dir = opendir(album_path);
-    if (!dir) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to open album directory");
+    int total = 0;
+    uint32_t generation = 0;
+    esp_err_t err = album_index_stat(decoded_album_name, &total, &generation);
+    if (err == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Album not found");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to index album");
         return ESP_FAIL;
     }
 
-    cJSON *response = cJSON_CreateArray();
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_type == DT_REG) {
-            if (entry->d_name[0] == '.' && entry->d_name[1] == '_') {
-                continue;
-            }
-            const char *ext = strrchr(entry->d_name, '.');
-            if (ext && (strcasecmp(ext, ".bmp") == 0 || strcasecmp(ext, ".png") == 0 ||
-                        strcasecmp(ext, ".epdgz") == 0)) {
-                cJSON *image_obj = cJSON_CreateObject();
-                cJSON_AddStringToObject(image_obj, "filename", entry->d_name);
-                cJSON_AddStringToObject(image_obj, "album", decoded_album_name);
-
-                // Check if a corresponding JPG thumbnail exists for any image type
-                char thumbnail_name[256];
-                char thumbnail_path[512];
-
-                // Extract base name without extension
-                int base_len = ext - entry->d_name;
-                snprintf(thumbnail_name, sizeof(thumbnail_name), "%.*s.jpg", base_len,
-                         entry->d_name);
-                snprintf(thumbnail_path, sizeof(thumbnail_path), "%s/%s", album_path,
-                         thumbnail_name);
-
-                // Check if thumbnail file exists
-                struct stat st;
-                if (stat(thumbnail_path, &st) == 0) {
-                    cJSON_AddStringToObject(image_obj, "thumbnail", thumbnail_name);
-                }
+    // The index generation changes with every upload, delete and re-index,
+    // so it tags every page of the listing
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"al-%08lx\"", (unsigned long) generation);
+    char if_none_match[32];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) ==
+            ESP_OK &&
+        strcmp(if_none_match, etag) == 0) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_set_hdr(req, "ETag", etag);
+        httpd_resp_send(req, NULL, 0);
+        return ESP_OK;
+    }
+
+    album_index_entry_t *entries = malloc(ALBUM_LISTING_BATCH * sizeof(album_index_entry_t));
+    listing_writer_t w = {.req = req, .buf = malloc(ALBUM_LISTING_CHUNK)};
+    if (!entries || !w.buf) {
+        free(entries);
+        free(w.buf);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
+        return ESP_FAIL;
+    }
 
-                cJSON_AddItemToArray(response, image_obj);
+    char total_str[12];
+    snprintf(total_str, sizeof(total_str), "%d", total);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "X-Total-Count", total_str);
+
+    int end = (limit < 0 || limit > total - offset) ? total : offset + limit;
+    err = listing_write(&w, "[");
+    for (int pos = offset; err == ESP_OK && pos < end;) {
+        int want = end - pos < ALBUM_LISTING_BATCH ? end - pos : ALBUM_LISTING_BATCH;
+        int n = 0;
+        if (album_index_read(decoded_album_name, pos, entries, want, &n) != ESP_OK || n == 0) {
+            break;  // the album shrank under us; close the array early
+        }
+        for (int i = 0; i < n && err == ESP_OK; i++) {
+            cJSON *image_obj = cJSON_CreateObject();
+            cJSON_AddStringToObject(image_obj, "filename", entries[i].name);
+            cJSON_AddStringToObject(image_obj, "album", decoded_album_name);
+            if (entries[i].has_thumbnail) {
+                char thumbnail_name[256];
+                const char *ext = strrchr(entries[i].name, '.');
+                snprintf(thumbnail_name, sizeof(thumbnail_name), "%.*s.jpg",
+                         (int) (ext - entries[i].name), entries[i].name);
+                cJSON_AddStringToObject(image_obj, "thumbnail", thumbnail_name);
+            }
+            char *json_str = cJSON_PrintUnformatted(image_obj);
+            cJSON_Delete(image_obj);
+            if (!json_str) {
+                err = ESP_ERR_NO_MEM;
+                break;
+            }
+            if (pos + i > offset) {
+                err = listing_write(&w, ",");
             }
+            if (err == ESP_OK) {
+                err = listing_write(&w, json_str);
+            }
+            free(json_str);
         }
+        pos += n;
     }
-    closedir(dir);
+    if (err == ESP_OK) {
+        err = listing_write(&w, "]");
+    }
+    if (err == ESP_OK && w.used > 0) {
+        err = httpd_resp_send_chunk(req, w.buf, w.used);
+    }
+    free(entries);
+    free(w.buf);
 
-    char *json_str = cJSON_Print(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
-    free(json_str);
-    cJSON_Delete(response);
+    if (err != ESP_OK) {
+        // Headers are already out; dropping the connection is all that's left
+        ESP_LOGW(TAG, "Failed to stream listing of album %s", decoded_album_name);
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
     return ESP_OK;
 }
 
@@ -2033,8 +2435,10 @@ static esp_err_t factory_reset_handler(httpd_req_t *req)
 {
     ESP_LOGI(TAG, "Factory reset requested");
 
-    // Erase all NVS data first
+    // Erase all NVS data first, and drop the RTC copy of the rotation
+    // bookkeeping so the restart does not restore it
     ESP_LOGI(TAG, "Erasing NVS flash...");
+    bookkeeping_invalidate();
     esp_err_t ret = nvs_flash_erase();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to erase NVS: %s", esp_err_to_name(ret));
@@ -2500,6 +2904,12 @@ esp_err_t http_server_init(void)
                                                 .user_ctx = NULL};
         httpd_register_uri_handler(server, &display_image_direct_uri);
 
+        httpd_uri_t display_region_uri = {.uri = "/api/display-region",
+                                          .method = HTTP_POST,
+                                          .handler = display_region_handler,
+                                          .user_ctx = NULL};
+        httpd_register_uri_handler(server, &display_region_uri);
+
         httpd_uri_t albums_get_uri = {
             .uri = "/api/albums", .method = HTTP_GET, .handler = albums_handler, .user_ctx = NULL};
         httpd_register_uri_handler(server, &albums_get_uri);
@@ -2520,6 +2930,12 @@ esp_err_t http_server_init(void)
                                          .user_ctx = NULL};
         httpd_register_uri_handler(server, &album_enabled_uri);
 
+        httpd_uri_t album_pack_uri = {.uri = "/api/albums/pack",
+                                      .method = HTTP_POST,
+                                      .handler = album_pack_handler,
+                                      .user_ctx = NULL};
+        httpd_register_uri_handler(server, &album_pack_uri);
+
         httpd_uri_t images_uri = {.uri = "/api/images",
                                   .method = HTTP_GET,
                                   .handler = album_images_handler,
@@ -10,6 +10,7 @@
 #include <unistd.h>
 
 #include "board_hal.h"
+#include "byte_source.h"
 #include "color_palette.h"
 #include "config_manager.h"
 #include "display_manager.h"
@@ -186,15 +187,32 @@ static inline uint8_t linear_to_srgb(float lin)
 // keeps chromaticity while avoiding a per-pixel Lab round-trip on device.
 // (A per-channel remap was tried and reverted -- it compresses chroma along
 // with lightness and visibly washes out midtones.)
+//
+// Optional auto-levels run in the same pass: source luminance is first
+// stretched between black/white points measured by a pre-pass (see
+// jpeg_levels_prepass), then compressed as usual, so chroma is preserved
+// the same way.
+typedef struct {
+    float lo;    // source luminance mapped to black
+    float gain;  // 1 / (white point - black point)
+} tone_levels_t;
+
 typedef struct {
     float black_Y;
     float range;
+    bool levels;
+    tone_levels_t lv;
 } cdr_state_t;
 
-static void cdr_init(cdr_state_t *cdr)
+static void cdr_init(cdr_state_t *cdr, const tone_levels_t *levels)
 {
     init_gamma_luts();
 
+    cdr->levels = levels != NULL;
+    if (levels) {
+        cdr->lv = *levels;
+    }
+
     // Compute display black/white luminance in linear space
     const rgb_t *mb = board_is_grayscale() ? &gray_measured[0] : &palette_measured[0];
     const rgb_t *mw = board_is_grayscale() ? &gray_measured[15] : &palette_measured[1];
@@ -220,8 +238,15 @@ static void cdr_apply_row(const cdr_state_t *cdr, uint8_t *row, int width)
         // Original luminance
         float Y = 0.2126729f * lr + 0.7151522f * lg + 0.0721750f * lb;
 
+        // Stretched to the measured black/white points when auto-levels is on
+        float Yn = Y;
+        if (cdr->levels) {
+            Yn = (Y - cdr->lv.lo) * cdr->lv.gain;
+            Yn = Yn < 0.0f ? 0.0f : (Yn > 1.0f ? 1.0f : Yn);
+        }
+
         // Compressed luminance mapped to [black_Y, white_Y]
-        float compressed_Y = cdr->black_Y + Y * cdr->range;
+        float compressed_Y = cdr->black_Y + Yn * cdr->range;
 
         // Scale RGB channels proportionally
         float scale;
@@ -494,6 +519,39 @@ esp_err_t image_processor_reload_palette(void)
 
 typedef esp_err_t (*row_sink_fn)(void *ctx, int y, const uint8_t *row);
 
+// Decoded-source cache. Tuning dither or tone settings in the web UI
+// re-sends the same source for every tweak; with the cache enabled, a
+// display run keeps its processing-space RGB (the resampled rows
+// geometry_fill_row emits, before CDR and dithering) in PSRAM. A later run
+// whose encoded source hashes the same and whose geometry still matches
+// skips decode and resampling and replays only the CDR/dither tail. One
+// entry of proc_w * proc_h * 3 bytes: 1.1 MB at 800x480, 5.8 MB at
+// 1200x1600 -- at 1872x1404 the allocation normally fails next to the
+// decoded source and runs simply stay uncached.
+typedef struct {
+    uint8_t *rows;
+    bool valid;
+    uint32_t hash;  // FNV-1a over the encoded source
+    size_t input_size;
+    // Geometry the rows were resampled under
+    int src_w;
+    int src_h;
+    bool rotate;
+    int proc_w;
+    int proc_h;
+    bool fit;
+    uint8_t bg[3];
+    // Auto-levels setting the entry was captured under, and the levels
+    // measured for it (JPEG sources only)
+    bool auto_levels;
+    bool has_levels;
+    tone_levels_t levels;
+} source_cache_t;
+
+static source_cache_t source_cache;
+static bool source_cache_enabled;
+static bool source_cache_last_hit;
+
 // The user's configured display orientation decides rotation -- the source
 // image is never auto-rotated based on its own aspect ratio. This matches
 // epaper-image-convert, which processes at the configured orientation's
@@ -537,6 +595,11 @@ typedef struct {
     // minimum row index
     const uint8_t *(*get_row)(void *ctx, int src_y);
     void *row_ctx;
+    // Decoded-source cache (processing order only): rows are served from
+    // cached instead of being resampled, or recorded into capture as they
+    // are resampled
+    const uint8_t *cached;
+    source_cache_t *capture;
 } geometry_t;
 
 // Map the background name to its theoretical output color. Only white and
@@ -547,22 +610,25 @@ static void background_theoretical_rgb(const char *name, uint8_t rgb[3])
     rgb[0] = rgb[1] = rgb[2] = v;
 }
 
-// rotate is passed in (not re-read from config) so one snapshot governs the
-// whole pass -- geometry, decoder gating, and sink must agree even if the
-// user flips the orientation setting mid-stream
-static void geometry_init(geometry_t *geo, const uint8_t *src, int src_w, int src_h, bool rotate)
+// Geometry for a proc_w x proc_h processing space (a whole panel or a
+// region patch); native output rows are that space rotated back when rotate
+// is set
+static void geometry_init_sized(geometry_t *geo, const uint8_t *src, int src_w, int src_h,
+                                bool rotate, int proc_w, int proc_h)
 {
     geo->src = src;
     geo->src_w = src_w;
     geo->src_h = src_h;
     geo->get_row = NULL;
     geo->row_ctx = NULL;
+    geo->cached = NULL;
+    geo->capture = NULL;
 
     geo->rotate = rotate;
-    geo->proc_w = geo->rotate ? BOARD_HAL_DISPLAY_HEIGHT : BOARD_HAL_DISPLAY_WIDTH;
-    geo->proc_h = geo->rotate ? BOARD_HAL_DISPLAY_WIDTH : BOARD_HAL_DISPLAY_HEIGHT;
-    geo->out_w = BOARD_HAL_DISPLAY_WIDTH;
-    geo->out_h = BOARD_HAL_DISPLAY_HEIGHT;
+    geo->proc_w = proc_w;
+    geo->proc_h = proc_h;
+    geo->out_w = rotate ? proc_h : proc_w;
+    geo->out_h = rotate ? proc_w : proc_h;
     geo->processing_order = false;
 
     // Cover mode: scale to fill the processing space, center-crop the excess
@@ -633,6 +699,16 @@ static void geometry_init(geometry_t *geo, const uint8_t *src, int src_w, int sr
     }
 }
 
+// rotate is passed in (not re-read from config) so one snapshot governs the
+// whole pass -- geometry, decoder gating, and sink must agree even if the
+// user flips the orientation setting mid-stream
+static void geometry_init(geometry_t *geo, const uint8_t *src, int src_w, int src_h, bool rotate)
+{
+    geometry_init_sized(geo, src, src_w, src_h, rotate,
+                        rotate ? BOARD_HAL_DISPLAY_HEIGHT : BOARD_HAL_DISPLAY_WIDTH,
+                        rotate ? BOARD_HAL_DISPLAY_WIDTH : BOARD_HAL_DISPLAY_HEIGHT);
+}
+
 // Emit rows in processing-space order instead of native order: the sink
 // receives proc_h rows of proc_w pixels and places them itself (as native
 // columns when rotated). Source-row access then stays monotonic -- which
@@ -664,6 +740,11 @@ static const uint8_t *geometry_src_pixel(const geometry_t *geo, int sx, int sy)
 
 static void geometry_fill_row(const geometry_t *geo, int out_y, uint8_t *row)
 {
+    if (geo->cached) {
+        memcpy(row, geo->cached + (size_t) out_y * geo->out_w * 3, (size_t) geo->out_w * 3);
+        return;
+    }
+
     for (int out_x = 0; out_x < geo->out_w; out_x++) {
         uint8_t *out = &row[out_x * 3];
 
@@ -767,11 +848,11 @@ static void geometry_repaint_background(const geometry_t *geo, int out_y, uint8_
     }
 }
 
-static esp_err_t run_stream(geometry_t *geo, dither_algorithm_t dither_algorithm, row_sink_fn sink,
-                            void *sink_ctx)
+static esp_err_t run_stream(geometry_t *geo, dither_algorithm_t dither_algorithm,
+                            const tone_levels_t *levels, row_sink_fn sink, void *sink_ctx)
 {
     cdr_state_t cdr;
-    cdr_init(&cdr);
+    cdr_init(&cdr, levels);
 
     dither_state_t dither;
     esp_err_t err = dither_init(&dither, geo->out_w, dither_algorithm);
@@ -788,6 +869,10 @@ static esp_err_t run_stream(geometry_t *geo, dither_algorithm_t dither_algorithm
 
     for (int y = 0; y < geo->out_h && err == ESP_OK; y++) {
         geometry_fill_row(geo, y, row);
+        if (geo->capture) {
+            memcpy(geo->capture->rows + (size_t) y * geo->out_w * 3, row,
+                   (size_t) geo->out_w * 3);
+        }
         cdr_apply_row(&cdr, row, geo->out_w);
         dither_row(&dither, row);
         geometry_repaint_background(geo, y, row);
@@ -802,6 +887,23 @@ static esp_err_t run_stream(geometry_t *geo, dither_algorithm_t dither_algorithm
         }
     }
 
+    if (geo->capture) {
+        // The caller marks the entry valid once the whole pass (including
+        // any streamed decode) is known to have succeeded
+        source_cache_t *c = geo->capture;
+        c->src_w = geo->src_w;
+        c->src_h = geo->src_h;
+        c->rotate = geo->rotate;
+        c->proc_w = geo->proc_w;
+        c->proc_h = geo->proc_h;
+        c->fit = geo->fit;
+        memcpy(c->bg, geo->bg, sizeof(c->bg));
+        c->has_levels = levels != NULL;
+        if (levels) {
+            c->levels = *levels;
+        }
+    }
+
     heap_caps_free(row);
     dither_free(&dither);
     return err;
@@ -809,7 +911,8 @@ static esp_err_t run_stream(geometry_t *geo, dither_algorithm_t dither_algorithm
 
 static esp_err_t process_rgb_stream(const uint8_t *rgb_buffer, int width, int height,
                                     dither_algorithm_t dither_algorithm, row_sink_fn sink,
-                                    void *sink_ctx, bool processing_order, bool rotated)
+                                    void *sink_ctx, bool processing_order, bool rotated,
+                                    const tone_levels_t *levels, source_cache_t *capture)
 {
     ESP_LOGI(TAG, "Processing RGB buffer: %dx%d", width, height);
 
@@ -817,8 +920,9 @@ static esp_err_t process_rgb_stream(const uint8_t *rgb_buffer, int width, int he
     geometry_init(&geo, rgb_buffer, width, height, rotated);
     if (processing_order) {
         geometry_set_processing_order(&geo);
+        geo.capture = capture;
     }
-    return run_stream(&geo, dither_algorithm, sink, sink_ctx);
+    return run_stream(&geo, dither_algorithm, levels, sink, sink_ctx);
 }
 
 // Streaming PNG writer -- rows are written to the file as they are produced
@@ -959,67 +1063,108 @@ static esp_err_t decode_jpg_buffer(const uint8_t *jpg_data, size_t jpg_size, uin
     return ESP_OK;
 }
 
-// PNG memory read callback structure
-typedef struct {
-    const uint8_t *data;
-    size_t size;
-    size_t offset;
-} png_mem_read_t;
-
-static void png_mem_read_callback(png_structp png_ptr, png_bytep data, png_size_t length)
+// Auto-levels pre-pass for JPEG sources. The streaming pass dithers each
+// row as soon as it is resampled, so global statistics have to come first:
+// a 1/8-scale decode only needs each block's DC coefficient (no IDCT),
+// which makes it a small fraction of the full decode. The 0.5%/99.5%
+// luminance percentiles become the black/white points; the stretch is
+// capped at 8x so flat or near-black frames don't turn into noise.
+#define LEVELS_HIST_BINS 256
+#define LEVELS_CLIP_FRACTION 0.005f
+#define LEVELS_MAX_GAIN 8.0f
+
+static esp_err_t jpeg_levels_prepass(const uint8_t *jpg_data, size_t jpg_size,
+                                     tone_levels_t *levels)
 {
-    png_mem_read_t *mem = (png_mem_read_t *) png_get_io_ptr(png_ptr);
-    if (mem->offset + length > mem->size) {
-        png_error(png_ptr, "Read past end of buffer");
-        return;
+    esp_jpeg_image_cfg_t jpeg_cfg = {.indata = (uint8_t *) jpg_data,
+                                     .indata_size = jpg_size,
+                                     .out_format = JPEG_IMAGE_FORMAT_RGB888,
+                                     .out_scale = JPEG_IMAGE_SCALE_1_8};
+    esp_jpeg_image_output_t outimg;
+    if (esp_jpeg_get_image_info(&jpeg_cfg, &outimg) != ESP_OK || outimg.width <= 0 ||
+        outimg.height <= 0) {
+        return ESP_FAIL;
     }
-    memcpy(data, mem->data + mem->offset, length);
-    mem->offset += length;
-}
 
-// Read just the PNG header dimensions, so oversized images can be rejected
-// before libpng allocates the full decoded image internally
-static bool png_peek_dims(const uint8_t *png_data, size_t png_size, int *width, int *height)
-{
-    png_mem_read_t mem = {.data = png_data, .size = png_size, .offset = 0};
-
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (!png_ptr) {
-        return false;
-    }
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-    if (!info_ptr) {
-        png_destroy_read_struct(&png_ptr, NULL, NULL);
-        return false;
+    uint8_t *dc = (uint8_t *) heap_caps_malloc(outimg.output_len, MALLOC_CAP_SPIRAM);
+    if (!dc) {
+        ESP_LOGW(TAG, "No memory for the %u-byte levels pre-pass", (unsigned) outimg.output_len);
+        return ESP_ERR_NO_MEM;
     }
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        return false;
+    jpeg_cfg.outbuf = dc;
+    jpeg_cfg.outbuf_size = outimg.output_len;
+    if (esp_jpeg_decode(&jpeg_cfg, &outimg) != ESP_OK) {
+        heap_caps_free(dc);
+        return ESP_FAIL;
     }
 
-    png_set_read_fn(png_ptr, &mem, png_mem_read_callback);
-    png_read_info(png_ptr, info_ptr);
-    *width = png_get_image_width(png_ptr, info_ptr);
-    *height = png_get_image_height(png_ptr, info_ptr);
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    return true;
+    // Histogram of gamma-encoded luminance, so shadows get as many bins as
+    // highlights
+    init_gamma_luts();
+    uint32_t hist[LEVELS_HIST_BINS] = {0};
+    size_t count = (size_t) outimg.width * outimg.height;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = &dc[i * 3];
+        float Y = 0.2126729f * srgb_to_linear(p[0]) + 0.7151522f * srgb_to_linear(p[1]) +
+                  0.0721750f * srgb_to_linear(p[2]);
+        hist[linear_to_srgb(Y)]++;
+    }
+    heap_caps_free(dc);
+
+    size_t clip = (size_t) (count * LEVELS_CLIP_FRACTION);
+    int lo_bin = 0;
+    size_t acc = 0;
+    while (lo_bin < LEVELS_HIST_BINS - 1 && acc + hist[lo_bin] <= clip) {
+        acc += hist[lo_bin++];
+    }
+    int hi_bin = LEVELS_HIST_BINS - 1;
+    acc = 0;
+    while (hi_bin > lo_bin && acc + hist[hi_bin] <= clip) {
+        acc += hist[hi_bin--];
+    }
+
+    float lo = srgb_to_linear((uint8_t) lo_bin);
+    float hi = srgb_to_linear((uint8_t) hi_bin);
+    if (hi - lo < 1.0f / LEVELS_MAX_GAIN) {
+        hi = fminf(lo + 1.0f / LEVELS_MAX_GAIN, 1.0f);
+        lo = hi - 1.0f / LEVELS_MAX_GAIN;
+    }
+    levels->lo = lo;
+    levels->gain = 1.0f / (hi - lo);
+
+    ESP_LOGI(TAG, "Auto-levels from %dx%d pre-pass: black point %d, white point %d (gain %.2f)",
+             outimg.width, outimg.height, lo_bin, hi_bin, levels->gain);
+    return ESP_OK;
 }
 
-// Decode PNG from buffer to RGB
-static esp_err_t decode_png_buffer(const uint8_t *png_data, size_t png_size, uint8_t **rgb_buffer,
-                                   int *width, int *height)
+// Levels for a pass over a JPEG source, or NULL to leave it as is (setting
+// off, or the pre-pass failed -- the full decode reports real errors)
+static const tone_levels_t *jpeg_levels_for(const uint8_t *jpg_data, size_t jpg_size,
+                                            bool auto_levels, tone_levels_t *storage)
 {
-    // Gate on the decoded size BEFORE the full decode: png_read_png allocates
-    // the whole image internally, so an oversized source would OOM inside
-    // libpng with a generic failure instead of this specific one
-    int peek_w = 0, peek_h = 0;
-    if (png_peek_dims(png_data, png_size, &peek_w, &peek_h) &&
-        (size_t) peek_w * peek_h * 3 > 6 * 1024 * 1024) {
-        ESP_LOGE(TAG, "PNG image too large for memory: %dx%d (limit 6MB decoded)", peek_w, peek_h);
-        return ESP_ERR_NO_MEM;
+    if (!auto_levels) {
+        return NULL;
     }
+    return jpeg_levels_prepass(jpg_data, jpg_size, storage) == ESP_OK ? storage : NULL;
+}
 
-    png_mem_read_t mem = {.data = png_data, .size = png_size, .offset = 0};
+// libpng read callback over a byte source
+static void png_source_read_callback(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    byte_source_t *src = (byte_source_t *) png_get_io_ptr(png_ptr);
+    if (byte_source_read(src, data, length) != length) {
+        png_error(png_ptr, "Read past end of source");
+    }
+}
+
+// Decode a PNG source to RGB. The header is checked before anything is
+// allocated, and rows are decoded straight into the RGB buffer, so peak
+// memory is the decoded image alone.
+static esp_err_t decode_png_source(byte_source_t *src, uint8_t **rgb_buffer, int *width,
+                                   int *height)
+{
+    *rgb_buffer = NULL;
+    png_bytep *volatile rows = NULL;
 
     png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!png_ptr) {
@@ -1037,49 +1182,63 @@ static esp_err_t decode_png_buffer(const uint8_t *png_data, size_t png_size, uin
     if (setjmp(png_jmpbuf(png_ptr))) {
         ESP_LOGE(TAG, "PNG decoding error");
         set_last_error("PNG decoding error");
+        heap_caps_free((void *) rows);
+        heap_caps_free(*rgb_buffer);
+        *rgb_buffer = NULL;
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
         return ESP_FAIL;
     }
 
-    png_set_read_fn(png_ptr, &mem, png_mem_read_callback);
-    png_read_png(png_ptr, info_ptr,
-                 PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_EXPAND |
-                     PNG_TRANSFORM_STRIP_ALPHA,
-                 NULL);
+    png_set_read_fn(png_ptr, src, png_source_read_callback);
+    png_read_info(png_ptr, info_ptr);
 
     *width = png_get_image_width(png_ptr, info_ptr);
     *height = png_get_image_height(png_ptr, info_ptr);
     ESP_LOGI(TAG, "PNG Image info: %dx%d", *width, *height);
 
-    size_t rgb_size = (*width) * (*height) * 3;
+    size_t rgb_size = (size_t) (*width) * (*height) * 3;
     if (rgb_size > 6 * 1024 * 1024) {
-        ESP_LOGE(TAG, "PNG image too large for memory: %zu bytes (limit 6MB)", rgb_size);
+        ESP_LOGE(TAG, "PNG image too large for memory: %dx%d (limit 6MB decoded)", *width,
+                 *height);
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
         return ESP_ERR_NO_MEM;
     }
 
-    *rgb_buffer = (uint8_t *) heap_caps_malloc(rgb_size, MALLOC_CAP_SPIRAM);
-    if (!*rgb_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate PNG RGB buffer of %zu bytes", rgb_size);
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        return ESP_ERR_NO_MEM;
-    }
+    // The transforms png_read_png applies for STRIP_16 | PACKING | EXPAND |
+    // STRIP_ALPHA
+    png_set_expand(png_ptr);
+    png_set_strip_16(png_ptr);
+    png_set_strip_alpha(png_ptr);
+    png_set_packing(png_ptr);
+    png_set_interlace_handling(png_ptr);
+    png_read_update_info(png_ptr, info_ptr);
 
-    png_bytep *row_pointers = png_get_rows(png_ptr, info_ptr);
     int channels = png_get_channels(png_ptr, info_ptr);
     if (channels != 3) {
         ESP_LOGE(TAG, "Unsupported channel count: %d", channels);
         set_last_error("Unsupported PNG pixel format");
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return ESP_FAIL;
+    }
+
+    *rgb_buffer = (uint8_t *) heap_caps_malloc(rgb_size, MALLOC_CAP_SPIRAM);
+    rows = (png_bytep *) heap_caps_malloc((size_t) (*height) * sizeof(png_bytep),
+                                          MALLOC_CAP_SPIRAM);
+    if (!*rgb_buffer || !rows) {
+        ESP_LOGE(TAG, "Failed to allocate PNG RGB buffer of %zu bytes", rgb_size);
+        heap_caps_free((void *) rows);
         heap_caps_free(*rgb_buffer);
         *rgb_buffer = NULL;
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        return ESP_FAIL;
+        return ESP_ERR_NO_MEM;
     }
 
     for (int y = 0; y < *height; y++) {
-        memcpy(*rgb_buffer + y * (*width) * 3, row_pointers[y], (*width) * 3);
+        rows[y] = *rgb_buffer + (size_t) y * (*width) * 3;
     }
+    png_read_image(png_ptr, (png_bytepp) rows);
 
+    heap_caps_free((void *) rows);
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
     return ESP_OK;
 }
@@ -1098,7 +1257,7 @@ static esp_err_t decode_png_buffer(const uint8_t *png_data, size_t png_size, uin
 typedef struct {
     png_structp png_ptr;
     png_infop info_ptr;
-    png_mem_read_t mem;
+    byte_source_t *input;
     uint8_t *ring;  // ring_rows decoded source rows
     int ring_rows;
     int width;
@@ -1118,20 +1277,21 @@ static void png_stream_close(png_stream_src_t *src)
     memset(src, 0, sizeof(*src));
 }
 
-// Prepares a streamed read of png_data. On ESP_OK with *supported true, the
+// Prepares a streamed read of input. On ESP_OK with *supported true, the
 // caller must run png_stream_run() and then png_stream_close(); with
-// *supported false the source needs the buffered path and src is already
-// closed. png_data must stay valid until png_stream_close().
+// *supported false the source needs the buffered path, src is already
+// closed and input is rewound for decode_png_source(). input must stay open
+// until png_stream_close().
 // native_row_order: the sink needs native panel rows (PNG file output), so a
 // rotated configuration cannot stream; display sinks accept processing order
 // and stream regardless of rotation.
-static esp_err_t png_stream_open(png_stream_src_t *src, const uint8_t *png_data, size_t png_size,
+static esp_err_t png_stream_open(png_stream_src_t *src, byte_source_t *input,
                                  bool native_row_order, bool rotated, bool *supported)
 {
     memset(src, 0, sizeof(*src));
     *supported = false;
 
-    src->mem = (png_mem_read_t){.data = png_data, .size = png_size, .offset = 0};
+    src->input = input;
 
     src->png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!src->png_ptr) {
@@ -1152,7 +1312,7 @@ static esp_err_t png_stream_open(png_stream_src_t *src, const uint8_t *png_data,
         return ESP_FAIL;
     }
 
-    png_set_read_fn(src->png_ptr, &src->mem, png_mem_read_callback);
+    png_set_read_fn(src->png_ptr, input, png_source_read_callback);
     png_read_info(src->png_ptr, src->info_ptr);
 
     src->width = png_get_image_width(src->png_ptr, src->info_ptr);
@@ -1172,10 +1332,10 @@ static esp_err_t png_stream_open(png_stream_src_t *src, const uint8_t *png_data,
     if ((native_row_order && rotated) ||
         png_get_interlace_type(src->png_ptr, src->info_ptr) != PNG_INTERLACE_NONE) {
         png_stream_close(src);
-        return ESP_OK;
+        return byte_source_rewind(input);
     }
 
-    // Normalize to RGB888, mirroring decode_png_buffer's transforms
+    // Normalize to RGB888, mirroring decode_png_source's transforms
     png_byte color_type = png_get_color_type(src->png_ptr, src->info_ptr);
     png_byte bit_depth = png_get_bit_depth(src->png_ptr, src->info_ptr);
     if (color_type == PNG_COLOR_TYPE_PALETTE)
@@ -1200,7 +1360,7 @@ static esp_err_t png_stream_open(png_stream_src_t *src, const uint8_t *png_data,
     if (png_get_channels(src->png_ptr, src->info_ptr) != 3) {
         // Let the buffered path report the unsupported layout
         png_stream_close(src);
-        return ESP_OK;
+        return byte_source_rewind(input);
     }
 
     // Ring sized for the widest resample window (box footprint), plus slack.
@@ -1263,7 +1423,7 @@ static const uint8_t *png_stream_get_row(void *ctx, int src_y)
 
 static esp_err_t png_stream_run(png_stream_src_t *src, dither_algorithm_t dither_algorithm,
                                 row_sink_fn sink, void *sink_ctx, bool processing_order,
-                                bool rotated)
+                                bool rotated, source_cache_t *capture)
 {
     ESP_LOGI(TAG, "Streaming PNG: %dx%d (%d-row window)", src->width, src->height, src->ring_rows);
 
@@ -1271,11 +1431,12 @@ static esp_err_t png_stream_run(png_stream_src_t *src, dither_algorithm_t dither
     geometry_init(&geo, NULL, src->width, src->height, rotated);
     if (processing_order) {
         geometry_set_processing_order(&geo);
+        geo.capture = capture;
     }
     geo.get_row = png_stream_get_row;
     geo.row_ctx = src;
 
-    esp_err_t err = run_stream(&geo, dither_algorithm, sink, sink_ctx);
+    esp_err_t err = run_stream(&geo, dither_algorithm, NULL, sink, sink_ctx);
     if (err == ESP_OK && src->error) {
         err = ESP_FAIL;
     }
@@ -1302,6 +1463,9 @@ image_format_t image_processor_detect_format_buffer(const uint8_t *data, size_t
     return IMAGE_FORMAT_UNKNOWN;
 }
 
+// Processing rows buffered per column tile on rotated displays
+#define DISPLAY_SINK_TILE_ROWS 16
+
 // Display sinks always receive processing-order rows. Unrotated, those are
 // native rows; rotated, each processing row is one native column (the paint
 // buffer is random access, unlike a PNG being encoded).
@@ -1309,15 +1473,193 @@ typedef struct {
     bool rotated;
     int proc_w;
     int proc_h;
+    // Rotated only: the last few processing rows, painted together as a tile
+    // of adjacent columns so the framebuffer is written a row of bytes at a
+    // time instead of one nibble per WidthByte stride
+    uint8_t *tile;
+    int tile_fill;
+    bool tile_failed;
 } display_sink_ctx_t;
 
+// Paint the buffered rows ending at processing row y as adjacent columns
+static esp_err_t display_sink_flush_tile(display_sink_ctx_t *d, int y)
+{
+    // Processing row y lands on column proc_h - 1 - y, so the newest row is
+    // the leftmost column of the tile
+    const uint8_t *cols[DISPLAY_SINK_TILE_ROWS];
+    for (int j = 0; j < d->tile_fill; j++) {
+        cols[j] = d->tile + (size_t) (d->tile_fill - 1 - j) * d->proc_w * 3;
+    }
+    esp_err_t err =
+        display_manager_push_rgb_columns(d->proc_h - 1 - y, d->tile_fill, cols, d->proc_w);
+    d->tile_fill = 0;
+    return err;
+}
+
 static esp_err_t display_row_sink(void *ctx, int y, const uint8_t *row)
 {
     display_sink_ctx_t *d = (display_sink_ctx_t *) ctx;
-    if (d->rotated) {
+    if (!d->rotated) {
+        return display_manager_push_rgb_row(y, row, BOARD_HAL_DISPLAY_WIDTH);
+    }
+
+    if (!d->tile && !d->tile_failed) {
+        d->tile = heap_caps_malloc((size_t) DISPLAY_SINK_TILE_ROWS * d->proc_w * 3,
+                                   MALLOC_CAP_SPIRAM);
+        d->tile_fill = 0;
+        if (!d->tile) {
+            ESP_LOGW(TAG, "No memory for column tile, painting single columns");
+            d->tile_failed = true;
+        }
+    }
+    if (!d->tile) {
         return display_manager_push_rgb_column(d->proc_h - 1 - y, row, d->proc_w);
     }
-    return display_manager_push_rgb_row(y, row, BOARD_HAL_DISPLAY_WIDTH);
+
+    memcpy(d->tile + (size_t) d->tile_fill * d->proc_w * 3, row, (size_t) d->proc_w * 3);
+    d->tile_fill++;
+    if (d->tile_fill == DISPLAY_SINK_TILE_ROWS || y == d->proc_h - 1) {
+        return display_sink_flush_tile(d, y);
+    }
+    return ESP_OK;
+}
+
+static void display_sink_release(display_sink_ctx_t *d)
+{
+    if (d->tile) {
+        heap_caps_free(d->tile);
+        d->tile = NULL;
+    }
+    d->tile_fill = 0;
+}
+
+static void source_cache_free(void)
+{
+    if (source_cache.rows) {
+        heap_caps_free(source_cache.rows);
+    }
+    memset(&source_cache, 0, sizeof(source_cache));
+}
+
+// FNV-1a over the whole source, which is rewound for the decode
+static uint32_t source_cache_hash(byte_source_t *src)
+{
+    uint32_t h = 2166136261u;
+    uint8_t chunk[512];
+    for (;;) {
+        size_t n;
+        const uint8_t *p = byte_source_next(src, SIZE_MAX, &n);
+        if (!p) {
+            n = byte_source_read(src, chunk, sizeof(chunk));
+            p = chunk;
+        }
+        if (n == 0) {
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            h ^= p[i];
+            h *= 16777619u;
+        }
+    }
+    byte_source_rewind(src);
+    return h;
+}
+
+void image_processor_set_source_cache(bool enabled)
+{
+    if (!enabled && source_cache.rows) {
+        ESP_LOGI(TAG, "Source cache disabled, releasing %u bytes",
+                 (unsigned) ((size_t) source_cache.proc_w * source_cache.proc_h * 3));
+    }
+    source_cache_enabled = enabled;
+    source_cache_last_hit = false;
+    if (!enabled) {
+        source_cache_free();
+    }
+}
+
+bool image_processor_source_cache_hit(void)
+{
+    return source_cache_last_hit;
+}
+
+// Replay the cached processing-space rows through the CDR/dither tail into
+// the display. ESP_ERR_NOT_FOUND (with nothing displayed) when the entry
+// does not match this source and the current geometry settings.
+static esp_err_t source_cache_replay(uint32_t hash, size_t input_size, bool auto_levels,
+                                     dither_algorithm_t dither_algorithm,
+                                     display_sink_ctx_t *sink_ctx, const display_publish_t *pub)
+{
+    if (!source_cache.valid || source_cache.hash != hash ||
+        source_cache.input_size != input_size || source_cache.rotate != sink_ctx->rotated ||
+        source_cache.auto_levels != auto_levels) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Rebuild the geometry from the cached source dimensions: scale mode,
+    // background and panel size are re-read, and any change invalidates the
+    // resampled rows
+    geometry_t geo;
+    geometry_init(&geo, NULL, source_cache.src_w, source_cache.src_h, sink_ctx->rotated);
+    geometry_set_processing_order(&geo);
+    if (geo.proc_w != source_cache.proc_w || geo.proc_h != source_cache.proc_h ||
+        geo.fit != source_cache.fit ||
+        (geo.fit && memcmp(geo.bg, source_cache.bg, sizeof(geo.bg)) != 0)) {
+        ESP_LOGI(TAG, "Source cache stale (geometry changed)");
+        return ESP_ERR_NOT_FOUND;
+    }
+    geo.cached = source_cache.rows;
+
+    ESP_LOGI(TAG, "Source cache hit: replaying %dx%d resampled rows", geo.proc_w, geo.proc_h);
+    source_cache_last_hit = true;
+
+    esp_err_t err = display_manager_begin_rgb_stream();
+    if (err == ESP_OK) {
+        err = run_stream(&geo, dither_algorithm,
+                         source_cache.has_levels ? &source_cache.levels : NULL, display_row_sink,
+                         sink_ctx);
+        esp_err_t end_err = display_manager_end_rgb_stream(err == ESP_OK, pub);
+        if (err == ESP_OK) {
+            err = end_err;
+        }
+    }
+    return err;
+}
+
+// Claim the cache entry for a display run of a new source. Returns NULL
+// (run uncached) when caching is off or PSRAM cannot hold the rows next to
+// the decode.
+static source_cache_t *source_cache_prepare(uint32_t hash, size_t input_size, bool auto_levels)
+{
+    if (!source_cache_enabled) {
+        return NULL;
+    }
+
+    source_cache_free();
+    size_t bytes = (size_t) BOARD_HAL_DISPLAY_WIDTH * BOARD_HAL_DISPLAY_HEIGHT * 3;
+    source_cache.rows = (uint8_t *) heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (!source_cache.rows) {
+        ESP_LOGW(TAG, "No PSRAM for a %u-byte source cache, processing uncached",
+                 (unsigned) bytes);
+        return NULL;
+    }
+    source_cache.hash = hash;
+    source_cache.input_size = input_size;
+    source_cache.auto_levels = auto_levels;
+    return &source_cache;
+}
+
+// Mark a captured entry usable once its pass succeeded; drop it otherwise
+static void source_cache_finish(source_cache_t *capture, esp_err_t err)
+{
+    if (!capture) {
+        return;
+    }
+    if (err == ESP_OK) {
+        capture->valid = true;
+    } else {
+        source_cache_free();
+    }
 }
 
 esp_err_t image_processor_process_to_display(const uint8_t *input_data, size_t input_size,
@@ -1329,8 +1671,24 @@ esp_err_t image_processor_process_to_display(const uint8_t *input_data, size_t i
         return ESP_ERR_INVALID_ARG;
     }
 
+    byte_source_t src;
+    byte_source_init_memory(&src, input_data, input_size);
+    esp_err_t err = image_processor_process_source_to_display(&src, format, dither_algorithm, pub);
+    byte_source_close(&src);
+    return err;
+}
+
+esp_err_t image_processor_process_source_to_display(byte_source_t *src, image_format_t format,
+                                                    dither_algorithm_t dither_algorithm,
+                                                    const display_publish_t *pub)
+{
+    size_t input_size = byte_source_remaining(src);
+    if (input_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     const char *algo_names[] = {"floyd-steinberg", "stucki", "burkes", "sierra"};
-    ESP_LOGI(TAG, "Processing buffer to display (%zu bytes, format: %d, dither: %s)", input_size,
+    ESP_LOGI(TAG, "Processing source to display (%zu bytes, format: %d, dither: %s)", input_size,
              format, algo_names[dither_algorithm]);
 
     last_error_msg[0] = '\0';
@@ -1344,23 +1702,44 @@ esp_err_t image_processor_process_to_display(const uint8_t *input_data, size_t i
         .rotated = orientation_needs_rotation(),
         .proc_w = 0,
         .proc_h = 0,
+        .tile = NULL,
+        .tile_fill = 0,
+        .tile_failed = false,
     };
     sink_ctx.proc_w = sink_ctx.rotated ? BOARD_HAL_DISPLAY_HEIGHT : BOARD_HAL_DISPLAY_WIDTH;
     sink_ctx.proc_h = sink_ctx.rotated ? BOARD_HAL_DISPLAY_WIDTH : BOARD_HAL_DISPLAY_HEIGHT;
 
+    // One snapshot of the setting governs the pass and the cache key
+    bool auto_levels = processing_settings_get_auto_levels();
+
+    source_cache_last_hit = false;
+    uint32_t src_hash = 0;
+    if (source_cache_enabled) {
+        src_hash = source_cache_hash(src);
+        err = source_cache_replay(src_hash, input_size, auto_levels, dither_algorithm, &sink_ctx,
+                                  pub);
+        display_sink_release(&sink_ctx);
+        if (err != ESP_ERR_NOT_FOUND) {
+            return err;
+        }
+    }
+
     if (format == IMAGE_FORMAT_PNG) {
         png_stream_src_t stream;
         bool streamable = false;
-        err =
-            png_stream_open(&stream, input_data, input_size, false, sink_ctx.rotated, &streamable);
+        err = png_stream_open(&stream, src, false, sink_ctx.rotated, &streamable);
         if (err != ESP_OK) {
             return err;
         }
         if (streamable) {
             err = display_manager_begin_rgb_stream();
             if (err == ESP_OK) {
+                source_cache_t *capture =
+                    source_cache_prepare(src_hash, input_size, auto_levels);
                 err = png_stream_run(&stream, dither_algorithm, display_row_sink, &sink_ctx, true,
-                                     sink_ctx.rotated);
+                                     sink_ctx.rotated, capture);
+                display_sink_release(&sink_ctx);
+                source_cache_finish(capture, err);
                 {
                     esp_err_t end_err = display_manager_end_rgb_stream(err == ESP_OK, pub);
                     if (err == ESP_OK) {
@@ -1377,11 +1756,20 @@ esp_err_t image_processor_process_to_display(const uint8_t *input_data, size_t i
     // Decode input to RGB
     uint8_t *rgb_buffer = NULL;
     int width = 0, height = 0;
+    tone_levels_t levels_storage;
+    const tone_levels_t *levels = NULL;
 
     if (format == IMAGE_FORMAT_JPG) {
-        err = decode_jpg_buffer(input_data, input_size, &rgb_buffer, &width, &height);
+        // The JPEG decoder takes one contiguous buffer
+        const uint8_t *jpg_data;
+        size_t jpg_size;
+        err = byte_source_map(src, &jpg_data, &jpg_size);
+        if (err == ESP_OK) {
+            levels = jpeg_levels_for(jpg_data, jpg_size, auto_levels, &levels_storage);
+            err = decode_jpg_buffer(jpg_data, jpg_size, &rgb_buffer, &width, &height);
+        }
     } else if (format == IMAGE_FORMAT_PNG) {
-        err = decode_png_buffer(input_data, input_size, &rgb_buffer, &width, &height);
+        err = decode_png_source(src, &rgb_buffer, &width, &height);
     } else {
         ESP_LOGE(TAG, "Unsupported image format for buffer processing: %d", format);
         return ESP_ERR_NOT_SUPPORTED;
@@ -1396,8 +1784,11 @@ esp_err_t image_processor_process_to_display(const uint8_t *input_data, size_t i
     // Stream processed rows straight into the display buffer, then refresh
     err = display_manager_begin_rgb_stream();
     if (err == ESP_OK) {
+        source_cache_t *capture = source_cache_prepare(src_hash, input_size, auto_levels);
         err = process_rgb_stream(rgb_buffer, width, height, dither_algorithm, display_row_sink,
-                                 &sink_ctx, true, sink_ctx.rotated);
+                                 &sink_ctx, true, sink_ctx.rotated, levels, capture);
+        display_sink_release(&sink_ctx);
+        source_cache_finish(capture, err);
 
         // Every row has been painted; release the decoded source before end
         // runs the snapshot (its zlib state needs PSRAM a near-full decode
@@ -1415,6 +1806,204 @@ esp_err_t image_processor_process_to_display(const uint8_t *input_data, size_t i
     return err;
 }
 
+// ---- Region patches ----
+//
+// A region is processed as a standalone image the size of its rectangle:
+// the source is scaled into it under the configured scale mode and error
+// diffusion starts fresh inside it (error that would cross the border is
+// dropped), so nothing outside the rectangle changes.
+typedef struct {
+    bool rotated;
+    int proc_h;  // full processing-space height
+    int x;       // region origin in processing space
+    int y;
+    int w;
+    int h;
+    // Rotated only: buffered region rows, painted together as a tile of
+    // adjacent columns like display_sink_ctx_t's
+    uint8_t *tile;
+    int tile_fill;
+    bool tile_failed;
+} region_sink_ctx_t;
+
+// Paint the buffered rows ending at region row y as adjacent columns
+static esp_err_t region_sink_flush_tile(region_sink_ctx_t *r, int y)
+{
+    // As in display_sink_flush_tile, the newest row is the leftmost column
+    const uint8_t *cols[DISPLAY_SINK_TILE_ROWS];
+    for (int j = 0; j < r->tile_fill; j++) {
+        cols[j] = r->tile + (size_t) (r->tile_fill - 1 - j) * r->w * 3;
+    }
+    esp_err_t err = display_manager_patch_columns(r->proc_h - 1 - (r->y + y), r->x,
+                                                  r->tile_fill, cols, r->w);
+    r->tile_fill = 0;
+    return err;
+}
+
+static esp_err_t region_row_sink(void *ctx, int y, const uint8_t *row)
+{
+    region_sink_ctx_t *r = (region_sink_ctx_t *) ctx;
+    if (!r->rotated) {
+        return display_manager_patch_row(r->x, r->y + y, row, r->w);
+    }
+
+    // As in display_row_sink: processing row y is native column
+    // proc_h - 1 - y, and processing x runs down that column
+    if (!r->tile && !r->tile_failed) {
+        r->tile = heap_caps_malloc((size_t) DISPLAY_SINK_TILE_ROWS * r->w * 3, MALLOC_CAP_SPIRAM);
+        r->tile_fill = 0;
+        if (!r->tile) {
+            ESP_LOGW(TAG, "No memory for column tile, patching single columns");
+            r->tile_failed = true;
+        }
+    }
+    if (!r->tile) {
+        return display_manager_patch_column(r->proc_h - 1 - (r->y + y), r->x, row, r->w);
+    }
+
+    memcpy(r->tile + (size_t) r->tile_fill * r->w * 3, row, (size_t) r->w * 3);
+    r->tile_fill++;
+    if (r->tile_fill == DISPLAY_SINK_TILE_ROWS || y == r->h - 1) {
+        return region_sink_flush_tile(r, y);
+    }
+    return ESP_OK;
+}
+
+static void region_sink_release(region_sink_ctx_t *r)
+{
+    if (r->tile) {
+        heap_caps_free(r->tile);
+        r->tile = NULL;
+    }
+    r->tile_fill = 0;
+}
+
+// Paint a packed 4bpp payload (two pixels per byte, high nibble first, rows
+// padded to whole bytes -- the .epdgz row layout) through the region sink.
+// Nibbles are framebuffer values, so they go out as their theoretical
+// colors and map back exactly; unknown Spectra indices paint white.
+static esp_err_t region_paint_packed(const uint8_t *data, int w, int h,
+                                     region_sink_ctx_t *sink_ctx)
+{
+    const size_t row_bytes = ((size_t) w + 1) / 2;
+    uint8_t *row = (uint8_t *) heap_caps_malloc((size_t) w * 3, MALLOC_CAP_SPIRAM);
+    if (!row) {
+        ESP_LOGE(TAG, "Failed to allocate row buffer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool gray = board_is_grayscale();
+    esp_err_t err = ESP_OK;
+    for (int y = 0; y < h && err == ESP_OK; y++) {
+        const uint8_t *src = data + (size_t) y * row_bytes;
+        for (int x = 0; x < w; x++) {
+            uint8_t v = (x & 1) ? (src[x / 2] & 0x0F) : (src[x / 2] >> 4);
+            const rgb_t *c;
+            if (gray) {
+                c = &gray_theoretical[v];
+            } else {
+                c = (v < 7 && v != 4) ? &palette[v] : &palette[1];
+            }
+            row[x * 3] = c->r;
+            row[x * 3 + 1] = c->g;
+            row[x * 3 + 2] = c->b;
+        }
+        err = region_row_sink(sink_ctx, y, row);
+    }
+
+    heap_caps_free(row);
+    return err;
+}
+
+esp_err_t image_processor_process_region(const uint8_t *input_data, size_t input_size,
+                                         image_format_t format, int x, int y, int w, int h,
+                                         dither_algorithm_t dither_algorithm,
+                                         const display_publish_t *pub)
+{
+    if (!input_data || input_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    last_error_msg[0] = '\0';
+
+    bool rotated = orientation_needs_rotation();
+    int proc_w = rotated ? BOARD_HAL_DISPLAY_HEIGHT : BOARD_HAL_DISPLAY_WIDTH;
+    int proc_h = rotated ? BOARD_HAL_DISPLAY_WIDTH : BOARD_HAL_DISPLAY_HEIGHT;
+    if (w <= 0 || h <= 0 || x < 0 || y < 0 || x > proc_w - w || y > proc_h - h) {
+        ESP_LOGE(TAG, "Region %dx%d at (%d,%d) outside the %dx%d display", w, h, x, y, proc_w,
+                 proc_h);
+        set_last_error("Region outside the display");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Processing region %dx%d at (%d,%d) (%zu bytes, format: %d)", w, h, x, y,
+             input_size, format);
+
+    region_sink_ctx_t sink_ctx = {
+        .rotated = rotated,
+        .proc_h = proc_h,
+        .x = x,
+        .y = y,
+        .w = w,
+        .h = h,
+    };
+
+    esp_err_t err = ESP_OK;
+    uint8_t *rgb_buffer = NULL;
+    int width = 0, height = 0;
+    tone_levels_t levels_storage;
+    const tone_levels_t *levels = NULL;
+
+    if (format == IMAGE_FORMAT_JPG) {
+        levels = jpeg_levels_for(input_data, input_size, processing_settings_get_auto_levels(),
+                                 &levels_storage);
+        err = decode_jpg_buffer(input_data, input_size, &rgb_buffer, &width, &height);
+    } else if (format == IMAGE_FORMAT_PNG) {
+        byte_source_t src;
+        byte_source_init_memory(&src, input_data, input_size);
+        err = decode_png_source(&src, &rgb_buffer, &width, &height);
+        byte_source_close(&src);
+    } else if (format == IMAGE_FORMAT_RAW_4BPP) {
+        size_t expected = ((size_t) w + 1) / 2 * h;
+        if (input_size != expected) {
+            ESP_LOGE(TAG, "Packed region is %zu bytes, expected %zu", input_size, expected);
+            set_last_error("Packed 4bpp payload does not match the region size");
+            return ESP_ERR_INVALID_ARG;
+        }
+    } else {
+        ESP_LOGE(TAG, "Unsupported image format for region processing: %d", format);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = display_manager_begin_patch();
+    if (err == ESP_OK) {
+        if (format == IMAGE_FORMAT_RAW_4BPP) {
+            err = region_paint_packed(input_data, w, h, &sink_ctx);
+        } else {
+            geometry_t geo;
+            geometry_init_sized(&geo, rgb_buffer, width, height, false, w, h);
+            geometry_set_processing_order(&geo);
+            err = run_stream(&geo, dither_algorithm, levels, region_row_sink, &sink_ctx);
+        }
+        region_sink_release(&sink_ctx);
+
+        heap_caps_free(rgb_buffer);
+        rgb_buffer = NULL;
+
+        esp_err_t end_err = display_manager_end_rgb_stream(err == ESP_OK, pub);
+        if (err == ESP_OK) {
+            err = end_err;
+        }
+    }
+
+    heap_caps_free(rgb_buffer);
+    return err;
+}
+
 esp_err_t image_processor_process(const char *input_path, const char *output_path,
                                   dither_algorithm_t dither_algorithm)
 {
@@ -1431,33 +2020,14 @@ esp_err_t image_processor_process(const char *input_path, const char *output_pat
         return ESP_FAIL;
     }
 
-    // Read entire file into buffer
-    FILE *fp = fopen(input_path, "rb");
-    if (!fp) {
+    // Decoders read the file through a byte source; only JPEG, whose
+    // decoder needs one contiguous buffer, may be copied into RAM
+    byte_source_t src;
+    if (byte_source_open_file(&src, input_path) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to open input file: %s", input_path);
         return ESP_FAIL;
     }
 
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    uint8_t *file_buffer = heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM);
-    if (!file_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate file buffer of %ld bytes", file_size);
-        fclose(fp);
-        return ESP_ERR_NO_MEM;
-    }
-
-    size_t read_bytes = fread(file_buffer, 1, file_size, fp);
-    fclose(fp);
-
-    if (read_bytes != file_size) {
-        ESP_LOGE(TAG, "Failed to read entire file");
-        heap_caps_free(file_buffer);
-        return ESP_FAIL;
-    }
-
     esp_err_t err;
     bool rotated = orientation_needs_rotation();
 
@@ -1465,9 +2035,9 @@ esp_err_t image_processor_process(const char *input_path, const char *output_pat
     if (format == IMAGE_FORMAT_PNG) {
         png_stream_src_t stream;
         bool streamable = false;
-        err = png_stream_open(&stream, file_buffer, file_size, true, rotated, &streamable);
+        err = png_stream_open(&stream, &src, true, rotated, &streamable);
         if (err != ESP_OK) {
-            heap_caps_free(file_buffer);
+            byte_source_close(&src);
             return err;
         }
         if (streamable) {
@@ -1477,14 +2047,14 @@ esp_err_t image_processor_process(const char *input_path, const char *output_pat
                                   BOARD_HAL_DISPLAY_HEIGHT);
             if (err == ESP_OK) {
                 err = png_stream_run(&stream, dither_algorithm, png_writer_row_sink, &writer, false,
-                                     rotated);
+                                     rotated, NULL);
                 esp_err_t close_err = png_writer_close(&writer, err == ESP_OK);
                 if (err == ESP_OK) {
                     err = close_err;
                 }
             }
             png_stream_close(&stream);
-            heap_caps_free(file_buffer);
+            byte_source_close(&src);
 
             if (err == ESP_OK) {
                 ESP_LOGI(TAG, "Successfully wrote PNG to %s", output_path);
@@ -1499,18 +2069,24 @@ esp_err_t image_processor_process(const char *input_path, const char *output_pat
     // Decode to RGB buffer
     uint8_t *rgb_buffer = NULL;
     int width = 0, height = 0;
+    tone_levels_t levels_storage;
+    const tone_levels_t *levels = NULL;
 
     if (format == IMAGE_FORMAT_JPG) {
-        err = decode_jpg_buffer(file_buffer, file_size, &rgb_buffer, &width, &height);
-    } else if (format == IMAGE_FORMAT_PNG) {
-        err = decode_png_buffer(file_buffer, file_size, &rgb_buffer, &width, &height);
+        const uint8_t *jpg_data;
+        size_t jpg_size;
+        err = byte_source_map(&src, &jpg_data, &jpg_size);
+        if (err == ESP_OK) {
+            levels = jpeg_levels_for(jpg_data, jpg_size, processing_settings_get_auto_levels(),
+                                     &levels_storage);
+            err = decode_jpg_buffer(jpg_data, jpg_size, &rgb_buffer, &width, &height);
+        }
     } else {
-        heap_caps_free(file_buffer);
-        return ESP_ERR_NOT_SUPPORTED;
+        err = decode_png_source(&src, &rgb_buffer, &width, &height);
     }
 
-    // Free input file buffer immediately after decoding
-    heap_caps_free(file_buffer);
+    // Release the input (and any mapped copy) immediately after decoding
+    byte_source_close(&src);
 
     if (err != ESP_OK) {
         return err;
@@ -1524,7 +2100,7 @@ esp_err_t image_processor_process(const char *input_path, const char *output_pat
     err = png_writer_open(&writer, output_path, BOARD_HAL_DISPLAY_WIDTH, BOARD_HAL_DISPLAY_HEIGHT);
     if (err == ESP_OK) {
         err = process_rgb_stream(rgb_buffer, width, height, dither_algorithm, png_writer_row_sink,
-                                 &writer, false, rotated);
+                                 &writer, false, rotated, levels, NULL);
         // Keep the processing error (e.g. ESP_ERR_NO_MEM, which callers map
         // to a specific response); only a failed finalize of an otherwise
         // successful write becomes the result.
@@ -1650,7 +2226,7 @@ static bool check_processed_png(png_structp png_ptr, png_infop info_ptr, bool pa
 
 esp_err_t image_processor_process_or_display_png(const char *path,
                                                  dither_algorithm_t dither_algorithm,
-                                                 const display_publish_t *pub, bool release_source)
+                                                 const display_publish_t *pub)
 {
     if (!path) {
         return ESP_ERR_INVALID_ARG;
@@ -1660,77 +2236,51 @@ esp_err_t image_processor_process_or_display_png(const char *path,
     // from the file in a single decode, with no RAM copy of the upload (a
     // near-5 MB source competes with the frame buffer, and on MemFS the
     // file already lives in PSRAM). Any validation failure leaves the panel
-    // untouched and the source falls back to full processing.
-    FILE *fp = fopen(path, "rb");
-    if (!fp) {
-        ESP_LOGE(TAG, "Failed to open %s", path);
+    // untouched and the source falls back to full processing, which reads
+    // the same file again. A file on a RAM filesystem is decoded straight
+    // out of its extents.
+    byte_source_t src;
+    if (byte_source_open_file(&src, path) != ESP_OK) {
         return ESP_FAIL;
     }
 
     uint8_t sig[8];
-    if (fread(sig, 1, 8, fp) == 8 && png_sig_cmp(sig, 0, 8) == 0) {
+    bool is_png = byte_source_read(&src, sig, 8) == 8 && png_sig_cmp(sig, 0, 8) == 0;
+
+    esp_err_t err = ESP_OK;
+    bool displayed = false;
+    if (is_png) {
         png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
         png_infop info_ptr = png_ptr ? png_create_info_struct(png_ptr) : NULL;
         if (png_ptr && info_ptr) {
-            png_init_io(png_ptr, fp);
+            png_set_read_fn(png_ptr, &src, png_source_read_callback);
             png_set_sig_bytes(png_ptr, 8);
 
-            esp_err_t err = display_manager_begin_rgb_stream();
-            if (err != ESP_OK) {
-                png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-                fclose(fp);
-                return err;
+            err = display_manager_begin_rgb_stream();
+            if (err == ESP_OK) {
+                displayed = check_processed_png(png_ptr, info_ptr, true);
+                esp_err_t end_err = display_manager_end_rgb_stream(displayed, pub);
+                if (displayed) {
+                    err = end_err;
+                    ESP_LOGI(TAG, "Displayed pre-processed PNG in a single decode");
+                } else {
+                    ESP_LOGI(TAG, "PNG needs processing");
+                }
             }
-
-            bool displayed = check_processed_png(png_ptr, info_ptr, true);
-            esp_err_t end_err = display_manager_end_rgb_stream(displayed, pub);
             png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-
-            if (displayed) {
-                fclose(fp);
-                ESP_LOGI(TAG, "Displayed pre-processed PNG in a single decode");
-                return end_err;
-            }
-            ESP_LOGI(TAG, "PNG needs processing");
         } else if (png_ptr) {
             png_destroy_read_struct(&png_ptr, NULL, NULL);
         }
     }
-    fclose(fp);
-
-    // Fallback: full processing needs the compressed source in RAM
-    fp = fopen(path, "rb");
-    if (!fp) {
-        return ESP_FAIL;
-    }
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    if (file_size <= 0) {
-        fclose(fp);
-        return ESP_FAIL;
-    }
-    uint8_t *file_buffer = (uint8_t *) heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM);
-    if (!file_buffer) {
-        fclose(fp);
-        return ESP_ERR_NO_MEM;
-    }
-    size_t read_bytes = fread(file_buffer, 1, file_size, fp);
-    fclose(fp);
-    if (read_bytes != (size_t) file_size) {
-        heap_caps_free(file_buffer);
-        return ESP_FAIL;
-    }
 
-    if (release_source) {
-        // MemFS-backed sources live in PSRAM; drop the file now that the
-        // compressed copy exists so the two never coexist with the decoder
-        unlink(path);
+    if (!displayed && err == ESP_OK) {
+        err = byte_source_rewind(&src);
+        if (err == ESP_OK) {
+            err = image_processor_process_source_to_display(&src, IMAGE_FORMAT_PNG,
+                                                            dither_algorithm, pub);
+        }
     }
-
-    esp_err_t err = image_processor_process_to_display(file_buffer, (size_t) file_size,
-                                                       IMAGE_FORMAT_PNG, dither_algorithm, pub);
-    heap_caps_free(file_buffer);
+    byte_source_close(&src);
     return err;
 }
 
@@ -5,6 +5,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "byte_source.h"
 #include "display_manager.h"
 #include "esp_err.h"
 
@@ -20,7 +21,10 @@ typedef enum {
     IMAGE_FORMAT_PNG,
     IMAGE_FORMAT_BMP,
     IMAGE_FORMAT_JPG,
-    IMAGE_FORMAT_EPD_GZ
+    IMAGE_FORMAT_EPD_GZ,
+    // Packed 4bpp framebuffer values, two pixels per byte (high nibble
+    // first), rows padded to whole bytes; only accepted for region patches
+    IMAGE_FORMAT_RAW_4BPP
 } image_format_t;
 
 esp_err_t image_processor_init(void);
@@ -56,19 +60,67 @@ esp_err_t image_processor_process_to_display(const uint8_t *input_data, size_t i
                                              dither_algorithm_t dither_algorithm,
                                              const display_publish_t *pub);
 
+/**
+ * @brief Process image data read from a byte source and show it on the display
+ *
+ * As image_processor_process_to_display, reading the source from its
+ * current position. PNG is decoded as it is read, so a file source is never
+ * held in RAM whole; JPEG is mapped (see byte_source_map). The source may be
+ * read more than once (rewound), and stays open for the caller to close.
+ */
+esp_err_t image_processor_process_source_to_display(byte_source_t *src, image_format_t format,
+                                                    dither_algorithm_t dither_algorithm,
+                                                    const display_publish_t *pub);
+
+/**
+ * @brief Process an image into one rectangle of the displayed frame
+ *
+ * The rectangle (x, y, w, h) is in processing space -- the displayed
+ * orientation, as the image appears on the frame. PNG and JPG sources are
+ * scaled into the rectangle and dithered as a standalone image, so error
+ * diffusion is clipped at its edges; IMAGE_FORMAT_RAW_4BPP payloads are
+ * painted verbatim. The rest of the frame keeps what the panel shows (see
+ * display_manager_begin_patch), and the patched frame is refreshed and
+ * published as described by pub.
+ *
+ * @return esp_err_t ESP_OK on success; ESP_ERR_INVALID_ARG for a rectangle
+ *         outside the display or a raw payload of the wrong size;
+ *         ESP_ERR_INVALID_STATE when the displayed frame is unknown
+ */
+esp_err_t image_processor_process_region(const uint8_t *input_data, size_t input_size,
+                                         image_format_t format, int x, int y, int w, int h,
+                                         dither_algorithm_t dither_algorithm,
+                                         const display_publish_t *pub);
+
 /**
  * @brief Display a PNG file, processing it only when necessary
  *
  * A pre-processed PNG (native dimensions, every pixel a theoretical output
  * color) is validated and painted straight from the file in a single decode
  * with no RAM copy; anything else falls back to
- * image_processor_process_to_display. Preferred entry point for PNG display
- * requests. With release_source set, the file is unlinked as soon as an
- * in-RAM copy exists (for MemFS-backed sources that live in PSRAM).
+ * image_processor_process_source_to_display on the same file, still without
+ * a RAM copy. Preferred entry point for PNG display requests.
  */
 esp_err_t image_processor_process_or_display_png(const char *path,
                                                  dither_algorithm_t dither_algorithm,
-                                                 const display_publish_t *pub, bool release_source);
+                                                 const display_publish_t *pub);
+
+/**
+ * @brief Enable or disable the decoded-source cache
+ *
+ * While enabled, image_processor_process_to_display keeps the last source's
+ * resampled processing-space RGB in PSRAM. Displaying the same source again
+ * (e.g. after changing the dither algorithm) skips decode and resampling and
+ * only re-runs dynamic-range compression and dithering. A change to the
+ * orientation, scale mode or background invalidates the entry. Disabling
+ * releases the cache.
+ */
+void image_processor_set_source_cache(bool enabled);
+
+/**
+ * @brief Whether the most recent display run was served from the source cache
+ */
+bool image_processor_source_cache_hit(void);
 
 esp_err_t image_processor_reload_palette(void);
 
@@ -5,7 +5,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "album_index.h"
 #include "album_manager.h"
+#include "album_pack.h"
+#include "album_transcode.h"
 #include "board_hal.h"
 #include "color_palette.h"
 #include "config.h"
@@ -564,6 +567,10 @@ void app_main(void)
 
     ESP_ERROR_CHECK(album_manager_init());
 
+    ESP_ERROR_CHECK(album_index_init());
+
+    ESP_ERROR_CHECK(album_pack_init());
+
     // Check wake-up source
     wakeup_source_t wakeup_src = power_manager_get_wakeup_source();
     ESP_LOGI(TAG, "Wake-up source: %d", wakeup_src);
@@ -595,6 +602,10 @@ void app_main(void)
         break;
     }
 
+    // The card may have been edited on a computer since the last interactive
+    // boot, which FAT directory mtimes do not reveal
+    album_index_verify();
+
     ESP_ERROR_CHECK(wifi_manager_init());
     ESP_ERROR_CHECK(wifi_provisioning_init());
 
@@ -698,6 +709,9 @@ void app_main(void)
     ESP_ERROR_CHECK(http_server_init());
     http_server_set_ready();
 
+    // Convert albums left from before transcode-on-ingest while on USB power
+    album_transcode_start_migration();
+
     if (wifi_manager_is_connected()) {
         char ip_str[16];
         wifi_manager_get_ip(ip_str, sizeof(ip_str));
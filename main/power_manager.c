@@ -18,9 +18,11 @@
 #endif
 
 #include "board_hal.h"
+#include "bookkeeping.h"
 #include "config.h"
 #include "config_manager.h"
 #include "debug_log.h"
+#include "display_manager.h"
 #include "ha_integration.h"
 #include "periodic_tasks.h"
 #include "storage.h"
@@ -83,6 +85,7 @@ static void rotation_timer_task(void *arg)
 
                 trigger_image_rotation();
                 ha_notify_update();
+                bookkeeping_cycle_done(board_hal_get_battery_percent());
 
                 // Schedule next rotation
                 int seconds_until_next = get_seconds_until_next_wakeup();
@@ -335,6 +338,9 @@ void power_manager_enter_sleep(void)
 
     ESP_LOGI(TAG, "Preparing to enter deep sleep mode");
 
+    // A double-buffered refresh may still be running in the background
+    display_manager_wait_idle();
+
     // Only notify HA offline when the network is actually up. The early-wake
     // re-sleep (deep_sleep_wake_main check #1) calls enter_sleep before WiFi /
     // esp_netif is initialized; issuing the HTTP notify there crashes on the
@@ -386,6 +392,11 @@ void power_manager_enter_sleep(void)
     // was never started.
     esp_wifi_stop();
 
+    // Write pending rotation bookkeeping back to NVS if a flush is due;
+    // otherwise it waits in RTC memory for a later wake. The battery is read
+    // here because preparing the board for sleep powers its gauge down.
+    bookkeeping_cycle_done(board_hal_get_battery_percent());
+
     ESP_LOGI(TAG, "Configuring Board HAL for deep sleep");
     board_hal_prepare_for_sleep();
 
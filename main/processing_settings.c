@@ -24,6 +24,7 @@ static const char *TAG = "processing_settings";
 #define NVS_PROC_DITHER_ALGO_KEY "proc_dith"
 #define NVS_PROC_SCALE_MODE_KEY "proc_smode"
 #define NVS_PROC_BG_COLOR_KEY "proc_bgcol"
+#define NVS_PROC_AUTO_LEVELS_KEY "proc_alvl"
 
 void processing_settings_get_defaults(processing_settings_t *settings)
 {
@@ -40,6 +41,7 @@ void processing_settings_get_defaults(processing_settings_t *settings)
     settings->compress_dynamic_range = true;
     strncpy(settings->scale_mode, "cover", sizeof(settings->scale_mode) - 1);
     strncpy(settings->background_color, "white", sizeof(settings->background_color) - 1);
+    settings->auto_levels = false;
 }
 
 dither_algorithm_t processing_settings_get_dithering_algorithm(void)
@@ -83,6 +85,15 @@ void processing_settings_get_background_color(char *out, size_t out_size)
     snprintf(out, out_size, "%s", settings.background_color);
 }
 
+bool processing_settings_get_auto_levels(void)
+{
+    processing_settings_t settings;
+    if (processing_settings_load(&settings) != ESP_OK) {
+        processing_settings_get_defaults(&settings);
+    }
+    return settings.auto_levels;
+}
+
 esp_err_t processing_settings_init(void)
 {
     ESP_LOGI(TAG, "Processing settings initialized");
@@ -121,6 +132,7 @@ esp_err_t processing_settings_save(const processing_settings_t *settings)
     nvs_set_str(nvs_handle, NVS_PROC_DITHER_ALGO_KEY, settings->dither_algorithm);
     nvs_set_str(nvs_handle, NVS_PROC_SCALE_MODE_KEY, settings->scale_mode);
     nvs_set_str(nvs_handle, NVS_PROC_BG_COLOR_KEY, settings->background_color);
+    nvs_set_u8(nvs_handle, NVS_PROC_AUTO_LEVELS_KEY, settings->auto_levels ? 1 : 0);
 
     err = nvs_commit(nvs_handle);
     nvs_close(nvs_handle);
@@ -192,6 +204,11 @@ esp_err_t processing_settings_load(processing_settings_t *settings)
     len = sizeof(settings->background_color);
     nvs_get_str(nvs_handle, NVS_PROC_BG_COLOR_KEY, settings->background_color, &len);
 
+    uint8_t auto_levels = 0;
+    if (nvs_get_u8(nvs_handle, NVS_PROC_AUTO_LEVELS_KEY, &auto_levels) == ESP_OK) {
+        settings->auto_levels = (auto_levels != 0);
+    }
+
     nvs_close(nvs_handle);
 
     return ESP_OK;
@@ -226,6 +243,8 @@ void processing_settings_from_json(cJSON *json, processing_settings_t *settings)
     if ((item = cJSON_GetObjectItem(json, "scaleMode")) && cJSON_IsString(item) &&
         (strcmp(item->valuestring, "cover") == 0 || strcmp(item->valuestring, "fit") == 0))
         strncpy(settings->scale_mode, item->valuestring, sizeof(settings->scale_mode) - 1);
+    if ((item = cJSON_GetObjectItem(json, "autoLevels")) && cJSON_IsBool(item))
+        settings->auto_levels = cJSON_IsTrue(item);
     if ((item = cJSON_GetObjectItem(json, "backgroundColor")) && cJSON_IsString(item)) {
         // Allowlist: guarantees termination and rejects unsupported names
         // (the letterbox background is white or black only)
@@ -260,6 +279,7 @@ char *processing_settings_to_json(const processing_settings_t *settings)
     cJSON_AddBoolToObject(json, "compressDynamicRange", settings->compress_dynamic_range);
     cJSON_AddStringToObject(json, "scaleMode", settings->scale_mode);
     cJSON_AddStringToObject(json, "backgroundColor", settings->background_color);
+    cJSON_AddBoolToObject(json, "autoLevels", settings->auto_levels);
 
     char *json_str = cJSON_PrintUnformatted(json);
     cJSON_Delete(json);
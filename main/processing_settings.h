@@ -21,6 +21,7 @@ typedef struct {
     bool compress_dynamic_range;
     char scale_mode[8];         // "cover" (crop to fill) or "fit" (letterbox)
     char background_color[12];  // palette color name for fit-mode letterbox bars
+    bool auto_levels;           // stretch black/white points from a JPEG pre-pass
 } processing_settings_t;
 
 typedef enum {
@@ -36,6 +37,8 @@ dither_algorithm_t processing_settings_get_dithering_algorithm(void);
 scale_mode_t processing_settings_get_scale_mode(void);
 // Palette color name for the fit-mode letterbox background ("white", ...)
 void processing_settings_get_background_color(char *out, size_t out_size);
+// Whether JPEG sources get histogram-driven black/white points before CDR
+bool processing_settings_get_auto_levels(void);
 char *processing_settings_to_json(const processing_settings_t *settings);
 void processing_settings_from_json(cJSON *json, processing_settings_t *settings);
 
@@ -0,0 +1,86 @@
+#include "shuffle_bag.h"
+
+#define SHUFFLE_BAG_ROUNDS 4
+#define SHUFFLE_BAG_MAX_HALF 15  // 2^30 positions
+
+// Round function: a murmur-style finalizer keyed by seed and round
+static uint32_t feistel_round(uint32_t x, uint32_t key)
+{
+    x ^= key;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+uint32_t shuffle_bag_permute(uint32_t seed, int half, uint32_t index)
+{
+    uint32_t mask = (1u << half) - 1;
+    uint32_t left = (index >> half) & mask;
+    uint32_t right = index & mask;
+    for (int r = 0; r < SHUFFLE_BAG_ROUNDS; r++) {
+        uint32_t next = left ^ (feistel_round(right, seed + (uint32_t) r * 0x9e3779b9u) & mask);
+        left = right;
+        right = next;
+    }
+    return (left << half) | right;
+}
+
+void shuffle_bag_reset(shuffle_bag_t *bag, uint32_t seed, uint32_t count, uint32_t layout)
+{
+    // Smallest balanced domain holding count, so a draw skips fewer than
+    // three positions on average
+    int half = 1;
+    while (half < SHUFFLE_BAG_MAX_HALF && ((uint64_t) 1 << (2 * half)) < count) {
+        half++;
+    }
+    bag->seed = seed;
+    bag->cursor = 0;
+    bag->layout = layout;
+    bag->half = (uint8_t) half;
+}
+
+bool shuffle_bag_next(shuffle_bag_t *bag, uint32_t count, uint32_t layout, uint32_t *out)
+{
+    if (bag->half == 0 || bag->half > SHUFFLE_BAG_MAX_HALF || bag->layout != layout) {
+        return false;
+    }
+    uint64_t domain = (uint64_t) 1 << (2 * bag->half);
+    while (bag->cursor < domain) {
+        uint32_t pos = shuffle_bag_permute(bag->seed, bag->half, bag->cursor++);
+        if (pos < count) {
+            *out = pos;
+            return true;
+        }
+    }
+    return false;
+}
+
+void shuffle_bag_reset_slots(shuffle_bag_t *bag, uint32_t seed, int lists, uint32_t layout)
+{
+    if (lists > SHUFFLE_BAG_MAX_SLOTS) {
+        lists = SHUFFLE_BAG_MAX_SLOTS;
+    }
+    shuffle_bag_reset(bag, seed, (uint32_t) lists << SHUFFLE_BAG_SLOT_BITS, layout);
+}
+
+bool shuffle_bag_next_slot(shuffle_bag_t *bag, const int *counts, int lists, uint32_t layout,
+                           int *list, uint32_t *index)
+{
+    if (lists > SHUFFLE_BAG_MAX_SLOTS) {
+        lists = SHUFFLE_BAG_MAX_SLOTS;
+    }
+    // Slot positions past a list's count are empty; skip them
+    uint32_t pos;
+    while (shuffle_bag_next(bag, (uint32_t) lists << SHUFFLE_BAG_SLOT_BITS, layout, &pos)) {
+        int i = (int) (pos >> SHUFFLE_BAG_SLOT_BITS);
+        uint32_t n = pos & ((1u << SHUFFLE_BAG_SLOT_BITS) - 1);
+        if (counts[i] > 0 && n < (uint32_t) counts[i]) {
+            *list = i;
+            *index = n;
+            return true;
+        }
+    }
+    return false;
+}
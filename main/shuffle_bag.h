@@ -0,0 +1,73 @@
+#ifndef SHUFFLE_BAG_H
+#define SHUFFLE_BAG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// Shuffle bag over image positions (pure, host-testable)
+//
+// A round visits every position in [0, count) exactly once, in an order
+// given by a seeded 4-round Feistel permutation over a power-of-four domain
+// of at least count. The whole round is described by the seed, the domain
+// size and a cursor, so it persists in a few bytes and each draw takes
+// constant time and memory: the cursor walks the domain and skips positions
+// at or past the current count (fewer than four per draw when the domain was
+// sized for that count).
+//
+// The count is read at every draw, so positions appended mid-round take
+// their shuffled slot in the remaining draws without a reshuffle, as long as
+// the count stays within the domain; beyond it they join the next round.
+//
+// A round only means something while every position keeps standing for the
+// same item. The caller tags the round with a layout value that changes
+// whenever positions may have moved (an item removed, the list reordered);
+// a draw under a different layout ends the round, so the next one starts
+// over instead of skipping or repeating items.
+//
+// Several lists shuffle together through slots: list i owns positions
+// [i << SHUFFLE_BAG_SLOT_BITS, (i + 1) << SHUFFLE_BAG_SLOT_BITS), so appending
+// to one list only raises its count and never moves another list's items.
+// ============================================================================
+
+// Positions per list slot; items past it are left out of slotted rounds
+#define SHUFFLE_BAG_SLOT_BITS 16
+// Most lists a slotted round covers (the domain is capped at 2^30)
+#define SHUFFLE_BAG_MAX_SLOTS (1 << 14)
+
+typedef struct {
+    uint32_t seed;
+    uint32_t cursor;  // next domain index to permute
+    uint32_t layout;  // caller's tag for what the positions stood for
+    uint8_t half;     // domain is [0, 4^half); 0 means no round in progress
+    uint8_t reserved[3];
+} shuffle_bag_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Start a new round over count positions, tagged with layout
+void shuffle_bag_reset(shuffle_bag_t *bag, uint32_t seed, uint32_t count, uint32_t layout);
+
+// Draw the next position below count. Returns false when the round is over,
+// none was started or it was started under another layout; the bag is left
+// unchanged apart from the cursor.
+bool shuffle_bag_next(shuffle_bag_t *bag, uint32_t count, uint32_t layout, uint32_t *out);
+
+// Start a new round over lists slots, tagged with layout
+void shuffle_bag_reset_slots(shuffle_bag_t *bag, uint32_t seed, int lists, uint32_t layout);
+
+// Draw the next item of a slotted round: *list and *index (below counts[*list])
+// identify it. Returns false as shuffle_bag_next does.
+bool shuffle_bag_next_slot(shuffle_bag_t *bag, const int *counts, int lists, uint32_t layout,
+                           int *list, uint32_t *index);
+
+// The round's bijection on [0, 4^half), exposed for tests
+uint32_t shuffle_bag_permute(uint32_t seed, int half, uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
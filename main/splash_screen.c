@@ -31,6 +31,25 @@ static inline uint8_t splash_white_nibble(void)
     return strncmp(BOARD_HAL_DISPLAY_TYPE, "gc", 2) == 0 ? 0x0F : EPD_WHITE;
 }
 
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+// The IT8951 driver expects frame buffers already in the panel's mirrored
+// 16-bit word order (see GUI_Paint's WordMirror); splash buffers are drawn
+// left to right, so reorder each row once before display.
+static void splash_to_panel_word_order(uint8_t *buffer, int width, int height)
+{
+    const int row_bytes = (width + 1) / 2;
+    const int row_words = row_bytes / 2;
+    for (int y = 0; y < height; y++) {
+        uint16_t *row = (uint16_t *) (buffer + (size_t) y * row_bytes);
+        for (int i = 0; i < row_words / 2; i++) {
+            uint16_t tmp = row[i];
+            row[i] = row[row_words - 1 - i];
+            row[row_words - 1 - i] = tmp;
+        }
+    }
+}
+#endif
+
 /**
  * Set a pixel in the 4-bit-per-pixel e-paper buffer.
  * Two pixels per byte: high nibble = even pixel, low nibble = odd pixel.
@@ -222,6 +241,9 @@ esp_err_t splash_screen_display(void)
 
     // Display on e-paper
     ESP_LOGI(TAG, "Displaying splash screen");
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+    splash_to_panel_word_order(epd_buffer, width, height);
+#endif
     epaper_display(epd_buffer);
 
     heap_caps_free(epd_buffer);
@@ -284,6 +306,9 @@ esp_err_t splash_screen_display_setup_complete(const char *hostname)
     }
 
     ESP_LOGI(TAG, "Displaying setup complete screen");
+#if CONFIG_IT8951_FB_PANEL_WORD_ORDER
+    splash_to_panel_word_order(epd_buffer, width, height);
+#endif
     epaper_display(epd_buffer);
 
     heap_caps_free(epd_buffer);
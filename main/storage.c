@@ -109,7 +109,18 @@ static esp_err_t mount_littlefs(void)
 }
 #endif
 
-esp_err_t storage_init(void)
+#if CONFIG_STAGING_IN_RAM
+// Transient display files get their own PSRAM mount, next to whichever
+// primary storage is active, so displaying an image never writes flash
+static void mount_staging(void)
+{
+    if (memfs_mount(STAGING_MOUNT_POINT, STAGING_MAX_FILES) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount staging MemFS at %s", STAGING_MOUNT_POINT);
+    }
+}
+#endif
+
+static esp_err_t mount_primary(void)
 {
     esp_err_t ret = ESP_OK;
 
@@ -146,6 +157,15 @@ esp_err_t storage_init(void)
     return ret;
 }
 
+esp_err_t storage_init(void)
+{
+    esp_err_t ret = mount_primary();
+#if CONFIG_STAGING_IN_RAM
+    mount_staging();
+#endif
+    return ret;
+}
+
 storage_type_t storage_get_type(void)
 {
     return current_storage_type;
@@ -157,6 +177,15 @@ bool storage_has_persistent_storage(void)
            current_storage_type == STORAGE_TYPE_LITTLEFS;
 }
 
+bool storage_staging_is_persistent(void)
+{
+#if CONFIG_STAGING_IN_RAM
+    return false;
+#else
+    return storage_has_persistent_storage();
+#endif
+}
+
 void storage_unmount(void)
 {
 #ifdef CONFIG_USE_INTERNAL_FLASH_STORAGE
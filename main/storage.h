@@ -40,6 +40,17 @@ storage_type_t storage_get_type(void);
  */
 bool storage_has_persistent_storage(void);
 
+/**
+ * @brief Check if the transient display files (STAGING_MOUNT_POINT) survive a reboot
+ *
+ * False when they live in RAM, either in the staging MemFS
+ * (CONFIG_STAGING_IN_RAM) or because no persistent storage is mounted.
+ * Decides whether full-size originals are kept for /api/current_image.
+ *
+ * @return true if staging is on persistent storage
+ */
+bool storage_staging_is_persistent(void);
+
 /**
  * @brief Read WiFi credentials from "wifi.txt" file on root storage (if available)
  *
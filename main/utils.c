@@ -6,6 +6,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "album_index.h"
 #include "board_hal.h"
 #include "cJSON.h"
 #include "cert_pin.h"
@@ -390,9 +391,7 @@ esp_err_t apply_config_from_json(cJSON *root)
     item = cJSON_GetObjectItem(root, "sd_rotation_mode");
     if (item && cJSON_IsString(item)) {
         const char *mode_str = cJSON_GetStringValue(item);
-        sd_rotation_mode_t mode =
-            (strcmp(mode_str, "sequential") == 0) ? SD_ROTATION_SEQUENTIAL : SD_ROTATION_RANDOM;
-        config_manager_set_sd_rotation_mode(mode);
+        config_manager_set_sd_rotation_mode(config_manager_parse_sd_rotation_mode(mode_str));
     }
 
     // Auto Rotate - URL (with auto-pinning)
@@ -941,8 +940,11 @@ static esp_err_t fetch_stream_display(image_format_t image_format, bool thumbnai
 
     dither_algorithm_t algo = processing_settings_get_dithering_algorithm();
 
-    bool persistent = storage_has_persistent_storage();
-    bool save_to_album = persistent && config_manager_get_save_downloaded_images();
+    // Whether the download's own files may be kept (see display_flow.h);
+    // album saving only needs persistent album storage
+    bool persistent = storage_staging_is_persistent();
+    bool save_to_album =
+        storage_has_persistent_storage() && config_manager_get_save_downloaded_images();
 
     // Album paths are decided before display so the current-image link
     // records the final logical name atomically with the refresh
@@ -979,9 +981,10 @@ static esp_err_t fetch_stream_display(image_format_t image_format, bool thumbnai
             unlink(temp_upload_path);
             return read_err;
         }
-        if (!persistent) {
-            // MemFS-backed source lives in PSRAM; drop the file now that
-            // the compressed copy exists
+        if (!persistent && !(save_to_album && !thumbnail_downloaded)) {
+            // RAM-backed source lives in PSRAM; drop the file now that the
+            // compressed copy exists, unless it is about to become the
+            // album preview
             unlink(temp_upload_path);
         }
     }
@@ -992,11 +995,8 @@ static esp_err_t fetch_stream_display(image_format_t image_format, bool thumbnai
     // (transiently, or permanently if the move fails)
     bool preview_staged = false;
     if (save_to_album && album_has_preview) {
-        if (thumbnail_downloaded) {
-            preview_staged = rename(temp_jpg_path, album_thumb_path) == 0;
-        } else {
-            preview_staged = rename(temp_upload_path, album_thumb_path) == 0;
-        }
+        const char *preview = thumbnail_downloaded ? temp_jpg_path : temp_upload_path;
+        preview_staged = display_flow_move_file(preview, album_thumb_path) == ESP_OK;
         if (!preview_staged) {
             ESP_LOGW(TAG, "Failed to stage album thumbnail; keeping original as preview");
             album_has_preview = false;
@@ -1018,7 +1018,7 @@ static esp_err_t fetch_stream_display(image_format_t image_format, bool thumbnai
     esp_err_t err;
     if (image_format == IMAGE_FORMAT_PNG) {
         // File-backed fused path: no RAM copy of the download; MemFS
-        // sources are released as soon as processing copies them
+        // sources are decoded in place
         err = display_flow_stream_file(temp_upload_path, image_format, algo, &pub, !persistent);
     } else {
         err = image_processor_process_to_display(file_buffer, file_size, image_format, algo, &pub);
@@ -1033,7 +1033,7 @@ static esp_err_t fetch_stream_display(image_format_t image_format, bool thumbnai
         if (preview_staged) {
             // Bring the staged album preview back as the current thumbnail
             // so the fallback link resolves
-            if (rename(album_thumb_path, temp_jpg_path) == 0) {
+            if (display_flow_move_file(album_thumb_path, temp_jpg_path) == ESP_OK) {
                 thumbnail_downloaded = true;
             } else {
                 ESP_LOGW(TAG, "Failed to restore staged album thumbnail");
@@ -1066,6 +1066,7 @@ static esp_err_t fetch_stream_display(image_format_t image_format, bool thumbnai
             unlink(temp_upload_path);
             display_flow_drop_stale_current(NULL, false);
         }
+        album_index_note_added(album_image_path);
         ESP_LOGI(TAG, "Saved to Downloads album: %s", album_image_path);
     } else {
         // Keep-original policy, matching the direct display endpoint
@@ -1108,7 +1109,7 @@ static esp_err_t fetch_display_file(image_format_t image_format, bool thumbnail_
             snprintf(final_image_path, sizeof(final_image_path), "%s/%s%s", downloads_path,
                      filename_base, save_ext);
 
-            if (rename(staged, final_image_path) != 0) {
+            if (display_flow_move_file(staged, final_image_path) != ESP_OK) {
                 ESP_LOGW(TAG, "Failed to move image to Downloads album, using temp path");
             } else {
                 snprintf(display_path, sizeof(display_path), "%s", final_image_path);
@@ -1120,13 +1121,14 @@ static esp_err_t fetch_display_file(image_format_t image_format, bool thumbnail_
                     char final_thumb_path[512];
                     snprintf(final_thumb_path, sizeof(final_thumb_path), "%s/%s.jpg",
                              downloads_path, filename_base);
-                    if (rename(CURRENT_JPG_PATH, final_thumb_path) == 0) {
+                    if (display_flow_move_file(CURRENT_JPG_PATH, final_thumb_path) == ESP_OK) {
                         thumbnail_saved_to_album = true;
                     } else {
                         ESP_LOGW(TAG, "Failed to move thumbnail to Downloads album");
                     }
                 }
 
+                album_index_note_added(final_image_path);
                 if (thumbnail_saved_to_album) {
                     ESP_LOGI(TAG, "Saved to Downloads album: %s (with thumbnail)", filename_base);
                 } else {
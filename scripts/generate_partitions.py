@@ -2,8 +2,8 @@
 """
 Generate partitions.csv for ESP32 PhotoFrame based on sdkconfig settings.
 
-Reads CONFIG_USE_INTERNAL_FLASH_STORAGE and CONFIG_ESPTOOLPY_FLASHSIZE_*
-from one or more config files to determine the appropriate partition layout.
+Reads CONFIG_USE_INTERNAL_FLASH_STORAGE, CONFIG_FRAME_STORE_PARTITION* and
+CONFIG_ESPTOOLPY_FLASHSIZE_* from one or more config files to determine the appropriate partition layout.
 
 Usage:
     python3 generate_partitions.py --sdkconfig sdkconfig.defaults boards/sdkconfig.defaults.board --output partitions.csv
@@ -35,11 +35,17 @@ phy_init, data, phy,     0x11000, 0x1000,
 # partition layout — and thus users' flash — is untouched.
 COREDUMP_SIZE = 0x10000
 
+# Raw frame store (CONFIG_FRAME_STORE_PARTITION=y), carved from the end of
+# the LittleFS storage partition. Matches the Kconfig default size.
+FRAME_STORE_DEFAULT_KB = 2048
+
 
 def parse_config_files(paths):
     use_internal_flash = False
     flash_size_mb = 16  # default
     coredump = False
+    frame_store_kb = 0
+    frame_store_size_kb = FRAME_STORE_DEFAULT_KB
 
     for path in paths:
         try:
@@ -50,17 +56,25 @@ def parse_config_files(paths):
                         use_internal_flash = True
                     elif line == "CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH=y":
                         coredump = True
+                    elif line == "CONFIG_FRAME_STORE_PARTITION=y":
+                        frame_store_kb = -1
+                    elif line.startswith("CONFIG_FRAME_STORE_PARTITION_KB="):
+                        frame_store_size_kb = int(line.split("=", 1)[1])
                     elif line in FLASH_SIZE_MAP:
                         flash_size_mb = FLASH_SIZE_MAP[line]
         except FileNotFoundError:
             print(f"Warning: config file not found: {path}", file=sys.stderr)
 
-    return use_internal_flash, flash_size_mb, coredump
+    if frame_store_kb:
+        frame_store_kb = frame_store_size_kb
+    return use_internal_flash, flash_size_mb, coredump, frame_store_kb
 
 
-def generate_csv(use_internal_flash, flash_size_mb, coredump=False):
+def generate_csv(use_internal_flash, flash_size_mb, coredump=False, frame_store_kb=0):
     csv = HEADER
     cd_size = COREDUMP_SIZE if coredump else 0
+    # Whole 64 KB blocks, so frame slots map and erase on block boundaries
+    fs_size = (frame_store_kb * 1024 + 0xFFFF) // 0x10000 * 0x10000 if use_internal_flash else 0
 
     if use_internal_flash:
         if flash_size_mb == 8:
@@ -81,13 +95,17 @@ def generate_csv(use_internal_flash, flash_size_mb, coredump=False):
         # unaddressed. Growing the size is safe for existing devices -- OTA
         # never rewrites the partition table, and after a full reflash
         # grow_on_mount (storage.c) expands the filesystem in place.
-        stg_size = flash_size_mb * 1024 * 1024 - stg_offset - cd_size
+        stg_size = flash_size_mb * 1024 * 1024 - stg_offset - fs_size - cd_size
         csv += f"storage,  data, littlefs,{stg_offset:#08x}, {stg_size:#010x},\n"
+        if fs_size:
+            csv += f"frames,   data, 0x40,    {stg_offset + stg_size:#08x}, {fs_size:#010x},\n"
         if coredump:
-            csv += f"coredump, data, coredump,{stg_offset + stg_size:#08x}, {cd_size:#010x},\n"
+            cd_offset = stg_offset + stg_size + fs_size
+            csv += f"coredump, data, coredump,{cd_offset:#08x}, {cd_size:#010x},\n"
         print(
             f"Partition table: internal flash storage enabled "
             f"({flash_size_mb}MB flash, storage size: {stg_size:#010x}"
+            f"{f', frames: {fs_size:#010x}' if fs_size else ''}"
             f"{', +coredump' if coredump else ''})",
             file=sys.stderr,
         )
@@ -124,8 +142,10 @@ def main():
     parser.add_argument("--output", required=True, help="Path to write partitions.csv")
     args = parser.parse_args()
 
-    use_internal_flash, flash_size_mb, coredump = parse_config_files(args.sdkconfig)
-    csv = generate_csv(use_internal_flash, flash_size_mb, coredump)
+    use_internal_flash, flash_size_mb, coredump, frame_store_kb = parse_config_files(
+        args.sdkconfig
+    )
+    csv = generate_csv(use_internal_flash, flash_size_mb, coredump, frame_store_kb)
 
     with open(args.output, "w") as f:
         f.write(csv)